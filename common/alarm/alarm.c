@@ -0,0 +1,520 @@
+/**
+ * @file alarm.c
+ * @brief 多个闹钟，保存在rom_key_value里，掉电不丢
+ *
+ * 所有启用的闹钟按下一次到时的UTC秒数放在一个最小堆里，堆顶就是最近的闹钟，
+ * 只有它被设置到RTC闹钟上。到时后只处理堆顶，重复闹钟算出下一次时间后重新入堆，
+ * 增删改一个闹钟都是O(log n)，平时不会每秒遍历所有闹钟。
+ * 只有RTC时间被修改时才需要AlarmReschedule重新计算全部闹钟。
+ */
+
+#include "alarm.h"
+#include "stddef.h"
+#include "stdio.h"
+#include "string.h"
+#include "driver.h"
+#include "rom_key_value.h"
+#include "terminal_com.h"
+#include "elog.h"
+
+#define ALARM_KEY_USED              "alarm_used"    // 已设置的闹钟编号位图
+#define ALARM_KEY_NAME_SIZE         12
+#define ALARM_TEST_DELAY            10              // alarm_test设置的闹钟在多少秒后响
+
+typedef struct __AlarmHeapNode
+{
+    uint32_t due;               // 下一次到时的UTC秒数
+    uint8_t id;
+}AlarmHeapNode;
+
+static Alarm alarms[ALARM_MAX_NUM];
+static uint32_t alarm_used = 0;
+
+static AlarmHeapNode heap[ALARM_MAX_NUM];
+static uint8_t heap_num = 0;
+static int8_t heap_pos[ALARM_MAX_NUM];      // 闹钟在堆里的位置，不在堆里为-1
+
+static TimeZone *alarm_zone = NULL;
+static AlarmFunc alarm_func = NULL;
+static volatile uint8_t alarm_pending = 0;
+
+static void alarm_key_name(uint8_t id, char *name);
+static int8_t alarm_save_used(void);
+static uint32_t alarm_local_to_utc(uint32_t local);
+static uint32_t alarm_next_due(const Alarm *alarm, uint32_t now);
+static void alarm_schedule(uint8_t id, uint32_t due);
+static void alarm_arm(void);
+static void heap_swap(uint8_t a, uint8_t b);
+static void heap_up(uint8_t i);
+static void heap_down(uint8_t i);
+static void heap_remove(uint8_t id);
+static void alarm_rtc_callback(void);
+static void alarm_list_command(void);
+static void alarm_test_command(void);
+
+/**
+ * @brief 从rom_key_value读出所有闹钟并设置最近的一个，需要在rom_key_value_init和RtcInit之后调用
+ *
+ * @param zone 闹钟时间按这个时区的本地时间解释
+ * @param func
+ * @return int8_t
+ */
+int8_t AlarmInit(TimeZone *zone, AlarmFunc func)
+{
+    char name[ALARM_KEY_NAME_SIZE];
+    uint32_t used = 0;
+    uint8_t id;
+
+    if(zone == NULL)
+    {
+        return -1;
+    }
+    alarm_zone = zone;
+    alarm_func = func;
+
+    memset(alarms, 0, sizeof(alarms));
+    if(GET_KEY_VALUE(ALARM_KEY_USED, used) != 0)
+    {
+        used = 0;
+    }
+    alarm_used = 0;
+    for(id = 0; id < ALARM_MAX_NUM; id ++)
+    {
+        if((used & (1UL << id)) == 0)
+            continue;
+        alarm_key_name(id, name);
+        if(get_key_value(name, &alarms[id], sizeof(Alarm)) == 0)
+        {
+            alarm_used |= 1UL << id;
+        }
+    }
+
+    RtcAlarmCallbackRegister(&alarm_rtc_callback);
+    AlarmReschedule();
+
+    TerminalCommandRegister("alarm_list", &alarm_list_command);
+    TerminalCommandRegister("alarm_test", &alarm_test_command);
+
+    return 0;
+}
+
+/**
+ * @brief 新建或修改一个闹钟，保存后重新设置最近的闹钟
+ *
+ * @param id
+ * @param alarm
+ * @return int8_t 参数错误、单次闹钟已经过去或者保存失败时返回-1
+ */
+int8_t AlarmSet(uint8_t id, const Alarm *alarm)
+{
+    char name[ALARM_KEY_NAME_SIZE];
+    uint32_t due;
+
+    if(id >= ALARM_MAX_NUM || alarm == NULL || alarm_zone == NULL)
+    {
+        return -1;
+    }
+    if(alarm->weekdays > ALARM_EVERY_DAY || (alarm->weekdays != ALARM_ONCE && alarm->time >= CALENDAR_SECONDS_PER_DAY))
+    {
+        return -1;
+    }
+    due = alarm_next_due(alarm, RtcNow());
+    if(alarm->enable != 0 && due == 0)
+    {
+        return -1;
+    }
+
+    alarm_key_name(id, name);
+    if(set_key_value(name, (void *)alarm, sizeof(Alarm)) != 0)
+    {
+        return -1;
+    }
+    alarms[id] = *alarm;
+    if((alarm_used & (1UL << id)) == 0)
+    {
+        alarm_used |= 1UL << id;
+        alarm_save_used();
+    }
+
+    alarm_schedule(id, due);
+    alarm_arm();
+
+    return 0;
+}
+
+int8_t AlarmGet(uint8_t id, Alarm *alarm)
+{
+    if(id >= ALARM_MAX_NUM || alarm == NULL || (alarm_used & (1UL << id)) == 0)
+    {
+        return -1;
+    }
+    *alarm = alarms[id];
+    return 0;
+}
+
+int8_t AlarmDelete(uint8_t id)
+{
+    char name[ALARM_KEY_NAME_SIZE];
+
+    if(id >= ALARM_MAX_NUM)
+    {
+        return -1;
+    }
+    if((alarm_used & (1UL << id)) == 0)
+    {
+        return 0;
+    }
+
+    alarm_key_name(id, name);
+    delete_key_value(name);
+    alarm_used &= ~(1UL << id);
+    alarm_save_used();
+
+    heap_remove(id);
+    alarm_arm();
+
+    return 0;
+}
+
+/**
+ * @brief 最近的一个闹钟
+ *
+ * @param id
+ * @param due 到时的UTC秒数
+ * @return int8_t 没有启用的闹钟时返回-1
+ */
+int8_t AlarmNext(uint8_t *id, uint32_t *due)
+{
+    if(heap_num == 0)
+    {
+        return -1;
+    }
+    *id = heap[0].id;
+    *due = heap[0].due;
+    return 0;
+}
+
+/**
+ * @brief RTC时间被修改后重新计算所有闹钟
+ *
+ */
+void AlarmReschedule(void)
+{
+    uint32_t now = RtcNow();
+    uint8_t id;
+
+    heap_num = 0;
+    memset(heap_pos, -1, sizeof(heap_pos));
+    for(id = 0; id < ALARM_MAX_NUM; id ++)
+    {
+        if((alarm_used & (1UL << id)) != 0)
+        {
+            alarm_schedule(id, alarm_next_due(&alarms[id], now));
+        }
+    }
+    alarm_arm();
+}
+
+/**
+ * @brief 主循环里调用，只比较堆顶，处理所有已经到时的闹钟
+ *
+ */
+void AlarmProcess(void)
+{
+    Alarm *alarm;
+    uint32_t now;
+    uint8_t id;
+
+    if(heap_num == 0)
+    {
+        return;
+    }
+    // RTC闹钟中断之外也比较一次，设置闹钟时刚好跨秒也不会错过
+    now = RtcNow();
+    if(alarm_pending == 0 && heap[0].due > now)
+    {
+        return;
+    }
+    alarm_pending = 0;
+
+    while(heap_num > 0 && heap[0].due <= now)
+    {
+        id = heap[0].id;
+        alarm = &alarms[id];
+
+        if(alarm_func != NULL)
+            alarm_func(id, alarm);
+
+        if(alarm->weekdays == ALARM_ONCE && (alarm->flags & ALARM_FLAG_TEMP) != 0)
+        {
+            // 临时闹钟不留在alarm_used里，编号可以再用
+            AlarmDelete(id);
+        }
+        else if(alarm->weekdays == ALARM_ONCE)
+        {
+            char name[ALARM_KEY_NAME_SIZE];
+
+            // 单次闹钟响过后关闭，保存下来，重新上电不会再响
+            alarm->enable = 0;
+            alarm_key_name(id, name);
+            set_key_value(name, alarm, sizeof(Alarm));
+            heap_remove(id);
+        }
+        else
+        {
+            alarm_schedule(id, alarm_next_due(alarm, now));
+        }
+    }
+
+    alarm_arm();
+}
+
+static void alarm_key_name(uint8_t id, char *name)
+{
+    sprintf(name, "alarm_%02u", id);
+}
+
+static int8_t alarm_save_used(void)
+{
+    return SET_KEY_VALUE(ALARM_KEY_USED, alarm_used);
+}
+
+/**
+ * @brief 本地时间转换为UTC，夏令时切换的那一个小时里按切换后的偏移计算
+ *
+ */
+static uint32_t alarm_local_to_utc(uint32_t local)
+{
+    uint32_t utc = local - (uint32_t)(alarm_zone->offset_min * 60);
+
+    return local - (uint32_t)CalendarUtcOffset(alarm_zone, utc);
+}
+
+/**
+ * @brief 闹钟在now之后的下一次到时时间
+ *
+ * @return uint32_t UTC秒数，闹钟关闭或单次闹钟已经过去时返回0
+ */
+static uint32_t alarm_next_due(const Alarm *alarm, uint32_t now)
+{
+    uint32_t day;
+    uint32_t due;
+    uint8_t i;
+
+    if(alarm->enable == 0)
+    {
+        return 0;
+    }
+
+    if(alarm->weekdays == ALARM_ONCE)
+    {
+        due = alarm_local_to_utc(alarm->time);
+        return due > now ? due : 0;
+    }
+
+    // 从今天开始最多看8天，今天的时间已经过去时下周的今天也能找到
+    day = CalendarToLocal(alarm_zone, now) / CALENDAR_SECONDS_PER_DAY;
+    for(i = 0; i <= 7; i ++)
+    {
+        if((alarm->weekdays & ALARM_WEEKDAY(CALENDAR_WEEKDAY(day + i))) == 0)
+            continue;
+        due = alarm_local_to_utc((day + i) * CALENDAR_SECONDS_PER_DAY + alarm->time);
+        if(due > now)
+            return due;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief 更新闹钟在堆里的位置，due为0时移出堆
+ *
+ */
+static void alarm_schedule(uint8_t id, uint32_t due)
+{
+    int8_t i = heap_pos[id];
+
+    if(due == 0)
+    {
+        heap_remove(id);
+        return;
+    }
+
+    if(i < 0)
+    {
+        i = heap_num ++;
+        heap[i].id = id;
+        heap_pos[id] = i;
+    }
+    heap[i].due = due;
+    heap_up(i);
+    heap_down(heap_pos[id]);
+}
+
+/**
+ * @brief 把堆顶设置到RTC闹钟上
+ *
+ */
+static void alarm_arm(void)
+{
+    if(heap_num == 0)
+    {
+        RtcDisableAlarm();
+        return;
+    }
+    if(heap[0].due <= RtcNow())
+    {
+        alarm_pending = 1;
+        return;
+    }
+    RtcSetAlarm(heap[0].due);
+}
+
+static void heap_swap(uint8_t a, uint8_t b)
+{
+    AlarmHeapNode node = heap[a];
+
+    heap[a] = heap[b];
+    heap[b] = node;
+    heap_pos[heap[a].id] = a;
+    heap_pos[heap[b].id] = b;
+}
+
+static void heap_up(uint8_t i)
+{
+    uint8_t parent;
+
+    while(i > 0)
+    {
+        parent = (i - 1) / 2;
+        if(heap[parent].due <= heap[i].due)
+            break;
+        heap_swap(i, parent);
+        i = parent;
+    }
+}
+
+static void heap_down(uint8_t i)
+{
+    uint8_t child;
+
+    while((child = 2 * i + 1) < heap_num)
+    {
+        if(child + 1 < heap_num && heap[child + 1].due < heap[child].due)
+            child ++;
+        if(heap[i].due <= heap[child].due)
+            break;
+        heap_swap(i, child);
+        i = child;
+    }
+}
+
+static void heap_remove(uint8_t id)
+{
+    int8_t i = heap_pos[id];
+    uint8_t moved;
+
+    if(i < 0)
+    {
+        return;
+    }
+    heap_pos[id] = -1;
+    heap_num --;
+    if(i == heap_num)
+    {
+        return;
+    }
+    // 用最后一个节点填补空位，它可能比父节点小也可能比子节点大
+    moved = heap[heap_num].id;
+    heap[i] = heap[heap_num];
+    heap_pos[moved] = i;
+    heap_up(i);
+    heap_down(heap_pos[moved]);
+}
+
+/**
+ * @brief RTC闹钟中断里调用，只置标志
+ *
+ */
+static void alarm_rtc_callback(void)
+{
+    alarm_pending = 1;
+}
+
+/**
+ * @brief 打印所有闹钟和最近的一个
+ *
+ */
+static void alarm_list_command(void)
+{
+    ClockTime local;
+    uint32_t due;
+    uint8_t next;
+    uint8_t id;
+
+    for(id = 0; id < ALARM_MAX_NUM; id ++)
+    {
+        if((alarm_used & (1UL << id)) == 0)
+            continue;
+        if(alarms[id].weekdays == ALARM_ONCE)
+        {
+            CalendarFromSeconds(alarms[id].time, &local);
+            elog_i("alarm", "%02u once %04d-%02d-%02d %02d:%02d:%02d %s", id, local.year, local.month, local.day,
+                local.hour, local.min, local.sec, alarms[id].enable ? "on" : "off");
+        }
+        else
+        {
+            elog_i("alarm", "%02u week 0x%02x %02u:%02u:%02u %s", id, alarms[id].weekdays, alarms[id].time / 3600,
+                alarms[id].time / 60 % 60, alarms[id].time % 60, alarms[id].enable ? "on" : "off");
+        }
+    }
+
+    if(AlarmNext(&next, &due) != 0)
+    {
+        elog_i("alarm", "no alarm armed");
+        return;
+    }
+    CalendarFromSeconds(CalendarToLocal(alarm_zone, due), &local);
+    elog_i("alarm", "next %02u at %04d-%02d-%02d %02d:%02d:%02d, in %us", next, local.year, local.month, local.day,
+        local.hour, local.min, local.sec, due - RtcNow());
+}
+
+/**
+ * @brief 设置一个ALARM_TEST_DELAY秒后的临时闹钟，响过后自动删除
+ *
+ * 还没响的测试闹钟直接改时间，否则用编号最大的空闲位置，不覆盖用户设置的闹钟
+ */
+static void alarm_test_command(void)
+{
+    Alarm alarm;
+    uint8_t id;
+
+    for(id = 0; id < ALARM_MAX_NUM; id ++)
+    {
+        if((alarm_used & (1UL << id)) != 0 && (alarms[id].flags & ALARM_FLAG_TEMP) != 0)
+            break;
+    }
+    if(id == ALARM_MAX_NUM)
+    {
+        while(id > 0 && (alarm_used & (1UL << (id - 1))) != 0)
+        {
+            id --;
+        }
+        if(id == 0)
+        {
+            elog_e("alarm", "all %u alarms in use, test alarm not set", ALARM_MAX_NUM);
+            return;
+        }
+        id --;
+    }
+
+    memset(&alarm, 0, sizeof(alarm));
+    alarm.time = CalendarToLocal(alarm_zone, RtcNow()) + ALARM_TEST_DELAY;
+    alarm.weekdays = ALARM_ONCE;
+    alarm.enable = 1;
+    alarm.flags = ALARM_FLAG_TEMP;
+    if(AlarmSet(id, &alarm) == 0)
+        elog_i("alarm", "alarm %u in %us", id, ALARM_TEST_DELAY);
+    else
+        elog_e("alarm", "set test alarm fail");
+}
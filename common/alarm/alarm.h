@@ -0,0 +1,47 @@
+#pragma once
+
+#include "stdint.h"
+#include "calendar.h"
+
+#define ALARM_MAX_NUM               32          // 闹钟编号0 ... ALARM_MAX_NUM - 1
+
+#define ALARM_WEEKDAY(w)            ((uint8_t)(1 << (w)))       // 0：星期日 ... 6：星期六
+#define ALARM_EVERY_DAY             0x7f
+#define ALARM_WORKDAYS              0x3e        // 星期一到星期五
+#define ALARM_ONCE                  0           // weekdays为0表示单次闹钟
+
+#define ALARM_FLAG_TEMP             0x01        // 单次闹钟响过后直接删除，不保留关闭的设置
+
+/**
+ * @brief 闹钟设置，8字节，整体作为一个值保存在rom_key_value里
+ *
+ * 单次闹钟的time为本地时间自2000-01-01起的秒数，重复闹钟的time为本地时间自零点起的秒数
+ */
+typedef struct __Alarm
+{
+    uint32_t time;
+    uint8_t weekdays;           // 重复的星期，ALARM_WEEKDAY的组合，ALARM_ONCE为单次
+    uint8_t enable;
+    uint8_t sound;              // 调用者自定义的提示音编号
+    uint8_t flags;              // ALARM_FLAG_的组合
+}Alarm;
+
+/**
+ * @brief 闹钟到时，在主循环里调用
+ *
+ */
+typedef void (*AlarmFunc)(uint8_t id, const Alarm *alarm);
+
+int8_t AlarmInit(TimeZone *zone, AlarmFunc func);
+
+int8_t AlarmSet(uint8_t id, const Alarm *alarm);
+
+int8_t AlarmGet(uint8_t id, Alarm *alarm);
+
+int8_t AlarmDelete(uint8_t id);
+
+int8_t AlarmNext(uint8_t *id, uint32_t *due);
+
+void AlarmReschedule(void);
+
+void AlarmProcess(void);
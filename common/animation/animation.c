@@ -0,0 +1,320 @@
+/**
+ * @file animation.c
+ * @brief 固定帧率的关键帧动画
+ *
+ * 定时器中断只记录帧号，插值和回调在主循环的AnimationProcess里执行，不会在中断里占用CPU。
+ * 主循环被传感器读取等工作耽误时，错过的帧直接跳过，动画时间按实际经过的帧数推进，
+ * 动画变得不连贯但总时长不变，也不会为了追赶而连续渲染。
+ * 插值全部是Q16定点运算。
+ */
+
+#include "animation.h"
+#include "stddef.h"
+#include "string.h"
+#include "gd32f30x.h"
+#include "driver.h"
+#include "terminal_com.h"
+#include "elog.h"
+
+#ifndef ANIMATION_TIMER
+    #error "please define ANIMATION_TIMER first!"
+#endif
+
+#if (1000 % ANIMATION_FPS) != 0
+    #error "animation frame period must be a whole number of milliseconds!"
+#endif
+
+#define ANIMATION_FRAME_CYCLES      (SystemCoreClock / ANIMATION_FPS)
+
+typedef struct __Animation
+{
+    const AnimKeyframe *keys;
+    AnimApplyFunc apply;
+    void *arg;
+    uint32_t time_ms;           // 从第一个关键帧开始经过的时间
+    uint8_t key_num;
+    uint8_t loop;
+    uint8_t running;
+}Animation;
+
+static Animation animations[ANIMATION_MAX_NUM];
+
+static volatile uint32_t frame_tick = 0;
+static volatile uint32_t frame_tick_cycles;
+static uint32_t rendered_tick = 0;
+
+static AnimationStat anim_stat;
+static uint64_t stat_render_cycles;     // 统计区间内渲染的总周期
+static uint32_t stat_start_tick;
+
+static void animation_frame_tick(void);
+static int32_t animation_value(const Animation *anim);
+static void anim_stat_command(void);
+
+int8_t AnimationInit(void)
+{
+    TimerInitStruct timer_init;
+
+    // 渲染耗时用DWT周期计数器统计
+    CycleCounterEnable();
+
+    memset(animations, 0, sizeof(animations));
+    memset(&anim_stat, 0, sizeof(anim_stat));
+
+    timer_init.update_time_us = ANIMATION_FRAME_MS * 1000;
+    TimerInit(ANIMATION_TIMER, &timer_init);
+    TimerUpdateCallbackRegister(ANIMATION_TIMER, &animation_frame_tick);
+
+    TerminalCommandRegister("anim_stat", &anim_stat_command);
+
+    return 0;
+}
+
+/**
+ * @brief 开始一个动画，立即输出第一个关键帧的值，只能在主循环里调用
+ *
+ * @param keys 关键帧，动画运行期间必须有效，按时间升序
+ * @param key_num
+ * @param loop 非0时播放到最后一个关键帧后从头开始
+ * @param apply
+ * @param arg 原样传给apply
+ * @return int8_t 动画编号，没有空闲位置时返回-1
+ */
+int8_t AnimationStart(const AnimKeyframe *keys, uint8_t key_num, uint8_t loop, AnimApplyFunc apply, void *arg)
+{
+    Animation *anim;
+    int8_t id;
+
+    if(keys == NULL || key_num == 0 || apply == NULL)
+    {
+        return -1;
+    }
+
+    for(id = 0; id < ANIMATION_MAX_NUM; id ++)
+    {
+        anim = &animations[id];
+        if(anim->running == 0)
+        {
+            anim->keys = keys;
+            anim->key_num = key_num;
+            anim->loop = loop;
+            anim->apply = apply;
+            anim->arg = arg;
+            anim->time_ms = 0;
+            anim->running = 1;
+            apply(keys[0].value, arg);
+            return id;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * @brief 停止动画，停在当前值
+ *
+ */
+void AnimationStop(int8_t id)
+{
+    if(id >= 0 && id < ANIMATION_MAX_NUM)
+        animations[id].running = 0;
+}
+
+uint8_t AnimationIsRunning(int8_t id)
+{
+    if(id < 0 || id >= ANIMATION_MAX_NUM)
+        return 0;
+    return animations[id].running;
+}
+
+/**
+ * @brief 主循环里调用，有新的帧时推进所有动画
+ *
+ */
+void AnimationProcess(void)
+{
+    Animation *anim;
+    uint32_t primask;
+    uint32_t tick;
+    uint32_t tick_cycles;
+    uint32_t start_cycles;
+    uint32_t render_cycles;
+    uint32_t elapsed;
+    uint32_t end_ms;
+    uint8_t active = 0;
+    uint8_t i;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    tick = frame_tick;
+    tick_cycles = frame_tick_cycles;
+    __set_PRIMASK(primask);
+
+    if(tick == rendered_tick)
+    {
+        return;
+    }
+
+    start_cycles = DWT->CYCCNT;
+    elapsed = tick - rendered_tick;
+    rendered_tick = tick;
+
+    for(i = 0; i < ANIMATION_MAX_NUM; i ++)
+    {
+        anim = &animations[i];
+        if(anim->running == 0)
+            continue;
+
+        active = 1;
+        anim->time_ms += elapsed * ANIMATION_FRAME_MS;
+        end_ms = anim->keys[anim->key_num - 1].time_ms;
+        if(anim->time_ms >= end_ms)
+        {
+            if(anim->loop != 0 && end_ms != 0)
+            {
+                anim->time_ms %= end_ms;
+            }
+            else
+            {
+                anim->time_ms = end_ms;
+                anim->running = 0;
+            }
+        }
+        anim->apply(animation_value(anim), anim->arg);
+    }
+
+    // 没有动画运行时不统计，主循环的其他工作耽误的帧不算跳帧
+    if(active == 0)
+    {
+        return;
+    }
+
+    render_cycles = DWT->CYCCNT - start_cycles;
+    anim_stat.frames ++;
+    anim_stat.skipped += elapsed - 1;
+    anim_stat.render_cycles_last = render_cycles;
+    if(render_cycles > anim_stat.render_cycles_max)
+        anim_stat.render_cycles_max = render_cycles;
+    if(start_cycles - tick_cycles > anim_stat.latency_cycles_max)
+        anim_stat.latency_cycles_max = start_cycles - tick_cycles;
+    stat_render_cycles += render_cycles;
+
+    if(frame_tick != tick)
+    {
+        anim_stat.deadline_misses ++;
+    }
+}
+
+/**
+ * @brief 缓动函数
+ *
+ * @param ease
+ * @param t 时间进度，Q16，0 ... ANIMATION_Q16_ONE
+ * @return int32_t 数值进度，Q16
+ */
+int32_t AnimationEase(AnimEase ease, int32_t t)
+{
+    int64_t u;
+
+    if(t <= 0)
+        return 0;
+    if(t >= ANIMATION_Q16_ONE)
+        return ANIMATION_Q16_ONE;
+
+    switch(ease)
+    {
+    case AnimEase_InQuad:
+        return (int32_t)(((int64_t)t * t) >> 16);
+    case AnimEase_OutQuad:
+        u = ANIMATION_Q16_ONE - t;
+        return (int32_t)(ANIMATION_Q16_ONE - ((u * u) >> 16));
+    case AnimEase_InOutCubic:
+        // 前半段4t^3，后半段1 - 4(1-t)^3
+        if(t < ANIMATION_Q16_ONE / 2)
+            return (int32_t)((4 * (int64_t)t * t >> 16) * t >> 16);
+        u = ANIMATION_Q16_ONE - t;
+        return (int32_t)(ANIMATION_Q16_ONE - ((4 * u * u >> 16) * u >> 16));
+    case AnimEase_Step:
+        return 0;
+    case AnimEase_Linear:
+    default:
+        return t;
+    }
+}
+
+/**
+ * @brief 取统计结果，CPU占用按上次调用以来经过的帧数计算
+ *
+ */
+void AnimationGetStat(AnimationStat *stat)
+{
+    uint32_t ticks = frame_tick - stat_start_tick;
+
+    anim_stat.load_permille = 0;
+    if(ticks != 0)
+    {
+        anim_stat.load_permille = (uint32_t)(stat_render_cycles * 1000 / ((uint64_t)ticks * ANIMATION_FRAME_CYCLES));
+    }
+    *stat = anim_stat;
+}
+
+/**
+ * @brief 定时器中断，只记录帧号和时间
+ *
+ */
+static void animation_frame_tick(void)
+{
+    frame_tick_cycles = DWT->CYCCNT;
+    frame_tick ++;
+}
+
+/**
+ * @brief 在当前时间所在的两个关键帧之间插值
+ *
+ */
+static int32_t animation_value(const Animation *anim)
+{
+    const AnimKeyframe *prev;
+    const AnimKeyframe *next;
+    uint32_t span;
+    int32_t t;
+    uint8_t i = 1;
+
+    while(i < anim->key_num && anim->keys[i].time_ms <= anim->time_ms)
+    {
+        i ++;
+    }
+    if(i >= anim->key_num)
+    {
+        return anim->keys[anim->key_num - 1].value;
+    }
+
+    prev = &anim->keys[i - 1];
+    next = &anim->keys[i];
+    span = next->time_ms - prev->time_ms;
+    // 关键帧间隔超过65535ms时乘65536会超出32位
+    t = (int32_t)((uint64_t)(anim->time_ms - prev->time_ms) * ANIMATION_Q16_ONE / span);
+
+    return prev->value + (int32_t)(((int64_t)(next->value - prev->value) * AnimationEase(next->ease, t)) >> 16);
+}
+
+/**
+ * @brief 打印上次调用以来的统计并重新开始统计
+ *
+ */
+static void anim_stat_command(void)
+{
+    AnimationStat stat;
+    uint32_t cycles_per_us = SystemCoreClock / 1000000;
+
+    AnimationGetStat(&stat);
+    elog_i("anim", "%u fps, frames %u, skipped %u, deadline misses %u", ANIMATION_FPS,
+        stat.frames, stat.skipped, stat.deadline_misses);
+    elog_i("anim", "render last %uus, max %uus, budget %uus, latency max %uus, load %u.%u%%",
+        stat.render_cycles_last / cycles_per_us, stat.render_cycles_max / cycles_per_us, ANIMATION_FRAME_MS * 1000,
+        stat.latency_cycles_max / cycles_per_us, stat.load_permille / 10, stat.load_permille % 10);
+
+    memset(&anim_stat, 0, sizeof(anim_stat));
+    stat_render_cycles = 0;
+    stat_start_tick = frame_tick;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "stdint.h"
+
+#define ANIMATION_FPS               50
+#define ANIMATION_FRAME_MS          (1000 / ANIMATION_FPS)
+#define ANIMATION_MAX_NUM           8           // 同时运行的动画数
+
+#define ANIMATION_Q16_ONE           65536       // 缓动函数的输入输出为Q16定点数，0 ... 1
+
+typedef enum __AnimEase
+{
+    AnimEase_Linear = 0,
+    AnimEase_InQuad,
+    AnimEase_OutQuad,
+    AnimEase_InOutCubic,
+    AnimEase_Step,              // 保持前一个关键帧的值，到时间后跳变
+}AnimEase;
+
+/**
+ * @brief 关键帧，ease为从前一个关键帧过渡到本帧使用的缓动，第一个关键帧的time_ms应为0
+ *
+ */
+typedef struct __AnimKeyframe
+{
+    uint16_t time_ms;
+    int32_t value;
+    AnimEase ease;
+}AnimKeyframe;
+
+/**
+ * @brief 每帧把插值结果交给调用者，在主循环里执行
+ *
+ */
+typedef void (*AnimApplyFunc)(int32_t value, void *arg);
+
+typedef struct __AnimationStat
+{
+    uint32_t frames;                // 渲染的帧数
+    uint32_t skipped;               // 主循环来不及处理而跳过的帧数，跳过的帧不渲染，动画按实际时间继续
+    uint32_t deadline_misses;       // 渲染结束时下一帧已经到了
+    uint32_t render_cycles_last;    // 一帧所有动画计算和回调的CPU周期
+    uint32_t render_cycles_max;
+    uint32_t latency_cycles_max;    // 定时器发出一帧到主循环开始渲染的延迟
+    uint32_t load_permille;         // 统计区间内渲染占用的CPU比例，千分之
+}AnimationStat;
+
+int8_t AnimationInit(void);
+
+int8_t AnimationStart(const AnimKeyframe *keys, uint8_t key_num, uint8_t loop, AnimApplyFunc apply, void *arg);
+
+void AnimationStop(int8_t id);
+
+uint8_t AnimationIsRunning(int8_t id);
+
+void AnimationProcess(void);
+
+int32_t AnimationEase(AnimEase ease, int32_t t);
+
+void AnimationGetStat(AnimationStat *stat);
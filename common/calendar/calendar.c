@@ -0,0 +1,327 @@
+/**
+ * @file calendar.c
+ * @brief 公历和时区换算，不查表、不循环，每次换算的耗时是固定的
+ *
+ * 日期和天数互换用三月为年首的算法：闰日落在年末，月份天数用(153 * m + 2) / 5累加，
+ * 400年为一个周期(146097天)，整个过程只有几次整数除法。
+ */
+
+#include "calendar.h"
+#include "stddef.h"
+#include "gd32f30x.h"
+#include "driver.h"
+#include "terminal_com.h"
+#include "elog.h"
+
+#define CALENDAR_DAYS_PER_ERA       146097L     // 400年的天数
+#define CALENDAR_MAX_DAYS           CALENDAR_DAYS(CALENDAR_MAX_YEAR, 12, 31)
+
+// (y + y/4 - y/100 + y/400) % 7为y年12月31日是星期几，12月28日所在的周总是该年最后一周
+#define ISO_DEC31_WEEKDAY(y)        (((y) + (y) / 4 - (y) / 100 + (y) / 400) % 7)
+#define ISO_WEEKS_IN_YEAR(y)        (52 + (ISO_DEC31_WEEKDAY(y) == 4 || ISO_DEC31_WEEKDAY((y) - 1) == 3))
+
+static uint32_t calendar_rule_to_utc(uint16_t year, const DstRule *rule, int32_t offset_min);
+static void calendar_zone_update(TimeZone *zone, uint32_t utc_seconds);
+static void cal_test_command(void);
+
+uint8_t CalendarIsLeapYear(uint16_t year)
+{
+    return CALENDAR_IS_LEAP_YEAR(year);
+}
+
+uint8_t CalendarDaysInMonth(uint16_t year, uint8_t month)
+{
+    if(month == 2)
+        return 28 + CALENDAR_IS_LEAP_YEAR(year);
+    // 七月之前单月31天，八月开始双月31天
+    return 30 + ((month + (month >> 3)) & 1);
+}
+
+/**
+ * @brief 检查时间是否合法且在支持的年份范围内
+ *
+ * @param time
+ * @return int8_t 不合法时返回-1
+ */
+int8_t CalendarCheck(const ClockTime *time)
+{
+    if(time->year < CALENDAR_BASE_YEAR || time->year > CALENDAR_MAX_YEAR ||
+        time->month < 1 || time->month > 12 ||
+        time->day < 1 || time->day > CalendarDaysInMonth(time->year, time->month) ||
+        time->hour > 23 || time->min > 59 || time->sec > 59) {
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief 公历日期转换为自2000-01-01起的天数
+ *
+ */
+int32_t CalendarDaysFromDate(uint16_t year, uint8_t month, uint8_t day)
+{
+    return CALENDAR_DAYS(year, month, day);
+}
+
+/**
+ * @brief 自2000-01-01起的天数转换为公历日期和星期，时分秒不变
+ *
+ * @param days 不能为负数
+ * @param time 传出参数
+ */
+void CalendarDateFromDays(int32_t days, ClockTime *time)
+{
+    uint32_t z = (uint32_t)days + CALENDAR_DAYS_OFFSET;
+    uint32_t era = z / CALENDAR_DAYS_PER_ERA;
+    uint32_t doe = z - era * CALENDAR_DAYS_PER_ERA;                             // 周期内第几天
+    uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;       // 周期内第几年
+    uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);                     // 从三月一日起第几天
+    uint32_t mp = (5 * doy + 2) / 153;                                          // 从三月起第几个月
+
+    time->day = doy - (153 * mp + 2) / 5 + 1;
+    time->month = mp < 10 ? mp + 3 : mp - 9;
+    time->year = yoe + era * 400 + (time->month <= 2);
+    time->week = CALENDAR_WEEKDAY(days);
+}
+
+uint32_t CalendarToSeconds(const ClockTime *time)
+{
+    return CALENDAR_SECONDS(time->year, time->month, time->day, time->hour, time->min, time->sec);
+}
+
+void CalendarFromSeconds(uint32_t seconds, ClockTime *time)
+{
+    uint32_t sec_of_day = seconds % CALENDAR_SECONDS_PER_DAY;
+
+    CalendarDateFromDays(seconds / CALENDAR_SECONDS_PER_DAY, time);
+    time->hour = sec_of_day / 3600;
+    time->min = sec_of_day % 3600 / 60;
+    time->sec = sec_of_day % 60;
+}
+
+/**
+ * @brief ISO 8601周数，周一为一周的第一天，包含该年第一个星期四的那一周是第1周
+ *
+ * @param time 只用到年月日和星期
+ * @param iso_year 传出参数，周数所属的年份，年初年末可能和日历年份不同，不需要时传NULL
+ * @return uint8_t 1 ... 53
+ */
+uint8_t CalendarIsoWeek(const ClockTime *time, uint16_t *iso_year)
+{
+    uint16_t year = time->year;
+    int32_t ordinal = CALENDAR_DAYS(year, time->month, time->day) - CALENDAR_DAYS(year, 1, 1) + 1;
+    int32_t iso_weekday = time->week == 0 ? 7 : time->week;
+    int32_t week = (ordinal - iso_weekday + 10) / 7;
+
+    if(week < 1) {
+        year --;
+        week = ISO_WEEKS_IN_YEAR(year);
+    }
+    else if(week > ISO_WEEKS_IN_YEAR(year)) {
+        year ++;
+        week = 1;
+    }
+
+    if(iso_year != NULL)
+        *iso_year = year;
+
+    return (uint8_t)week;
+}
+
+/**
+ * @brief 某个UTC时刻所在时区的本地时间偏移
+ *
+ * @param zone 会更新其中的缓存
+ * @param utc_seconds
+ * @return int32_t 偏移秒数，本地时间 = UTC + 偏移
+ */
+int32_t CalendarUtcOffset(TimeZone *zone, uint32_t utc_seconds)
+{
+    int32_t offset_min = zone->offset_min;
+
+    if(zone->dst_offset_min == 0)
+        return offset_min * 60;
+
+    if(utc_seconds < zone->cache_begin || utc_seconds >= zone->cache_end)
+        calendar_zone_update(zone, utc_seconds);
+
+    // 按规则的月份区分南北半球，超出范围的年份切换时刻被截断成相等的值时也不会判断错
+    if(zone->dst_start.month < zone->dst_end.month) {
+        if(utc_seconds >= zone->cache_dst_start && utc_seconds < zone->cache_dst_end)
+            offset_min += zone->dst_offset_min;
+    }
+    else {
+        // 南半球夏令时跨年，年初和年末都是夏令时
+        if(utc_seconds >= zone->cache_dst_start || utc_seconds < zone->cache_dst_end)
+            offset_min += zone->dst_offset_min;
+    }
+
+    return offset_min * 60;
+}
+
+/**
+ * @brief UTC秒数转换为本地时间的秒数，结果可以直接交给CalendarFromSeconds
+ *
+ */
+uint32_t CalendarToLocal(TimeZone *zone, uint32_t utc_seconds)
+{
+    return utc_seconds + (uint32_t)CalendarUtcOffset(zone, utc_seconds);
+}
+
+void CalendarInit(void)
+{
+    TerminalCommandRegister("cal_test", &cal_test_command);
+}
+
+/**
+ * @brief 计算某年的切换规则对应的UTC时刻
+ *
+ * @param year
+ * @param rule
+ * @param offset_min 切换前本地时间相对UTC的偏移
+ * @return uint32_t 超出支持的范围时取边界值
+ */
+static uint32_t calendar_rule_to_utc(uint16_t year, const DstRule *rule, int32_t offset_min)
+{
+    int32_t days;
+    int64_t seconds;
+
+    if(rule->week == DST_WEEK_LAST) {
+        days = CALENDAR_DAYS(year, rule->month, CalendarDaysInMonth(year, rule->month));
+        days -= (CALENDAR_WEEKDAY(days) + 7 - rule->weekday) % 7;
+    }
+    else {
+        days = CALENDAR_DAYS(year, rule->month, 1);
+        days += (rule->weekday + 7 - CALENDAR_WEEKDAY(days)) % 7 + (rule->week - 1) * 7;
+    }
+
+    seconds = (int64_t)days * CALENDAR_SECONDS_PER_DAY + ((int32_t)rule->minute - offset_min) * 60;
+    if(seconds < 0)
+        return 0;
+    if(seconds > 0xffffffffLL)
+        return 0xffffffffUL;
+
+    return (uint32_t)seconds;
+}
+
+/**
+ * @brief 重新计算时刻所在年份的夏令时切换时刻
+ *
+ */
+static void calendar_zone_update(TimeZone *zone, uint32_t utc_seconds)
+{
+    ClockTime local;
+    int64_t begin;
+    int64_t end;
+    int64_t local_sec;
+    int32_t offset_sec = zone->offset_min * 60;
+    uint16_t year;
+
+    // 年份按标准时间划分，夏令时的年初年末都不在切换附近
+    // 西半球的时区在2000-01-01零点UTC之后的几个小时里本地时间还是1999年
+    local_sec = (int64_t)utc_seconds + offset_sec;
+    if(local_sec < 0) {
+        year = CALENDAR_BASE_YEAR - 1;
+    }
+    else {
+        CalendarFromSeconds((uint32_t)local_sec, &local);
+        year = local.year;
+    }
+
+    begin = (int64_t)CALENDAR_DAYS(year, 1, 1) * CALENDAR_SECONDS_PER_DAY - offset_sec;
+    end = (int64_t)CALENDAR_DAYS(year + 1, 1, 1) * CALENDAR_SECONDS_PER_DAY - offset_sec;
+    zone->cache_begin = begin < 0 ? 0 : (uint32_t)begin;
+    zone->cache_end = end > 0xffffffffLL ? 0xffffffffUL : (uint32_t)end;
+    zone->cache_dst_start = calendar_rule_to_utc(year, &zone->dst_start, zone->offset_min);
+    zone->cache_dst_end = calendar_rule_to_utc(year, &zone->dst_end, zone->offset_min + zone->dst_offset_min);
+}
+
+/**
+ * @brief 遍历支持范围内的每一天做往返换算校验，并统计每次换算的CPU周期
+ *
+ */
+static void cal_test_command(void)
+{
+    ClockTime time;
+    ClockTime last;
+    TimeZone zone = TIME_ZONE_CENTRAL_EUROPE;
+    int32_t days;
+    uint32_t errors = 0;
+    uint32_t start_cycles;
+    uint64_t to_date_cycles = 0;
+    uint64_t from_date_cycles = 0;
+    uint64_t offset_cycles = 0;
+    uint16_t iso_year;
+    uint8_t iso_week;
+    uint8_t last_iso_week = 52;     // 2000-01-01属于1999年第52周
+
+    CycleCounterEnable();
+
+    last.year = CALENDAR_BASE_YEAR - 1;
+    last.month = 12;
+    last.day = 31;
+    last.week = (CALENDAR_BASE_WEEKDAY + 6) % 7;
+
+    for(days = 0; days <= CALENDAR_MAX_DAYS; days ++) {
+        start_cycles = DWT->CYCCNT;
+        CalendarDateFromDays(days, &time);
+        to_date_cycles += DWT->CYCCNT - start_cycles;
+
+        start_cycles = DWT->CYCCNT;
+        if(CalendarDaysFromDate(time.year, time.month, time.day) != days)
+            errors ++;
+        from_date_cycles += DWT->CYCCNT - start_cycles;
+
+        start_cycles = DWT->CYCCNT;
+        CalendarUtcOffset(&zone, (uint32_t)days * CALENDAR_SECONDS_PER_DAY);
+        offset_cycles += DWT->CYCCNT - start_cycles;
+
+        // 和前一天比较：日期连续、星期连续
+        if(time.week != (last.week + 1) % 7)
+            errors ++;
+        if(time.day == 1) {
+            if(last.day != CalendarDaysInMonth(last.year, last.month) ||
+                time.month != last.month % 12 + 1 || time.year != last.year + (last.month == 12))
+                errors ++;
+        }
+        else if(time.day != last.day + 1 || time.month != last.month || time.year != last.year) {
+            errors ++;
+        }
+
+        // 周数只在周一加一或回到1
+        iso_week = CalendarIsoWeek(&time, &iso_year);
+        if(time.week == 1) {
+            if(iso_week != last_iso_week + 1 && iso_week != 1)
+                errors ++;
+        }
+        else if(iso_week != last_iso_week) {
+            errors ++;
+        }
+        last_iso_week = iso_week;
+
+        last = time;
+    }
+
+    // 2000-01-01是星期六，2024-12-30属于2025年第1周，2020-12-31属于2020年第53周
+    CalendarDateFromDays(0, &time);
+    if(time.week != 6)
+        errors ++;
+    CalendarDateFromDays(CALENDAR_DAYS(2024, 12, 30), &time);
+    if(CalendarIsoWeek(&time, &iso_year) != 1 || iso_year != 2025)
+        errors ++;
+    CalendarDateFromDays(CALENDAR_DAYS(2020, 12, 31), &time);
+    if(CalendarIsoWeek(&time, &iso_year) != 53 || iso_year != 2020)
+        errors ++;
+
+    // 中欧时间2024-03-31 01:00 UTC进入夏令时，2024-10-27 01:00 UTC退出
+    if(CalendarUtcOffset(&zone, CALENDAR_SECONDS(2024, 3, 31, 0, 59, 59)) != 3600 ||
+        CalendarUtcOffset(&zone, CALENDAR_SECONDS(2024, 3, 31, 1, 0, 0)) != 7200 ||
+        CalendarUtcOffset(&zone, CALENDAR_SECONDS(2024, 10, 27, 0, 59, 59)) != 7200 ||
+        CalendarUtcOffset(&zone, CALENDAR_SECONDS(2024, 10, 27, 1, 0, 0)) != 3600)
+        errors ++;
+
+    elog_i("cal", "%d days checked, %u errors", days, errors);
+    elog_i("cal", "cycles to date %u, from date %u, utc offset %u", (uint32_t)(to_date_cycles / days),
+        (uint32_t)(from_date_cycles / days), (uint32_t)(offset_cycles / days));
+}
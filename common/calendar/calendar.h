@@ -0,0 +1,102 @@
+#pragma once
+
+#include "stdint.h"
+
+/*
+ * 时间统一用自2000-01-01 00:00:00起的秒数表示(uint32_t)，支持2000年到2135年，
+ * 天数同样以2000-01-01为第0天。和时区一起使用时秒数表示UTC时间。
+ */
+
+#define CALENDAR_BASE_YEAR          2000
+#define CALENDAR_MAX_YEAR           2135
+#define CALENDAR_BASE_WEEKDAY       6           // 2000-01-01是星期六
+#define CALENDAR_SECONDS_PER_DAY    86400UL
+
+// 0000-03-01到2000-01-01的天数，按三月为一年开始计算时的偏移
+#define CALENDAR_DAYS_OFFSET        730425L
+
+#define CALENDAR_IS_LEAP_YEAR(y)    ((((y) % 4) == 0 && ((y) % 100) != 0) || ((y) % 400) == 0)
+
+/**
+ * @brief 公历日期转换为自2000-01-01起的天数，只有整数运算，参数都是常量时可用于静态初始化
+ *
+ * 把三月当作一年的第一个月，闰日落在年末，月份的天数按(153 * m + 2) / 5累加
+ */
+#define CALENDAR_DAYS(y, m, d)                                                          \
+    ((int32_t)(365L * ((y) - ((m) <= 2)) + ((y) - ((m) <= 2)) / 4 -                     \
+    ((y) - ((m) <= 2)) / 100 + ((y) - ((m) <= 2)) / 400 +                               \
+    (153L * (((m) + 9) % 12) + 2) / 5 + (d) - 1 - CALENDAR_DAYS_OFFSET))
+
+#define CALENDAR_SECONDS(y, mo, d, h, mi, s)                                            \
+    ((uint32_t)CALENDAR_DAYS(y, mo, d) * CALENDAR_SECONDS_PER_DAY +                     \
+    (uint32_t)(h) * 3600 + (uint32_t)(mi) * 60 + (uint32_t)(s))
+
+#define CALENDAR_WEEKDAY(days)      ((uint8_t)(((days) + CALENDAR_BASE_WEEKDAY) % 7))
+
+#define DST_WEEK_LAST               5           // 当月最后一个星期几
+
+typedef struct __ClockTime
+{
+    uint8_t sec;
+    uint8_t min;
+    uint8_t hour;
+    uint8_t week;       // 0：星期日 ... 6：星期六
+    uint8_t day;
+    uint8_t month;
+    uint16_t year;
+}ClockTime;
+
+/**
+ * @brief 夏令时切换规则：某月第几个星期几，切换前的本地时间几点几分
+ *
+ */
+typedef struct __DstRule
+{
+    uint8_t month;      // 1 ... 12
+    uint8_t week;       // 1 ... 4，DST_WEEK_LAST表示最后一个
+    uint8_t weekday;    // 0：星期日 ... 6：星期六
+    uint16_t minute;    // 切换前的本地时间，自零点起的分钟数
+}DstRule;
+
+typedef struct __TimeZone
+{
+    int16_t offset_min;         // 标准时间相对UTC的偏移
+    int16_t dst_offset_min;     // 夏令时额外的偏移，为0表示不使用夏令时
+    DstRule dst_start;
+    DstRule dst_end;
+
+    // 缓存当年的切换时刻，时间还在缓存的年份里时不用重新计算，全部为0表示没有缓存
+    uint32_t cache_begin;       // 缓存年份开始和结束的UTC秒数(按标准时间)
+    uint32_t cache_end;
+    uint32_t cache_dst_start;   // 当年夏令时开始和结束的UTC秒数
+    uint32_t cache_dst_end;
+}TimeZone;
+
+// 中国标准时间，不使用夏令时
+#define TIME_ZONE_CHINA             {8 * 60, 0, {0, 0, 0, 0}, {0, 0, 0, 0}, 0, 0, 0, 0}
+// 中欧时间，三月最后一个星期日02:00到十月最后一个星期日03:00
+#define TIME_ZONE_CENTRAL_EUROPE    {1 * 60, 60, {3, DST_WEEK_LAST, 0, 2 * 60}, {10, DST_WEEK_LAST, 0, 3 * 60}, 0, 0, 0, 0}
+// 美国东部时间，三月第二个星期日02:00到十一月第一个星期日02:00
+#define TIME_ZONE_US_EASTERN        {-5 * 60, 60, {3, 2, 0, 2 * 60}, {11, 1, 0, 2 * 60}, 0, 0, 0, 0}
+
+uint8_t CalendarIsLeapYear(uint16_t year);
+
+uint8_t CalendarDaysInMonth(uint16_t year, uint8_t month);
+
+int8_t CalendarCheck(const ClockTime *time);
+
+int32_t CalendarDaysFromDate(uint16_t year, uint8_t month, uint8_t day);
+
+void CalendarDateFromDays(int32_t days, ClockTime *time);
+
+uint32_t CalendarToSeconds(const ClockTime *time);
+
+void CalendarFromSeconds(uint32_t seconds, ClockTime *time);
+
+uint8_t CalendarIsoWeek(const ClockTime *time, uint16_t *iso_year);
+
+int32_t CalendarUtcOffset(TimeZone *zone, uint32_t utc_seconds);
+
+uint32_t CalendarToLocal(TimeZone *zone, uint32_t utc_seconds);
+
+void CalendarInit(void);
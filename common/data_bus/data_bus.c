@@ -0,0 +1,323 @@
+/**
+ * @file data_bus.c
+ * @brief 按主题发布订阅传感器数据
+ *
+ * 每个主题只保存最新的一个值和一个序号锁：发布者关中断写入，序号前后各加一，
+ * 可以在中断里发布；读取者不关中断，读到的序号为奇数或前后不一致时重读。
+ * 发布只置一个主题位，订阅者在主循环的DataBusProcess里被通知：
+ * 和上次通知的值相差不到死区的变化被过滤，通知间隔小于限速时推迟到间隔满了再通知最新值。
+ * 订阅表是固定大小的数组，不动态分配。
+ */
+
+#include "data_bus.h"
+#include "stddef.h"
+#include "string.h"
+#include "gd32f30x.h"
+#include "system_timer.h"
+#include "terminal_com.h"
+#include "elog.h"
+
+typedef struct __DataTopicSlot
+{
+    volatile uint32_t lock;         // 奇数表示正在写入
+    DataSample sample;
+}DataTopicSlot;
+
+typedef struct __DataSubscriber
+{
+    DataBusFunc func;
+    void *arg;
+    float deadband;
+    uint32_t min_interval_ms;
+    DataSample last;                // 上次通知的值，sequence为0表示还没有通知过
+    uint32_t last_ms;
+    DataTopic topic;
+    uint8_t pending;                // 有变化但被限速推迟
+}DataSubscriber;
+
+static const DataType topic_type[DataTopic_Num] = {
+    DataType_Float, DataType_Float, DataType_Float, DataType_Float, DataType_Int, DataType_Int
+};
+
+static const char * const topic_name[DataTopic_Num] = {
+    "temperature", "humidity", "illuminance", "illuminance_opt", "vin_mv", "chip_temp"
+};
+
+static DataTopicSlot topics[DataTopic_Num];
+static DataSubscriber subscribers[DATA_BUS_MAX_SUBSCRIBERS];
+static volatile uint32_t topic_dirty = 0;
+static uint8_t pending_num = 0;
+static DataBusStat bus_stat;
+
+static int8_t data_bus_publish(DataTopic topic, const DataSample *sample);
+static float data_bus_delta(const DataSample *a, const DataSample *b);
+static void bus_stat_command(void);
+
+void DataBusInit(void)
+{
+    uint8_t i;
+
+    memset(topics, 0, sizeof(topics));
+    memset(subscribers, 0, sizeof(subscribers));
+    memset(&bus_stat, 0, sizeof(bus_stat));
+    for(i = 0; i < DataTopic_Num; i ++)
+    {
+        topics[i].sample.type = topic_type[i];
+    }
+
+    TerminalCommandRegister("bus_stat", &bus_stat_command);
+}
+
+DataType DataBusType(DataTopic topic)
+{
+    return topic_type[topic];
+}
+
+/**
+ * @brief 发布一个浮点值，可以在中断里调用
+ *
+ * @return int8_t 主题不存在或类型不是float时返回-1
+ */
+int8_t DataBusPublishFloat(DataTopic topic, float value)
+{
+    DataSample sample;
+
+    if(topic >= DataTopic_Num || topic_type[topic] != DataType_Float)
+    {
+        return -1;
+    }
+    sample.type = DataType_Float;
+    sample.value.f = value;
+    return data_bus_publish(topic, &sample);
+}
+
+/**
+ * @brief 发布一个整数值，可以在中断里调用
+ *
+ * @return int8_t 主题不存在或类型不是int时返回-1
+ */
+int8_t DataBusPublishInt(DataTopic topic, int32_t value)
+{
+    DataSample sample;
+
+    if(topic >= DataTopic_Num || topic_type[topic] != DataType_Int)
+    {
+        return -1;
+    }
+    sample.type = DataType_Int;
+    sample.value.i = value;
+    return data_bus_publish(topic, &sample);
+}
+
+/**
+ * @brief 读主题的最新值，不关中断，写入期间读到的结果会被丢弃重读
+ *
+ * @return int8_t 还没有发布过时返回-1
+ */
+int8_t DataBusGet(DataTopic topic, DataSample *sample)
+{
+    DataTopicSlot *slot;
+    uint32_t lock;
+
+    if(topic >= DataTopic_Num || sample == NULL)
+    {
+        return -1;
+    }
+
+    slot = &topics[topic];
+    do
+    {
+        lock = slot->lock;
+        __DMB();
+        *sample = slot->sample;
+        __DMB();
+    }while((lock & 1) != 0 || lock != slot->lock);
+
+    return sample->sequence == 0 ? -1 : 0;
+}
+
+/**
+ * @brief 订阅一个主题，第一次发布或订阅时已有值时立即通知
+ *
+ * @param topic
+ * @param deadband 和上次通知的值相差不小于这个值才通知，为0时每次发布都通知
+ * @param min_interval_ms 两次通知的最小间隔，为0不限速
+ * @param func
+ * @param arg 原样传给func
+ * @return int8_t 订阅编号，订阅表满时返回-1
+ */
+int8_t DataBusSubscribe(DataTopic topic, float deadband, uint32_t min_interval_ms, DataBusFunc func, void *arg)
+{
+    DataSubscriber *sub;
+    int8_t id;
+
+    if(topic >= DataTopic_Num || func == NULL || deadband < 0)
+    {
+        return -1;
+    }
+
+    for(id = 0; id < DATA_BUS_MAX_SUBSCRIBERS; id ++)
+    {
+        sub = &subscribers[id];
+        if(sub->func == NULL)
+        {
+            memset(sub, 0, sizeof(DataSubscriber));
+            sub->topic = topic;
+            sub->deadband = deadband;
+            sub->min_interval_ms = min_interval_ms;
+            sub->arg = arg;
+            sub->func = func;
+            // 已经有值的主题在下一次DataBusProcess里通知
+            sub->pending = 1;
+            pending_num ++;
+            return id;
+        }
+    }
+
+    return -1;
+}
+
+void DataBusUnsubscribe(int8_t id)
+{
+    if(id < 0 || id >= DATA_BUS_MAX_SUBSCRIBERS)
+        return;
+    subscribers[id].func = NULL;
+}
+
+/**
+ * @brief 主循环里调用，没有新发布也没有推迟的通知时直接返回
+ *
+ */
+void DataBusProcess(void)
+{
+    DataSubscriber *sub;
+    DataSample sample;
+    uint32_t primask;
+    uint32_t dirty;
+    uint32_t now;
+    uint8_t pending = 0;
+    uint8_t was_pending;
+    uint8_t i;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    dirty = topic_dirty;
+    topic_dirty = 0;
+    __set_PRIMASK(primask);
+
+    if(dirty == 0 && pending_num == 0)
+    {
+        return;
+    }
+
+    now = (uint32_t)GetSystemTimer_ms();
+    for(i = 0; i < DATA_BUS_MAX_SUBSCRIBERS; i ++)
+    {
+        sub = &subscribers[i];
+        if(sub->func == NULL)
+            continue;
+        if((dirty & (1UL << sub->topic)) == 0 && sub->pending == 0)
+            continue;
+
+        was_pending = sub->pending;
+        sub->pending = 0;
+        if(DataBusGet(sub->topic, &sample) != 0 || sample.sequence == sub->last.sequence)
+            continue;
+
+        if(sub->last.sequence != 0)
+        {
+            if(data_bus_delta(&sample, &sub->last) < sub->deadband)
+            {
+                bus_stat.filtered ++;
+                continue;
+            }
+            if(now - sub->last_ms < sub->min_interval_ms)
+            {
+                // 间隔满了以后通知那时的最新值，等待期间每轮都会走到这里，只在开始推迟时计数
+                if(was_pending == 0)
+                    bus_stat.deferred ++;
+                sub->pending = 1;
+                pending ++;
+                continue;
+            }
+        }
+
+        sub->last = sample;
+        sub->last_ms = now;
+        bus_stat.delivered ++;
+        sub->func(sub->topic, &sample, sub->arg);
+    }
+    pending_num = pending;
+}
+
+void DataBusGetStat(DataBusStat *stat)
+{
+    *stat = bus_stat;
+}
+
+static int8_t data_bus_publish(DataTopic topic, const DataSample *sample)
+{
+    DataTopicSlot *slot = &topics[topic];
+    uint32_t timestamp = (uint32_t)GetSystemTimer_ms();
+    uint32_t primask;
+
+    // 关中断只为了让不同优先级的发布者互斥，读取者靠lock检测写入
+    primask = __get_PRIMASK();
+    __disable_irq();
+    slot->lock ++;
+    __DMB();
+    slot->sample.value = sample->value;
+    slot->sample.timestamp_ms = timestamp;
+    slot->sample.sequence ++;
+    __DMB();
+    slot->lock ++;
+    topic_dirty |= 1UL << topic;
+    bus_stat.published ++;
+    __set_PRIMASK(primask);
+
+    return 0;
+}
+
+/**
+ * @brief 两个同类型值之差的绝对值
+ *
+ */
+static float data_bus_delta(const DataSample *a, const DataSample *b)
+{
+    float delta;
+
+    if(a->type == DataType_Float)
+        delta = a->value.f - b->value.f;
+    else
+        delta = (float)(a->value.i - b->value.i);
+
+    return delta < 0 ? -delta : delta;
+}
+
+/**
+ * @brief 打印各主题的最新值和通知统计
+ *
+ */
+static void bus_stat_command(void)
+{
+    DataSample sample;
+    uint8_t i;
+
+    for(i = 0; i < DataTopic_Num; i ++)
+    {
+        if(DataBusGet((DataTopic)i, &sample) != 0)
+        {
+            elog_i("bus", "%s: none", topic_name[i]);
+        }
+        else if(sample.type == DataType_Float)
+        {
+            elog_i("bus", "%s: %.2f at %ums, seq %u", topic_name[i], sample.value.f, sample.timestamp_ms, sample.sequence);
+        }
+        else
+        {
+            elog_i("bus", "%s: %d at %ums, seq %u", topic_name[i], sample.value.i, sample.timestamp_ms, sample.sequence);
+        }
+    }
+    elog_i("bus", "published %u, delivered %u, filtered %u, deferred %u", bus_stat.published,
+        bus_stat.delivered, bus_stat.filtered, bus_stat.deferred);
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "stdint.h"
+
+#define DATA_BUS_MAX_SUBSCRIBERS    16
+
+typedef enum __DataTopic
+{
+    DataTopic_Temperature = 0,      // 环境温度，度，float
+    DataTopic_Humidity,             // 相对湿度，%，float
+    DataTopic_Illuminance,          // BH1750光照度，lux，float
+    DataTopic_IlluminanceOpt3001,   // OPT3001光照度，lux，float
+    DataTopic_SupplyVoltage,        // 供电电压，mV，int
+    DataTopic_ChipTemperature,      // 芯片温度，0.1度，int
+    DataTopic_Num,
+}DataTopic;
+
+typedef enum __DataType
+{
+    DataType_Float = 0,
+    DataType_Int,
+}DataType;
+
+typedef struct __DataSample
+{
+    DataType type;
+    union
+    {
+        float f;
+        int32_t i;
+    }value;
+    uint32_t timestamp_ms;          // 发布时的系统时间
+    uint32_t sequence;              // 该主题发布的次数，0表示还没有发布过
+}DataSample;
+
+/**
+ * @brief 订阅者回调，在主循环的DataBusProcess里调用
+ *
+ */
+typedef void (*DataBusFunc)(DataTopic topic, const DataSample *sample, void *arg);
+
+typedef struct __DataBusStat
+{
+    uint32_t published;
+    uint32_t delivered;             // 交给订阅者的次数
+    uint32_t filtered;              // 变化小于死区而没有通知的次数
+    uint32_t deferred;              // 因为限速推迟的通知数，推迟期间的多次检查只算一次
+}DataBusStat;
+
+void DataBusInit(void);
+
+DataType DataBusType(DataTopic topic);
+
+int8_t DataBusPublishFloat(DataTopic topic, float value);
+
+int8_t DataBusPublishInt(DataTopic topic, int32_t value);
+
+int8_t DataBusGet(DataTopic topic, DataSample *sample);
+
+int8_t DataBusSubscribe(DataTopic topic, float deadband, uint32_t min_interval_ms, DataBusFunc func, void *arg);
+
+void DataBusUnsubscribe(int8_t id);
+
+void DataBusProcess(void);
+
+void DataBusGetStat(DataBusStat *stat);
@@ -31,7 +31,7 @@
 #include "elog.h"
 #include <string.h>
 #include <stdarg.h>
-#include <stdio.h>
+#include "gd32f30x.h"
 
 #if !defined(ELOG_OUTPUT_LVL)
     #error "Please configure static output log level (in elog_cfg.h)"
@@ -57,11 +57,23 @@
     #error "Please configure output newline sign (in elog_cfg.h)"
 #endif
 
+#if !defined(ELOG_TAG_MAX_NUM) || ELOG_TAG_MAX_NUM > 254
+    #error "Please configure interned tag max number, no more than 254 (in elog_cfg.h)"
+#endif
+
+#if !defined(ELOG_LINE_BUF_NEST_NUM)
+    #error "Please configure line buffer number for nested contexts (in elog_cfg.h)"
+#endif
+
 /* output filter's tag level max num */
 #ifndef ELOG_FILTER_TAG_LVL_MAX_NUM
 #define ELOG_FILTER_TAG_LVL_MAX_NUM          4
 #endif
 
+#if defined(ELOG_RATE_LIMIT_ENABLE) && (ELOG_RATE_LIMIT_PER_SEC > 255 || ELOG_RATE_LIMIT_BURST > 255)
+    #error "ELOG_RATE_LIMIT_PER_SEC and ELOG_RATE_LIMIT_BURST must be no more than 255"
+#endif
+
 #ifdef ELOG_COLOR_ENABLE
 /**
  * CSI(Control Sequence Introducer/Initiator) sign
@@ -116,8 +128,16 @@
 
 /* EasyLogger object */
 static EasyLogger elog;
-/* every line log's buffer */
-static char log_buf[ELOG_LINE_BUF_SIZE] = { 0 };
+/* every line log's buffer, one for each nested context: main loop and interrupts */
+static char line_buf[ELOG_LINE_BUF_NEST_NUM][ELOG_LINE_BUF_SIZE] = { 0 };
+/* line buffers in use, interrupts nest so they are taken and given back like a stack */
+static volatile uint32_t line_buf_used = 0;
+/* pass level of every interned tag, logs below it are output. id 0 is a call site that has
+ * not interned its tag yet (or the table is full), it always goes to the full check */
+uint8_t elog_tag_pass[ELOG_TAG_MAX_NUM + 1] = { 0xFF };
+/* interned tag names, the strings are the callers' literals */
+static const char *tag_name[ELOG_TAG_MAX_NUM + 1];
+static volatile uint8_t tag_num = 0;
 /* level output info */
 static const char *level_output_info[] = {
         [ELOG_LVL_ASSERT]  = "A/",
@@ -140,7 +160,58 @@ static const char *color_output_info[] = {
 };
 #endif /* ELOG_COLOR_ENABLE */
 
+#ifdef ELOG_RATE_LIMIT_ENABLE
+/* one log in a token bucket, tokens are microseconds times logs per second */
+#define RATE_TOKEN_ONE                 1000000UL
+
+/* token bucket of a tag */
+typedef struct {
+    uint32_t tokens;
+    uint32_t last_us;
+    uint32_t limited;
+    uint8_t per_sec;
+    uint8_t burst;
+} ElogRate;
+
+/* bucket of every interned tag, id 0 is shared by tags which are not interned */
+static ElogRate tag_rate[ELOG_TAG_MAX_NUM + 1];
+#endif /* ELOG_RATE_LIMIT_ENABLE */
+
+#ifdef ELOG_REPEAT_SUPPRESS_ENABLE
+/* FNV-1a offset basis */
+#define REPEAT_HASH_INIT               2166136261UL
+
+/* the last log, the same log after it is counted instead of output */
+static struct {
+    uint32_t hash;
+    const char *tag;
+    uint8_t level;
+    uint32_t count;
+    uint32_t time;      /* timestamp of the last log of the run */
+} repeat_run;
+/* logs suppressed since power on */
+static uint32_t repeat_suppressed = 0;
+#endif /* ELOG_REPEAT_SUPPRESS_ENABLE */
+
 static bool get_fmt_enabled(uint8_t level, size_t set);
+static char *line_buf_take(void);
+static uint8_t tag_pass_level(const char *tag);
+static void tag_pass_update(void);
+static void elog_voutput(uint8_t level, uint8_t tag_id, const char *tag, const char *file, const char *func,
+        const long line, const char *format, va_list args);
+static void line_buf_give(void);
+static size_t fmt_text_len(int fmt_result, size_t size);
+#if defined(ELOG_BIN_OUTPUT_ENABLE) && defined(ELOG_BUF_OUTPUT_ENABLE)
+static void bin_output_text(const ElogBinSite *site, const uint32_t *args, uint8_t nargs);
+#endif
+#ifdef ELOG_RATE_LIMIT_ENABLE
+static bool rate_take(uint8_t tag_id, uint8_t level);
+#endif
+#ifdef ELOG_REPEAT_SUPPRESS_ENABLE
+static uint32_t repeat_hash(uint32_t hash, const void *data, size_t size);
+static bool repeat_check(uint32_t hash, uint8_t level, const char *tag);
+static void repeat_report(uint8_t level, const char *tag, uint32_t count);
+#endif
 static void elog_set_filter_tag_lvl_default(void);
 
 /* EasyLogger assert hook */
@@ -178,6 +249,13 @@ ElogErrCode elog_init(void) {
     }
 #endif
 
+#ifdef ELOG_FLASH_ENABLE
+    result = elog_flash_init();
+    if (result != ELOG_NO_ERR) {
+        return result;
+    }
+#endif
+
     /* enable the output lock */
     elog_output_lock_enabled(true);
     /* output locked status initialize */
@@ -195,6 +273,11 @@ ElogErrCode elog_init(void) {
     /* set tag_level to default val */
     elog_set_filter_tag_lvl_default();
 
+#ifdef ELOG_RATE_LIMIT_ENABLE
+    /* every tag gets the default bucket */
+    elog_set_rate_limit(NULL, ELOG_RATE_LIMIT_PER_SEC, ELOG_RATE_LIMIT_BURST);
+#endif
+
     elog.init_ok = true;
 
     return result;
@@ -275,6 +358,7 @@ void elog_set_output_enabled(bool enabled) {
     ELOG_ASSERT((enabled == false) || (enabled == true));
 
     elog.output_enabled = enabled;
+    tag_pass_update();
 }
 
 #ifdef ELOG_COLOR_ENABLE
@@ -342,6 +426,7 @@ void elog_set_filter_lvl(uint8_t level) {
     ELOG_ASSERT(level <= ELOG_LVL_VERBOSE);
 
     elog.filter.level = level;
+    tag_pass_update();
 }
 
 /**
@@ -351,6 +436,7 @@ void elog_set_filter_lvl(uint8_t level) {
  */
 void elog_set_filter_tag(const char *tag) {
     strncpy(elog.filter.tag, tag, ELOG_FILTER_TAG_MAX_LEN);
+    tag_pass_update();
 }
 
 /**
@@ -461,6 +547,7 @@ void elog_set_filter_tag_lvl(const char *tag, uint8_t level)
         }
     }
     elog_output_unlock();
+    tag_pass_update();
 }
 
 /**
@@ -505,11 +592,15 @@ void elog_raw(const char *format, ...) {
     va_list args;
     size_t log_len = 0;
     int fmt_result;
+    char *log_buf;
 
     /* check output enabled */
     if (!elog.output_enabled) {
         return;
     }
+    if ((log_buf = line_buf_take()) == NULL) {
+        return;
+    }
 
     /* args point to the first variable parameter */
     va_start(args, format);
@@ -518,7 +609,7 @@ void elog_raw(const char *format, ...) {
     elog_output_lock();
 
     /* package log data to buffer */
-    fmt_result = vsnprintf(log_buf, ELOG_LINE_BUF_SIZE, format, args);
+    fmt_result = elog_vsnprintf(log_buf, ELOG_LINE_BUF_SIZE, format, args);
 
     /* output converted log */
     if ((fmt_result > -1) && (fmt_result <= ELOG_LINE_BUF_SIZE)) {
@@ -532,13 +623,14 @@ void elog_raw(const char *format, ...) {
     /* raw log will using assert level */
     elog_async_output(ELOG_LVL_ASSERT, log_buf, log_len);
 #elif defined(ELOG_BUF_OUTPUT_ENABLE)
-    extern void elog_buf_output(const char *log, size_t size);
-    elog_buf_output(log_buf, log_len);
+    extern void elog_buf_output(uint8_t level, const char *tag, const char *log, size_t size);
+    elog_buf_output(ELOG_LVL_ASSERT, "", log_buf, log_len);
 #else
     elog_port_output(log_buf, log_len);
 #endif
     /* unlock output */
     elog_output_unlock();
+    line_buf_give();
 
     va_end(args);
 }
@@ -557,30 +649,261 @@ void elog_raw(const char *format, ...) {
  */
 void elog_output(uint8_t level, const char *tag, const char *file, const char *func,
         const long line, const char *format, ...) {
-    extern const char *elog_port_get_time(void);
+    va_list args;
+    uint8_t tag_id = elog_tag_intern(tag);
+
+    if (level >= (tag_id != 0 ? elog_tag_pass[tag_id] : tag_pass_level(tag))) {
+        return;
+    }
+    /* args point to the first variable parameter */
+    va_start(args, format);
+    elog_voutput(level, tag_id, tag, file, func, line, format, args);
+    va_end(args);
+}
+
+/**
+ * output the log from elog_x macros, the call site keeps the interned tag id,
+ * the macro has already checked the level when the id is known
+ *
+ * @param tag_id call site's tag id, 0 when it is not interned yet
+ * @see elog_output
+ */
+void elog_output_id(uint8_t *tag_id, uint8_t level, const char *tag, const char *file, const char *func,
+        const long line, const char *format, ...) {
+    va_list args;
+
+    if (*tag_id == 0) {
+        *tag_id = elog_tag_intern(tag);
+        if (level >= (*tag_id != 0 ? elog_tag_pass[*tag_id] : tag_pass_level(tag))) {
+            return;
+        }
+    }
+    /* args point to the first variable parameter */
+    va_start(args, format);
+    elog_voutput(level, *tag_id, tag, file, func, line, format, args);
+    va_end(args);
+}
+
+/**
+ * intern the tag, the same string always gets the same id.
+ * it can be called from any interrupt, interrupts are disabled only to add a new tag.
+ *
+ * @param tag tag, must be a string that never changes (normally a literal)
+ *
+ * @return tag id, 0 when the tag table is full
+ */
+uint8_t elog_tag_intern(const char *tag) {
+    uint32_t primask;
+    uint8_t id;
+
+    ELOG_ASSERT(tag != NULL);
+
+    for (id = 1; id <= tag_num; id++) {
+        if (tag_name[id] == tag || !strcmp(tag_name[id], tag)) {
+            return id;
+        }
+    }
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    /* an interrupt may have added tags after the search above */
+    for (; id <= tag_num; id++) {
+        if (!strcmp(tag_name[id], tag)) {
+            __set_PRIMASK(primask);
+            return id;
+        }
+    }
+    if (tag_num < ELOG_TAG_MAX_NUM) {
+        /* the pass level is ready before other contexts can find the tag */
+        tag_name[id] = tag;
+        elog_tag_pass[id] = tag_pass_level(tag);
+        tag_num = id;
+    } else {
+        /* table full, the tag is checked by name on every log */
+        id = 0;
+    }
+    __set_PRIMASK(primask);
+
+    return id;
+}
+
+/**
+ * get interned tags number, ids are 1 ... number
+ *
+ * @return tags number
+ */
+uint8_t elog_tag_get_num(void) {
+    return tag_num;
+}
+
+/**
+ * get interned tag's name
+ *
+ * @param tag_id tag id
+ *
+ * @return tag name, NULL when the id is not used
+ */
+const char *elog_tag_get_name(uint8_t tag_id) {
+    if (tag_id == 0 || tag_id > tag_num) {
+        return NULL;
+    }
+    return tag_name[tag_id];
+}
+
+#ifdef ELOG_RATE_LIMIT_ENABLE
+/**
+ * set the rate limit of a tag, logs beyond its token bucket are dropped and counted.
+ * a tag must be interned (logged once) before it can get its own limit.
+ *
+ * @param tag tag, NULL for all tags and the tags interned later
+ * @param per_sec logs per second, 0: no limit
+ * @param burst logs which can be output at once after a quiet time
+ *
+ * @return false: the tag is not interned
+ */
+bool elog_set_rate_limit(const char *tag, uint8_t per_sec, uint8_t burst) {
+    uint32_t primask;
+    uint8_t id, first = 0, last = ELOG_TAG_MAX_NUM;
+
+    if (tag != NULL) {
+        for (id = 1; id <= tag_num && strcmp(tag_name[id], tag); id++);
+        if (id > tag_num) {
+            return false;
+        }
+        first = last = id;
+    }
+    if (burst == 0) {
+        burst = 1;
+    }
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    for (id = first; id <= last; id++) {
+        tag_rate[id].per_sec = per_sec;
+        tag_rate[id].burst = burst;
+        tag_rate[id].tokens = burst * RATE_TOKEN_ONE;
+    }
+    __set_PRIMASK(primask);
+
+    return true;
+}
+
+/**
+ * get the rate limit of an interned tag and the logs it has dropped
+ *
+ * @param tag_id tag id, 0: tags which are not interned
+ * @param per_sec logs per second
+ * @param burst burst logs
+ *
+ * @return logs dropped by the limit
+ */
+uint32_t elog_get_rate_limit(uint8_t tag_id, uint8_t *per_sec, uint8_t *burst) {
+    ELOG_ASSERT(tag_id <= ELOG_TAG_MAX_NUM);
+
+    *per_sec = tag_rate[tag_id].per_sec;
+    *burst = tag_rate[tag_id].burst;
+
+    return tag_rate[tag_id].limited;
+}
+#endif /* ELOG_RATE_LIMIT_ENABLE */
+
+#ifdef ELOG_REPEAT_SUPPRESS_ENABLE
+/**
+ * get the number of repeated logs which were counted instead of output
+ *
+ * @return suppressed logs
+ */
+uint32_t elog_get_repeat_suppressed(void) {
+    return repeat_suppressed;
+}
+
+/**
+ * report a run of repeats that has stopped, otherwise it is only reported when
+ * the next different log comes. call it from the main loop.
+ * the next log is output again even when it is the same as the run.
+ */
+void elog_repeat_flush(void) {
+    extern uint32_t elog_port_get_timestamp(void);
+
+    uint32_t primask, count;
+    const char *tag;
+    uint8_t level;
+
+    if (repeat_run.count == 0) {
+        return;
+    }
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    if (repeat_run.count == 0 || elog_port_get_timestamp() - repeat_run.time < ELOG_REPEAT_FLUSH_MS * 1000UL) {
+        __set_PRIMASK(primask);
+        return;
+    }
+    count = repeat_run.count;
+    level = repeat_run.level;
+    tag = repeat_run.tag;
+    repeat_run.count = 0;
+    repeat_run.tag = NULL;
+    __set_PRIMASK(primask);
+
+    repeat_report(level, tag, count);
+}
+#endif /* ELOG_REPEAT_SUPPRESS_ENABLE */
+
+/**
+ * calculate the pass level of a tag from output enabled, level, tag level and tag filters
+ *
+ * @param tag tag
+ *
+ * @return logs below the level are output, 0: no log is output
+ */
+static uint8_t tag_pass_level(const char *tag) {
+    uint8_t level = elog.filter.level;
+    uint8_t tag_level = elog_get_filter_tag_lvl(tag);
+
+    if (!elog.output_enabled || !strstr(tag, elog.filter.tag)) {
+        return 0;
+    }
+    if (tag_level < level) {
+        level = tag_level;
+    }
+    return level + 1;
+}
+
+/**
+ * update all interned tags after a filter is changed
+ */
+static void tag_pass_update(void) {
+    uint8_t id;
+
+    for (id = 1; id <= tag_num; id++) {
+        elog_tag_pass[id] = tag_pass_level(tag_name[id]);
+    }
+}
+
+/**
+ * format and output the log, filters except keyword have been checked
+ */
+static void elog_voutput(uint8_t level, uint8_t tag_id, const char *tag, const char *file, const char *func,
+        const long line, const char *format, va_list args) {
+    extern size_t elog_port_get_time(char *time, size_t size);
     extern const char *elog_port_get_p_info(void);
     extern const char *elog_port_get_t_info(void);
 
     size_t tag_len = strlen(tag), log_len = 0, newline_len = strlen(ELOG_NEWLINE_SIGN);
     char line_num[ELOG_LINE_NUM_MAX_LEN + 1] = { 0 };
     char tag_sapce[ELOG_FILTER_TAG_MAX_LEN / 2 + 1] = { 0 };
-    va_list args;
     int fmt_result;
+    char *log_buf;
+#ifdef ELOG_REPEAT_SUPPRESS_ENABLE
+    size_t body_start;
+#endif
 
     ELOG_ASSERT(level <= ELOG_LVL_VERBOSE);
 
-    /* check output enabled */
-    if (!elog.output_enabled) {
+    if ((log_buf = line_buf_take()) == NULL) {
         return;
     }
-    /* level filter */
-    if (level > elog.filter.level || level > elog_get_filter_tag_lvl(tag)) {
-        return;
-    } else if (!strstr(tag, elog.filter.tag)) { /* tag filter */
-        return;
-    }
-    /* args point to the first variable parameter */
-    va_start(args, format);
     /* lock output */
     elog_output_lock();
 
@@ -611,7 +934,7 @@ void elog_output(uint8_t level, const char *tag, const char *file, const char *f
         log_len += elog_strcpy(log_len, log_buf + log_len, "[");
         /* package time info */
         if (get_fmt_enabled(level, ELOG_FMT_TIME)) {
-            log_len += elog_strcpy(log_len, log_buf + log_len, elog_port_get_time());
+            log_len += elog_port_get_time(log_buf + log_len, ELOG_LINE_BUF_SIZE - log_len);
             if (get_fmt_enabled(level, ELOG_FMT_P_INFO | ELOG_FMT_T_INFO)) {
                 log_len += elog_strcpy(log_len, log_buf + log_len, " ");
             }
@@ -643,7 +966,7 @@ void elog_output(uint8_t level, const char *tag, const char *file, const char *f
         }
         /* package line info */
         if (get_fmt_enabled(level, ELOG_FMT_LINE)) {
-            snprintf(line_num, ELOG_LINE_NUM_MAX_LEN, "%ld", line);
+            elog_snprintf(line_num, ELOG_LINE_NUM_MAX_LEN, "%ld", line);
             log_len += elog_strcpy(log_len, log_buf + log_len, line_num);
             if (get_fmt_enabled(level, ELOG_FMT_FUNC)) {
                 log_len += elog_strcpy(log_len, log_buf + log_len, " ");
@@ -656,10 +979,11 @@ void elog_output(uint8_t level, const char *tag, const char *file, const char *f
         }
         log_len += elog_strcpy(log_len, log_buf + log_len, ")");
     }
-    /* package other log data to buffer. '\0' must be added in the end by vsnprintf. */
-    fmt_result = vsnprintf(log_buf + log_len, ELOG_LINE_BUF_SIZE - log_len, format, args);
-
-    va_end(args);
+    /* package other log data to buffer. '\0' must be added in the end by elog_vsnprintf. */
+#ifdef ELOG_REPEAT_SUPPRESS_ENABLE
+    body_start = log_len;
+#endif
+    fmt_result = elog_vsnprintf(log_buf + log_len, ELOG_LINE_BUF_SIZE - log_len, format, args);
     /* calculate log length */
     if ((log_len + fmt_result <= ELOG_LINE_BUF_SIZE) && (fmt_result > -1)) {
         log_len += fmt_result;
@@ -690,9 +1014,26 @@ void elog_output(uint8_t level, const char *tag, const char *file, const char *f
         if (!strstr(log_buf, elog.filter.keyword)) {
             /* unlock output */
             elog_output_unlock();
+            line_buf_give();
             return;
         }
     }
+#ifdef ELOG_REPEAT_SUPPRESS_ENABLE
+    /* the message without its header is the same while a log repeats */
+    if (repeat_check(repeat_hash(REPEAT_HASH_INIT, log_buf + body_start, log_len > body_start ? log_len - body_start : 0),
+            level, tag)) {
+        elog_output_unlock();
+        line_buf_give();
+        return;
+    }
+#endif
+#ifdef ELOG_RATE_LIMIT_ENABLE
+    if (!rate_take(tag_id, level)) {
+        elog_output_unlock();
+        line_buf_give();
+        return;
+    }
+#endif
 
 #ifdef ELOG_COLOR_ENABLE
     /* add CSI end sign */
@@ -708,13 +1049,14 @@ void elog_output(uint8_t level, const char *tag, const char *file, const char *f
     extern void elog_async_output(uint8_t level, const char *log, size_t size);
     elog_async_output(level, log_buf, log_len);
 #elif defined(ELOG_BUF_OUTPUT_ENABLE)
-    extern void elog_buf_output(const char *log, size_t size);
-    elog_buf_output(log_buf, log_len);
+    extern void elog_buf_output(uint8_t level, const char *tag, const char *log, size_t size);
+    elog_buf_output(level, tag, log_buf, log_len);
 #else
     elog_port_output(log_buf, log_len);
 #endif
     /* unlock output */
     elog_output_unlock();
+    line_buf_give();
 }
 
 /**
@@ -840,6 +1182,114 @@ const char *elog_find_tag(const char *log, uint8_t lvl, size_t *tag_len) {
     return tag;
 }
 
+#ifdef ELOG_BIN_OUTPUT_ENABLE
+/**
+ * output binary log, the text is rebuilt by the host decoder from the firmware image
+ *
+ * record: 0xFF, level << 4 | nargs, site id (u16), timestamp us (u32), args (u32 * nargs),
+ * all little endian. 0xFF never appears in UTF-8 text, so records can be mixed with text logs.
+ * the level, tag level and tag filters are checked as for text logs, the keyword filter needs the text.
+ *
+ * @param tag_id call site's tag id, 0 when it is not interned yet, the descriptor is in flash so it is kept here
+ * @param site call site descriptor in flash
+ * @param args 32 bits arguments
+ * @param nargs arguments number
+ */
+void elog_bin_output(uint8_t *tag_id, const ElogBinSite *site, const uint32_t *args, uint8_t nargs) {
+    extern uint32_t elog_port_get_timestamp(void);
+
+    uint8_t record[8 + ELOG_BIN_MAX_ARGS * 4];
+    uint32_t id = ((uint32_t)(uintptr_t)site - ELOG_BIN_SITE_BASE) >> 2;
+    uint32_t timestamp;
+    size_t size;
+
+    /* same filter as the text logs: the tag level and tag filter apply too */
+    if (*tag_id == 0) {
+        *tag_id = elog_tag_intern(site->tag);
+    }
+    if (site->level >= (*tag_id != 0 ? elog_tag_pass[*tag_id] : tag_pass_level(site->tag))) {
+        return;
+    }
+    if (nargs > ELOG_BIN_MAX_ARGS) {
+        nargs = ELOG_BIN_MAX_ARGS;
+    }
+#ifdef ELOG_REPEAT_SUPPRESS_ENABLE
+    if (repeat_check(repeat_hash(repeat_hash(REPEAT_HASH_INIT, &site, sizeof(site)), args, nargs * 4),
+            site->level, site->tag)) {
+        return;
+    }
+#endif
+#ifdef ELOG_RATE_LIMIT_ENABLE
+    if (!rate_take(*tag_id, site->level)) {
+        return;
+    }
+#endif
+
+    timestamp = elog_port_get_timestamp();
+    record[0] = 0xFF;
+    record[1] = (uint8_t)(site->level << 4 | nargs);
+    record[2] = (uint8_t)id;
+    record[3] = (uint8_t)(id >> 8);
+    memcpy(record + 4, &timestamp, 4);
+    memcpy(record + 8, args, nargs * 4);
+    size = 8 + nargs * 4;
+
+    /* lock output */
+    elog_output_lock();
+#if defined(ELOG_BUF_OUTPUT_ENABLE)
+    extern void elog_buf_output(uint8_t level, const char *tag, const char *log, size_t size);
+    elog_buf_output(site->level, site->tag, (const char *)record, size);
+    /* text sinks get it formatted now, while %s arguments still point to valid strings */
+    if (elog_buf_text_wanted(site->level, site->tag)) {
+        bin_output_text(site, args, nargs);
+    }
+#else
+    elog_port_output((const char *)record, size);
+#endif
+    /* unlock output */
+    elog_output_unlock();
+}
+
+#ifdef ELOG_BUF_OUTPUT_ENABLE
+/**
+ * format a binary log to a text line without colour for the text sinks
+ *
+ * @param site call site descriptor in flash
+ * @param args 32 bits arguments
+ * @param nargs arguments number
+ */
+static void bin_output_text(const ElogBinSite *site, const uint32_t *args, uint8_t nargs) {
+    extern size_t elog_port_get_time(char *time, size_t size);
+
+    size_t log_len = 0, newline_len = strlen(ELOG_NEWLINE_SIGN);
+    int fmt_result;
+    char *log_buf;
+
+    if ((log_buf = line_buf_take()) == NULL) {
+        return;
+    }
+
+    /* the same level, tag and time layout as text logs */
+    log_len += elog_strcpy(log_len, log_buf + log_len, level_output_info[site->level]);
+    fmt_result = elog_snprintf(log_buf + log_len, ELOG_LINE_BUF_SIZE - log_len, "%-*s [",
+            ELOG_FILTER_TAG_MAX_LEN / 2, site->tag);
+    log_len += fmt_text_len(fmt_result, ELOG_LINE_BUF_SIZE - log_len);
+    log_len += elog_port_get_time(log_buf + log_len, ELOG_LINE_BUF_SIZE - log_len);
+    log_len += elog_strcpy(log_len, log_buf + log_len, "] ");
+    fmt_result = elog_snprintf_words(log_buf + log_len, ELOG_LINE_BUF_SIZE - log_len, site->fmt, args, nargs);
+    log_len += fmt_text_len(fmt_result, ELOG_LINE_BUF_SIZE - log_len);
+    /* overflow check and reserve some space for newline sign */
+    if (log_len + newline_len > ELOG_LINE_BUF_SIZE) {
+        log_len = ELOG_LINE_BUF_SIZE - newline_len;
+    }
+    log_len += elog_strcpy(log_len, log_buf + log_len, ELOG_NEWLINE_SIGN);
+
+    elog_buf_output_text(site->level, site->tag, log_buf, log_len);
+    line_buf_give();
+}
+#endif /* ELOG_BUF_OUTPUT_ENABLE */
+#endif /* ELOG_BIN_OUTPUT_ENABLE */
+
 /**
  * dump the hex format data to log
  *
@@ -857,6 +1307,7 @@ void elog_hexdump(const char *name, uint8_t width, const void *buf, uint16_t siz
     const uint8_t *buf_p = buf;
     char dump_string[8] = {0};
     int fmt_result;
+    char *log_buf;
 
     if (!elog.output_enabled) {
         return;
@@ -868,13 +1319,16 @@ void elog_hexdump(const char *name, uint8_t width, const void *buf, uint16_t siz
     } else if (!strstr(name, elog.filter.tag)) { /* tag filter */
         return;
     }
+    if ((log_buf = line_buf_take()) == NULL) {
+        return;
+    }
 
     /* lock output */
     elog_output_lock();
 
     for (i = 0; i < size; i += width) {
         /* package header */
-        fmt_result = snprintf(log_buf, ELOG_LINE_BUF_SIZE, "D/HEX %s: %04X-%04X: ", name, i, i + width - 1);
+        fmt_result = elog_snprintf(log_buf, ELOG_LINE_BUF_SIZE, "D/HEX %s: %04X-%04X: ", name, i, i + width - 1);
         /* calculate log length */
         if ((fmt_result > -1) && (fmt_result <= ELOG_LINE_BUF_SIZE)) {
             log_len = fmt_result;
@@ -884,7 +1338,7 @@ void elog_hexdump(const char *name, uint8_t width, const void *buf, uint16_t siz
         /* dump hex */
         for (j = 0; j < width; j++) {
             if (i + j < size) {
-                snprintf(dump_string, sizeof(dump_string), "%02X ", buf_p[i + j]);
+                elog_snprintf(dump_string, sizeof(dump_string), "%02X ", buf_p[i + j]);
             } else {
                 strncpy(dump_string, "   ", sizeof(dump_string));
             }
@@ -897,7 +1351,7 @@ void elog_hexdump(const char *name, uint8_t width, const void *buf, uint16_t siz
         /* dump char for hex */
         for (j = 0; j < width; j++) {
             if (i + j < size) {
-                snprintf(dump_string, sizeof(dump_string), "%c", __is_print(buf_p[i + j]) ? buf_p[i + j] : '.');
+                elog_snprintf(dump_string, sizeof(dump_string), "%c", __is_print(buf_p[i + j]) ? buf_p[i + j] : '.');
                 log_len += elog_strcpy(log_len, log_buf + log_len, dump_string);
             }
         }
@@ -912,12 +1366,212 @@ void elog_hexdump(const char *name, uint8_t width, const void *buf, uint16_t siz
         extern void elog_async_output(uint8_t level, const char *log, size_t size);
         elog_async_output(ELOG_LVL_DEBUG, log_buf, log_len);
 #elif defined(ELOG_BUF_OUTPUT_ENABLE)
-        extern void elog_buf_output(const char *log, size_t size);
-    elog_buf_output(log_buf, log_len);
+        extern void elog_buf_output(uint8_t level, const char *tag, const char *log, size_t size);
+        elog_buf_output(ELOG_LVL_DEBUG, name, log_buf, log_len);
 #else
         elog_port_output(log_buf, log_len);
 #endif
     }
     /* unlock output */
     elog_output_unlock();
+    line_buf_give();
+}
+
+/**
+ * length actually stored by a formatter call which may have been truncated
+ */
+static size_t fmt_text_len(int fmt_result, size_t size) {
+    if (fmt_result <= 0 || size == 0) {
+        return 0;
+    }
+
+    return (size_t)fmt_result < size ? (size_t)fmt_result : size - 1;
+}
+
+#ifdef ELOG_RATE_LIMIT_ENABLE
+/**
+ * take a log from the tag's token bucket, assert logs always pass
+ *
+ * @param tag_id tag id, 0: tags which are not interned
+ * @param level level
+ *
+ * @return false: the bucket is empty, the log is dropped
+ */
+static bool rate_take(uint8_t tag_id, uint8_t level) {
+    extern uint32_t elog_port_get_timestamp(void);
+
+    ElogRate *rate = &tag_rate[tag_id];
+    uint32_t primask, elapsed, full;
+    bool pass = true;
+
+    if (level == ELOG_LVL_ASSERT || rate->per_sec == 0) {
+        return true;
+    }
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    /* the time is read with interrupts disabled, so buckets see it in order */
+    elapsed = elog_port_get_timestamp() - rate->last_us;
+    rate->last_us += elapsed;
+    full = rate->burst * RATE_TOKEN_ONE;
+    if (elapsed >= full / rate->per_sec) {
+        rate->tokens = full;
+    } else {
+        rate->tokens += elapsed * rate->per_sec;
+        if (rate->tokens > full) {
+            rate->tokens = full;
+        }
+    }
+    if (rate->tokens >= RATE_TOKEN_ONE) {
+        rate->tokens -= RATE_TOKEN_ONE;
+    } else {
+        rate->limited++;
+        pass = false;
+    }
+    __set_PRIMASK(primask);
+
+    return pass;
+}
+#endif /* ELOG_RATE_LIMIT_ENABLE */
+
+#ifdef ELOG_REPEAT_SUPPRESS_ENABLE
+/**
+ * FNV-1a hash
+ */
+static uint32_t repeat_hash(uint32_t hash, const void *data, size_t size) {
+    const uint8_t *byte = data;
+
+    while (size-- > 0) {
+        hash = (hash ^ *byte++) * 16777619UL;
+    }
+
+    return hash;
+}
+
+/**
+ * count the log when it is the same as the last one.
+ * a different log ends the run, its count is reported before the log.
+ * a long run is reported every ELOG_REPEAT_REPORT_NUM repeats.
+ *
+ * @param hash hash of the message
+ * @param level level
+ * @param tag tag
+ *
+ * @return true: the log is a repeat and is not output
+ */
+static bool repeat_check(uint32_t hash, uint8_t level, const char *tag) {
+    extern uint32_t elog_port_get_timestamp(void);
+
+    uint32_t primask, count, now = elog_port_get_timestamp();
+    const char *run_tag;
+    uint8_t run_level;
+    bool repeat;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    repeat = hash == repeat_run.hash && level == repeat_run.level && tag == repeat_run.tag;
+    repeat_run.time = now;
+    if (repeat) {
+        repeat_suppressed++;
+        if (++repeat_run.count < ELOG_REPEAT_REPORT_NUM) {
+            __set_PRIMASK(primask);
+            return true;
+        }
+    }
+    count = repeat_run.count;
+    run_level = repeat_run.level;
+    run_tag = repeat_run.tag;
+    repeat_run.hash = hash;
+    repeat_run.level = level;
+    repeat_run.tag = tag;
+    repeat_run.count = 0;
+    __set_PRIMASK(primask);
+
+    if (count != 0) {
+        repeat_report(run_level, run_tag, count);
+    }
+
+    return repeat;
+}
+
+/**
+ * output how many times the last log was repeated, with its level and tag
+ */
+static void repeat_report(uint8_t level, const char *tag, uint32_t count) {
+    extern size_t elog_port_get_time(char *time, size_t size);
+
+    size_t log_len = 0, newline_len = strlen(ELOG_NEWLINE_SIGN);
+    int fmt_result;
+    char *log_buf;
+
+    if ((log_buf = line_buf_take()) == NULL) {
+        return;
+    }
+
+#ifdef ELOG_COLOR_ENABLE
+    if (elog.text_color_enabled) {
+        log_len += elog_strcpy(log_len, log_buf + log_len, CSI_START);
+        log_len += elog_strcpy(log_len, log_buf + log_len, color_output_info[level]);
+    }
+#endif
+    log_len += elog_strcpy(log_len, log_buf + log_len, level_output_info[level]);
+    fmt_result = elog_snprintf(log_buf + log_len, ELOG_LINE_BUF_SIZE - log_len, "%-*s [",
+            ELOG_FILTER_TAG_MAX_LEN / 2, tag);
+    log_len += fmt_text_len(fmt_result, ELOG_LINE_BUF_SIZE - log_len);
+    log_len += elog_port_get_time(log_buf + log_len, ELOG_LINE_BUF_SIZE - log_len);
+    fmt_result = elog_snprintf(log_buf + log_len, ELOG_LINE_BUF_SIZE - log_len, "] last log repeated %u times",
+            (unsigned)count);
+    log_len += fmt_text_len(fmt_result, ELOG_LINE_BUF_SIZE - log_len);
+#ifdef ELOG_COLOR_ENABLE
+    if (elog.text_color_enabled) {
+        log_len += elog_strcpy(log_len, log_buf + log_len, CSI_END);
+    }
+#endif
+    /* overflow check and reserve some space for newline sign */
+    if (log_len + newline_len > ELOG_LINE_BUF_SIZE) {
+        log_len = ELOG_LINE_BUF_SIZE - newline_len;
+    }
+    log_len += elog_strcpy(log_len, log_buf + log_len, ELOG_NEWLINE_SIGN);
+
+#if defined(ELOG_ASYNC_OUTPUT_ENABLE)
+    extern void elog_async_output(uint8_t level, const char *log, size_t size);
+    elog_async_output(level, log_buf, log_len);
+#elif defined(ELOG_BUF_OUTPUT_ENABLE)
+    extern void elog_buf_output(uint8_t level, const char *tag, const char *log, size_t size);
+    elog_buf_output(level, tag, log_buf, log_len);
+#else
+    elog_port_output(log_buf, log_len);
+#endif
+    line_buf_give();
+}
+#endif /* ELOG_REPEAT_SUPPRESS_ENABLE */
+
+/**
+ * take the line buffer for current context, it can be called from any interrupt
+ *
+ * @return NULL: too many nested logs, the log is dropped
+ */
+static char *line_buf_take(void) {
+    uint32_t used;
+
+    do {
+        used = __LDREXW(&line_buf_used);
+        if (used >= ELOG_LINE_BUF_NEST_NUM) {
+            __CLREX();
+            return NULL;
+        }
+    } while (__STREXW(used + 1, &line_buf_used) != 0);
+
+    return line_buf[used];
+}
+
+/**
+ * give back the line buffer taken by line_buf_take
+ */
+static void line_buf_give(void) {
+    uint32_t used;
+
+    do {
+        used = __LDREXW(&line_buf_used);
+    } while (__STREXW(used - 1, &line_buf_used) != 0);
 }
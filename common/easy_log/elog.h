@@ -33,11 +33,19 @@
 #include <stdint.h>
 #include <stddef.h>
 #include <stdbool.h>
+#include <stdarg.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/* let the compiler check format and arguments of the printf-like APIs */
+#if defined(__GNUC__) || defined(__CC_ARM)
+    #define ELOG_PRINTF_CHECK(fmt_index, args_index) __attribute__((format(printf, fmt_index, args_index)))
+#else
+    #define ELOG_PRINTF_CHECK(fmt_index, args_index)
+#endif
+
 /* output log's level */
 #define ELOG_LVL_ASSERT                      0
 #define ELOG_LVL_ERROR                       1
@@ -62,7 +70,7 @@ extern "C" {
     if (!(EXPR))                                                              \
     {                                                                         \
         if (elog_assert_hook == NULL) {                                       \
-            elog_a("elog", "(%s) has assert failed at %s:%ld.", #EXPR, __FUNCTION__, __LINE__); \
+            elog_a("elog", "(%s) has assert failed at %s:%ld.", #EXPR, __FUNCTION__, (long)__LINE__); \
             while (1);                                                        \
         } else {                                                              \
             elog_assert_hook(#EXPR, __FUNCTION__, __LINE__);                  \
@@ -80,44 +88,53 @@ extern "C" {
     #define elog_debug(tag, ...)
     #define elog_verbose(tag, ...)
 #else /* ELOG_OUTPUT_ENABLE */
+    /* every call site keeps its interned tag id, a suppressed log costs one table load and compare */
+    #define elog_output_tag(level, tag, ...)                                       \
+    do {                                                                        \
+        static uint8_t elog_tag_id_ = 0;                                        \
+        if ((level) < elog_tag_pass[elog_tag_id_]) {                            \
+            elog_output_id(&elog_tag_id_, level, tag, __FILE__, __FUNCTION__, __LINE__, __VA_ARGS__); \
+        }                                                                       \
+    } while (0)
+
     #if ELOG_OUTPUT_LVL >= ELOG_LVL_ASSERT
         #define elog_assert(tag, ...) \
-                elog_output(ELOG_LVL_ASSERT, tag, __FILE__, __FUNCTION__, __LINE__, __VA_ARGS__)
+                elog_output_tag(ELOG_LVL_ASSERT, tag, __VA_ARGS__)
     #else
         #define elog_assert(tag, ...)
     #endif /* ELOG_OUTPUT_LVL >= ELOG_LVL_ASSERT */
 
     #if ELOG_OUTPUT_LVL >= ELOG_LVL_ERROR
         #define elog_error(tag, ...) \
-                elog_output(ELOG_LVL_ERROR, tag, __FILE__, __FUNCTION__, __LINE__, __VA_ARGS__)
+                elog_output_tag(ELOG_LVL_ERROR, tag, __VA_ARGS__)
     #else
         #define elog_error(tag, ...)
     #endif /* ELOG_OUTPUT_LVL >= ELOG_LVL_ERROR */
 
     #if ELOG_OUTPUT_LVL >= ELOG_LVL_WARN
         #define elog_warn(tag, ...) \
-                elog_output(ELOG_LVL_WARN, tag, __FILE__, __FUNCTION__, __LINE__, __VA_ARGS__)
+                elog_output_tag(ELOG_LVL_WARN, tag, __VA_ARGS__)
     #else
         #define elog_warn(tag, ...)
     #endif /* ELOG_OUTPUT_LVL >= ELOG_LVL_WARN */
 
     #if ELOG_OUTPUT_LVL >= ELOG_LVL_INFO
         #define elog_info(tag, ...) \
-                elog_output(ELOG_LVL_INFO, tag, __FILE__, __FUNCTION__, __LINE__, __VA_ARGS__)
+                elog_output_tag(ELOG_LVL_INFO, tag, __VA_ARGS__)
     #else
         #define elog_info(tag, ...)
     #endif /* ELOG_OUTPUT_LVL >= ELOG_LVL_INFO */
 
     #if ELOG_OUTPUT_LVL >= ELOG_LVL_DEBUG
         #define elog_debug(tag, ...) \
-                elog_output(ELOG_LVL_DEBUG, tag, __FILE__, __FUNCTION__, __LINE__, __VA_ARGS__)
+                elog_output_tag(ELOG_LVL_DEBUG, tag, __VA_ARGS__)
     #else
         #define elog_debug(tag, ...)
     #endif /* ELOG_OUTPUT_LVL >= ELOG_LVL_DEBUG */
 
     #if ELOG_OUTPUT_LVL == ELOG_LVL_VERBOSE
         #define elog_verbose(tag, ...) \
-                elog_output(ELOG_LVL_VERBOSE, tag, __FILE__, __FUNCTION__, __LINE__, __VA_ARGS__)
+                elog_output_tag(ELOG_LVL_VERBOSE, tag, __VA_ARGS__)
     #else
         #define elog_verbose(tag, ...)
     #endif /* ELOG_OUTPUT_LVL == ELOG_LVL_VERBOSE */
@@ -170,6 +187,67 @@ typedef struct {
 
 }EasyLogger, *EasyLogger_t;
 
+/* binary log's call site, placed in flash and identified by its address */
+typedef struct {
+    const char *tag;
+    const char *fmt;
+    uint16_t line;
+    uint8_t level;
+    uint8_t reserved;
+} ElogBinSite;
+
+/* lock-free ring for any number of writers and one reader, size must be a power of 2 */
+typedef struct {
+    char *buf;
+    uint32_t size;
+    volatile uint32_t state;
+    volatile uint32_t commit;
+    volatile uint32_t tail;
+} ElogRing;
+
+#define ELOG_RING_INIT(buf)          { (buf), sizeof(buf), 0, 0, 0 }
+
+/* sink output mode */
+typedef enum {
+    ELOG_SINK_TEXT,                      /* text lines, binary logs are formatted to text for it */
+    ELOG_SINK_BIN,                       /* text lines and binary records as they are */
+    ELOG_SINK_LZ,                        /* the same as binary, compressed by its writer */
+} ElogSinkMode;
+
+typedef struct ElogSink ElogSink;
+/* copy logs to the device, return the bytes taken, size 0 only starts what is pending */
+typedef size_t (*ElogSinkWrite)(ElogSink *sink, const char *log, size_t size);
+
+/* a log destination with its own buffer and filter, drained by its own writer */
+struct ElogSink {
+    const char *name;
+    ElogRing ring;
+    ElogSinkWrite write;                 /* NULL: the owner reads the ring itself */
+    void *port;                          /* writer's data */
+    uint8_t mode;
+    uint8_t level;
+    char tag[ELOG_FILTER_TAG_MAX_LEN + 1];
+    volatile uint32_t dropped;
+    volatile uint32_t drain_owned;
+    volatile bool drain_again;
+    volatile bool overflow_marked;
+};
+
+#define ELOG_SINK_INIT(name, buf, write, port, mode, level) \
+    { (name), ELOG_RING_INIT(buf), (write), (port), (mode), (level), "", 0, 0, false, false }
+
+#ifdef ELOG_LZ_OUTPUT_ENABLE
+/* streaming compressor, the history is shared by all frames until the next reset */
+typedef struct {
+    uint8_t window[ELOG_LZ_WINDOW_SIZE];
+    uint16_t head[ELOG_LZ_HASH_SIZE];
+    uint32_t pos;
+    uint32_t frames;
+    uint32_t in_bytes;
+    uint32_t out_bytes;
+} ElogLz;
+#endif
+
 /* EasyLogger error code */
 typedef enum {
     ELOG_NO_ERR,
@@ -191,15 +269,26 @@ void elog_set_filter_tag(const char *tag);
 void elog_set_filter_kw(const char *keyword);
 void elog_set_filter_tag_lvl(const char *tag, uint8_t level);
 uint8_t elog_get_filter_tag_lvl(const char *tag);
-void elog_raw(const char *format, ...);
+void elog_raw(const char *format, ...) ELOG_PRINTF_CHECK(1, 2);
 void elog_output(uint8_t level, const char *tag, const char *file, const char *func,
-        const long line, const char *format, ...);
+        const long line, const char *format, ...) ELOG_PRINTF_CHECK(6, 7);
+void elog_output_id(uint8_t *tag_id, uint8_t level, const char *tag, const char *file, const char *func,
+        const long line, const char *format, ...) ELOG_PRINTF_CHECK(7, 8);
+uint8_t elog_tag_intern(const char *tag);
+uint8_t elog_tag_get_num(void);
+const char *elog_tag_get_name(uint8_t tag_id);
+bool elog_set_rate_limit(const char *tag, uint8_t per_sec, uint8_t burst);
+uint32_t elog_get_rate_limit(uint8_t tag_id, uint8_t *per_sec, uint8_t *burst);
+uint32_t elog_get_repeat_suppressed(void);
+void elog_repeat_flush(void);
+extern uint8_t elog_tag_pass[];
 void elog_output_lock_enabled(bool enabled);
 extern void (*elog_assert_hook)(const char* expr, const char* func, size_t line);
 void elog_assert_set_hook(void (*hook)(const char* expr, const char* func, size_t line));
 int8_t elog_find_lvl(const char *log);
 const char *elog_find_tag(const char *log, uint8_t lvl, size_t *tag_len);
 void elog_hexdump(const char *name, uint8_t width, const void *buf, uint16_t size);
+void elog_bin_output(uint8_t *tag_id, const ElogBinSite *site, const uint32_t *args, uint8_t nargs);
 
 #define elog_a(tag, ...)     elog_assert(tag, __VA_ARGS__)
 #define elog_e(tag, ...)     elog_error(tag, __VA_ARGS__)
@@ -254,15 +343,131 @@ void elog_hexdump(const char *name, uint8_t width, const void *buf, uint16_t siz
     #define assert           ELOG_ASSERT
 #endif
 
+/**
+ * binary log API, only the call site id, timestamp and raw 32 bits arguments are output.
+ * NOTE: float arguments must be wrapped by ELOG_BIN_FLOAT(), %s arguments must point to flash
+ * so that the decoder can find them in the firmware image.
+ */
+#if defined(ELOG_OUTPUT_ENABLE) && defined(ELOG_BIN_OUTPUT_ENABLE)
+    /* count the arguments after format, up to ELOG_BIN_MAX_ARGS */
+    #define ELOG_BIN_NARGS(...)      ELOG_BIN_NARGS_(__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0, 0)
+    #define ELOG_BIN_NARGS_(fmt, a1, a2, a3, a4, a5, a6, a7, a8, n, ...) n
+    #define ELOG_BIN_FIRST(...)      ELOG_BIN_FIRST_(__VA_ARGS__, 0)
+    #define ELOG_BIN_FIRST_(fmt, ...) fmt
+    #define ELOG_BIN_ARGS(n, ...)    ELOG_BIN_ARGS_N(n, __VA_ARGS__)
+    #define ELOG_BIN_ARGS_N(n, ...)  ELOG_BIN_ARGS_##n(__VA_ARGS__)
+    /* format without arguments still needs one element for the array */
+    #define ELOG_BIN_ARGS_0(f)                               0
+    #define ELOG_BIN_ARGS_1(f, a)                            (uint32_t)(a)
+    #define ELOG_BIN_ARGS_2(f, a, b)                         (uint32_t)(a), (uint32_t)(b)
+    #define ELOG_BIN_ARGS_3(f, a, b, c)                      ELOG_BIN_ARGS_2(f, a, b), (uint32_t)(c)
+    #define ELOG_BIN_ARGS_4(f, a, b, c, d)                   ELOG_BIN_ARGS_3(f, a, b, c), (uint32_t)(d)
+    #define ELOG_BIN_ARGS_5(f, a, b, c, d, e)                ELOG_BIN_ARGS_4(f, a, b, c, d), (uint32_t)(e)
+    #define ELOG_BIN_ARGS_6(f, a, b, c, d, e, g)             ELOG_BIN_ARGS_5(f, a, b, c, d, e), (uint32_t)(g)
+    #define ELOG_BIN_ARGS_7(f, a, b, c, d, e, g, h)          ELOG_BIN_ARGS_6(f, a, b, c, d, e, g), (uint32_t)(h)
+    #define ELOG_BIN_ARGS_8(f, a, b, c, d, e, g, h, i)       ELOG_BIN_ARGS_7(f, a, b, c, d, e, g, h), (uint32_t)(i)
+
+    #define elog_bin_output_site(level, tag, ...)                                  \
+    do {                                                                        \
+        static const ElogBinSite elog_bin_site_ = {                             \
+            tag, ELOG_BIN_FIRST(__VA_ARGS__), __LINE__, level, 0 };             \
+        static uint8_t elog_tag_id_ = 0;                                        \
+        if ((level) < elog_tag_pass[elog_tag_id_]) {                            \
+            const uint32_t elog_bin_args_[] = {                                 \
+                ELOG_BIN_ARGS(ELOG_BIN_NARGS(__VA_ARGS__), __VA_ARGS__) };      \
+            elog_bin_output(&elog_tag_id_, &elog_bin_site_, elog_bin_args_, ELOG_BIN_NARGS(__VA_ARGS__)); \
+        }                                                                       \
+    } while (0)
+
+    /* reinterpret float as 32 bits, the decoder converts it back for %f */
+    #define ELOG_BIN_FLOAT(x)        elog_float_bits(x)
+    static __inline uint32_t elog_float_bits(float x) {
+        union { float f; uint32_t u; } v;
+        v.f = x;
+        return v.u;
+    }
+
+    #if ELOG_OUTPUT_LVL >= ELOG_LVL_ASSERT
+        #define elog_bin_a(tag, ...) elog_bin_output_site(ELOG_LVL_ASSERT, tag, __VA_ARGS__)
+    #else
+        #define elog_bin_a(tag, ...)
+    #endif
+    #if ELOG_OUTPUT_LVL >= ELOG_LVL_ERROR
+        #define elog_bin_e(tag, ...) elog_bin_output_site(ELOG_LVL_ERROR, tag, __VA_ARGS__)
+    #else
+        #define elog_bin_e(tag, ...)
+    #endif
+    #if ELOG_OUTPUT_LVL >= ELOG_LVL_WARN
+        #define elog_bin_w(tag, ...) elog_bin_output_site(ELOG_LVL_WARN, tag, __VA_ARGS__)
+    #else
+        #define elog_bin_w(tag, ...)
+    #endif
+    #if ELOG_OUTPUT_LVL >= ELOG_LVL_INFO
+        #define elog_bin_i(tag, ...) elog_bin_output_site(ELOG_LVL_INFO, tag, __VA_ARGS__)
+    #else
+        #define elog_bin_i(tag, ...)
+    #endif
+    #if ELOG_OUTPUT_LVL >= ELOG_LVL_DEBUG
+        #define elog_bin_d(tag, ...) elog_bin_output_site(ELOG_LVL_DEBUG, tag, __VA_ARGS__)
+    #else
+        #define elog_bin_d(tag, ...)
+    #endif
+    #if ELOG_OUTPUT_LVL == ELOG_LVL_VERBOSE
+        #define elog_bin_v(tag, ...) elog_bin_output_site(ELOG_LVL_VERBOSE, tag, __VA_ARGS__)
+    #else
+        #define elog_bin_v(tag, ...)
+    #endif
+#else
+    /* binary mode disabled, fall back to text logs */
+    #define ELOG_BIN_FLOAT(x)        (x)
+    #define elog_bin_a(tag, ...)     elog_a(tag, __VA_ARGS__)
+    #define elog_bin_e(tag, ...)     elog_e(tag, __VA_ARGS__)
+    #define elog_bin_w(tag, ...)     elog_w(tag, __VA_ARGS__)
+    #define elog_bin_i(tag, ...)     elog_i(tag, __VA_ARGS__)
+    #define elog_bin_d(tag, ...)     elog_d(tag, __VA_ARGS__)
+    #define elog_bin_v(tag, ...)     elog_v(tag, __VA_ARGS__)
+#endif /* ELOG_BIN_OUTPUT_ENABLE */
+
 /* elog_buf.c */
 void elog_buf_enabled(bool enabled);
 void elog_flush(void);
+uint32_t elog_buf_get_dropped(void);
+void elog_buf_output_text(uint8_t level, const char *tag, const char *log, size_t size);
+bool elog_buf_text_wanted(uint8_t level, const char *tag);
+bool elog_buf_write(const char *log, size_t size);
+bool elog_sink_register(ElogSink *sink);
+ElogSink *elog_sink_get(uint8_t index);
+ElogSink *elog_sink_find(const char *name);
+void elog_sink_set_filter(ElogSink *sink, uint8_t level, const char *tag);
+void elog_sink_set_mode(ElogSink *sink, uint8_t mode);
+void elog_sink_flush(ElogSink *sink);
+bool elog_ring_put(ElogRing *ring, const char *data, size_t size);
+size_t elog_ring_used(ElogRing *ring);
+size_t elog_ring_peek(ElogRing *ring, const char **data);
+void elog_ring_skip(ElogRing *ring, size_t size);
+
+/* elog_flash.c */
+ElogErrCode elog_flash_init(void);
+void elog_flash_process(void);
+bool elog_flash_dump(void);
+ElogSink *elog_flash_get_sink(void);
 
 /* elog_async.c */
 void elog_async_enabled(bool enabled);
 size_t elog_async_get_log(char *log, size_t size);
 size_t elog_async_get_line_log(char *log, size_t size);
 
+/* elog_fmt.c */
+int elog_vsnprintf(char *buf, size_t size, const char *format, va_list args);
+int elog_snprintf(char *buf, size_t size, const char *format, ...) ELOG_PRINTF_CHECK(3, 4);
+int elog_snprintf_words(char *buf, size_t size, const char *format, const uint32_t *words, uint8_t num);
+
+#ifdef ELOG_LZ_OUTPUT_ENABLE
+/* elog_lz.c */
+void elog_lz_init(ElogLz *lz);
+size_t elog_lz_compress(ElogLz *lz, const char *log, size_t size, uint8_t *out, size_t out_size, size_t *out_len);
+#endif
+
 /* elog_utils.c */
 size_t elog_strcpy(size_t cur_len, char *dst, const char *src);
 size_t elog_cpyln(char *line, const char *log, size_t len);
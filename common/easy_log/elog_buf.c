@@ -22,22 +22,40 @@
  * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
  * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  *
- * Function: Logs buffered output.
+ * Function: Logs buffered output, routed to sinks which are drained independently.
  * Created on: 2016-11-09
  */
 
 #include "elog.h"
 #include <string.h>
+#include "gd32f30x.h"
 
 #ifdef ELOG_BUF_OUTPUT_ENABLE
 #if !defined(ELOG_BUF_OUTPUT_BUF_SIZE)
     #error "Please configure buffer size for buffered output mode (in elog_cfg.h)"
 #endif
 
-/* buffered output mode's buffer */
-static char log_buf[ELOG_BUF_OUTPUT_BUF_SIZE] = { 0 };
-/* log buffer current write size */
-static size_t buf_write_size = 0;
+#if (ELOG_BUF_OUTPUT_BUF_SIZE & (ELOG_BUF_OUTPUT_BUF_SIZE - 1)) != 0 || ELOG_BUF_OUTPUT_BUF_SIZE > 0x800000
+    #error "ELOG_BUF_OUTPUT_BUF_SIZE must be a power of 2 and no more than 8MB"
+#endif
+
+/*
+ * lock-free multi-producer single-consumer ring, writers may be in any interrupt.
+ * a writer reserves space by advancing the write index with LDREX/STREX, copies its log,
+ * then leaves. the writer count lives in the same word as the write index, the writer
+ * that brings it back to zero publishes the write index it saw, so the consumer only
+ * sees complete logs and always in reserve order, and no writer waits for another.
+ */
+/* bit 0..23: free running write index, bit 24..31: writers still copying */
+#define RING_INDEX_MASK      0x00FFFFFFUL
+#define RING_WRITER_ONE      0x01000000UL
+
+/* notice written in place of the first dropped log after each flush */
+static const char overflow_string[] = "\nelog buffer overflow\n";
+
+/* registered sinks, the first one is the console */
+static ElogSink *sink_list[ELOG_SINK_MAX_NUM];
+static uint8_t sink_num = 0;
 /* buffered output mode enabled flag */
 static bool is_enabled = false;
 
@@ -45,56 +63,236 @@ extern int8_t elog_port_output(const char *log, size_t size);
 extern void elog_output_lock(void);
 extern void elog_output_unlock(void);
 
+static void buf_route(uint8_t level, const char *tag, const char *log, size_t size, uint8_t modes);
+static bool sink_pass(const ElogSink *sink, uint8_t level, const char *tag);
+static bool ring_reserve(ElogRing *ring, size_t size, uint32_t *index);
+static void ring_write(ElogRing *ring, uint32_t index, const char *data, size_t size);
+static void ring_release(ElogRing *ring);
+static bool drain_take(ElogSink *sink);
+
 /**
- * output buffered logs when buffer is full
+ * put a whole log into every sink that takes it, a sink that is full drops the log.
+ * it can be called from any interrupt, interrupts are never disabled.
+ * binary records (first byte 0xFF) skip text sinks, elog formats them for text sinks.
  *
- * @param log will be buffered line's log
+ * @param level log level
+ * @param tag log tag
+ * @param log will be buffered line's log or binary record
  * @param size log size
  */
-void elog_buf_output(const char *log, size_t size) {
-    size_t write_size = 0, write_index = 0;
-
+void elog_buf_output(uint8_t level, const char *tag, const char *log, size_t size) {
     if (!is_enabled) {
         elog_port_output(log, size);
         return;
     }
 
-    while (true) {
-        if (buf_write_size + size > ELOG_BUF_OUTPUT_BUF_SIZE) {
-            write_size = ELOG_BUF_OUTPUT_BUF_SIZE - buf_write_size;
-            memcpy(log_buf + buf_write_size, log + write_index, write_size);
-            write_index += write_size;
-            size -= write_size;
-            buf_write_size += write_size;
-            /* output log */
-            elog_port_output(log_buf, buf_write_size);
-            /* reset write index */
-            buf_write_size = 0;
-        } else {
-            memcpy(log_buf + buf_write_size, log + write_index, size);
-            buf_write_size += size;
-            break;
+    if ((uint8_t)log[0] == 0xFF) {
+        buf_route(level, tag, log, size, (uint8_t)~(1 << ELOG_SINK_TEXT));
+    } else {
+        buf_route(level, tag, log, size, 0xFF);
+    }
+}
+
+/**
+ * put a binary log formatted to text into the text sinks
+ *
+ * @see elog_buf_output
+ */
+void elog_buf_output_text(uint8_t level, const char *tag, const char *log, size_t size) {
+    if (is_enabled) {
+        buf_route(level, tag, log, size, 1 << ELOG_SINK_TEXT);
+    }
+}
+
+/**
+ * check whether any text sink takes a log, so a binary log is only formatted when it is needed
+ *
+ * @param level log level
+ * @param tag log tag
+ *
+ * @return true: format it
+ */
+bool elog_buf_text_wanted(uint8_t level, const char *tag) {
+    uint8_t i;
+
+    for (i = 0; is_enabled && i < sink_num; i++) {
+        if (sink_list[i]->mode == ELOG_SINK_TEXT && sink_pass(sink_list[i], level, tag)) {
+            return true;
         }
     }
+
+    return false;
+}
+
+/**
+ * put data into the console only, nothing is dropped or counted.
+ * it is used to replay stored logs, which must not be stored again.
+ *
+ * @param log log data
+ * @param size log size
+ *
+ * @return false: not enough space now, try again after the buffer is drained
+ */
+bool elog_buf_write(const char *log, size_t size) {
+    if (!is_enabled || sink_num == 0) {
+        return elog_port_output(log, size) == 0;
+    }
+
+    return elog_ring_put(&sink_list[0]->ring, log, size);
 }
 
 /**
- * flush all buffered logs to output device
+ * drain every sink that has a writer, called from the main loop
  */
 void elog_flush(void) {
-    if (buf_write_size == 0)
+    uint8_t i;
+
+    for (i = 0; i < sink_num; i++) {
+        if (sink_list[i]->write != NULL) {
+            elog_sink_flush(sink_list[i]);
+        }
+    }
+}
+
+/**
+ * move a sink's logs to its writer until the writer is full.
+ * it is called from the main loop and from the writer's own send complete interrupt,
+ * only one of them drains at a time, the other one asks the owner to drain again.
+ * a slow sink only fills its own ring, the others go on.
+ *
+ * @param sink sink with a writer
+ */
+void elog_sink_flush(ElogSink *sink) {
+    const char *data;
+    size_t size, written;
+
+    if (!drain_take(sink)) {
+        sink->drain_again = true;
         return;
+    }
     /* lock output */
     elog_output_lock();
-    /* output log */
-    if(elog_port_output(log_buf, buf_write_size) == 0) {
-        /* reset write index */
-        buf_write_size = 0;
-    }
+    do {
+        sink->drain_again = false;
+        /* output the continuous part before the end of buffer first */
+        while ((size = elog_ring_peek(&sink->ring, &data)) != 0) {
+            written = sink->write(sink, data, size);
+            if (written != 0) {
+                /* the writer has copied the log, the space can be reused */
+                elog_ring_skip(&sink->ring, written);
+                sink->overflow_marked = false;
+            }
+            if (written < size) {
+                break;
+            }
+        }
+        /* start what is left in the writer even if there is nothing new */
+        if (size == 0) {
+            sink->write(sink, NULL, 0);
+        }
+        __DMB();
+        sink->drain_owned = 0;
+    } while (sink->drain_again && drain_take(sink));
     /* unlock output */
     elog_output_unlock();
 }
 
+/**
+ * add a sink, the first one added is the console
+ *
+ * @param sink sink, it must stay valid
+ *
+ * @return false: no room
+ */
+bool elog_sink_register(ElogSink *sink) {
+    if (sink_num >= ELOG_SINK_MAX_NUM) {
+        return false;
+    }
+    sink_list[sink_num] = sink;
+    /* the sink is complete before the router can see it */
+    __DMB();
+    sink_num++;
+
+    return true;
+}
+
+/**
+ * get a sink by its registering order
+ *
+ * @param index 0: console
+ *
+ * @return sink, NULL: no such sink
+ */
+ElogSink *elog_sink_get(uint8_t index) {
+    return index < sink_num ? sink_list[index] : NULL;
+}
+
+/**
+ * find a sink by name
+ *
+ * @param name sink name
+ *
+ * @return sink, NULL: not found
+ */
+ElogSink *elog_sink_find(const char *name) {
+    uint8_t i;
+
+    for (i = 0; i < sink_num; i++) {
+        if (!strcmp(sink_list[i]->name, name)) {
+            return sink_list[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * set a sink's own filter, it can only be stricter than the global filter
+ *
+ * @param sink sink
+ * @param level highest level it takes
+ * @param tag it takes tags containing this, NULL or "" for all tags
+ */
+void elog_sink_set_filter(ElogSink *sink, uint8_t level, const char *tag) {
+    ELOG_ASSERT(level <= ELOG_LVL_VERBOSE);
+
+    /* a log in the middle of the change may see half a tag, it is only filtered wrongly */
+    sink->tag[0] = '\0';
+    if (tag != NULL) {
+        strncpy(sink->tag, tag, ELOG_FILTER_TAG_MAX_LEN);
+        sink->tag[ELOG_FILTER_TAG_MAX_LEN] = '\0';
+    }
+    sink->level = level;
+}
+
+/**
+ * set a sink's mode, a writer without compression sends ELOG_SINK_LZ as ELOG_SINK_BIN
+ *
+ * @param sink sink
+ * @param mode ElogSinkMode
+ */
+void elog_sink_set_mode(ElogSink *sink, uint8_t mode) {
+    ELOG_ASSERT(mode <= ELOG_SINK_LZ);
+
+    sink->mode = mode;
+}
+
+/**
+ * get the number of logs dropped by all sinks
+ *
+ * @return dropped logs
+ */
+uint32_t elog_buf_get_dropped(void) {
+    uint32_t dropped = 0;
+    uint8_t i;
+
+    for (i = 0; i < sink_num; i++) {
+        dropped += sink_list[i]->dropped;
+    }
+
+    return dropped;
+}
+
 /**
  * enable or disable buffered output mode
  * the log will be output directly when mode is disabled
@@ -104,4 +302,175 @@ void elog_flush(void) {
 void elog_buf_enabled(bool enabled) {
     is_enabled = enabled;
 }
+
+static void buf_route(uint8_t level, const char *tag, const char *log, size_t size, uint8_t modes) {
+    ElogSink *sink;
+    uint32_t dropped;
+    uint8_t i;
+
+    for (i = 0; i < sink_num; i++) {
+        sink = sink_list[i];
+        if (!(modes & (1 << sink->mode)) || !sink_pass(sink, level, tag)) {
+            continue;
+        }
+        if (elog_ring_put(&sink->ring, log, size)) {
+            continue;
+        }
+
+        /* never split a log, a partial binary record can not be decoded */
+        if (sink->write != NULL && !sink->overflow_marked
+                && elog_ring_put(&sink->ring, overflow_string, sizeof(overflow_string) - 1)) {
+            sink->overflow_marked = true;
+        }
+        do {
+            dropped = __LDREXW(&sink->dropped);
+        } while (__STREXW(dropped + 1, &sink->dropped) != 0);
+    }
+}
+
+static bool sink_pass(const ElogSink *sink, uint8_t level, const char *tag) {
+    return level <= sink->level && (sink->tag[0] == '\0' || strstr(tag, sink->tag) != NULL);
+}
+
+/**
+ * put whole data into a ring, it can be called from any interrupt.
+ *
+ * @param ring ring buffer
+ * @param data data
+ * @param size data size
+ *
+ * @return false: not enough space, nothing is written
+ */
+bool elog_ring_put(ElogRing *ring, const char *data, size_t size) {
+    uint32_t index;
+
+    if (!ring_reserve(ring, size, &index)) {
+        return false;
+    }
+    ring_write(ring, index, data, size);
+    ring_release(ring);
+
+    return true;
+}
+
+/**
+ * get the complete data in a ring, only for its single consumer
+ *
+ * @param ring ring buffer
+ *
+ * @return data size
+ */
+size_t elog_ring_used(ElogRing *ring) {
+    return (ring->commit - ring->tail) & RING_INDEX_MASK;
+}
+
+/**
+ * get the complete data before the end of ring buffer, only for its single consumer
+ *
+ * @param ring ring buffer
+ * @param data start of the data
+ *
+ * @return continuous data size, 0: empty
+ */
+size_t elog_ring_peek(ElogRing *ring, const char **data) {
+    size_t used = elog_ring_used(ring);
+    size_t offset = ring->tail & (ring->size - 1);
+
+    *data = ring->buf + offset;
+
+    return used < ring->size - offset ? used : ring->size - offset;
+}
+
+/**
+ * give consumed data back to the writers, only for its single consumer
+ *
+ * @param ring ring buffer
+ * @param size consumed size
+ */
+void elog_ring_skip(ElogRing *ring, size_t size) {
+    /* reads of the data are done before writers can reuse the space */
+    __DMB();
+    ring->tail = (ring->tail + size) & RING_INDEX_MASK;
+}
+
+/**
+ * reserve space and count one more writer
+ *
+ * @param size log size
+ * @param index start of the reserved space
+ *
+ * @return false: not enough space
+ */
+static bool ring_reserve(ElogRing *ring, size_t size, uint32_t *index) {
+    uint32_t state, head;
+
+    do {
+        state = __LDREXW(&ring->state);
+        head = state & RING_INDEX_MASK;
+        if (((head - ring->tail) & RING_INDEX_MASK) + size > ring->size) {
+            __CLREX();
+            return false;
+        }
+    } while (__STREXW(((head + size) & RING_INDEX_MASK) | ((state & ~RING_INDEX_MASK) + RING_WRITER_ONE),
+            &ring->state) != 0);
+    *index = head;
+
+    return true;
+}
+
+static void ring_write(ElogRing *ring, uint32_t index, const char *data, size_t size) {
+    size_t offset = index & (ring->size - 1);
+    size_t first = ring->size - offset;
+
+    if (first >= size) {
+        memcpy(ring->buf + offset, data, size);
+    } else {
+        memcpy(ring->buf + offset, data, first);
+        memcpy(ring->buf, data + first, size - first);
+    }
+}
+
+/**
+ * become the only consumer of a sink
+ *
+ * @return false: another context is draining
+ */
+static bool drain_take(ElogSink *sink) {
+    do {
+        if (__LDREXW(&sink->drain_owned) != 0) {
+            __CLREX();
+            return false;
+        }
+    } while (__STREXW(1, &sink->drain_owned) != 0);
+    __DMB();
+
+    return true;
+}
+
+/**
+ * count one less writer, the last one publishes everything reserved so far
+ */
+static void ring_release(ElogRing *ring) {
+    uint32_t state, head, commit;
+
+    /* log data must be visible before the writer count drops */
+    __DMB();
+    do {
+        state = __LDREXW(&ring->state) - RING_WRITER_ONE;
+    } while (__STREXW(state, &ring->state) != 0);
+    if ((state & ~RING_INDEX_MASK) != 0) {
+        /* an interrupted writer is still copying, it will publish */
+        return;
+    }
+
+    head = state & RING_INDEX_MASK;
+    do {
+        commit = __LDREXW(&ring->commit);
+        /* a later writer may have published a newer index already */
+        if (((head - commit) & RING_INDEX_MASK) - 1 >= ring->size) {
+            __CLREX();
+            return;
+        }
+    } while (__STREXW(head, &ring->commit) != 0);
+}
 #endif /* ELOG_BUF_OUTPUT_ENABLE */
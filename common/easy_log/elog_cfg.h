@@ -36,18 +36,36 @@
 /* enable assert check */
 #define ELOG_ASSERT_ENABLE
 /* buffer size for every line's log */
-#define ELOG_LINE_BUF_SIZE                       512
+#define ELOG_LINE_BUF_SIZE                       256
+/* line buffers for nested contexts, main loop and interrupt priorities that log */
+#define ELOG_LINE_BUF_NEST_NUM                   3
 /* output line number max length */
 #define ELOG_LINE_NUM_MAX_LEN                    4
 /* output filter's tag max length */
 #define ELOG_FILTER_TAG_MAX_LEN                  16
 /* output filter's keyword max length */
 #define ELOG_FILTER_KW_MAX_LEN                   16
+/* interned tags max num, every tag used by elog_x gets a small id for level filtering */
+#define ELOG_TAG_MAX_NUM                         32
 /* output filter's tag level max num */
 #define ELOG_FILTER_TAG_LVL_MAX_NUM              5
 /* output newline sign */
 #define ELOG_NEWLINE_SIGN                        "\n"
 /*---------------------------------------------------------------------------*/
+/* enable rate limiting, every tag has a token bucket and logs beyond it are dropped.
+ * off by default: command replies are logs too and a long listing would lose lines */
+// #define ELOG_RATE_LIMIT_ENABLE
+/* default logs per second and burst of every tag, 0 logs per second: no limit. assert logs are never limited */
+#define ELOG_RATE_LIMIT_PER_SEC                  10
+#define ELOG_RATE_LIMIT_BURST                    40
+/* enable repeat suppression, consecutive identical logs are output once and then counted.
+ * off by default: a command run twice would only answer once */
+// #define ELOG_REPEAT_SUPPRESS_ENABLE
+/* a long run of repeats is reported every this many repeats */
+#define ELOG_REPEAT_REPORT_NUM                   100
+/* a run that stops is reported by elog_repeat_flush after this many ms without a repeat */
+#define ELOG_REPEAT_FLUSH_MS                     1000
+/*---------------------------------------------------------------------------*/
 /* enable log color */
 #define ELOG_COLOR_ENABLE
 /* change the some level logs to not default color if you want */
@@ -71,7 +89,46 @@
 /*---------------------------------------------------------------------------*/
 /* enable buffered output mode */
  #define ELOG_BUF_OUTPUT_ENABLE
-/* buffer size for buffered output mode */
-#define ELOG_BUF_OUTPUT_BUF_SIZE                 (ELOG_LINE_BUF_SIZE * 2)
+/* console sink's buffer size for buffered output mode */
+#define ELOG_BUF_OUTPUT_BUF_SIZE                 1024
+/* max sinks, each one has its own buffer, level, tag filter and mode */
+#define ELOG_SINK_MAX_NUM                        4
+/* enable the UART1 sink, UART1 is then only used by logs */
+// #define ELOG_SINK_UART1_ENABLE
+/* enable the RAM sink, it keeps the newest logs and log_ram prints them */
+#define ELOG_SINK_RAM_ENABLE
+/* RAM sink size, must be a power of 2 */
+#define ELOG_SINK_RAM_SIZE                       1024
+/*---------------------------------------------------------------------------*/
+/* enable binary output mode, elog_bin_x logs are decoded by tools/elog_decode.py */
+#define ELOG_BIN_OUTPUT_ENABLE
+/* max arguments of one binary log, every argument is 32 bits */
+#define ELOG_BIN_MAX_ARGS                        8
+/* call site id is the descriptor's word offset from this address (flash base) */
+#define ELOG_BIN_SITE_BASE                       0x08000000UL
+/* the console UART sends binary records (LZ frames with ELOG_LZ_OUTPUT_ENABLE) instead of text, it is also
+ * the command shell, so this needs tools/elog_decode.py on the host. "log_sink uart0 bin" switches at run time */
+// #define ELOG_CONSOLE_BIN_ENABLE
+/*---------------------------------------------------------------------------*/
+/* enable compression, UART sinks in ELOG_SINK_LZ mode send LZ frames which tools/elog_decode.py expands,
+ * the console uses it with ELOG_CONSOLE_BIN_ENABLE */
+// #define ELOG_LZ_OUTPUT_ENABLE
+/* history window, fixed by the match token format */
+#define ELOG_LZ_WINDOW_SIZE                      1024
+/* match finder hash entries (2 bytes each), must be a power of 2 and no more than 4096 */
+#define ELOG_LZ_HASH_SIZE                        512
+/* history is reset every this many frames so a reader can start in the middle */
+#define ELOG_LZ_RESET_FRAMES                     64
+/*---------------------------------------------------------------------------*/
+/* enable flash log mode, every buffered log is also kept in a circular flash region */
+#define ELOG_FLASH_ENABLE
+/* flash region, whole pages and out of the program's IROM */
+#define ELOG_FLASH_START_ADDR                    0x08034000UL
+#define ELOG_FLASH_SIZE                          0x8000UL
+#define ELOG_FLASH_PAGE_SIZE                     0x800UL
+/* RAM staging buffer size for logs waiting to be programmed, must be a power of 2 */
+#define ELOG_FLASH_BUF_SIZE                      1024
+/* words programmed per elog_flash_process call */
+#define ELOG_FLASH_PROGRAM_WORDS                 16
 
 #endif /* _ELOG_CFG_H_ */
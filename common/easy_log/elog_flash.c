@@ -0,0 +1,415 @@
+/*
+ * This file is part of the EasyLogger Library.
+ *
+ * Function: Keep logs in a circular flash region that survives reset.
+ *           It is a sink, logs are copied into its RAM ring by whoever outputs them, the main loop
+ *           programs a few words per elog_flash_process call and erases the page ahead when
+ *           the current one is full, so logging never waits for flash. Pages are used in turn,
+ *           every page is erased once per lap of the region.
+ *
+ *           page:  magic (u32), sequence (u32), chunks...
+ *           chunk: length (u16), ~length (u16), data padded with 0xFF to whole words
+ *
+ *           A chunk only holds whole logs, a log that does not fit in the rest of a page starts
+ *           the next page, so every page decodes on its own after the oldest one is erased.
+ *
+ *           A chunk's header is programmed after its data and a page's magic after its
+ *           sequence, so a reset in the middle leaves an erased header and the data is ignored.
+ */
+
+#include "elog.h"
+#include <string.h>
+#include "gd32f30x.h"
+
+#ifdef ELOG_FLASH_ENABLE
+#if !defined(ELOG_BUF_OUTPUT_ENABLE)
+    #error "flash log mode is fed by buffered output mode, please enable ELOG_BUF_OUTPUT_ENABLE"
+#endif
+
+#if (ELOG_FLASH_START_ADDR % ELOG_FLASH_PAGE_SIZE) != 0 || (ELOG_FLASH_SIZE % ELOG_FLASH_PAGE_SIZE) != 0 \
+        || ELOG_FLASH_SIZE < 2 * ELOG_FLASH_PAGE_SIZE
+    #error "flash log region must be at least two whole pages"
+#endif
+
+#if (ELOG_FLASH_BUF_SIZE & (ELOG_FLASH_BUF_SIZE - 1)) != 0
+    #error "ELOG_FLASH_BUF_SIZE must be a power of 2"
+#endif
+
+#if ELOG_LINE_BUF_SIZE > ELOG_FLASH_PAGE_SIZE - 12
+    #error "a log line must fit in an empty flash log page"
+#endif
+
+#define PAGE_NUM             (ELOG_FLASH_SIZE / ELOG_FLASH_PAGE_SIZE)
+#define PAGE_MAGIC           0x474F4C45UL            /* "ELOG" */
+#define PAGE_HEADER_SIZE     8
+#define CHUNK_HEADER_SIZE    4
+/* binary record: 0xFF, level << 4 | nargs, site id (u16), timestamp (u32), args (u32 * nargs) */
+#define BIN_RECORD_MARK      0xFF
+#define BIN_RECORD_SIZE(b1)  (8 + 4 * ((b1) & 0x0F))
+#define ERASED_WORD          0xFFFFFFFFUL
+/* a log dump sends this much at most from one chunk before trying the next write */
+#define DUMP_PIECE_SIZE      64
+
+#define PAGE_ADDR(page)      (ELOG_FLASH_START_ADDR + (uint32_t)(page) * ELOG_FLASH_PAGE_SIZE)
+#define WORD_ALIGN(size)     (((size) + 3) & ~3UL)
+#define FLASH_WORD(addr)     (*(const volatile uint32_t *)(addr))
+
+/* logs waiting to be programmed, text and binary records as they are */
+static char stage_buf[ELOG_FLASH_BUF_SIZE];
+static ElogSink flash_sink = ELOG_SINK_INIT("flash", stage_buf, NULL, NULL, ELOG_SINK_BIN, ELOG_LVL_VERBOSE);
+
+/* page being written and its sequence, the next page gets sequence + 1 */
+static uint16_t cur_page = PAGE_NUM - 1;
+static uint32_t cur_seq = 0;
+/* false: the next page must be erased before anything is programmed */
+static bool page_ready = false;
+/* header of the next chunk */
+static uint32_t write_addr = 0;
+/* chunk being programmed, its length is fixed when it starts */
+static uint32_t chunk_len = 0;
+static uint32_t chunk_done = 0;
+
+/* dump state, programming waits while a dump is running */
+static bool dumping = false;
+static uint16_t dump_count = 0;
+static uint32_t dump_addr = 0;
+static uint32_t dump_end = 0;
+static const char *dump_data = NULL;
+static uint32_t dump_left = 0;
+static uint32_t dump_total = 0;
+
+extern int8_t elog_port_flash_erase(uint32_t addr);
+extern int8_t elog_port_flash_write(uint32_t addr, const uint32_t *words, size_t num);
+
+static uint32_t chunk_check(uint32_t addr, uint32_t end);
+static void page_recover(void);
+static void page_prepare(void);
+static uint8_t stage_byte(uint32_t offset);
+static uint32_t stage_records(uint32_t used, uint32_t max);
+static void stage_read(uint8_t *data, size_t size);
+static void dump_process(void);
+static bool dump_next_chunk(void);
+
+/**
+ * find the newest page and where its writing stopped, then start taking logs
+ *
+ * @return result
+ */
+ElogErrCode elog_flash_init(void) {
+    uint32_t page, addr;
+    bool found = false;
+
+    for (page = 0; page < PAGE_NUM; page++) {
+        addr = PAGE_ADDR(page);
+        if (FLASH_WORD(addr) == PAGE_MAGIC && (!found || FLASH_WORD(addr + 4) - cur_seq < 0x80000000UL)) {
+            cur_page = page;
+            cur_seq = FLASH_WORD(addr + 4);
+            found = true;
+        }
+    }
+    if (found) {
+        page_recover();
+    }
+    elog_sink_register(&flash_sink);
+
+    return ELOG_NO_ERR;
+}
+
+/**
+ * program staged logs, called from the main loop.
+ * every call programs ELOG_FLASH_PROGRAM_WORDS words at most, or erases one page.
+ */
+void elog_flash_process(void) {
+    uint32_t words[ELOG_FLASH_PROGRAM_WORDS];
+    uint32_t header, space, part, addr, used;
+    size_t num = 0;
+
+    if (dumping) {
+        dump_process();
+        return;
+    }
+    if (!page_ready) {
+        page_prepare();
+        return;
+    }
+
+    if (chunk_len == 0) {
+        used = elog_ring_used(&flash_sink.ring);
+        if (used == 0) {
+            return;
+        }
+        space = PAGE_ADDR(cur_page) + ELOG_FLASH_PAGE_SIZE - write_addr;
+        chunk_len = space < CHUNK_HEADER_SIZE + 4 ? 0 : stage_records(used, space - CHUNK_HEADER_SIZE);
+        if (chunk_len == 0) {
+            if (write_addr != PAGE_ADDR(cur_page) + PAGE_HEADER_SIZE) {
+                /* the next log does not fit, it goes to the next page */
+                page_ready = false;
+                return;
+            }
+            /* only data that is not a log can be longer than a page, it is split */
+            chunk_len = used < space - CHUNK_HEADER_SIZE ? used : space - CHUNK_HEADER_SIZE;
+        }
+        chunk_done = 0;
+    }
+
+    /* data words first, in one batch */
+    addr = write_addr + CHUNK_HEADER_SIZE + chunk_done;
+    while (num < ELOG_FLASH_PROGRAM_WORDS && chunk_done < chunk_len) {
+        part = chunk_len - chunk_done < 4 ? chunk_len - chunk_done : 4;
+        words[num] = ERASED_WORD;
+        stage_read((uint8_t *)&words[num], part);
+        num++;
+        chunk_done += part;
+    }
+    if (elog_port_flash_write(addr, words, num) != 0) {
+        /* programming failed, the rest of this page is not trusted */
+        chunk_len = 0;
+        page_ready = false;
+        return;
+    }
+    if (chunk_done < chunk_len) {
+        return;
+    }
+
+    /* data is complete, the header makes it visible */
+    header = chunk_len | ((~chunk_len & 0xFFFF) << 16);
+    if (elog_port_flash_write(write_addr, &header, 1) != 0) {
+        page_ready = false;
+    }
+    write_addr += CHUNK_HEADER_SIZE + WORD_ALIGN(chunk_len);
+    chunk_len = 0;
+}
+
+/**
+ * start sending the stored logs from the oldest page through the output device.
+ * the dump runs in elog_flash_process as fast as the output device takes it.
+ *
+ * @return false: a dump is running already
+ */
+bool elog_flash_dump(void) {
+    if (dumping) {
+        return false;
+    }
+    dump_count = 0;
+    dump_addr = 0;
+    dump_left = 0;
+    dump_total = 0;
+    dumping = true;
+
+    return true;
+}
+
+/**
+ * get the flash sink to change its filter or read its statistics
+ *
+ * @return flash sink
+ */
+ElogSink *elog_flash_get_sink(void) {
+    return &flash_sink;
+}
+
+/**
+ * check a chunk header
+ *
+ * @param addr chunk header address
+ * @param end page end
+ *
+ * @return chunk length, 0: erased or broken header
+ */
+static uint32_t chunk_check(uint32_t addr, uint32_t end) {
+    uint32_t header, len;
+
+    if (addr + CHUNK_HEADER_SIZE > end) {
+        return 0;
+    }
+    header = FLASH_WORD(addr);
+    len = header & 0xFFFF;
+    if (len == 0 || (header >> 16) != (~len & 0xFFFF) || addr + CHUNK_HEADER_SIZE + len > end) {
+        return 0;
+    }
+
+    return len;
+}
+
+/**
+ * continue after the last complete chunk of the current page.
+ * the page is left for the next one if a broken chunk or programmed data follows it.
+ */
+static void page_recover(void) {
+    uint32_t end = PAGE_ADDR(cur_page) + ELOG_FLASH_PAGE_SIZE;
+    uint32_t addr = PAGE_ADDR(cur_page) + PAGE_HEADER_SIZE;
+    uint32_t len;
+
+    while ((len = chunk_check(addr, end)) != 0) {
+        addr += CHUNK_HEADER_SIZE + WORD_ALIGN(len);
+    }
+    write_addr = addr;
+    for (; addr < end; addr += 4) {
+        if (FLASH_WORD(addr) != ERASED_WORD) {
+            return;
+        }
+    }
+    page_ready = true;
+}
+
+/**
+ * erase the next page and write its header, this is the only call that waits for a whole page
+ */
+static void page_prepare(void) {
+    uint16_t page = (cur_page + 1) % PAGE_NUM;
+    uint32_t header[2];
+
+    cur_page = page;
+    cur_seq++;
+    if (elog_port_flash_erase(PAGE_ADDR(page)) != 0) {
+        /* a bad page is skipped, the next call tries the page after it */
+        return;
+    }
+    header[0] = cur_seq;
+    if (elog_port_flash_write(PAGE_ADDR(page) + 4, &header[0], 1) != 0) {
+        return;
+    }
+    header[1] = PAGE_MAGIC;
+    if (elog_port_flash_write(PAGE_ADDR(page), &header[1], 1) != 0) {
+        return;
+    }
+    write_addr = PAGE_ADDR(page) + PAGE_HEADER_SIZE;
+    page_ready = true;
+}
+
+/**
+ * get a staged byte without taking it
+ *
+ * @param offset offset from the oldest staged byte
+ *
+ * @return staged byte
+ */
+static uint8_t stage_byte(uint32_t offset) {
+    return (uint8_t)flash_sink.ring.buf[(flash_sink.ring.tail + offset) & (flash_sink.ring.size - 1)];
+}
+
+/**
+ * find how many staged bytes make whole logs and fit in a chunk.
+ * a text log ends with its newline, or where a binary record starts if it has none,
+ * 0xFF never appears in UTF-8 text.
+ *
+ * @param used staged bytes, the ring only holds whole logs
+ * @param max chunk space
+ *
+ * @return length of the whole logs, 0: the first log does not fit
+ */
+static uint32_t stage_records(uint32_t used, uint32_t max) {
+    uint32_t len = 0, next;
+
+    while (len < used) {
+        if (stage_byte(len) == BIN_RECORD_MARK) {
+            next = len + 1 < used ? len + BIN_RECORD_SIZE(stage_byte(len + 1)) : used;
+        } else {
+            next = len + 1;
+            while (next < used && next <= max && stage_byte(next - 1) != '\n'
+                    && stage_byte(next) != BIN_RECORD_MARK) {
+                next++;
+            }
+        }
+        if (next > used) {
+            next = used;
+        }
+        if (next > max) {
+            break;
+        }
+        len = next;
+    }
+
+    return len;
+}
+
+/**
+ * take staged bytes, the copy may cross the end of the ring
+ */
+static void stage_read(uint8_t *data, size_t size) {
+    const char *part;
+    size_t len;
+
+    while (size > 0) {
+        len = elog_ring_peek(&flash_sink.ring, &part);
+        if (len > size) {
+            len = size;
+        }
+        memcpy(data, part, len);
+        elog_ring_skip(&flash_sink.ring, len);
+        data += len;
+        size -= len;
+    }
+}
+
+/**
+ * send stored chunks until the output buffer is full
+ */
+static void dump_process(void) {
+    static const char begin_string[] = "\n--- flash log begin ---\n";
+    char end_string[64];
+    uint32_t part;
+    int len;
+
+    if (dump_count == 0) {
+        /* dump_count 0: the begin notice is not sent yet */
+        if (!elog_buf_write(begin_string, sizeof(begin_string) - 1)) {
+            return;
+        }
+        dump_count = 1;
+    }
+
+    for (;;) {
+        if (dump_left == 0 && !dump_next_chunk()) {
+            len = elog_snprintf(end_string, sizeof(end_string), "\n--- flash log end, %u bytes, %u dropped ---\n",
+                    (unsigned)dump_total, (unsigned)flash_sink.dropped);
+            if (elog_buf_write(end_string, (size_t)len < sizeof(end_string) ? (size_t)len : sizeof(end_string) - 1)) {
+                dumping = false;
+            }
+            return;
+        }
+        part = dump_left < DUMP_PIECE_SIZE ? dump_left : DUMP_PIECE_SIZE;
+        if (!elog_buf_write(dump_data, part)) {
+            /* the output device drains the buffer, continue in the next call */
+            return;
+        }
+        dump_data += part;
+        dump_left -= part;
+        dump_total += part;
+    }
+}
+
+/**
+ * move to the next stored chunk, pages are visited from the one after the current page
+ *
+ * @return false: all pages are sent
+ */
+static bool dump_next_chunk(void) {
+    uint32_t page, len;
+
+    for (;;) {
+        if (dump_addr == 0) {
+            /* dump_count 1 is the oldest page, PAGE_NUM the current one */
+            if (dump_count > PAGE_NUM) {
+                return false;
+            }
+            page = (cur_page + dump_count) % PAGE_NUM;
+            dump_count++;
+            if (FLASH_WORD(PAGE_ADDR(page)) != PAGE_MAGIC) {
+                continue;
+            }
+            dump_addr = PAGE_ADDR(page) + PAGE_HEADER_SIZE;
+            dump_end = PAGE_ADDR(page) + ELOG_FLASH_PAGE_SIZE;
+        }
+        len = chunk_check(dump_addr, dump_end);
+        if (len == 0) {
+            dump_addr = 0;
+            continue;
+        }
+        dump_data = (const char *)dump_addr + CHUNK_HEADER_SIZE;
+        dump_left = len;
+        dump_addr += CHUNK_HEADER_SIZE + WORD_ALIGN(len);
+        return true;
+    }
+}
+#endif /* ELOG_FLASH_ENABLE */
@@ -0,0 +1,485 @@
+/*
+ * This file is part of the EasyLogger Library.
+ *
+ * Function: Small printf-like formatter used instead of the C library's vsnprintf.
+ *           No heap, no locale, no double precision printf engine, one small stack frame.
+ *           Supported: %d %i %u %x %X %o %c %s %p %% and %f with fixed-point rendering,
+ *           flags '-' '0' '+' ' ', width and precision (number or '*'),
+ *           length hh h l ll z j t. Other conversions are copied to the output as they are.
+ *           Arguments come from a va_list, or from the 32 bits words of a binary log.
+ */
+
+#include "elog.h"
+#include <stdarg.h>
+
+/* output state, everything after size - 1 is counted but not stored like vsnprintf */
+typedef struct {
+    char *buf;
+    size_t size;
+    size_t len;
+} ElogFmtOut;
+
+/* arguments from a va_list, or 32 bits words when ap is NULL, missing words read as 0 */
+typedef struct {
+    va_list *ap;
+    const uint32_t *words;
+    uint8_t num;
+    uint8_t index;
+} ElogFmtArgs;
+
+#define FLAG_LEFT            (1 << 0)
+#define FLAG_ZERO            (1 << 1)
+#define FLAG_PLUS            (1 << 2)
+#define FLAG_SPACE           (1 << 3)
+#define FLAG_UPPER           (1 << 4)
+
+/* %f precision is limited so the fraction fits in 32 bits */
+#define FIXED_MAX_PREC       9
+
+static const uint32_t pow10_table[FIXED_MAX_PREC + 1] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+};
+
+static void fmt_putc(ElogFmtOut *out, char ch) {
+    if (out->len + 1 < out->size) {
+        out->buf[out->len] = ch;
+    }
+    out->len++;
+}
+
+static void fmt_pad(ElogFmtOut *out, char ch, int count) {
+    while (count-- > 0) {
+        fmt_putc(out, ch);
+    }
+}
+
+/**
+ * output digits with sign, padding and minimum digits
+ *
+ * @param digits digits in reverse order
+ * @param num digits number
+ * @param sign sign char, 0 for none
+ * @param width minimum field width
+ * @param min_digits minimum digits, zeros are added in front
+ */
+static void fmt_field(ElogFmtOut *out, const char *digits, int num, char sign, int width, int min_digits,
+        uint8_t flags) {
+    int zeros = min_digits > num ? min_digits - num : 0;
+    int pad = width - num - zeros - (sign ? 1 : 0);
+
+    if (!(flags & FLAG_LEFT) && (flags & FLAG_ZERO)) {
+        /* zero padding goes after the sign */
+        zeros += pad > 0 ? pad : 0;
+        pad = 0;
+    }
+    if (!(flags & FLAG_LEFT)) {
+        fmt_pad(out, ' ', pad);
+    }
+    if (sign) {
+        fmt_putc(out, sign);
+    }
+    fmt_pad(out, '0', zeros);
+    while (num-- > 0) {
+        fmt_putc(out, digits[num]);
+    }
+    if (flags & FLAG_LEFT) {
+        fmt_pad(out, ' ', pad);
+    }
+}
+
+/**
+ * convert to digits in reverse order, 64 bits division only when the value needs it
+ *
+ * @return digits number
+ */
+static int fmt_digits(char *digits, uint64_t value, uint8_t base, uint8_t flags) {
+    const char *hex = (flags & FLAG_UPPER) ? "0123456789ABCDEF" : "0123456789abcdef";
+    uint32_t value32;
+    int num = 0;
+
+    while (value > 0xFFFFFFFFUL) {
+        digits[num++] = hex[value % base];
+        value /= base;
+    }
+    value32 = (uint32_t)value;
+    do {
+        digits[num++] = hex[value32 % base];
+        value32 /= base;
+    } while (value32 != 0);
+
+    return num;
+}
+
+static void fmt_integer(ElogFmtOut *out, uint64_t value, bool negative, uint8_t base, int width, int prec,
+        uint8_t flags) {
+    char digits[22];
+    char sign = 0;
+    int num;
+
+    if (negative) {
+        sign = '-';
+    } else if (flags & FLAG_PLUS) {
+        sign = '+';
+    } else if (flags & FLAG_SPACE) {
+        sign = ' ';
+    }
+    if (prec >= 0) {
+        /* precision given, '0' flag is ignored like printf */
+        flags &= ~FLAG_ZERO;
+    }
+    if (prec == 0 && value == 0) {
+        num = 0;
+    } else {
+        num = fmt_digits(digits, value, base, flags);
+    }
+    fmt_field(out, digits, num, sign, width, prec, flags);
+}
+
+static void fmt_string(ElogFmtOut *out, const char *str, int width, int prec, uint8_t flags) {
+    int len = 0;
+    int i;
+
+    if (str == NULL) {
+        str = "(null)";
+    }
+    while (str[len] != '\0' && (prec < 0 || len < prec)) {
+        len++;
+    }
+    if (!(flags & FLAG_LEFT)) {
+        fmt_pad(out, ' ', width - len);
+    }
+    for (i = 0; i < len; i++) {
+        fmt_putc(out, str[i]);
+    }
+    if (flags & FLAG_LEFT) {
+        fmt_pad(out, ' ', width - len);
+    }
+}
+
+/**
+ * render a floating value as integer part and rounded fraction, both by integer conversion
+ */
+static void fmt_fixed(ElogFmtOut *out, double value, int width, int prec, uint8_t flags) {
+    char digits[32];
+    char sign = 0;
+    uint64_t int_part;
+    uint32_t frac_part;
+    double frac;
+    int num = 0;
+    int i;
+
+    if (prec < 0) {
+        prec = 6;
+    } else if (prec > FIXED_MAX_PREC) {
+        prec = FIXED_MAX_PREC;
+    }
+    if (value != value) {
+        fmt_string(out, "nan", width, -1, flags);
+        return;
+    }
+    if (value < 0) {
+        sign = '-';
+        value = -value;
+    } else if (flags & FLAG_PLUS) {
+        sign = '+';
+    } else if (flags & FLAG_SPACE) {
+        sign = ' ';
+    }
+    if (value >= 18446744073709551615.0) {
+        fmt_string(out, sign == '-' ? "-inf" : "inf", width, -1, flags);
+        return;
+    }
+
+    int_part = (uint64_t)value;
+    /* halves round up, the C library may differ in the last digit when the value is a half */
+    frac = (value - (double)int_part) * pow10_table[prec] + 0.5;
+    frac_part = (uint32_t)frac;
+    if (frac_part >= pow10_table[prec]) {
+        /* rounding carried into the integer part */
+        frac_part -= pow10_table[prec];
+        int_part++;
+    }
+
+    /* digits are collected in reverse order: fraction, point, integer */
+    for (i = 0; i < prec; i++) {
+        digits[num++] = (char)('0' + frac_part % 10);
+        frac_part /= 10;
+    }
+    if (prec > 0) {
+        digits[num++] = '.';
+    }
+    num += fmt_digits(digits + num, int_part, 10, 0);
+    fmt_field(out, digits, num, sign, width, 0, flags);
+}
+
+static uint32_t arg_word(ElogFmtArgs *args) {
+    return args->index < args->num ? args->words[args->index++] : 0;
+}
+
+static int arg_int(ElogFmtArgs *args) {
+    return args->ap != NULL ? va_arg(*args->ap, int) : (int)arg_word(args);
+}
+
+/* a 32 bits word is sign extended whatever the length is */
+static int64_t arg_signed(ElogFmtArgs *args, char length) {
+    int64_t value;
+
+    if (args->ap == NULL) {
+        value = (int32_t)arg_word(args);
+    } else if (length == 'L') {
+        value = va_arg(*args->ap, long long);
+    } else if (length == 'l') {
+        value = va_arg(*args->ap, long);
+    } else {
+        value = va_arg(*args->ap, int);
+    }
+    if (length == 'h') {
+        value = (short)value;
+    } else if (length == 'H') {
+        value = (signed char)value;
+    }
+
+    return value;
+}
+
+static uint64_t arg_unsigned(ElogFmtArgs *args, char length) {
+    uint64_t value;
+
+    if (args->ap == NULL) {
+        value = arg_word(args);
+    } else if (length == 'L') {
+        value = va_arg(*args->ap, unsigned long long);
+    } else if (length == 'l') {
+        value = va_arg(*args->ap, unsigned long);
+    } else if (length == 'z') {
+        value = va_arg(*args->ap, size_t);
+    } else {
+        value = va_arg(*args->ap, unsigned int);
+    }
+    if (length == 'h') {
+        value = (unsigned short)value;
+    } else if (length == 'H') {
+        value = (unsigned char)value;
+    }
+
+    return value;
+}
+
+/* binary logs pass floats as their bits, see ELOG_BIN_FLOAT */
+static double arg_double(ElogFmtArgs *args) {
+    union {
+        uint32_t bits;
+        float value;
+    } word;
+
+    if (args->ap != NULL) {
+        return va_arg(*args->ap, double);
+    }
+    word.bits = arg_word(args);
+
+    return word.value;
+}
+
+static const void *arg_pointer(ElogFmtArgs *args) {
+    return args->ap != NULL ? va_arg(*args->ap, const void *) : (const void *)(uintptr_t)arg_word(args);
+}
+
+static int fmt_format(char *buf, size_t size, const char *format, ElogFmtArgs *args) {
+    ElogFmtOut out;
+    const char *spec;
+    uint8_t flags;
+    int width, prec;
+    char length;
+    uint64_t value;
+    int64_t svalue;
+
+    out.buf = buf;
+    out.size = size;
+    out.len = 0;
+
+    while (*format != '\0') {
+        if (*format != '%') {
+            fmt_putc(&out, *format++);
+            continue;
+        }
+        spec = format++;
+
+        /* flags */
+        flags = 0;
+        for (;; format++) {
+            if (*format == '-') {
+                flags |= FLAG_LEFT;
+            } else if (*format == '0') {
+                flags |= FLAG_ZERO;
+            } else if (*format == '+') {
+                flags |= FLAG_PLUS;
+            } else if (*format == ' ') {
+                flags |= FLAG_SPACE;
+            } else if (*format != '#') {
+                break;
+            }
+        }
+        /* width */
+        width = 0;
+        if (*format == '*') {
+            width = arg_int(args);
+            if (width < 0) {
+                flags |= FLAG_LEFT;
+                width = -width;
+            }
+            format++;
+        } else {
+            while (*format >= '0' && *format <= '9') {
+                width = width * 10 + (*format++ - '0');
+            }
+        }
+        /* precision */
+        prec = -1;
+        if (*format == '.') {
+            format++;
+            prec = 0;
+            if (*format == '*') {
+                prec = arg_int(args);
+                format++;
+            } else {
+                while (*format >= '0' && *format <= '9') {
+                    prec = prec * 10 + (*format++ - '0');
+                }
+            }
+        }
+        /* length: 'H' hh, 'h', 'l', 'L' ll, 'z' size_t and the same size j t */
+        length = 0;
+        if (*format == 'h') {
+            length = *++format == 'h' ? (format++, 'H') : 'h';
+        } else if (*format == 'l') {
+            length = *++format == 'l' ? (format++, 'L') : 'l';
+        } else if (*format == 'z' || *format == 'j' || *format == 't') {
+            length = *format == 'j' ? 'L' : 'z';
+            format++;
+        }
+
+        switch (*format) {
+        case 'd':
+        case 'i':
+            svalue = arg_signed(args, length);
+            value = svalue < 0 ? (uint64_t)0 - (uint64_t)svalue : (uint64_t)svalue;
+            fmt_integer(&out, value, svalue < 0, 10, width, prec, flags);
+            break;
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'o':
+            value = arg_unsigned(args, length);
+            if (*format == 'X') {
+                flags |= FLAG_UPPER;
+            }
+            flags &= ~(FLAG_PLUS | FLAG_SPACE);
+            fmt_integer(&out, value, false, *format == 'u' ? 10 : (*format == 'o' ? 8 : 16), width, prec,
+                    flags);
+            break;
+        case 'p':
+            fmt_putc(&out, '0');
+            fmt_putc(&out, 'x');
+            fmt_integer(&out, (uintptr_t)arg_pointer(args), false, 16, width > 2 ? width - 2 : 0,
+                    prec, flags & ~(FLAG_PLUS | FLAG_SPACE));
+            break;
+        case 'c':
+            if (!(flags & FLAG_LEFT)) {
+                fmt_pad(&out, ' ', width - 1);
+            }
+            fmt_putc(&out, (char)arg_int(args));
+            if (flags & FLAG_LEFT) {
+                fmt_pad(&out, ' ', width - 1);
+            }
+            break;
+        case 's':
+            fmt_string(&out, (const char *)arg_pointer(args), width, prec, flags);
+            break;
+        case 'f':
+        case 'F':
+            fmt_fixed(&out, arg_double(args), width, prec, flags);
+            break;
+        case '%':
+            fmt_putc(&out, '%');
+            break;
+        default:
+            /* unsupported conversion, copy it so the mistake is visible */
+            while (spec <= format && *spec != '\0') {
+                fmt_putc(&out, *spec++);
+            }
+            if (*format == '\0') {
+                format--;
+            }
+            break;
+        }
+        format++;
+    }
+
+    if (size != 0) {
+        buf[out.len < size ? out.len : size - 1] = '\0';
+    }
+
+    return (int)out.len;
+}
+
+/**
+ * format to buffer like vsnprintf, the buffer is always terminated when size is not zero
+ *
+ * @param buf output buffer
+ * @param size buffer size
+ * @param format format
+ * @param args arguments
+ *
+ * @return length of the whole output, the output is truncated when it is not less than size
+ */
+int elog_vsnprintf(char *buf, size_t size, const char *format, va_list args) {
+    ElogFmtArgs fmt_args;
+    va_list ap;
+    int result;
+
+    /* a va_list parameter may be an array, only a copy can be passed by address */
+    va_copy(ap, args);
+    fmt_args.ap = &ap;
+    result = fmt_format(buf, size, format, &fmt_args);
+    va_end(ap);
+
+    return result;
+}
+
+/**
+ * format a binary log's arguments, every conversion takes one 32 bits word
+ *
+ * @param buf output buffer
+ * @param size buffer size
+ * @param format format
+ * @param words arguments
+ * @param num arguments number
+ *
+ * @see elog_vsnprintf
+ */
+int elog_snprintf_words(char *buf, size_t size, const char *format, const uint32_t *words, uint8_t num) {
+    ElogFmtArgs fmt_args;
+
+    fmt_args.ap = NULL;
+    fmt_args.words = words;
+    fmt_args.num = num;
+    fmt_args.index = 0;
+
+    return fmt_format(buf, size, format, &fmt_args);
+}
+
+/**
+ * format to buffer like snprintf
+ *
+ * @see elog_vsnprintf
+ */
+int elog_snprintf(char *buf, size_t size, const char *format, ...) {
+    va_list args;
+    int result;
+
+    va_start(args, format);
+    result = elog_vsnprintf(buf, size, format, args);
+    va_end(args);
+
+    return result;
+}
@@ -0,0 +1,167 @@
+/*
+ * This file is part of the EasyLogger Library.
+ *
+ * Function: Streaming LZ compression of the output stream, decoded by tools/elog_decode.py.
+ *           Log lines repeat colour sequences, tags, time brackets and format text, a small
+ *           window over the recent output finds most of it. The history is kept between calls,
+ *           so each line is matched against the lines sent before it.
+ *
+ *           frame: 0xFE, length (u16, bit 15: history reset), tokens
+ *           tokens: groups of a control byte and 8 tokens, bit n set: token n is a match
+ *                   literal: 1 byte
+ *                   match: (distance - 1) low 8 bits, (distance - 1) >> 8 << 6 | (length - 3)
+ *
+ *           0xFE never appears in UTF-8 text, so frames and raw terminal output can share a link.
+ *           The history is reset every ELOG_LZ_RESET_FRAMES frames so a late reader can join.
+ */
+
+#include "elog.h"
+#include <string.h>
+
+#ifdef ELOG_LZ_OUTPUT_ENABLE
+#if ELOG_LZ_WINDOW_SIZE != 1024
+    #error "the match token has 10 bits of distance, ELOG_LZ_WINDOW_SIZE must be 1024"
+#endif
+
+#define FRAME_SYNC           0xFE
+#define FRAME_HEADER_SIZE    3
+#define FRAME_RESET          0x8000
+#define FRAME_MAX_SIZE       0x7FFF
+#define MATCH_MIN            3
+#define MATCH_MAX            (MATCH_MIN + 63)
+/* room for a control byte and the largest token */
+#define TOKEN_MAX_SIZE       3
+
+#define WINDOW_MASK          (ELOG_LZ_WINDOW_SIZE - 1)
+/* multiplicative hash of the next 3 bytes, Cortex-M4 multiplies in one cycle */
+#define HASH(a, b, c)        (((((uint32_t)(a) | (uint32_t)(b) << 8 | (uint32_t)(c) << 16) * 2654435761UL) >> 20) \
+                                & (ELOG_LZ_HASH_SIZE - 1))
+
+#if (ELOG_LZ_HASH_SIZE & (ELOG_LZ_HASH_SIZE - 1)) != 0 || ELOG_LZ_HASH_SIZE > 4096
+    #error "ELOG_LZ_HASH_SIZE must be a power of 2 and no more than 4096"
+#endif
+
+static uint8_t lz_byte(const ElogLz *lz, uint32_t index, const uint8_t *in);
+static void lz_append(ElogLz *lz, const uint8_t *in, size_t size);
+
+/**
+ * start a new stream, the next frame tells the reader to forget its history
+ *
+ * @param lz compressor
+ */
+void elog_lz_init(ElogLz *lz) {
+    lz->pos = 0;
+    lz->frames = 0;
+    lz->in_bytes = 0;
+    lz->out_bytes = 0;
+}
+
+/**
+ * compress as much of the input as surely fits in the output as one frame
+ *
+ * @param lz compressor
+ * @param log input
+ * @param size input size
+ * @param out output buffer
+ * @param out_size output buffer size
+ * @param out_len frame size
+ *
+ * @return input bytes compressed, 0: the output buffer is too small for a frame
+ */
+size_t elog_lz_compress(ElogLz *lz, const char *log, size_t size, uint8_t *out, size_t out_size, size_t *out_len) {
+    const uint8_t *in = (const uint8_t *)log;
+    uint8_t *control = NULL;
+    uint32_t token_num = 0, header;
+    uint32_t candidate, distance, len, max_len, hash;
+    size_t done = 0, olen = FRAME_HEADER_SIZE;
+
+    *out_len = 0;
+    if (out_size > FRAME_MAX_SIZE) {
+        out_size = FRAME_MAX_SIZE;
+    }
+    if (size == 0 || out_size < FRAME_HEADER_SIZE + TOKEN_MAX_SIZE) {
+        return 0;
+    }
+
+    header = 0;
+    if (lz->frames == 0) {
+        /* history starts from this frame */
+        lz->pos = 0;
+        header = FRAME_RESET;
+    }
+
+    while (done < size && olen + TOKEN_MAX_SIZE <= out_size) {
+        if (token_num % 8 == 0) {
+            control = &out[olen++];
+            *control = 0;
+        }
+
+        len = 0;
+        max_len = size - done < MATCH_MAX ? size - done : MATCH_MAX;
+        if (max_len >= MATCH_MIN) {
+            hash = HASH(in[done], in[done + 1], in[done + 2]);
+            candidate = lz->head[hash];
+            lz->head[hash] = (uint16_t)lz->pos;
+            distance = (uint16_t)(lz->pos - candidate);
+            if (distance != 0 && distance <= ELOG_LZ_WINDOW_SIZE && distance <= lz->pos) {
+                candidate = lz->pos - distance;
+                while (len < max_len && lz_byte(lz, candidate + len, in + done) == in[done + len]) {
+                    len++;
+                }
+            }
+        }
+
+        if (len >= MATCH_MIN) {
+            *control |= 1 << (token_num % 8);
+            out[olen++] = (uint8_t)(distance - 1);
+            out[olen++] = (uint8_t)(((distance - 1) >> 8) << 6 | (len - MATCH_MIN));
+        } else {
+            len = 1;
+            out[olen++] = in[done];
+        }
+        token_num++;
+        lz_append(lz, in + done, len);
+        done += len;
+    }
+
+    header |= olen - FRAME_HEADER_SIZE;
+    out[0] = FRAME_SYNC;
+    out[1] = (uint8_t)header;
+    out[2] = (uint8_t)(header >> 8);
+    *out_len = olen;
+
+    if (++lz->frames >= ELOG_LZ_RESET_FRAMES) {
+        lz->frames = 0;
+    }
+    lz->in_bytes += done;
+    lz->out_bytes += olen;
+
+    return done;
+}
+
+/**
+ * get a byte before or inside the input, a match may overlap the bytes it copies
+ */
+static uint8_t lz_byte(const ElogLz *lz, uint32_t index, const uint8_t *in) {
+    if (index < lz->pos) {
+        return lz->window[index & WINDOW_MASK];
+    }
+
+    return in[index - lz->pos];
+}
+
+/**
+ * move encoded bytes to the history, every position after the first one is hashed too
+ */
+static void lz_append(ElogLz *lz, const uint8_t *in, size_t size) {
+    size_t i;
+
+    for (i = 0; i < size; i++) {
+        if (i != 0 && i + 2 < size) {
+            lz->head[HASH(in[i], in[i + 1], in[i + 2])] = (uint16_t)lz->pos;
+        }
+        lz->window[lz->pos & WINDOW_MASK] = in[i];
+        lz->pos++;
+    }
+}
+#endif /* ELOG_LZ_OUTPUT_ENABLE */
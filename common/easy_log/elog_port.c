@@ -26,14 +26,14 @@
  * Created on: 2015-04-28
  */
  
-#include <stdio.h> 
-#include "stdarg.h"
 #include "string.h"
 
 #include "elog.h"
 
+#include "gd32f30x.h"
 #include "driver.h"
 #include "system_timer.h"
+#include "terminal_com.h"
 // #include "FreeRTOS.h"
 // #include "semphr.h"
 
@@ -45,16 +45,79 @@
 	#endif
 #endif // #define USE_UART_LOG
 
-// 这里是默认就是使用buffer模式了
-const char overflow_string[] = "\nuart overflow\n";
-#define UART_DMA_BUFFER_LEN	    ELOG_BUF_OUTPUT_BUF_SIZE + sizeof(overflow_string)
+// 这里是默认就是使用buffer模式了，每个sink有自己的缓存，缓存区满时的溢出提示由elog_buf写入
+// 每个日志串口两个DMA缓存轮流使用：一个在发送，另一个接收sink取出的日志，发送完成中断里立即换过来发送
+#define UART_DMA_BUFFER_LEN	    (ELOG_BUF_OUTPUT_BUF_SIZE / 2)
 #define LOG_BAUDRATE       115200U
+#define ELOG_BENCH_ROUNDS       4
+#define LOG_RAM_PIECE_LEN       64      // log_ram每次放进终端缓存的长度
 
-static uint8_t dma_send_buffer[UART_DMA_BUFFER_LEN];
-static uint8_t overflow_flag = 0;
+// 终端串口也是命令行，默认发送文本；二进制记录里的0xFF/0xFE普通终端显示不了，要打开ELOG_CONSOLE_BIN_ENABLE
+#if defined(ELOG_CONSOLE_BIN_ENABLE) && defined(ELOG_LZ_OUTPUT_ENABLE)
+#define CONSOLE_MODE            ELOG_SINK_LZ
+#elif defined(ELOG_CONSOLE_BIN_ENABLE)
+#define CONSOLE_MODE            ELOG_SINK_BIN
+#else
+#define CONSOLE_MODE            ELOG_SINK_TEXT
+#endif
 
-static int8_t log_uart_init(void);
-static int8_t log_uart_printf(const char * _format, ...);
+#if defined(ELOG_SINK_RAM_ENABLE) && (ELOG_SINK_RAM_SIZE <= ELOG_LINE_BUF_SIZE || (ELOG_SINK_RAM_SIZE & (ELOG_SINK_RAM_SIZE - 1)) != 0)
+    #error "ELOG_SINK_RAM_SIZE must be a power of 2 and larger than a line"
+#endif
+
+// 日志串口的发送状态，只在对应sink的elog_sink_flush持有者里使用
+typedef struct
+{
+    UartStruct *uart;
+    uint8_t buffer[2][UART_DMA_BUFFER_LEN];
+    uint8_t fill_index;                 // 正在填充的缓存
+    uint16_t fill_len;
+#ifdef ELOG_LZ_OUTPUT_ENABLE
+    ElogLz lz;                          // 压缩历史
+    uint8_t lz_started;                 // 切换到压缩模式后第一帧重新开始历史
+#endif
+}LogUart;
+
+static size_t log_uart_write(ElogSink *sink, const char *log, size_t size);
+
+static LogUart log_uart0 = { TERMINAL_UART };
+static char uart0_buf[ELOG_BUF_OUTPUT_BUF_SIZE];
+static ElogSink uart0_sink = ELOG_SINK_INIT("uart0", uart0_buf, &log_uart_write, &log_uart0, CONSOLE_MODE,
+    ELOG_LVL_VERBOSE);
+#ifdef ELOG_SINK_UART1_ENABLE
+static LogUart log_uart1 = { &Uart1 };
+static char uart1_buf[ELOG_BUF_OUTPUT_BUF_SIZE];
+static ElogSink uart1_sink = ELOG_SINK_INIT("uart1", uart1_buf, &log_uart_write, &log_uart1, ELOG_SINK_TEXT,
+    ELOG_LVL_VERBOSE);
+#endif
+#ifdef ELOG_SINK_RAM_ENABLE
+static size_t log_ram_write(ElogSink *sink, const char *log, size_t size);
+
+// 只保留警告以上的最新日志，出问题后用log_ram查看
+static char ram_buf[ELOG_SINK_RAM_SIZE];
+static ElogSink ram_sink = ELOG_SINK_INIT("ram", ram_buf, &log_ram_write, NULL, ELOG_SINK_TEXT, ELOG_LVL_WARN);
+#endif
+
+static int8_t log_uart_init(LogUart *log_uart, UartSendCpltFunc send_complete);
+static void log_uart0_send_complete(void);
+static void log_lvl_command(void);
+static void log_sink_command(void);
+#ifdef ELOG_RATE_LIMIT_ENABLE
+static void log_rate_command(void);
+#endif
+#ifdef ELOG_SINK_UART1_ENABLE
+static void log_uart1_send_complete(void);
+#endif
+#ifdef ELOG_SINK_RAM_ENABLE
+static void log_ram_command(void);
+#endif
+#ifdef ELOG_FLASH_ENABLE
+static void fmc_flags_clear(void);
+static void log_dump_command(void);
+#endif
+#ifdef ELOG_BIN_OUTPUT_ENABLE
+static void elog_bench_command(void);
+#endif
 
 /**
  * EasyLogger port initialize
@@ -66,7 +129,28 @@ ElogErrCode elog_port_init(void) {
 
     /* add your code here */
     // OutputLockMutex = xSemaphoreCreateMutex();
-    log_uart_init();
+    // 第一个注册的是终端
+    log_uart_init(&log_uart0, &log_uart0_send_complete);
+    elog_sink_register(&uart0_sink);
+#ifdef ELOG_SINK_UART1_ENABLE
+    log_uart_init(&log_uart1, &log_uart1_send_complete);
+    elog_sink_register(&uart1_sink);
+#endif
+#ifdef ELOG_SINK_RAM_ENABLE
+    elog_sink_register(&ram_sink);
+    TerminalCommandRegister("log_ram", &log_ram_command);
+#endif
+    TerminalCommandRegister("log_lvl", &log_lvl_command);
+    TerminalCommandRegister("log_sink", &log_sink_command);
+#ifdef ELOG_RATE_LIMIT_ENABLE
+    TerminalCommandRegister("log_rate", &log_rate_command);
+#endif
+#ifdef ELOG_FLASH_ENABLE
+    TerminalCommandRegister("log_dump", &log_dump_command);
+#endif
+#ifdef ELOG_BIN_OUTPUT_ENABLE
+    TerminalCommandRegister("elog_bench", &elog_bench_command);
+#endif
     
     return result;
 }
@@ -81,30 +165,105 @@ void elog_port_deinit(void) {
 
 }
 
+/**
+ * 串口sink的writer：把日志复制到正在填充的DMA缓存，串口空闲时立即发送
+ * 只能由sink的elog_sink_flush持有者调用，发送完成中断也是通过elog_sink_flush进来的
+ * 二进制日志里有0，按长度原样发送，不能当作字符串处理
+ *
+ * @param sink 串口sink，port指向LogUart
+ * @param log output of log, size为0时只检查有没有待发送的数据
+ * @param size log size
+ * @return 放进缓存的长度，缓存满时小于size
+ */
+static size_t log_uart_write(ElogSink *sink, const char *log, size_t size)
+{
+    LogUart *log_uart = sink->port;
+    size_t written = 0;
+    size_t part;
+#ifdef ELOG_LZ_OUTPUT_ENABLE
+    size_t frame_len;
+#endif
+
+    do
+    {
+        part = size - written;
+#ifdef ELOG_LZ_OUTPUT_ENABLE
+        if(sink->mode == ELOG_SINK_LZ)
+        {
+            if(log_uart->lz_started == 0)
+            {
+                elog_lz_init(&log_uart->lz);
+                log_uart->lz_started = 1;
+            }
+            // 压缩成一帧放进缓存，剩下的空间放不下一帧时part为0
+            part = elog_lz_compress(&log_uart->lz, log + written, part,
+                &log_uart->buffer[log_uart->fill_index][log_uart->fill_len],
+                UART_DMA_BUFFER_LEN - log_uart->fill_len, &frame_len);
+            log_uart->fill_len += frame_len;
+            written += part;
+        }
+        else
+#endif
+        {
+#ifdef ELOG_LZ_OUTPUT_ENABLE
+            log_uart->lz_started = 0;
+#endif
+            if(part > UART_DMA_BUFFER_LEN - log_uart->fill_len)
+                part = UART_DMA_BUFFER_LEN - log_uart->fill_len;
+            if(part != 0)
+            {
+                memcpy(&log_uart->buffer[log_uart->fill_index][log_uart->fill_len], log + written, part);
+                log_uart->fill_len += part;
+                written += part;
+            }
+        }
+
+        // 另一个缓存发送完了就交换，剩下的日志放进空出来的缓存
+        // 终端回显占用串口时等它的发送完成中断
+        if(log_uart->fill_len == 0 || log_uart->uart->send_info.send_busy != 0)
+            break;
+        if(UartSendDMA(log_uart->uart, log_uart->buffer[log_uart->fill_index], log_uart->fill_len) != 0)
+            break;
+        log_uart->fill_index ^= 1;
+        log_uart->fill_len = 0;
+    }while(written < size);
+
+    return written;
+}
+
+#ifdef ELOG_SINK_RAM_ENABLE
+/**
+ * RAM sink的writer：平时不取走日志，剩余空间不够一行时丢掉最早的一行
+ * 由主循环的elog_flush调用
+ *
+ * @return 丢掉的长度
+ */
+static size_t log_ram_write(ElogSink *sink, const char *log, size_t size)
+{
+    const char *line_end;
+
+    if(size == 0 || sink->ring.size - elog_ring_used(&sink->ring) >= ELOG_LINE_BUF_SIZE)
+        return 0;
+    line_end = memchr(log, '\n', size);
+    return line_end != NULL ? line_end - log + 1 : size;
+}
+#endif
+
 /**
  * output log port interface
- * 增加output状态返回值，并且修改elog_buf文件对该函数的使用
+ * 不使用buffer模式时直接写到终端串口
  * @param log output of log
  * @param size log size
+ * @return 0: 全部放进了DMA缓存，-1: 缓存满
  */
 int8_t elog_port_output(const char *log, size_t size) {
     /* output to terminal */
-    int8_t ret;
-    
-    ret = log_uart_printf("%.*s", size, log);
-    if(ret < 0 && size == ELOG_BUF_OUTPUT_BUF_SIZE)
-    {
-        // 如果某一包发送失败，且需要发送的数据大小为最大值（即缓存区也已经满了）
-        // 则需要标记缓存区已经溢出了，发送的时候会在这个日志后面加一句溢出警告
-        overflow_flag = 1;
-    }
-    return ret;
-    /* add your code here */
-    
+    return log_uart_write(&uart0_sink, log, size) == size ? 0 : -1;
 }
 
 /**
  * output lock
+ * elog_buf的环形缓存不用锁，这里不能关中断，否则中断里的日志会拖慢中断
  */
 void elog_port_output_lock(void) {
     
@@ -125,20 +284,32 @@ void elog_port_output_unlock(void) {
 
 /**
  * get current time interface
+ * 秒和毫秒分开用整数输出，和原来的"%8.3f"一样宽，不用浮点格式化
  *
- * @return current time
+ * @param time 直接写进日志行
+ * @param size time剩余的长度
+ * @return 写入的长度
  */
-const char *elog_port_get_time(void) {
-    static char time_string[12];
-	uint64_t running_time_ms;
-    float running_time_s;
+size_t elog_port_get_time(char *time, size_t size) {
+    uint64_t running_time_ms;
+    int len;
 
-	running_time_ms = GetSystemTimer_ms();
-    running_time_s = running_time_ms / 1000.f;
+    if(size == 0)
+        return 0;
+    running_time_ms = GetSystemTimer_ms();
+    len = elog_snprintf(time, size, "%4u.%03u", (uint32_t)(running_time_ms / 1000),
+        (uint32_t)(running_time_ms % 1000));
 
-    sprintf(time_string, "%8.3f", running_time_s);
+    return (size_t)len < size ? (size_t)len : size - 1;
+}
 
-    return (const char *)time_string;
+/**
+ * get timestamp for binary log interface
+ *
+ * @return 系统时间的低32位，单位us，由上位机解码时展开
+ */
+uint32_t elog_port_get_timestamp(void) {
+    return (uint32_t)GetSystemTimer_us();
 }
 
 /**
@@ -163,7 +334,67 @@ const char *elog_port_get_t_info(void) {
     
 }
 
-int8_t log_uart_init(void)
+#ifdef ELOG_FLASH_ENABLE
+/**
+ * flash log erase page interface
+ * 擦除期间从flash取指令会停住，所以elog_flash每次最多擦一页
+ *
+ * @param addr page address
+ * @return 0: 成功，-1: 失败
+ */
+int8_t elog_port_flash_erase(uint32_t addr) {
+    int8_t ret = 0;
+
+    fmc_unlock();
+    fmc_flags_clear();
+    if(fmc_page_erase(addr) != FMC_READY)
+        ret = -1;
+    fmc_flags_clear();
+    fmc_lock();
+
+    return ret;
+}
+
+/**
+ * flash log program interface
+ * 一次解锁编程一批字，不在这里等待其他事情
+ *
+ * @param addr word address
+ * @param words data
+ * @param num word number
+ * @return 0: 成功，-1: 有字编程失败
+ */
+int8_t elog_port_flash_write(uint32_t addr, const uint32_t *words, size_t num) {
+    int8_t ret = 0;
+
+    fmc_unlock();
+    fmc_flags_clear();
+    for(; num > 0; num --)
+    {
+        if(fmc_word_program(addr, *words) != FMC_READY)
+            ret = -1;
+        fmc_flags_clear();
+        addr += 4;
+        words ++;
+    }
+    fmc_lock();
+
+    return ret;
+}
+
+/**
+ * @brief 清除上次操作留下的结束和错误标志，fmc_flag_clear一次只能清一个
+ *
+ */
+static void fmc_flags_clear(void)
+{
+    fmc_flag_clear(FMC_FLAG_BANK0_END);
+    fmc_flag_clear(FMC_FLAG_BANK0_WPERR);
+    fmc_flag_clear(FMC_FLAG_BANK0_PGERR);
+}
+#endif
+
+static int8_t log_uart_init(LogUart *log_uart, UartSendCpltFunc send_complete)
 {
     UartInitStruct init;
 
@@ -172,36 +403,336 @@ int8_t log_uart_init(void)
     init.stop_bit = StopBit_1Bit;
     init.parity = ParityNone;
     
-    return UartInit(TERMINAL_UART, &init);
+    UartInit(log_uart->uart, &init);
+    return UartSendCallbackRegister(log_uart->uart, send_complete);
 }
 
 /**
- * @brief 打印函数
+ * @brief 发送完成中断里接着发送另一个缓存，并从这个串口的sink取日志填充
  * 
- * @param _format 待打印的字符串
- * @param ... 参数
- * @return int8_t 
  */
-int8_t log_uart_printf(const char * _format, ...)
+static void log_uart0_send_complete(void)
 {
-    va_list ap;
-    
-    if(TERMINAL_UART->send_info.send_busy != 0)
+    elog_sink_flush(&uart0_sink);
+}
+
+#ifdef ELOG_SINK_UART1_ENABLE
+static void log_uart1_send_complete(void)
+{
+    elog_sink_flush(&uart1_sink);
+}
+#endif
+
+/**
+ * @brief 解析日志等级，数字0~5或者A/E/W/I/D/V
+ * 
+ * @return int8_t 不认识时返回-1
+ */
+static int8_t log_lvl_parse(const char *str)
+{
+    static const char level_char[] = "AEWIDV";
+    const char *pos;
+
+    if(str[0] == '\0' || (str[1] != '\0' && str[1] != ' '))
+        return -1;
+    if(str[0] >= '0' && str[0] <= '5')
+        return str[0] - '0';
+    pos = strchr(level_char, str[0] & ~0x20);
+    if(pos == NULL)
         return -1;
+    return pos - level_char;
+}
 
-    va_start(ap, _format);
-    vsnprintf((char *)dma_send_buffer, ELOG_BUF_OUTPUT_BUF_SIZE, _format, ap);
-    va_end(ap);
+/**
+ * @brief 查看和修改日志等级
+ *
+ * log_lvl              列出全局等级和每个tag当前的等级
+ * log_lvl 等级          修改全局等级
+ * log_lvl tag 等级      修改一个tag的等级，V表示取消这个tag的单独设置
+ */
+static void log_lvl_command(void)
+{
+    char tag[ELOG_FILTER_TAG_MAX_LEN + 1];
+    const char *args = TerminalCommandArgs();
+    const char *level_str;
+    const char *name;
+    int8_t level;
+    uint8_t i;
 
-    if(overflow_flag == 1)
+    if(args[0] == '\0')
     {
-        memcpy(&dma_send_buffer[ELOG_BUF_OUTPUT_BUF_SIZE], overflow_string, sizeof(overflow_string));
-        UartSendDMA(TERMINAL_UART, dma_send_buffer, UART_DMA_BUFFER_LEN);
+        for(i = 1; i <= elog_tag_get_num(); i ++)
+        {
+            name = elog_tag_get_name(i);
+            elog_i("elog", "%-16s %u%s", name, elog_get_filter_tag_lvl(name),
+                elog_tag_pass[i] == 0 ? " (filtered)" : "");
+        }
+        return;
     }
-    else
+
+    level_str = strchr(args, ' ');
+    if(level_str == NULL)
     {
-        UartSendDMA(TERMINAL_UART, dma_send_buffer, strlen((const char *)dma_send_buffer));
+        if((level = log_lvl_parse(args)) < 0)
+        {
+            elog_w("elog", "usage: log_lvl [tag] 0~5|A|E|W|I|D|V");
+            return;
+        }
+        elog_set_filter_lvl(level);
+        elog_i("elog", "level %d", level);
+        return;
     }
-    
-    return 0;
+
+    if(level_str - args > ELOG_FILTER_TAG_MAX_LEN || (level = log_lvl_parse(level_str + 1)) < 0)
+    {
+        elog_w("elog", "usage: log_lvl [tag] 0~5|A|E|W|I|D|V");
+        return;
+    }
+    memcpy(tag, args, level_str - args);
+    tag[level_str - args] = '\0';
+    elog_set_filter_tag_lvl(tag, level);
+    elog_i("elog", "%s level %d", tag, level);
+}
+
+/**
+ * @brief 查看和修改sink
+ *
+ * log_sink                     列出每个sink的模式、等级、tag、缓存占用和丢弃数
+ * log_sink 名字 text|bin|lz     修改输出模式，text模式下二进制日志格式化成文本
+ * log_sink 名字 等级 [tag]       只输出这个等级以下、tag包含这个字符串的日志
+ */
+static void log_sink_command(void)
+{
+    static const char *const mode_name[] = { "text", "bin", "lz" };
+    char name[16];
+    const char *args = TerminalCommandArgs();
+    const char *param;
+    ElogSink *sink;
+    int8_t level;
+    uint8_t i;
+#ifdef ELOG_LZ_OUTPUT_ENABLE
+    LogUart *log_uart;
+#endif
+
+    if(args[0] == '\0')
+    {
+        for(i = 0; (sink = elog_sink_get(i)) != NULL; i ++)
+        {
+            elog_i("elog", "%-6s %-4s %u %-8s %4u/%-4u dropped %u", sink->name, mode_name[sink->mode], sink->level,
+                sink->tag[0] != '\0' ? sink->tag : "*", (uint32_t)elog_ring_used(&sink->ring), sink->ring.size, sink->dropped);
+#ifdef ELOG_LZ_OUTPUT_ENABLE
+            log_uart = sink->port;
+            if(sink->write == &log_uart_write && log_uart->lz.in_bytes != 0)
+                elog_i("elog", "%-6s lz %u -> %u bytes, %u%%", sink->name, log_uart->lz.in_bytes,
+                    log_uart->lz.out_bytes, (uint32_t)((uint64_t)log_uart->lz.out_bytes * 100 / log_uart->lz.in_bytes));
+#endif
+        }
+        return;
+    }
+
+    param = strchr(args, ' ');
+    if(param == NULL || param - args >= sizeof(name))
+    {
+        elog_w("elog", "usage: log_sink [name text|bin|lz|level [tag]]");
+        return;
+    }
+    memcpy(name, args, param - args);
+    name[param - args] = '\0';
+    param ++;
+    sink = elog_sink_find(name);
+    if(sink == NULL)
+    {
+        elog_w("elog", "no sink %s", name);
+        return;
+    }
+
+    for(i = 0; i < sizeof(mode_name) / sizeof(mode_name[0]); i ++)
+    {
+        if(strcmp(param, mode_name[i]) == 0)
+        {
+            // 只有串口sink能切换，flash和RAM按写入时的样子保存
+            if(sink->write != &log_uart_write)
+            {
+                elog_w("elog", "%s mode is fixed", name);
+                return;
+            }
+            elog_sink_set_mode(sink, i);
+            elog_i("elog", "%s mode %s", name, mode_name[i]);
+            return;
+        }
+    }
+
+    if((level = log_lvl_parse(param)) < 0)
+    {
+        elog_w("elog", "usage: log_sink [name text|bin|lz|level [tag]]");
+        return;
+    }
+    param = param[1] == ' ' ? param + 2 : "";
+    elog_sink_set_filter(sink, level, param);
+    elog_i("elog", "%s level %d tag %s", name, level, param[0] != '\0' ? param : "*");
+}
+
+#ifdef ELOG_RATE_LIMIT_ENABLE
+/**
+ * @brief 解析一个0~255的数字
+ * 
+ * @return const char* 数字后面的位置，不是数字时返回NULL
+ */
+static const char *log_num_parse(const char *str, uint8_t *value)
+{
+    uint16_t num = 0;
+
+    if(*str < '0' || *str > '9')
+        return NULL;
+    while(*str >= '0' && *str <= '9')
+    {
+        num = num * 10 + (*str - '0');
+        if(num > 255)
+            return NULL;
+        str ++;
+    }
+    if(*str != '\0' && *str != ' ')
+        return NULL;
+    *value = num;
+    return *str == ' ' ? str + 1 : str;
+}
+
+/**
+ * @brief 查看和修改限速
+ *
+ * log_rate                         列出每个tag的限速、被限速丢掉的日志数和合并掉的重复日志数
+ * log_rate 每秒条数 突发条数         修改所有tag，每秒条数为0表示不限速
+ * log_rate tag 每秒条数 突发条数     修改一个输出过日志的tag
+ */
+static void log_rate_command(void)
+{
+    char tag[ELOG_FILTER_TAG_MAX_LEN + 1];
+    const char *args = TerminalCommandArgs();
+    const char *param;
+    uint8_t per_sec, burst;
+    uint32_t limited;
+    uint8_t i;
+
+    if(args[0] == '\0')
+    {
+        for(i = 0; i <= elog_tag_get_num(); i ++)
+        {
+            limited = elog_get_rate_limit(i, &per_sec, &burst);
+            if(i == 0 && limited == 0)
+                continue;
+            elog_i("elog", "%-16s %3u/s burst %3u limited %u", i == 0 ? "(other)" : elog_tag_get_name(i),
+                per_sec, burst, limited);
+        }
+#ifdef ELOG_REPEAT_SUPPRESS_ENABLE
+        elog_i("elog", "repeats suppressed %u", elog_get_repeat_suppressed());
+#endif
+        return;
+    }
+
+    tag[0] = '\0';
+    param = args;
+    if(*param < '0' || *param > '9')
+    {
+        param = strchr(args, ' ');
+        if(param == NULL || param - args > ELOG_FILTER_TAG_MAX_LEN)
+        {
+            elog_w("elog", "usage: log_rate [[tag] per_sec burst]");
+            return;
+        }
+        memcpy(tag, args, param - args);
+        tag[param - args] = '\0';
+        param ++;
+    }
+    if((param = log_num_parse(param, &per_sec)) == NULL || (param = log_num_parse(param, &burst)) == NULL
+        || *param != '\0')
+    {
+        elog_w("elog", "usage: log_rate [[tag] per_sec burst]");
+        return;
+    }
+    if(!elog_set_rate_limit(tag[0] != '\0' ? tag : NULL, per_sec, burst))
+    {
+        elog_w("elog", "no tag %s", tag);
+        return;
+    }
+    elog_i("elog", "%s %u/s burst %u", tag[0] != '\0' ? tag : "all", per_sec, burst);
+}
+#endif
+
+#ifdef ELOG_SINK_RAM_ENABLE
+/**
+ * @brief 把RAM sink里保存的日志发到终端，不会清掉
+ *
+ * 终端缓存满时等串口发送，RAM sink只在主循环里丢旧日志，命令执行期间内容不会变
+ */
+static void log_ram_command(void)
+{
+    static const char begin_string[] = "\n--- ram log begin ---\n";
+    static const char end_string[] = "--- ram log end ---\n";
+    uint32_t used = elog_ring_used(&ram_sink.ring);
+    uint32_t offset = ram_sink.ring.tail;
+    uint32_t part;
+
+    while(!elog_buf_write(begin_string, sizeof(begin_string) - 1))
+        elog_sink_flush(&uart0_sink);
+    while(used > 0)
+    {
+        offset &= ram_sink.ring.size - 1;
+        part = used < LOG_RAM_PIECE_LEN ? used : LOG_RAM_PIECE_LEN;
+        if(part > ram_sink.ring.size - offset)
+            part = ram_sink.ring.size - offset;
+        if(!elog_buf_write(&ram_sink.ring.buf[offset], part))
+        {
+            elog_sink_flush(&uart0_sink);
+            continue;
+        }
+        offset += part;
+        used -= part;
+    }
+    while(!elog_buf_write(end_string, sizeof(end_string) - 1))
+        elog_sink_flush(&uart0_sink);
+}
+#endif
+
+#ifdef ELOG_FLASH_ENABLE
+/**
+ * @brief 从最早的一页开始把flash里的日志发到串口
+ *
+ * 在主循环的elog_flash_process里一块一块放进elog_buf，串口发多快就放多快，
+ * 发送期间暂停写flash，新日志先留在暂存缓存里
+ */
+static void log_dump_command(void)
+{
+    if(!elog_flash_dump())
+        elog_w("elog", "flash log dump is running");
+}
+#endif
+
+#ifdef ELOG_BIN_OUTPUT_ENABLE
+/**
+ * @brief 比较同一条日志文本格式化和二进制记录的耗时
+ *
+ * 两种方式都只写进elog_buf的环形缓存，不等串口发送
+ */
+static void elog_bench_command(void)
+{
+    uint32_t text_cycles = 0;
+    uint32_t bin_cycles = 0;
+    uint32_t start_cycles;
+    uint8_t i;
+
+    CycleCounterEnable();
+
+    for(i = 0; i < ELOG_BENCH_ROUNDS; i ++)
+    {
+        start_cycles = DWT->CYCCNT;
+        elog_i("bench", "round %d, value %d, %s", i, 1234, "text");
+        text_cycles += DWT->CYCCNT - start_cycles;
+
+        start_cycles = DWT->CYCCNT;
+        elog_bin_i("bench", "round %d, value %d, %s", i, 1234, "binary");
+        bin_cycles += DWT->CYCCNT - start_cycles;
+    }
+    elog_i("bench", "text %u cycles, binary %u cycles per log", text_cycles / ELOG_BENCH_ROUNDS,
+        bin_cycles / ELOG_BENCH_ROUNDS);
 }
+#endif
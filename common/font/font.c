@@ -0,0 +1,262 @@
+/**
+ * @file font.c
+ * @brief 字形查找和渲染缓存
+ *
+ * 字库是编译期生成的const表(font_data.c)，查找只是一次数组下标。
+ * 彩色屏幕需要的RGB565像素块按(字符, 前景色, 背景色)缓存在SRAM里，最近最少使用的先被替换，
+ * 命中时画一个字符就是把缓存的像素块整块交给blit，不再逐像素展开。
+ */
+
+#include "font.h"
+#include "stddef.h"
+#include "string.h"
+#include "gd32f30x.h"
+#include "driver.h"
+#include "terminal_com.h"
+#include "elog.h"
+
+#define FONT_BENCH_LOOPS        100
+
+#define FONT_SEGMENT_ROWS       5           // 七段码从上到下：a, f b, g, e c, d
+
+typedef struct __FontCacheEntry
+{
+    uint32_t last_use;          // 为0表示空闲
+    uint16_t fg;
+    uint16_t bg;
+    uint8_t glyph;
+    uint16_t pixels[FONT_GLYPH_PIXELS];
+}FontCacheEntry;
+
+static FontCacheEntry font_cache[FONT_CACHE_SIZE];
+static uint32_t use_counter = 0;
+static FontStat font_stat;
+
+static uint16_t bench_buf[FONT_GLYPH_PIXELS];
+
+static uint8_t font_glyph_index(char c);
+static uint8_t font_segment_row(uint8_t segments, uint8_t row);
+static void font_render(FontCacheEntry *entry);
+static void font_bench_blit(uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint16_t *pixels);
+static void font_bench_command(void);
+
+void FontInit(void)
+{
+    TerminalCommandRegister("font_bench", &font_bench_command);
+}
+
+/**
+ * @brief 字符的七段码，用于数码管
+ *
+ */
+uint8_t FontSegments(char c)
+{
+    return font_segments[font_glyph_index(c)];
+}
+
+/**
+ * @brief 两个七段码之间向上滚动的中间状态
+ *
+ * 数码管按行看是横、竖、横、竖、横五行，旧字符下面接一个空的竖行再接新字符，每步上移两行，
+ * 横段只会移到横段的位置，竖段只会移到竖段的位置。小数点不参与滚动。
+ *
+ * @param from 旧的段码
+ * @param to 新的段码
+ * @param step 0 ... FONT_SEGMENT_ROLL_STEPS，0为旧字符，FONT_SEGMENT_ROLL_STEPS为新字符
+ * @return uint8_t
+ */
+uint8_t FontSegmentsRoll(uint8_t from, uint8_t to, uint8_t step)
+{
+    uint8_t segments = 0;
+    uint8_t row;
+    uint8_t src;
+    uint8_t bits;
+
+    if(step >= FONT_SEGMENT_ROLL_STEPS)
+        return to;
+
+    for(row = 0; row < FONT_SEGMENT_ROWS; row ++)
+    {
+        src = row + step * 2;
+        if(src < FONT_SEGMENT_ROWS)
+            bits = font_segment_row(from, src);
+        else if(src > FONT_SEGMENT_ROWS)
+            bits = font_segment_row(to, src - FONT_SEGMENT_ROWS - 1);
+        else
+            bits = 0;
+
+        switch(row)
+        {
+        case 0: segments |= (bits & 1) ? DISPLAY_SEG_A : 0; break;
+        case 1: segments |= ((bits & 1) ? DISPLAY_SEG_F : 0) | ((bits & 2) ? DISPLAY_SEG_B : 0); break;
+        case 2: segments |= (bits & 1) ? DISPLAY_SEG_G : 0; break;
+        case 3: segments |= ((bits & 1) ? DISPLAY_SEG_E : 0) | ((bits & 2) ? DISPLAY_SEG_C : 0); break;
+        default: segments |= (bits & 1) ? DISPLAY_SEG_D : 0; break;
+        }
+    }
+
+    return segments;
+}
+
+/**
+ * @brief 字符的点阵，FONT_HEIGHT行，每行一个字节，最高位在左，用于单色屏
+ *
+ */
+const uint8_t *FontBitmap(char c)
+{
+    return font_bitmap[font_glyph_index(c)];
+}
+
+/**
+ * @brief 取得字符渲染好的像素块，未命中时替换最久没用过的缓存项
+ *
+ * @param c
+ * @param fg 前景色，RGB565
+ * @param bg 背景色，RGB565
+ * @return const uint16_t* FONT_WIDTH * FONT_HEIGHT个像素，下一次调用可能被替换
+ */
+const uint16_t *FontGlyphPixels(char c, uint16_t fg, uint16_t bg)
+{
+    uint8_t glyph = font_glyph_index(c);
+    FontCacheEntry *victim = &font_cache[0];
+    uint8_t i;
+
+    use_counter ++;
+    for(i = 0; i < FONT_CACHE_SIZE; i ++) {
+        FontCacheEntry *entry = &font_cache[i];
+        if(entry->last_use != 0 && entry->glyph == glyph && entry->fg == fg && entry->bg == bg) {
+            entry->last_use = use_counter;
+            font_stat.hits ++;
+            return entry->pixels;
+        }
+        if(entry->last_use < victim->last_use)
+            victim = entry;
+    }
+
+    font_stat.misses ++;
+    victim->glyph = glyph;
+    victim->fg = fg;
+    victim->bg = bg;
+    victim->last_use = use_counter;
+    font_render(victim);
+
+    return victim->pixels;
+}
+
+/**
+ * @brief 绘制一行文字，每个字符调用一次blit
+ *
+ * @param x 左上角
+ * @param y
+ * @param text
+ * @param fg
+ * @param bg
+ * @param blit
+ * @return uint16_t 绘制后的x坐标
+ */
+uint16_t FontDrawText(uint16_t x, uint16_t y, const char *text, uint16_t fg, uint16_t bg, FontBlitFunc blit)
+{
+    while(*text != '\0') {
+        blit(x, y, FONT_WIDTH, FONT_HEIGHT, FontGlyphPixels(*text, fg, bg));
+        x += FONT_WIDTH;
+        text ++;
+    }
+
+    return x;
+}
+
+void FontGetStat(FontStat *stat)
+{
+    *stat = font_stat;
+}
+
+static uint8_t font_glyph_index(char c)
+{
+    uint8_t code = (uint8_t)c;
+
+    if(code < FONT_CHAR_FIRST || code >= FONT_CHAR_FIRST + FONT_CHAR_NUM)
+        return 0;
+    return font_char_map[code - FONT_CHAR_FIRST];
+}
+
+/**
+ * @brief 七段码中一行的段，横行只有bit0，竖行bit0为左边、bit1为右边
+ *
+ */
+static uint8_t font_segment_row(uint8_t segments, uint8_t row)
+{
+    switch(row)
+    {
+    case 0: return (segments & DISPLAY_SEG_A) ? 1 : 0;
+    case 1: return ((segments & DISPLAY_SEG_F) ? 1 : 0) | ((segments & DISPLAY_SEG_B) ? 2 : 0);
+    case 2: return (segments & DISPLAY_SEG_G) ? 1 : 0;
+    case 3: return ((segments & DISPLAY_SEG_E) ? 1 : 0) | ((segments & DISPLAY_SEG_C) ? 2 : 0);
+    default: return (segments & DISPLAY_SEG_D) ? 1 : 0;
+    }
+}
+
+/**
+ * @brief 按点阵展开成RGB565像素
+ *
+ */
+static void font_render(FontCacheEntry *entry)
+{
+    const uint8_t *bitmap = font_bitmap[entry->glyph];
+    uint16_t color[2];
+    uint16_t *pixel = entry->pixels;
+    uint8_t row;
+    uint8_t bits;
+    uint8_t i;
+
+    color[0] = entry->bg;
+    color[1] = entry->fg;
+
+    for(row = 0; row < FONT_HEIGHT; row ++) {
+        bits = bitmap[row];
+        for(i = 0; i < FONT_WIDTH; i ++) {
+            *pixel++ = color[bits >> 7];
+            bits <<= 1;
+        }
+    }
+}
+
+static void font_bench_blit(uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint16_t *pixels)
+{
+    // 相当于一次整块的DMA发送或帧缓冲拷贝
+    memcpy(bench_buf, pixels, (uint32_t)w * h * sizeof(uint16_t));
+}
+
+/**
+ * @brief 测量绘制时间和温湿度两行文字的耗时，分别给出缓存全部失效和全部命中的情况
+ *
+ */
+static void font_bench_command(void)
+{
+    static const char time_text[] = "12:34:56";
+    static const char temp_text[] = "23.5\x7f" "C 45%";
+    FontStat start_stat;
+    uint32_t start_cycles;
+    uint32_t cold_cycles;
+    uint32_t warm_cycles;
+    uint16_t i;
+
+    CycleCounterEnable();
+
+    memset(font_cache, 0, sizeof(font_cache));
+    start_stat = font_stat;
+
+    start_cycles = DWT->CYCCNT;
+    FontDrawText(0, 0, time_text, FONT_COLOR_WHITE, FONT_COLOR_BLACK, &font_bench_blit);
+    FontDrawText(0, FONT_HEIGHT, temp_text, FONT_COLOR_WHITE, FONT_COLOR_BLACK, &font_bench_blit);
+    cold_cycles = DWT->CYCCNT - start_cycles;
+
+    start_cycles = DWT->CYCCNT;
+    for(i = 0; i < FONT_BENCH_LOOPS; i ++) {
+        FontDrawText(0, 0, time_text, FONT_COLOR_WHITE, FONT_COLOR_BLACK, &font_bench_blit);
+        FontDrawText(0, FONT_HEIGHT, temp_text, FONT_COLOR_WHITE, FONT_COLOR_BLACK, &font_bench_blit);
+    }
+    warm_cycles = (DWT->CYCCNT - start_cycles) / FONT_BENCH_LOOPS;
+
+    elog_i("font", "frame cycles cold %u, warm %u", cold_cycles, warm_cycles);
+    elog_i("font", "hits %u misses %u", font_stat.hits - start_stat.hits, font_stat.misses - start_stat.misses);
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "stdint.h"
+
+#define FONT_WIDTH              8
+#define FONT_HEIGHT             16
+#define FONT_GLYPH_PIXELS       (FONT_WIDTH * FONT_HEIGHT)
+
+#define FONT_CHAR_FIRST         0x20
+#define FONT_CHAR_NUM           96          // 0x20 ... 0x7F
+#define FONT_GLYPH_NUM          17
+#define FONT_CHAR_DEGREE        0x7F        // 度数符号，用在字符串里写作"\x7f"
+
+#define FONT_SEGMENT_ROLL_STEPS 3           // 七段码滚动的步数
+
+#define FONT_CACHE_SIZE         12          // 渲染缓存的字形数，每个占FONT_GLYPH_PIXELS * 2字节
+
+// RGB565颜色
+#define FONT_COLOR(r, g, b)     ((uint16_t)((((r) & 0xf8) << 8) | (((g) & 0xfc) << 3) | ((b) >> 3)))
+#define FONT_COLOR_BLACK        FONT_COLOR(0, 0, 0)
+#define FONT_COLOR_WHITE        FONT_COLOR(255, 255, 255)
+
+/**
+ * @brief 把渲染好的像素块输出到屏幕或帧缓冲
+ *
+ * @param pixels w * h个RGB565像素，逐行排列
+ */
+typedef void (*FontBlitFunc)(uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint16_t *pixels);
+
+typedef struct __FontStat
+{
+    uint32_t hits;
+    uint32_t misses;
+}FontStat;
+
+extern const uint8_t font_bitmap[FONT_GLYPH_NUM][FONT_HEIGHT];
+extern const uint8_t font_segments[FONT_GLYPH_NUM];
+extern const uint8_t font_char_map[FONT_CHAR_NUM];
+
+void FontInit(void);
+
+uint8_t FontSegments(char c);
+
+uint8_t FontSegmentsRoll(uint8_t from, uint8_t to, uint8_t step);
+
+const uint8_t *FontBitmap(char c);
+
+const uint16_t *FontGlyphPixels(char c, uint16_t fg, uint16_t bg);
+
+uint16_t FontDrawText(uint16_t x, uint16_t y, const char *text, uint16_t fg, uint16_t bg, FontBlitFunc blit);
+
+void FontGetStat(FontStat *stat);
@@ -0,0 +1,286 @@
+/**
+ * @file font_data.c
+ * @brief 8x16点阵字库和七段码表，全部由宏在编译期展开成const表，存放在flash中
+ *
+ * 点阵每行一个字节，最高位是最左边的像素，用B8()按二进制写出，源码里就能看出字形。
+ * 只收录时钟和温湿度显示用到的字符，字库外的字符显示为空格。
+ */
+
+#include "font.h"
+#include "driver.h"
+
+// 把写成二进制形式的8位数转换为常量：B8(01111100) == 0x7C
+#define HEX__(n)        0x##n##LU
+#define B8__(x)         (((x) & 0x0000000FLU) ? 1 : 0) + (((x) & 0x000000F0LU) ? 2 : 0) +      \
+                        (((x) & 0x00000F00LU) ? 4 : 0) + (((x) & 0x0000F000LU) ? 8 : 0) +      \
+                        (((x) & 0x000F0000LU) ? 16 : 0) + (((x) & 0x00F00000LU) ? 32 : 0) +    \
+                        (((x) & 0x0F000000LU) ? 64 : 0) + (((x) & 0xF0000000LU) ? 128 : 0)
+#define B8(d)           ((uint8_t)(B8__(HEX__(d))))
+
+// 字形上下各留两行和四行空白，和VGA字库一致
+#define GLYPH(r0, r1, r2, r3, r4, r5, r6, r7, r8, r9)                                       \
+    {0, 0, B8(r0), B8(r1), B8(r2), B8(r3), B8(r4), B8(r5), B8(r6), B8(r7), B8(r8), B8(r9), 0, 0, 0, 0}
+
+const uint8_t font_bitmap[FONT_GLYPH_NUM][FONT_HEIGHT] = {
+    // space
+    GLYPH(
+        00000000,
+        00000000,
+        00000000,
+        00000000,
+        00000000,
+        00000000,
+        00000000,
+        00000000,
+        00000000,
+        00000000
+    ),
+    // 0
+    GLYPH(
+        01111100,
+        11000110,
+        11000110,
+        11001110,
+        11011110,
+        11110110,
+        11100110,
+        11000110,
+        11000110,
+        01111100
+    ),
+    // 1
+    GLYPH(
+        00011000,
+        00111000,
+        01111000,
+        00011000,
+        00011000,
+        00011000,
+        00011000,
+        00011000,
+        00011000,
+        01111110
+    ),
+    // 2
+    GLYPH(
+        01111100,
+        11000110,
+        00000110,
+        00001100,
+        00011000,
+        00110000,
+        01100000,
+        11000000,
+        11000110,
+        11111110
+    ),
+    // 3
+    GLYPH(
+        01111100,
+        11000110,
+        00000110,
+        00000110,
+        00111100,
+        00000110,
+        00000110,
+        00000110,
+        11000110,
+        01111100
+    ),
+    // 4
+    GLYPH(
+        00001100,
+        00011100,
+        00111100,
+        01101100,
+        11001100,
+        11111110,
+        00001100,
+        00001100,
+        00001100,
+        00011110
+    ),
+    // 5
+    GLYPH(
+        11111110,
+        11000000,
+        11000000,
+        11000000,
+        11111100,
+        00000110,
+        00000110,
+        00000110,
+        11000110,
+        01111100
+    ),
+    // 6
+    GLYPH(
+        00111000,
+        01100000,
+        11000000,
+        11000000,
+        11111100,
+        11000110,
+        11000110,
+        11000110,
+        11000110,
+        01111100
+    ),
+    // 7
+    GLYPH(
+        11111110,
+        11000110,
+        00000110,
+        00000110,
+        00001100,
+        00011000,
+        00110000,
+        00110000,
+        00110000,
+        00110000
+    ),
+    // 8
+    GLYPH(
+        01111100,
+        11000110,
+        11000110,
+        11000110,
+        01111100,
+        11000110,
+        11000110,
+        11000110,
+        11000110,
+        01111100
+    ),
+    // 9
+    GLYPH(
+        01111100,
+        11000110,
+        11000110,
+        11000110,
+        01111110,
+        00000110,
+        00000110,
+        00000110,
+        00001100,
+        01111000
+    ),
+    // colon
+    GLYPH(
+        00000000,
+        00000000,
+        00011000,
+        00011000,
+        00000000,
+        00000000,
+        00000000,
+        00011000,
+        00011000,
+        00000000
+    ),
+    // dot
+    GLYPH(
+        00000000,
+        00000000,
+        00000000,
+        00000000,
+        00000000,
+        00000000,
+        00000000,
+        00000000,
+        00011000,
+        00011000
+    ),
+    // minus
+    GLYPH(
+        00000000,
+        00000000,
+        00000000,
+        00000000,
+        00000000,
+        11111110,
+        00000000,
+        00000000,
+        00000000,
+        00000000
+    ),
+    // percent
+    GLYPH(
+        00000000,
+        00000000,
+        11000010,
+        11000110,
+        00001100,
+        00011000,
+        00110000,
+        01100000,
+        11000110,
+        10000110
+    ),
+    // C
+    GLYPH(
+        00111100,
+        01100110,
+        11000010,
+        11000000,
+        11000000,
+        11000000,
+        11000000,
+        11000010,
+        01100110,
+        00111100
+    ),
+    // degree
+    GLYPH(
+        00111000,
+        01101100,
+        01101100,
+        00111000,
+        00000000,
+        00000000,
+        00000000,
+        00000000,
+        00000000,
+        00000000
+    )
+};
+
+const uint8_t font_segments[FONT_GLYPH_NUM] = {
+    0, // space
+    DISPLAY_SEG_A | DISPLAY_SEG_B | DISPLAY_SEG_C | DISPLAY_SEG_D | DISPLAY_SEG_E | DISPLAY_SEG_F, // 0
+    DISPLAY_SEG_B | DISPLAY_SEG_C, // 1
+    DISPLAY_SEG_A | DISPLAY_SEG_B | DISPLAY_SEG_D | DISPLAY_SEG_E | DISPLAY_SEG_G, // 2
+    DISPLAY_SEG_A | DISPLAY_SEG_B | DISPLAY_SEG_C | DISPLAY_SEG_D | DISPLAY_SEG_G, // 3
+    DISPLAY_SEG_B | DISPLAY_SEG_C | DISPLAY_SEG_F | DISPLAY_SEG_G, // 4
+    DISPLAY_SEG_A | DISPLAY_SEG_C | DISPLAY_SEG_D | DISPLAY_SEG_F | DISPLAY_SEG_G, // 5
+    DISPLAY_SEG_A | DISPLAY_SEG_C | DISPLAY_SEG_D | DISPLAY_SEG_E | DISPLAY_SEG_F | DISPLAY_SEG_G, // 6
+    DISPLAY_SEG_A | DISPLAY_SEG_B | DISPLAY_SEG_C, // 7
+    DISPLAY_SEG_A | DISPLAY_SEG_B | DISPLAY_SEG_C | DISPLAY_SEG_D | DISPLAY_SEG_E | DISPLAY_SEG_F | DISPLAY_SEG_G, // 8
+    DISPLAY_SEG_A | DISPLAY_SEG_B | DISPLAY_SEG_C | DISPLAY_SEG_D | DISPLAY_SEG_F | DISPLAY_SEG_G, // 9
+    DISPLAY_SEG_DP, // colon
+    DISPLAY_SEG_DP, // dot
+    DISPLAY_SEG_G, // minus
+    0, // percent
+    DISPLAY_SEG_A | DISPLAY_SEG_D | DISPLAY_SEG_E | DISPLAY_SEG_F, // C
+    DISPLAY_SEG_A | DISPLAY_SEG_B | DISPLAY_SEG_F | DISPLAY_SEG_G, // degree
+};
+
+// ASCII 0x20 ... 0x7F到字形序号，没有列出的字符为0，即空格
+const uint8_t font_char_map[FONT_CHAR_NUM] = {
+    ['0' - FONT_CHAR_FIRST] = 1,
+    ['1' - FONT_CHAR_FIRST] = 2,
+    ['2' - FONT_CHAR_FIRST] = 3,
+    ['3' - FONT_CHAR_FIRST] = 4,
+    ['4' - FONT_CHAR_FIRST] = 5,
+    ['5' - FONT_CHAR_FIRST] = 6,
+    ['6' - FONT_CHAR_FIRST] = 7,
+    ['7' - FONT_CHAR_FIRST] = 8,
+    ['8' - FONT_CHAR_FIRST] = 9,
+    ['9' - FONT_CHAR_FIRST] = 10,
+    [':' - FONT_CHAR_FIRST] = 11,
+    ['.' - FONT_CHAR_FIRST] = 12,
+    ['-' - FONT_CHAR_FIRST] = 13,
+    ['%' - FONT_CHAR_FIRST] = 14,
+    ['C' - FONT_CHAR_FIRST] = 15,
+    [FONT_CHAR_DEGREE - FONT_CHAR_FIRST] = 16
+};
@@ -85,6 +85,7 @@ static const uint32_t space_base_addr_set[SPACE_NUM] = {
 static space_num cur_space;
 static uint32_t base_addr;
 static uint32_t final_addr_offset = 0;
+static uint8_t compacting = 0;
 
 static uint32_t get_final_kv_addr(void);
 static uint32_t get_next_kv(uint32_t last_addr);
@@ -307,6 +308,15 @@ int8_t set_key_value(const char *name, void *data, uint16_t len)
 
     // 寻找下一个可用空间
     wr_addr_offset = get_final_kv_addr();
+    // 空间写满时整理一次，把有效的值搬到另一个存储空间，不用等到下次上电
+    if(wr_addr_offset + ROM_DATA_STRUCT_SIZE > USED_SPACE_SIZE && compacting == 0)
+    {
+        compacting = 1;
+        LM_LOG_WARN("rom full, compact space_%d", cur_space);
+        rom_key_value_init();
+        compacting = 0;
+        wr_addr_offset = get_final_kv_addr();
+    }
     if(wr_addr_offset + ROM_DATA_STRUCT_SIZE > USED_SPACE_SIZE)
     {
         // TODO 加入逻辑判断如果空间使用满了需要向上反馈，停止写入
@@ -601,7 +611,7 @@ static int8_t key_value_write(uint32_t kv_addr_offset, const char *name, void *d
 
     // 将除了状态之外的数据写入
     ret = flash_write(base_addr + kv_addr_offset + STATUS_CODE_SIZE, \
-        (void*)(&struct_write_in) + STATUS_CODE_SIZE, \
+        (uint8_t *)(&struct_write_in) + STATUS_CODE_SIZE, \
         ROM_DATA_STRUCT_SIZE - STATUS_CODE_SIZE);
 
     if(ret < 0)
@@ -11,6 +11,7 @@
 
 #pragma once
 
-#define START_ADDR      0x081c0000      // 使用的起始地址（记得加入编译或运行检验其合理性）
-#define USED_SPACE_SIZE 0x20000          // 使用的空间大小（最好编译时限制为整数倍）
+// GD32F303CC共256KB闪存，每页2KB，使用最后16KB，两个存储空间各8KB
+#define START_ADDR      0x0803c000      // 使用的起始地址（记得加入编译或运行检验其合理性）
+#define USED_SPACE_SIZE 0x2000          // 使用的空间大小，必须是页大小的整数倍
 
@@ -13,16 +13,24 @@
 #include "rom_key_value_cfg.h"
 #include "string.h"
 #include "stdint.h"
-#include "stm32f7xx_hal.h"
+#include "stddef.h"
+#include "gd32f30x.h"
 
-#define MIN_ERASE_SIZE          0x20000
-#define MIN_WRITE_SIZE          4
+#define MIN_ERASE_SIZE          0x800           // FMC页大小
+#define MIN_WRITE_SIZE          4               // FMC按字编程
+
+#if (USED_SPACE_SIZE % MIN_ERASE_SIZE) != 0 || (START_ADDR % MIN_ERASE_SIZE) != 0
+    #error "key value space must be whole flash pages!"
+#endif
+
+static void fmc_flags_clear(void);
 
 int8_t flash_write(uint32_t phy_addr, void *data, uint32_t size)
 {
     int8_t ret = 0;
     uint32_t wr_cnt;
-    void *wr_pointer = data;
+    uint32_t word;
+    uint8_t *wr_pointer = data;
     uint32_t wr_phy_addr = phy_addr;
     if(size % MIN_WRITE_SIZE != 0)
     {
@@ -35,18 +43,21 @@ int8_t flash_write(uint32_t phy_addr, void *data, uint32_t size)
         return -1;
     }
 
-	HAL_FLASH_Unlock();
-	// 循环写入数据
+    fmc_unlock();
+    fmc_flags_clear();
+    // 循环写入数据，源数据可能不是字对齐的
     for(wr_cnt = size/MIN_WRITE_SIZE; wr_cnt > 0; wr_cnt --)
     {
-        if(HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, wr_phy_addr, *((uint32_t *)wr_pointer)) != HAL_OK)
+        memcpy(&word, wr_pointer, MIN_WRITE_SIZE);
+        if(fmc_word_program(wr_phy_addr, word) != FMC_READY)
         {
-        	ret = -1;
+            ret = -1;
         }
+        fmc_flags_clear();
         wr_pointer += MIN_WRITE_SIZE;
         wr_phy_addr += MIN_WRITE_SIZE;
     }
-	HAL_FLASH_Lock();
+    fmc_lock();
 
     return ret;
 }
@@ -73,30 +84,43 @@ int8_t flash_read(uint32_t phy_addr, void *data, uint32_t size)
 
 int8_t flash_erase(uint32_t phy_addr, uint32_t size)
 {
-    FLASH_EraseInitTypeDef flash_erase_struct;
-    uint32_t sector_err;
+    int8_t ret = 0;
+    uint32_t page_addr;
+
     // 检查可以被整除
-    if(size % MIN_ERASE_SIZE != 0)
+    if(size % MIN_ERASE_SIZE != 0 || phy_addr % MIN_ERASE_SIZE != 0)
     {
         return -1;
     }
 
-    flash_erase_struct.VoltageRange = FLASH_VOLTAGE_RANGE_3;
-    flash_erase_struct.TypeErase = FLASH_TYPEERASE_SECTORS;
-    flash_erase_struct.NbSectors = 1;
-
-	// TODO 改成可读性更高的写法
-    if(phy_addr == START_ADDR)
-        flash_erase_struct.Sector = FLASH_SECTOR_22;
-    else if(phy_addr == START_ADDR + USED_SPACE_SIZE)
-        flash_erase_struct.Sector = FLASH_SECTOR_23;
-
-    HAL_FLASH_Unlock();
-    if(HAL_FLASHEx_Erase(&flash_erase_struct, &sector_err) != HAL_OK)
+    if(phy_addr + size > START_ADDR + USED_SPACE_SIZE + USED_SPACE_SIZE || \
+        phy_addr < START_ADDR)
     {
         return -1;
     }
-    HAL_FLASH_Lock();
 
-    return 0;
+    fmc_unlock();
+    fmc_flags_clear();
+    for(page_addr = phy_addr; page_addr < phy_addr + size; page_addr += MIN_ERASE_SIZE)
+    {
+        if(fmc_page_erase(page_addr) != FMC_READY)
+        {
+            ret = -1;
+        }
+        fmc_flags_clear();
+    }
+    fmc_lock();
+
+    return ret;
+}
+
+/**
+ * @brief 清除上次操作留下的结束和错误标志，fmc_flag_clear一次只能清一个
+ *
+ */
+static void fmc_flags_clear(void)
+{
+    fmc_flag_clear(FMC_FLAG_BANK0_END);
+    fmc_flag_clear(FMC_FLAG_BANK0_WPERR);
+    fmc_flag_clear(FMC_FLAG_BANK0_PGERR);
 }
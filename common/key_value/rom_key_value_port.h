@@ -12,7 +12,13 @@
 #pragma once
 
 #include "stdint.h"
-#include "../sys_support.h" // TODO 优化包含关系
+#include "elog.h"
+
+// 日志输出到easy_log，使用前定义MODULE_TAG
+#define LM_LOG_DEBUG(...)       elog_d(MODULE_TAG, __VA_ARGS__)
+#define LM_LOG_INFO(...)        elog_i(MODULE_TAG, __VA_ARGS__)
+#define LM_LOG_WARN(...)        elog_w(MODULE_TAG, __VA_ARGS__)
+#define LM_LOG_ERROR(...)       elog_e(MODULE_TAG, __VA_ARGS__)
 
 int8_t flash_init(void);
 
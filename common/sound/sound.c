@@ -0,0 +1,390 @@
+/**
+ * @file sound.c
+ * @brief 波表合成的提示音
+ *
+ * DAC由定时器触发，DMA循环读取双缓冲，下一块在DMA的半传输/传输完成中断里混音，
+ * 每块的计算量固定为SOUND_VOICE_NUM个音符 * SOUND_BLOCK_LEN个样点，CPU占用有上限。
+ * 波表相邻两点打包成一个32位数，插值用一条SMLAD完成；每个音符的包络在块内线性过渡，
+ * 块与块之间按指数衰减；各音符两个样点一组用QADD16饱和叠加，不会溢出翻转。
+ * 没有音符也没有待播放的序列时自动停止DAC。
+ */
+
+#include "sound.h"
+#include "stddef.h"
+#include "string.h"
+#include "math.h"
+#include "gd32f30x.h"
+#include "driver.h"
+#include "terminal_com.h"
+#include "elog.h"
+
+#define SOUND_WAVE_LEN              (1 << SOUND_WAVE_BITS)
+#define SOUND_WAVE_AMPLITUDE        32000       // 留出插值的余量
+#define SOUND_ENV_SHIFT             8           // 包络在块内按Q23累加，步长不会被截成0
+#define SOUND_ENV_MIN               16          // 包络低于这个值时音符结束
+#define SOUND_SILENT_BLOCKS         2           // 连续静音这么多块后停止DAC，缓冲区已全部是中点
+
+// 每块的衰减系数，Q15，decay_ms为包络衰减到1/e左右的时间
+#define SOUND_DECAY(ms)             ((uint16_t)(32768 - 32768UL * SOUND_BLOCK_US / ((ms) * 1000UL)))
+
+#if SOUND_BLOCK_LEN % 2 != 0
+    #error "sound block must hold whole sample pairs!"
+#endif
+
+typedef struct __SoundVoice
+{
+    uint32_t phase;
+    uint32_t inc;
+    int32_t env;                // 当前包络，Q15
+    int32_t peak;               // 起音目标
+    uint16_t decay;             // 每块的衰减系数，Q15
+    uint8_t attack;             // 第一块从0过渡到peak
+    uint8_t active;
+}SoundVoice;
+
+typedef struct __SoundStep
+{
+    uint16_t delay_blocks;      // 距离上一步的块数
+    uint32_t inc;
+    uint16_t level;
+    uint16_t decay;
+}SoundStep;
+
+#define SOUND_MS_TO_BLOCKS(ms)      ((uint16_t)((ms) * 1000UL / SOUND_BLOCK_US))
+
+// 整点报时：四个音，每个音带一个高八度、衰减更快的泛音
+static const SoundStep chime_steps[] = {
+    {0,                         SOUND_PHASE_INC(659.26), 14000, SOUND_DECAY(1200)},
+    {0,                         SOUND_PHASE_INC(1318.5), 4000,  SOUND_DECAY(250)},
+    {SOUND_MS_TO_BLOCKS(450),   SOUND_PHASE_INC(523.25), 14000, SOUND_DECAY(1200)},
+    {0,                         SOUND_PHASE_INC(1046.5), 4000,  SOUND_DECAY(250)},
+    {SOUND_MS_TO_BLOCKS(450),   SOUND_PHASE_INC(587.33), 14000, SOUND_DECAY(1200)},
+    {0,                         SOUND_PHASE_INC(1174.7), 4000,  SOUND_DECAY(250)},
+    {SOUND_MS_TO_BLOCKS(450),   SOUND_PHASE_INC(392.00), 16000, SOUND_DECAY(2000)},
+    {0,                         SOUND_PHASE_INC(784.00), 5000,  SOUND_DECAY(300)},
+};
+
+static uint16_t sound_buf[SOUND_BUF_LEN];
+static uint32_t mix_buf[SOUND_BLOCK_LEN / 2];       // 两个样点一组的Q15混音结果
+static uint32_t wave_pair[SOUND_WAVE_LEN];          // 低16位为第i点，高16位为第i+1点
+
+static SoundVoice voices[SOUND_VOICE_NUM];
+static const SoundStep *seq = NULL;
+static uint8_t seq_len;
+static uint8_t seq_pos;
+static uint16_t seq_wait;
+static uint8_t silent_blocks;
+
+static SoundStat sound_stat;
+static uint64_t stat_cycles;
+
+static void sound_fill(uint16_t *buf, uint16_t num);
+static void sound_voice_start(uint32_t inc, uint16_t level, uint16_t decay);
+static void sound_voice_mix(SoundVoice *voice);
+static void sound_stream_start(void);
+static void snd_stat_command(void);
+static void chime_command(void);
+
+int8_t SoundInit(void)
+{
+    int16_t cur;
+    int16_t next;
+    uint16_t i;
+
+    // 混音耗时用DWT周期计数器统计
+    CycleCounterEnable();
+
+    // 每点和下一点一起装进wave_pair，下一点留到下一次循环用，不在栈上放整张表
+    next = 0;       // sin(0)
+    for(i = 0; i < SOUND_WAVE_LEN; i ++)
+    {
+        cur = next;
+        next = (int16_t)(sinf(6.2831853f * ((i + 1) % SOUND_WAVE_LEN) / SOUND_WAVE_LEN) * SOUND_WAVE_AMPLITUDE);
+        wave_pair[i] = __PKHBT(cur, next, 16);
+    }
+
+    memset(voices, 0, sizeof(voices));
+    memset(&sound_stat, 0, sizeof(sound_stat));
+
+    TerminalCommandRegister("snd_stat", &snd_stat_command);
+    TerminalCommandRegister("chime", &chime_command);
+
+    return DacInit(sound_buf, SOUND_BUF_LEN, &sound_fill);
+}
+
+/**
+ * @brief 播放一个音符，没有空闲的音符时替换当前最轻的一个
+ *
+ * @param freq_hz
+ * @param level 音量，Q15，多个音符叠加超过满幅时饱和
+ * @param decay_ms 衰减时间，不小于一块的时长
+ * @return int8_t
+ */
+int8_t SoundPlayNote(uint16_t freq_hz, uint16_t level, uint16_t decay_ms)
+{
+    uint32_t primask;
+
+    if(freq_hz == 0 || freq_hz >= DAC_SAMPLE_HZ / 2 || level > SOUND_LEVEL_MAX
+        || (uint32_t)decay_ms * 1000 <= SOUND_BLOCK_US)
+    {
+        return -1;
+    }
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    sound_voice_start((uint32_t)(((uint64_t)freq_hz << 32) / DAC_SAMPLE_HZ), level, SOUND_DECAY(decay_ms));
+    __set_PRIMASK(primask);
+
+    sound_stream_start();
+
+    return 0;
+}
+
+/**
+ * @brief 播放整点报时，序列在中断里按块推进，调用后立即返回
+ *
+ */
+void SoundPlayChime(void)
+{
+    uint32_t primask;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    seq = chime_steps;
+    seq_len = sizeof(chime_steps) / sizeof(chime_steps[0]);
+    seq_pos = 0;
+    seq_wait = chime_steps[0].delay_blocks;
+    silent_blocks = 0;
+    __set_PRIMASK(primask);
+
+    sound_stream_start();
+}
+
+/**
+ * @brief 停止所有音符和序列，输出回到中点后DAC自动停止
+ *
+ */
+void SoundStop(void)
+{
+    uint32_t primask;
+    uint8_t i;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    seq = NULL;
+    for(i = 0; i < SOUND_VOICE_NUM; i ++)
+    {
+        voices[i].active = 0;
+    }
+    __set_PRIMASK(primask);
+}
+
+uint8_t SoundIsPlaying(void)
+{
+    return DacIsRunning();
+}
+
+/**
+ * @brief 取统计结果，CPU占用按播放期间的块数计算
+ *
+ */
+void SoundGetStat(SoundStat *stat)
+{
+    uint64_t block_cycles = (uint64_t)SystemCoreClock * SOUND_BLOCK_LEN / DAC_SAMPLE_HZ;
+
+    sound_stat.load_permille = 0;
+    if(sound_stat.blocks != 0)
+    {
+        sound_stat.load_permille = (uint32_t)(stat_cycles * 1000 / (sound_stat.blocks * block_cycles));
+    }
+    *stat = sound_stat;
+}
+
+/**
+ * @brief 刚播放的音符保证下一块不是静音，这里检查之后DAC不会被中断停掉
+ *
+ */
+static void sound_stream_start(void)
+{
+    if(DacIsRunning() == 0)
+    {
+        silent_blocks = 0;
+        DacStart();
+    }
+}
+
+/**
+ * @brief 混音一块，在DMA中断里调用，DacStart预填充时在主循环里调用
+ *
+ */
+static void sound_fill(uint16_t *buf, uint16_t num)
+{
+    uint32_t start_cycles = DWT->CYCCNT;
+    uint32_t cycles;
+    uint32_t pair;
+    uint8_t active = 0;
+    uint16_t i;
+
+    // 推进序列，同一块里可以开始多个音符
+    while(seq != NULL && seq_wait == 0)
+    {
+        sound_voice_start(seq[seq_pos].inc, seq[seq_pos].level, seq[seq_pos].decay);
+        seq_pos ++;
+        if(seq_pos >= seq_len)
+            seq = NULL;
+        else
+            seq_wait = seq[seq_pos].delay_blocks;
+    }
+    if(seq != NULL)
+        seq_wait --;
+
+    memset(mix_buf, 0, sizeof(mix_buf));
+    for(i = 0; i < SOUND_VOICE_NUM; i ++)
+    {
+        if(voices[i].active != 0)
+        {
+            sound_voice_mix(&voices[i]);
+            active = 1;
+        }
+    }
+
+    // Q15转成12位无符号
+    for(i = 0; i < num / 2; i ++)
+    {
+        pair = mix_buf[i];
+        buf[2 * i] = (uint16_t)(((int16_t)pair >> 4) + DAC_MID_LEVEL);
+        buf[2 * i + 1] = (uint16_t)(((int16_t)(pair >> 16) >> 4) + DAC_MID_LEVEL);
+    }
+
+    cycles = DWT->CYCCNT - start_cycles;
+    sound_stat.blocks ++;
+    sound_stat.cycles_last = cycles;
+    if(cycles > sound_stat.cycles_max)
+        sound_stat.cycles_max = cycles;
+    stat_cycles += cycles;
+
+    if(active == 0 && seq == NULL)
+    {
+        silent_blocks ++;
+        if(silent_blocks >= SOUND_SILENT_BLOCKS)
+        {
+            DacStop();
+        }
+    }
+    else
+    {
+        silent_blocks = 0;
+    }
+}
+
+/**
+ * @brief 占用一个音符，调用者负责关中断
+ *
+ */
+static void sound_voice_start(uint32_t inc, uint16_t level, uint16_t decay)
+{
+    SoundVoice *voice = &voices[0];
+    uint8_t i;
+
+    for(i = 0; i < SOUND_VOICE_NUM; i ++)
+    {
+        if(voices[i].active == 0)
+        {
+            voice = &voices[i];
+            voice->env = 0;
+            break;
+        }
+        if(voices[i].env < voice->env)
+        {
+            voice = &voices[i];
+        }
+    }
+
+    // 替换正在发声的音符时从它的当前包络起音，不会突变
+    voice->phase = 0;
+    voice->inc = inc;
+    voice->peak = level;
+    voice->decay = decay;
+    voice->attack = 1;
+    voice->active = 1;
+}
+
+/**
+ * @brief 一个音符的一块叠加到mix_buf
+ *
+ */
+static void sound_voice_mix(SoundVoice *voice)
+{
+    uint32_t phase = voice->phase;
+    uint32_t inc = voice->inc;
+    uint32_t frac;
+    int32_t env;
+    int32_t step;
+    int32_t end;
+    int32_t s0;
+    int32_t s1;
+    uint16_t i;
+
+    if(voice->attack != 0)
+    {
+        voice->attack = 0;
+        end = voice->peak;
+    }
+    else
+    {
+        end = (voice->env * voice->decay) >> 15;
+        if(end < SOUND_ENV_MIN)
+        {
+            end = 0;
+            voice->active = 0;
+        }
+    }
+    env = voice->env << SOUND_ENV_SHIFT;
+    step = ((end - voice->env) << SOUND_ENV_SHIFT) / SOUND_BLOCK_LEN;
+
+    for(i = 0; i < SOUND_BLOCK_LEN / 2; i ++)
+    {
+        // 相位高8位是波表下标，接下来15位是两点之间的插值系数
+        frac = (phase >> 9) & 0x7fff;
+        s0 = (int32_t)__SMLAD(wave_pair[phase >> 24], __PKHBT(0x7fff - frac, frac, 16), 0) >> 15;
+        s0 = (s0 * (env >> SOUND_ENV_SHIFT)) >> 15;
+        phase += inc;
+        env += step;
+
+        frac = (phase >> 9) & 0x7fff;
+        s1 = (int32_t)__SMLAD(wave_pair[phase >> 24], __PKHBT(0x7fff - frac, frac, 16), 0) >> 15;
+        s1 = (s1 * (env >> SOUND_ENV_SHIFT)) >> 15;
+        phase += inc;
+        env += step;
+
+        mix_buf[i] = __QADD16(mix_buf[i], __PKHBT(s0, s1, 16));
+    }
+
+    voice->phase = phase;
+    voice->env = end;
+}
+
+/**
+ * @brief 打印上次调用以来的统计并重新开始统计
+ *
+ */
+static void snd_stat_command(void)
+{
+    SoundStat stat;
+    uint32_t cycles_per_us = SystemCoreClock / 1000000;
+
+    SoundGetStat(&stat);
+    elog_i("sound", "%u voices, %u Hz, blocks %u, playing %u", SOUND_VOICE_NUM, DAC_SAMPLE_HZ,
+        stat.blocks, DacIsRunning());
+    elog_i("sound", "mix last %uus, max %uus, budget %uus, load %u.%u%%",
+        stat.cycles_last / cycles_per_us, stat.cycles_max / cycles_per_us, (uint32_t)SOUND_BLOCK_US,
+        stat.load_permille / 10, stat.load_permille % 10);
+
+    memset(&sound_stat, 0, sizeof(sound_stat));
+    stat_cycles = 0;
+}
+
+static void chime_command(void)
+{
+    SoundPlayChime();
+}
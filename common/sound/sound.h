@@ -0,0 +1,35 @@
+#pragma once
+
+#include "stdint.h"
+#include "driver_dac.h"
+
+#define SOUND_VOICE_NUM             4           // 同时发声的音符数
+#define SOUND_BUF_LEN               256         // DMA双缓冲总样点数，每半个为一块
+#define SOUND_BLOCK_LEN             (SOUND_BUF_LEN / 2)
+#define SOUND_BLOCK_US              (SOUND_BLOCK_LEN * 1000000UL / DAC_SAMPLE_HZ)
+#define SOUND_WAVE_BITS             8           // 波表256个点
+
+#define SOUND_LEVEL_MAX             32767       // 音量为Q15
+
+// 频率对应的相位增量，32位相位一圈
+#define SOUND_PHASE_INC(hz)         ((uint32_t)((hz) * 4294967296.0 / DAC_SAMPLE_HZ))
+
+typedef struct __SoundStat
+{
+    uint32_t blocks;                // 混音的块数
+    uint32_t cycles_last;           // 混音一块的CPU周期
+    uint32_t cycles_max;
+    uint32_t load_permille;         // 播放期间混音占用的CPU比例，千分之
+}SoundStat;
+
+int8_t SoundInit(void);
+
+int8_t SoundPlayNote(uint16_t freq_hz, uint16_t level, uint16_t decay_ms);
+
+void SoundPlayChime(void);
+
+void SoundStop(void);
+
+uint8_t SoundIsPlaying(void);
+
+void SoundGetStat(SoundStat *stat);
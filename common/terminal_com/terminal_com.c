@@ -9,8 +9,6 @@
 #error "please define TERMINAL_UART first!"
 #endif
 
-#define MAX_COMMAND_NUM         10
-
 #define TERMINAL_BAUDRATE           115200U
 #define TERMINAL_DMA_TX_BUF_SIZE    32
 #define TERMINAL_DMA_RX_BUF_SIZE    32
@@ -21,7 +19,8 @@
 #define CHAR_BACKSPACE          0x7f
 #define CHAR_SPACE              ' '
 
-static Command command[MAX_COMMAND_NUM];
+// 按命令名排序的命令表
+static Command command[TERMINAL_COMMAND_MAX_NUM];
 static uint16_t command_num = 0;
 
 static uint8_t terminal_rx_dma_buf[TERMINAL_DMA_RX_BUF_SIZE];
@@ -31,6 +30,9 @@ static struct
     uint16_t num;
 }unformed_command;
 
+// 命令名后面的参数，命令执行期间有效
+static char command_args[TERMINAL_CMD_MAX_LEN + 1];
+
 static struct 
 {
     uint8_t buffer[TERMINAL_DMA_TX_BUF_SIZE];
@@ -42,6 +44,9 @@ static void terminal_input_process(uint16_t size);
 static int8_t compare_command(Command **command);
 static int8_t complete_command(void);
 static void command_list(void);
+static int command_name_cmp(const char *command_string, const char *name, size_t name_len);
+static uint16_t command_lower_bound(const char *name, size_t name_len);
+static uint16_t command_prefix_end(const char *prefix, size_t prefix_len, uint16_t start);
 
 int8_t TerminalComInit(void)
 {
@@ -64,20 +69,32 @@ int8_t TerminalComInit(void)
     return ret;
 }
 
+/**
+ * @brief 注册命令，按命令名插入到排序的命令表里
+ * 
+ * @param command_string 命令名，要一直有效（一般是字符串常量）
+ * @param command_func 命令函数
+ * @return int8_t 0: 成功，-1: 命令名太长、已经注册过或者命令表已满
+ */
 int8_t TerminalCommandRegister(const char *command_string, CommandFuncType *command_func)
 {
-    if(strlen(command_string) > TERMINAL_CMD_MAX_LEN) {
+    size_t name_len = strlen(command_string);
+    uint16_t index;
+
+    if(name_len > TERMINAL_CMD_MAX_LEN || command_num >= TERMINAL_COMMAND_MAX_NUM) {
         return -1;
     }
-    if(command_num < MAX_COMMAND_NUM){
-        command[command_num].command_string = command_string;
-        command[command_num].command_func = command_func;
-        command_num ++;
-
-        return 0;
+    index = command_lower_bound(command_string, name_len);
+    if(index < command_num && command_name_cmp(command[index].command_string, command_string, name_len) == 0) {
+        return -1;
     }
 
-    return -1;
+    memmove(&command[index + 1], &command[index], (command_num - index) * sizeof(Command));
+    command[index].command_string = command_string;
+    command[index].command_func = command_func;
+    command_num ++;
+
+    return 0;
 }
 
 static void terminal_input_process(uint16_t size)
@@ -157,83 +174,141 @@ static void terminal_input_process(uint16_t size)
 
 /**
  * @brief 将接收到的指令和已有的指令比较，如果存在相同指令，则返回0
+ * 第一个空格前是命令名，后面的部分作为参数保存，由TerminalCommandArgs取得
  * 
  * @param command 传出参数，相匹配的指令的指针
  * @return int8_t 
  */
 static int8_t compare_command(Command **_command)
 {
+    const char *input = (const char *)unformed_command.buffer;
+    size_t name_len = strcspn(input, " ");
+    uint16_t index;
+
     *_command = NULL;
-    // 逐个命令比对，遇到相同则返回对应函数指针
-    for(uint8_t i = 0; i < MAX_COMMAND_NUM; i ++)
-    {
-        if(strcmp((const char *)unformed_command.buffer, (const char *)command[i].command_string) == 0)
-        {
-            *_command = &command[i];
-            return 0;
-        }
+    // 二分查找命令名
+    index = command_lower_bound(input, name_len);
+    if(index >= command_num || command_name_cmp(command[index].command_string, input, name_len) != 0) {
+        return -1;
     }
 
-    return -1;
+    input += name_len;
+    while(*input == CHAR_SPACE)
+        input ++;
+    strcpy(command_args, input);
+    *_command = &command[index];
+    return 0;
+}
+
+/**
+ * @brief 当前命令的参数，只能在命令函数里调用
+ * 
+ * @return const char* 去掉了开头空格，没有参数时为空字符串
+ */
+const char *TerminalCommandArgs(void)
+{
+    return command_args;
 }
 
 /**
  * @brief 指令联想，自动补齐
+ * 以输入开头的命令在表里是连续的一段，补齐到这一段第一条和最后一条的公共前缀
  * 
  * @return int8_t 
  */
 int8_t complete_command(void)
 {
-    while(1) {
-        uint8_t match_flag = 0;
-        uint8_t char_diff_flag = 0;
-        uint8_t next_char = 0;
-        uint8_t i = 0;
-
-        // 逐个取指令的前面几个字符来比对
-        for(i = 0; i < MAX_COMMAND_NUM; i ++)
-        {
-            // 输入的代码如果并不比该指令长，则跳过
-            if(unformed_command.num >= strlen((const char *)command[i].command_string)) {
-                continue;
-            }
+    const char *input = (const char *)unformed_command.buffer;
+    const char *first;
+    const char *last;
+    uint16_t start, end;
+    uint16_t len;
 
-            // 如果输入的代码和指令的开头一致，则记录该指令的下一个字符
-            if(memcmp((const char *)unformed_command.buffer, (const char *)command[i].command_string, unformed_command.num) == 0) {
-                // 如果还有其它指令的开头也和输入的相匹配，则需要看两者的下一个字符是否一致
-                if(match_flag == 1) {
-                    // 如果两个指令的下一个字符不一致，即：若输入的是ab，存在abc和abd两个指令，则无法联想，直接退出
-                    if(next_char != command[i].command_string[unformed_command.num]) {
-                        char_diff_flag = 1;
-                        break;
-                    }
-                }
-                else {
-                    // 记录该指令的下一个字符
-                    match_flag = 1;
-                    next_char = command[i].command_string[unformed_command.num];
-                }
-            }
-        }
+    start = command_lower_bound(input, unformed_command.num);
+    end = command_prefix_end(input, unformed_command.num, start);
+    if(start == end) {
+        return -1;
+    }
 
-        // 如果输入的和某个指令相匹配且下一个字符一致
-        if(match_flag == 1 && char_diff_flag != 1) {
-            
-            // 在输入缓存区添加这个字符
-            unformed_command.buffer[unformed_command.num] = next_char;
-            unformed_command.num ++;
-            // 直接在发送区缓存添加这个字符
-            unsent_obj.buffer[unsent_obj.num] = next_char;
+    first = command[start].command_string;
+    last = command[end - 1].command_string;
+    len = unformed_command.num;
+    while(first[len] != '\0' && first[len] == last[len] && len < TERMINAL_CMD_MAX_LEN)
+    {
+        // 在输入缓存区添加这个字符
+        unformed_command.buffer[len] = first[len];
+        // 直接在发送区缓存添加这个字符
+        if(unsent_obj.num < TERMINAL_DMA_TX_BUF_SIZE)
+        {
+            unsent_obj.buffer[unsent_obj.num] = first[len];
             unsent_obj.num ++;
         }
-        else {
-            break;
-        }
+        len ++;
     }
+    unformed_command.num = len;
 
     return 0;
 }
 
+/**
+ * @brief 按字典序比较命令名和长度为name_len的名字
+ * 
+ * @return int 和strcmp一样
+ */
+static int command_name_cmp(const char *command_string, const char *name, size_t name_len)
+{
+    int ret = strncmp(command_string, name, name_len);
+
+    if(ret != 0)
+        return ret;
+    // 前name_len个字符相同，命令名更长时排在后面
+    return command_string[name_len] != '\0' ? 1 : 0;
+}
+
+/**
+ * @brief 第一条不小于name的命令
+ * 
+ * @return uint16_t 命令表的下标，都比name小时为command_num
+ */
+static uint16_t command_lower_bound(const char *name, size_t name_len)
+{
+    uint16_t low = 0;
+    uint16_t high = command_num;
+    uint16_t mid;
+
+    while(low < high)
+    {
+        mid = (low + high) / 2;
+        if(command_name_cmp(command[mid].command_string, name, name_len) < 0)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low;
+}
+
+/**
+ * @brief 从start开始以prefix开头的一段命令的结尾
+ * 
+ * @return uint16_t 这一段后面第一条命令的下标
+ */
+static uint16_t command_prefix_end(const char *prefix, size_t prefix_len, uint16_t start)
+{
+    uint16_t low = start;
+    uint16_t high = command_num;
+    uint16_t mid;
+
+    while(low < high)
+    {
+        mid = (low + high) / 2;
+        if(strncmp(command[mid].command_string, prefix, prefix_len) <= 0)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low;
+}
+
 /**
  * @brief 终端输出的函数
  * 
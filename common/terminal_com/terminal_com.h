@@ -2,6 +2,9 @@
 
 #include "stdint.h"
 
+// 命令表的容量，所有模块都启用时约30条命令
+#define TERMINAL_COMMAND_MAX_NUM    40
+
 typedef void CommandFuncType(void);
 
 typedef struct __Command
@@ -14,4 +17,6 @@ int8_t TerminalComInit(void);
 
 int8_t TerminalCommandRegister(const char *command_string, CommandFuncType* command_func);
 
+const char *TerminalCommandArgs(void);
+
 int8_t terminal_output(void);
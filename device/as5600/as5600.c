@@ -0,0 +1,281 @@
+/**
+ * @file as5600.c
+ * @brief AS5600磁编码器旋钮输入：1kHz采样RAW ANGLE，解卷绕、定点测速、档位去抖后输出事件
+ *
+ * 采样由AS5600_SAMPLE_TIMER定时发起，用I2cMemRead以重复起始位只读2字节，
+ * 数据处理在I2C读完成中断里进行，主循环只需要取事件。
+ */
+
+#include "as5600.h"
+#include "stddef.h"
+#include "gd32f30x.h"
+#include "driver.h"
+#include "system_timer.h"
+#include "terminal_com.h"
+#include "elog.h"
+
+#ifndef AS5600_I2C
+    #error "please define AS5600_I2C first!"
+#endif
+
+#ifndef AS5600_SAMPLE_TIMER
+    #error "please define AS5600_SAMPLE_TIMER first!"
+#endif
+
+#define AS5600_ADDR                 0x6C
+#define AS5600_REG_RAW_ANGLE        0x0C
+
+#define AS5600_SAMPLE_PERIOD_US     1000
+#define AS5600_SAMPLE_RATE          (1000000 / AS5600_SAMPLE_PERIOD_US)
+
+#define AS5600_DETENT_NUM           24      // 每圈的档位数
+#define AS5600_DEBOUNCE_SAMPLES     2       // 连续几个采样越过档位边界才算一步
+#define AS5600_SETTLE_SAMPLES       4       // 连续几个采样停在档位内才算停稳
+#define AS5600_SETTLE_VELOCITY      (AS5600_COUNTS_PER_REV / 8)    // 低于该速度(counts/s)认为已停下
+#define AS5600_VELOCITY_SHIFT       3       // 速度一阶低通，系数为1/8
+
+// 档位宽度和滞回量都用Q8定点表示，避免每圈档位数不能整除4096时的累计误差
+#define DETENT_WIDTH_Q8             (((int32_t)AS5600_COUNTS_PER_REV << 8) / AS5600_DETENT_NUM)
+#define DETENT_HYSTERESIS_Q8        (DETENT_WIDTH_Q8 / 8)
+#define DETENT_STEP_THRESHOLD_Q8    (DETENT_WIDTH_Q8 / 2 + DETENT_HYSTERESIS_Q8)
+
+static uint8_t raw_buf[2];
+static volatile uint8_t sample_pending = 0;
+static uint8_t first_sample = 1;
+
+static uint16_t last_raw;
+static volatile int32_t position;       // 解卷绕后的累计位置，单位counts
+static volatile int32_t velocity_q8;    // counts/s，Q8
+static volatile int32_t detent;
+
+static int8_t pending_dir = 0;
+static uint8_t debounce_cnt = 0;
+static uint8_t settle_cnt = 0;
+static uint8_t settled = 1;
+
+static KnobEvent event_queue[AS5600_EVENT_QUEUE_SIZE];
+static volatile uint8_t event_head = 0;     // 只在中断里写
+static volatile uint8_t event_tail = 0;     // 只在主循环里写
+
+static KnobStat knob_stat;
+
+static void as5600_sample_start(void);
+static void as5600_sample_done(int8_t result);
+static void as5600_process(uint16_t raw);
+static void as5600_push_event(KnobEventType type);
+static void knob_stat_command(void);
+
+int8_t As5600Init(void)
+{
+    TimerInitStruct timer_init;
+
+    // 打开DWT周期计数器，用于统计每个采样的处理耗时
+    CycleCounterEnable();
+
+    I2cReadCallbackRegister(AS5600_I2C, &as5600_sample_done);
+
+    timer_init.update_time_us = AS5600_SAMPLE_PERIOD_US;
+    TimerInit(AS5600_SAMPLE_TIMER, &timer_init);
+    TimerUpdateCallbackRegister(AS5600_SAMPLE_TIMER, &as5600_sample_start);
+
+    TerminalCommandRegister("knob_stat", &knob_stat_command);
+
+    return 0;
+}
+
+/**
+ * @brief 取出一个旋钮事件
+ *
+ * @param event 传出参数
+ * @return int8_t 没有事件时返回-1
+ */
+int8_t As5600GetEvent(KnobEvent *event)
+{
+    if(event_tail == event_head)
+        return -1;
+
+    *event = event_queue[event_tail];
+    event_tail = (event_tail + 1) % AS5600_EVENT_QUEUE_SIZE;
+
+    return 0;
+}
+
+int32_t As5600GetPosition(void)
+{
+    return position;
+}
+
+int32_t As5600GetVelocity(void)
+{
+    return velocity_q8 >> 8;
+}
+
+int32_t As5600GetDetent(void)
+{
+    return detent;
+}
+
+void As5600GetStat(KnobStat *stat)
+{
+    // 统计值在I2C中断里更新，拷贝时关中断
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *stat = knob_stat;
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief 定时器中断里发起一次采样，总线被占用时丢弃这次采样
+ *
+ */
+static void as5600_sample_start(void)
+{
+    if(sample_pending == 1) {
+        knob_stat.missed ++;
+        return;
+    }
+
+    if(I2cMemRead(AS5600_I2C, AS5600_ADDR, AS5600_REG_RAW_ANGLE, raw_buf, sizeof(raw_buf)) == 0) {
+        sample_pending = 1;
+    }
+    else {
+        knob_stat.missed ++;
+    }
+}
+
+/**
+ * @brief I2C读完成中断回调，总线上其他设备的读取也会进来，用sample_pending区分
+ *
+ * @param result 读取出错时为-1，丢弃这个采样，下一个采样照常发起
+ */
+static void as5600_sample_done(int8_t result)
+{
+    uint32_t start_cycles;
+    uint32_t cycles;
+
+    if(sample_pending == 0)
+        return;
+    sample_pending = 0;
+    if(result != 0) {
+        knob_stat.errors ++;
+        return;
+    }
+
+    start_cycles = DWT->CYCCNT;
+    as5600_process(((raw_buf[0] & 0x0f) << 8) | raw_buf[1]);
+    cycles = DWT->CYCCNT - start_cycles;
+
+    knob_stat.samples ++;
+    knob_stat.last_cycles = cycles;
+    knob_stat.total_cycles += cycles;
+    if(cycles > knob_stat.max_cycles)
+        knob_stat.max_cycles = cycles;
+}
+
+static void as5600_process(uint16_t raw)
+{
+    int32_t delta;
+    int64_t offset_q8;
+    int8_t dir = 0;
+
+    if(first_sample == 1) {
+        // 以上电时的绝对角度作为初始位置
+        first_sample = 0;
+        last_raw = raw;
+        position = raw;
+        detent = ((int32_t)raw * 256 + DETENT_WIDTH_Q8 / 2) / DETENT_WIDTH_Q8;
+        return;
+    }
+
+    // 解卷绕：两次采样间转过的角度不会超过半圈
+    delta = (int32_t)raw - last_raw;
+    if(delta > AS5600_COUNTS_PER_REV / 2)
+        delta -= AS5600_COUNTS_PER_REV;
+    else if(delta < -AS5600_COUNTS_PER_REV / 2)
+        delta += AS5600_COUNTS_PER_REV;
+    last_raw = raw;
+    position += delta;
+
+    // 一阶低通测速
+    velocity_q8 += ((delta * AS5600_SAMPLE_RATE * 256) - velocity_q8) >> AS5600_VELOCITY_SHIFT;
+
+    // 相对当前档位中心的偏移
+    offset_q8 = (int64_t)position * 256 - (int64_t)detent * DETENT_WIDTH_Q8;
+    if(offset_q8 > DETENT_STEP_THRESHOLD_Q8)
+        dir = 1;
+    else if(offset_q8 < -DETENT_STEP_THRESHOLD_Q8)
+        dir = -1;
+
+    if(dir != 0) {
+        if(dir == pending_dir) {
+            debounce_cnt ++;
+        }
+        else {
+            pending_dir = dir;
+            debounce_cnt = 1;
+        }
+
+        if(debounce_cnt >= AS5600_DEBOUNCE_SAMPLES) {
+            // 转得快时一次可能越过多个档位，逐个产生事件
+            while(offset_q8 > DETENT_STEP_THRESHOLD_Q8 || offset_q8 < -DETENT_STEP_THRESHOLD_Q8) {
+                detent += dir;
+                offset_q8 -= dir * DETENT_WIDTH_Q8;
+                as5600_push_event(dir > 0 ? KNOB_EVENT_STEP_CW : KNOB_EVENT_STEP_CCW);
+            }
+            pending_dir = 0;
+            debounce_cnt = 0;
+            settled = 0;
+            settle_cnt = 0;
+        }
+    }
+    else {
+        pending_dir = 0;
+        debounce_cnt = 0;
+    }
+
+    // 停稳判断
+    if(settled == 0) {
+        int32_t velocity = velocity_q8 >> 8;
+        if(velocity < AS5600_SETTLE_VELOCITY && velocity > -AS5600_SETTLE_VELOCITY && dir == 0) {
+            settle_cnt ++;
+            if(settle_cnt >= AS5600_SETTLE_SAMPLES) {
+                settled = 1;
+                as5600_push_event(KNOB_EVENT_DETENT);
+            }
+        }
+        else {
+            settle_cnt = 0;
+        }
+    }
+}
+
+static void as5600_push_event(KnobEventType type)
+{
+    uint8_t next = (event_head + 1) % AS5600_EVENT_QUEUE_SIZE;
+
+    // 队列满则丢弃最新的事件
+    if(next == event_tail)
+        return;
+
+    event_queue[event_head].type = type;
+    event_queue[event_head].detent = detent;
+    event_queue[event_head].velocity = velocity_q8 >> 8;
+    event_queue[event_head].time_ms = (uint32_t)GetSystemTimer_ms();
+    event_head = next;
+}
+
+static void knob_stat_command(void)
+{
+    KnobStat stat;
+    uint32_t avg_cycles = 0;
+
+    As5600GetStat(&stat);
+    if(stat.samples != 0)
+        avg_cycles = (uint32_t)(stat.total_cycles / stat.samples);
+
+    elog_i("knob", "samples %u missed %u errors %u", stat.samples, stat.missed, stat.errors);
+    // CPU占用按千分比给出：平均周期数 * 采样率 / 主频
+    elog_i("knob", "cycles avg %u max %u last %u, cpu %u/1000", avg_cycles, stat.max_cycles, stat.last_cycles,
+        (uint32_t)((uint64_t)avg_cycles * AS5600_SAMPLE_RATE * 1000 / SystemCoreClock));
+    elog_i("knob", "position %d detent %d velocity %d", position, detent, velocity_q8 >> 8);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "stdint.h"
+
+#define AS5600_COUNTS_PER_REV       4096
+#define AS5600_EVENT_QUEUE_SIZE     16
+
+typedef enum __KnobEventType
+{
+    KNOB_EVENT_STEP_CW = 0,     // 顺时针越过一个档位
+    KNOB_EVENT_STEP_CCW,        // 逆时针越过一个档位
+    KNOB_EVENT_DETENT,          // 停稳在某个档位上
+}KnobEventType;
+
+typedef struct __KnobEvent
+{
+    KnobEventType type;
+    int32_t detent;             // 事件发生时所在档位
+    int32_t velocity;           // 角速度，单位 counts/s
+    uint32_t time_ms;
+}KnobEvent;
+
+typedef struct __KnobStat
+{
+    uint32_t samples;           // 处理过的采样数
+    uint32_t missed;            // 总线忙导致丢弃的采样数
+    uint32_t errors;            // I2C出错(无应答、总线错误)的采样数
+    uint32_t last_cycles;       // 最近一次采样处理耗费的CPU周期
+    uint32_t max_cycles;
+    uint64_t total_cycles;
+}KnobStat;
+
+int8_t As5600Init(void);
+
+int8_t As5600GetEvent(KnobEvent *event);
+
+int32_t As5600GetPosition(void);
+
+int32_t As5600GetVelocity(void);
+
+int32_t As5600GetDetent(void);
+
+void As5600GetStat(KnobStat *stat);
@@ -0,0 +1,510 @@
+/**
+ * @file bl8025.c
+ * @brief BL8025实时时钟：定期对时时读取芯片，其余时间用GetSystemTimer_us本地计时
+ *
+ * 对时时会寻找芯片的秒边沿，用两次秒边沿之间的本地时间估计本地晶振相对芯片的漂移，
+ * 本地计时按估计出的漂移修正。找到芯片的秒边沿后再找内部RTC的秒边沿，两者的相位差
+ * 随时间的变化就是LXTAL相对芯片的漂移，间隔足够长后写入RTC的校准。
+ * 读写芯片都在I2C中断回调里结束，主循环只推进状态，不等待总线。
+ */
+
+#include "bl8025.h"
+#include "stddef.h"
+#include "stdio.h"
+#include "driver.h"
+#include "system_timer.h"
+#include "terminal_com.h"
+#include "elog.h"
+
+#ifndef BL8025_I2C
+    #error "please define BL8025_I2C first!"
+#endif
+
+#define BL8025_ADDR                 0x64
+#define BL8025_REG_SEC              0x00
+#define BL8025_TIME_REG_NUM         7
+
+#define BL8025_RESYNC_INTERVAL_US   (600ULL * 1000000)  // 每十分钟与芯片对一次时
+#define BL8025_EDGE_POLL_US         10000               // 寻找秒边沿时的读取间隔
+#define BL8025_EDGE_LEAD_US         30000               // 在预测的秒边沿之前多久开始读取
+#define BL8025_EDGE_TIMEOUT_US      1200000
+#define BL8025_DRIFT_MIN_SPAN_S     60                  // 参考间隔太短时漂移估计误差太大，不更新
+#define BL8025_RTC_CALIB_MIN_SPAN_S (6UL * 3600)        // RTC边沿只能在主循环里查到，间隔要长到这个误差可以忽略
+
+#define BL8025_BASE_YEAR            CALENDAR_BASE_YEAR
+
+#define BCD_TO_BIN(value)           ((((value) >> 4) & 0x0f) * 10 + ((value) & 0x0f))
+#define BIN_TO_BCD(value)           ((uint8_t)((((value) / 10) << 4) | ((value) % 10)))
+
+typedef enum __Bl8025SyncState
+{
+    BL8025_IDLE = 0,
+    BL8025_WAIT_EDGE,       // 等待预测的秒边沿到来
+    BL8025_READ_FIRST,      // 第一次读取进行中
+    BL8025_SEEK_EDGE,       // 等待下一次轮询
+    BL8025_READ_SEEK,       // 轮询的读取进行中，读到秒值变化就找到了边沿
+    BL8025_SEEK_RTC,        // 等待内部RTC的秒边沿
+    BL8025_WRITE,           // 设置时间的写入进行中
+}Bl8025SyncState;
+
+static uint8_t reg_buf[BL8025_TIME_REG_NUM];
+static uint8_t write_buf[BL8025_TIME_REG_NUM + 1];
+
+// 由I2C中断回调置位，主循环取走结果
+static volatile uint8_t transfer_pending = 0;
+static volatile uint8_t transfer_done = 0;
+static volatile int8_t transfer_result = 0;
+
+static struct
+{
+    uint32_t base_sec;      // 最近一次秒边沿时芯片的时间，自2000-01-01起的秒数
+    uint64_t base_us;       // 该秒边沿对应的本地时间
+    uint32_t ref_sec;       // 漂移估计的参考秒边沿
+    uint64_t ref_us;
+    int32_t drift_ppb;      // 本地时钟比芯片快多少，单位十亿分之一
+    uint8_t synced;
+}clock_model;
+
+static struct
+{
+    uint32_t ref_sec;       // 参考点的芯片时间
+    int64_t ref_offset_us;  // 参考点RTC比芯片快多少
+    int32_t drift_ppb;      // 最近一次估计的LXTAL剩余漂移，已经计入校准
+    uint8_t valid;          // 为0时下一次对时重新取参考点
+}rtc_model;
+
+static struct
+{
+    Bl8025SyncState state;
+    uint64_t last_attempt_us;
+    uint64_t next_poll_us;
+    uint64_t seek_start_us;
+    uint64_t read_us;       // 正在进行的传输的发起时间
+    uint64_t last_read_us;
+    uint32_t last_read_sec;
+    uint32_t edge_sec;      // 找到的芯片秒边沿，等RTC边沿时使用
+    uint64_t edge_us;
+    uint32_t rtc_sec;
+    uint32_t set_sec;       // 正在写入芯片的时间
+}sync_info;
+
+static int8_t bl8025_read_start(uint64_t now);
+static void bl8025_transfer_done(int8_t result);
+static int8_t bl8025_parse_seconds(uint32_t *sec);
+static void bl8025_edge_found(uint32_t sec, uint64_t edge_us);
+static void bl8025_rtc_edge_found(uint32_t rtc_sec, uint64_t rtc_edge_us);
+static uint64_t bl8025_predict_edge(uint64_t now);
+static void rtc_time_command(void);
+static void bl_set_command(void);
+
+/**
+ * @brief 注册I2C回调并立即对一次时，会阻塞到找到芯片和RTC的秒边沿，最多约两秒
+ *
+ * @return int8_t 芯片时间无效或没有应答时返回-1，之后主循环里照常定期重试
+ */
+int8_t Bl8025Init(void)
+{
+    TerminalCommandRegister("rtc_time", &rtc_time_command);
+    TerminalCommandRegister("bl_set", &bl_set_command);
+    I2cReadCallbackRegister(BL8025_I2C, &bl8025_transfer_done);
+    I2cWriteCallbackRegister(BL8025_I2C, &bl8025_transfer_done);
+
+    sync_info.last_attempt_us = GetSystemTimer_us();
+    sync_info.next_poll_us = sync_info.last_attempt_us;
+    sync_info.state = BL8025_WAIT_EDGE;
+    while(sync_info.state != BL8025_IDLE)
+        Bl8025Process();
+
+    if(clock_model.synced == 0) {
+        elog_e("rtc", "bl8025 time invalid");
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief 主循环中调用，到对时周期后寻找芯片秒边沿并更新本地计时，每次调用只推进一步，不等待总线
+ *
+ */
+void Bl8025Process(void)
+{
+    uint64_t now = GetSystemTimer_us();
+    uint32_t sec;
+
+    switch(sync_info.state) {
+    case BL8025_IDLE:
+        if(now - sync_info.last_attempt_us < BL8025_RESYNC_INTERVAL_US)
+            break;
+        sync_info.last_attempt_us = now;
+        if(clock_model.synced == 1) {
+            // 按本地模型预测下一个秒边沿，只在边沿附近读芯片
+            sync_info.next_poll_us = bl8025_predict_edge(now) - BL8025_EDGE_LEAD_US;
+        }
+        else {
+            sync_info.next_poll_us = now;
+        }
+        sync_info.state = BL8025_WAIT_EDGE;
+        break;
+    case BL8025_WAIT_EDGE:
+        if(now < sync_info.next_poll_us)
+            break;
+        // 总线被占用时下一次再试
+        if(bl8025_read_start(now) == 0)
+            sync_info.state = BL8025_READ_FIRST;
+        break;
+    case BL8025_READ_FIRST:
+        if(transfer_done == 0)
+            break;
+        transfer_done = 0;
+        if(transfer_result != 0 || bl8025_parse_seconds(&sec) != 0) {
+            sync_info.state = BL8025_IDLE;
+            break;
+        }
+        sync_info.last_read_sec = sec;
+        sync_info.last_read_us = sync_info.read_us;
+        sync_info.seek_start_us = sync_info.read_us;
+        sync_info.next_poll_us = sync_info.read_us + BL8025_EDGE_POLL_US;
+        sync_info.state = BL8025_SEEK_EDGE;
+        break;
+    case BL8025_SEEK_EDGE:
+        if(now < sync_info.next_poll_us)
+            break;
+        if(bl8025_read_start(now) == 0)
+            sync_info.state = BL8025_READ_SEEK;
+        break;
+    case BL8025_READ_SEEK:
+        if(transfer_done == 0)
+            break;
+        transfer_done = 0;
+        if(transfer_result != 0 || bl8025_parse_seconds(&sec) != 0) {
+            sync_info.state = BL8025_IDLE;
+            break;
+        }
+        if(sec != sync_info.last_read_sec) {
+            // 秒边沿在两次读取之间，取中点
+            bl8025_edge_found(sec, (sync_info.last_read_us + sync_info.read_us) / 2);
+            sync_info.edge_sec = sec;
+            sync_info.edge_us = (sync_info.last_read_us + sync_info.read_us) / 2;
+            sync_info.rtc_sec = RtcNow();
+            sync_info.seek_start_us = now;
+            sync_info.state = BL8025_SEEK_RTC;
+        }
+        else if(sync_info.read_us - sync_info.seek_start_us > BL8025_EDGE_TIMEOUT_US) {
+            // 没有等到秒边沿，还没对过时就直接按读到的值对时
+            if(clock_model.synced == 0)
+                bl8025_edge_found(sec, sync_info.seek_start_us);
+            sync_info.state = BL8025_IDLE;
+        }
+        else {
+            sync_info.last_read_us = sync_info.read_us;
+            sync_info.next_poll_us = sync_info.read_us + BL8025_EDGE_POLL_US;
+            sync_info.state = BL8025_SEEK_EDGE;
+        }
+        break;
+    case BL8025_SEEK_RTC:
+        // RTC计数器只是寄存器读取，每次主循环都查
+        sec = RtcNow();
+        if(sec != sync_info.rtc_sec) {
+            bl8025_rtc_edge_found(sec, now);
+            sync_info.state = BL8025_IDLE;
+        }
+        else if(now - sync_info.seek_start_us > BL8025_EDGE_TIMEOUT_US) {
+            // RTC没有在走
+            sync_info.state = BL8025_IDLE;
+        }
+        break;
+    case BL8025_WRITE:
+        if(transfer_done == 0)
+            break;
+        transfer_done = 0;
+        sync_info.state = BL8025_IDLE;
+        if(transfer_result != 0) {
+            elog_w("rtc", "bl8025 write failed");
+            break;
+        }
+        // 写秒寄存器时芯片的分频链被清零，当作一个秒边沿，芯片时间不连续了，漂移参考点重新开始
+        clock_model.base_sec = sync_info.set_sec;
+        clock_model.base_us = sync_info.read_us;
+        clock_model.ref_sec = clock_model.base_sec;
+        clock_model.ref_us = sync_info.read_us;
+        clock_model.synced = 1;
+        rtc_model.valid = 0;
+        RtcSetTime(sync_info.set_sec, RTC_SYNC_USER);
+        sync_info.last_attempt_us = now;
+        break;
+    default:
+        sync_info.state = BL8025_IDLE;
+        break;
+    }
+}
+
+/**
+ * @brief 获取本地计时的当前时间，自2000-01-01起的秒数，不访问I2C总线
+ *
+ * @return uint32_t
+ */
+uint32_t Bl8025GetSeconds(void)
+{
+    int64_t elapsed_us = (int64_t)(GetSystemTimer_us() - clock_model.base_us);
+
+    elapsed_us -= elapsed_us * clock_model.drift_ppb / 1000000000;
+
+    return clock_model.base_sec + (uint32_t)(elapsed_us / 1000000);
+}
+
+int8_t Bl8025GetTime(ClockTime *time)
+{
+    if(clock_model.synced == 0)
+        return -1;
+
+    CalendarFromSeconds(Bl8025GetSeconds(), time);
+
+    return 0;
+}
+
+/**
+ * @brief 设置时间，在主循环里写入芯片，写完后同步内部RTC并重新开始漂移估计
+ *
+ * @param time UTC时间
+ * @return int8_t 时间不合法或者还有传输没有结束时返回-1
+ */
+int8_t Bl8025SetTime(const ClockTime *time)
+{
+    int32_t days;
+    uint64_t now;
+
+    // 芯片只有两位年份
+    if(CalendarCheck(time) != 0 || time->year > BL8025_BASE_YEAR + 99) {
+        return -1;
+    }
+    if(sync_info.state == BL8025_READ_FIRST || sync_info.state == BL8025_READ_SEEK ||
+        sync_info.state == BL8025_WRITE) {
+        return -1;
+    }
+
+    days = CalendarDaysFromDate(time->year, time->month, time->day);
+
+    write_buf[0] = BL8025_REG_SEC;
+    write_buf[1] = BIN_TO_BCD(time->sec);
+    write_buf[2] = BIN_TO_BCD(time->min);
+    write_buf[3] = BIN_TO_BCD(time->hour);
+    write_buf[4] = 1 << CALENDAR_WEEKDAY(days);     // 星期寄存器每天占一位
+    write_buf[5] = BIN_TO_BCD(time->day);
+    write_buf[6] = BIN_TO_BCD(time->month);
+    write_buf[7] = BIN_TO_BCD(time->year - BL8025_BASE_YEAR);
+
+    now = GetSystemTimer_us();
+    transfer_pending = 1;
+    if(I2cWrite(BL8025_I2C, BL8025_ADDR, write_buf, sizeof(write_buf)) != 0) {
+        transfer_pending = 0;
+        return -1;
+    }
+    sync_info.read_us = now;
+    sync_info.set_sec = CalendarToSeconds(time);
+    sync_info.state = BL8025_WRITE;
+
+    return 0;
+}
+
+int32_t Bl8025GetDriftPpb(void)
+{
+    return clock_model.drift_ppb;
+}
+
+/**
+ * @brief 发起一次时间寄存器的读取，在bl8025_transfer_done里结束
+ *
+ * @param now 发起时间，找秒边沿时用
+ * @return int8_t 总线忙时返回-1
+ */
+static int8_t bl8025_read_start(uint64_t now)
+{
+    // 先置位再发起，回调可能在I2cMemRead返回之前就进来
+    transfer_pending = 1;
+    if(I2cMemRead(BL8025_I2C, BL8025_ADDR, BL8025_REG_SEC, reg_buf, sizeof(reg_buf)) != 0) {
+        transfer_pending = 0;
+        return -1;
+    }
+    sync_info.read_us = now;
+
+    return 0;
+}
+
+/**
+ * @brief I2C读写完成中断回调，总线上其他设备的传输也会进来，用transfer_pending区分
+ *
+ * @param result
+ */
+static void bl8025_transfer_done(int8_t result)
+{
+    if(transfer_pending == 0)
+        return;
+    transfer_pending = 0;
+    transfer_result = result;
+    transfer_done = 1;
+}
+
+/**
+ * @brief 把读到的7个时间寄存器转换为秒数
+ *
+ * @param sec 传出参数，自2000-01-01起的秒数
+ * @return int8_t 寄存器内容不合法时返回-1
+ */
+static int8_t bl8025_parse_seconds(uint32_t *sec)
+{
+    uint8_t second, minute, hour, day, month, year;
+
+    second = BCD_TO_BIN(reg_buf[0] & 0x7f);
+    minute = BCD_TO_BIN(reg_buf[1] & 0x7f);
+    hour = BCD_TO_BIN(reg_buf[2] & 0x3f);
+    day = BCD_TO_BIN(reg_buf[4] & 0x3f);
+    month = BCD_TO_BIN(reg_buf[5] & 0x1f);
+    year = BCD_TO_BIN(reg_buf[6]);
+
+    if(second > 59 || minute > 59 || hour > 23 || day < 1 ||
+        month < 1 || month > 12 || year > 99 || day > CalendarDaysInMonth(BL8025_BASE_YEAR + year, month)) {
+        return -1;
+    }
+
+    *sec = CALENDAR_SECONDS(BL8025_BASE_YEAR + year, month, day, hour, minute, second);
+
+    return 0;
+}
+
+/**
+ * @brief 找到一个秒边沿，更新本地计时的基准，参考间隔足够长时更新漂移估计
+ *
+ * @param sec 边沿之后芯片的秒数
+ * @param edge_us 边沿对应的本地时间
+ */
+static void bl8025_edge_found(uint32_t sec, uint64_t edge_us)
+{
+    if(clock_model.synced == 0 || sec < clock_model.ref_sec) {
+        clock_model.ref_sec = sec;
+        clock_model.ref_us = edge_us;
+    }
+    else if(sec - clock_model.ref_sec >= BL8025_DRIFT_MIN_SPAN_S) {
+        // 误差(us) / 间隔(s) * 1000 即为ppb，参考点固定在最早的边沿，间隔越长估计越准
+        uint32_t span_s = sec - clock_model.ref_sec;
+        int64_t error_us = (int64_t)(edge_us - clock_model.ref_us) - (int64_t)span_s * 1000000;
+        clock_model.drift_ppb = (int32_t)(error_us * 1000 / span_s);
+    }
+
+    if(clock_model.synced == 0) {
+        // 第一次对时，内部RTC按芯片时间设置，RTC的漂移参考点重新开始
+        RtcSetTime(sec, RTC_SYNC_BL8025);
+        rtc_model.valid = 0;
+    }
+    clock_model.base_sec = sec;
+    clock_model.base_us = edge_us;
+    clock_model.synced = 1;
+}
+
+/**
+ * @brief 找到内部RTC的秒边沿，和刚找到的芯片秒边沿比较，间隔足够长时把RTC的漂移计入校准
+ *
+ * 两个边沿相隔不到两秒，本地时钟的漂移可以忽略，直接用本地时间比较
+ *
+ * @param rtc_sec 边沿之后RTC的秒数
+ * @param rtc_edge_us 边沿对应的本地时间
+ */
+static void bl8025_rtc_edge_found(uint32_t rtc_sec, uint64_t rtc_edge_us)
+{
+    // RTC边沿时刻芯片的时间是edge_sec加上两个边沿的间隔
+    int64_t offset_us = ((int64_t)rtc_sec - sync_info.edge_sec) * 1000000 -
+        (int64_t)(rtc_edge_us - sync_info.edge_us);
+    int32_t step_s;
+    uint32_t span_s;
+    RtcSyncInfo info;
+
+    // 差出半秒以上时按整秒调整RTC计数器，刚过RTC边沿，改写不会和进位撞上
+    if(offset_us >= 500000 || offset_us <= -500000) {
+        step_s = (int32_t)((offset_us + (offset_us > 0 ? 500000 : -500000)) / 1000000);
+        RtcSetTime(rtc_sec - step_s, RTC_SYNC_BL8025);
+        offset_us -= (int64_t)step_s * 1000000;
+        rtc_model.ref_offset_us -= (int64_t)step_s * 1000000;
+    }
+
+    if(rtc_model.valid == 0 || sync_info.edge_sec < rtc_model.ref_sec) {
+        rtc_model.ref_sec = sync_info.edge_sec;
+        rtc_model.ref_offset_us = offset_us;
+        rtc_model.valid = 1;
+        return;
+    }
+
+    span_s = sync_info.edge_sec - rtc_model.ref_sec;
+    if(span_s < BL8025_RTC_CALIB_MIN_SPAN_S)
+        return;
+
+    // 测得的是当前校准下剩下的漂移，加到已有的校准上，校准改变后参考点重新开始
+    rtc_model.drift_ppb = (int32_t)((offset_us - rtc_model.ref_offset_us) * 1000 / span_s);
+    RtcGetSyncInfo(&info);
+    if(RtcSetCalibration(info.calibration_ppb + rtc_model.drift_ppb) != 0)
+        elog_w("rtc", "LXTAL drift %d ppb out of calibration range", info.calibration_ppb + rtc_model.drift_ppb);
+    rtc_model.ref_sec = sync_info.edge_sec;
+    rtc_model.ref_offset_us = offset_us;
+}
+
+/**
+ * @brief 按本地模型预测下一个秒边沿的本地时间
+ *
+ * @param now
+ * @return uint64_t
+ */
+static uint64_t bl8025_predict_edge(uint64_t now)
+{
+    int64_t elapsed_us = (int64_t)(now - clock_model.base_us);
+    int64_t next_us;
+
+    elapsed_us -= elapsed_us * clock_model.drift_ppb / 1000000000;
+    next_us = (elapsed_us / 1000000 + 1) * 1000000;
+
+    return clock_model.base_us + next_us + next_us * clock_model.drift_ppb / 1000000000;
+}
+
+static void rtc_time_command(void)
+{
+    ClockTime time;
+
+    if(Bl8025GetTime(&time) != 0) {
+        elog_w("rtc", "not synced");
+        return;
+    }
+    elog_i("rtc", "%04d-%02d-%02d %02d:%02d:%02d week %d", time.year, time.month, time.day,
+        time.hour, time.min, time.sec, time.week);
+    elog_i("rtc", "drift %d ppb, LXTAL drift %d ppb", clock_model.drift_ppb, rtc_model.drift_ppb);
+}
+
+/**
+ * @brief 设置芯片时间，同时同步内部RTC
+ *
+ * bl_set 2026-01-01 08:00:00       UTC时间
+ */
+static void bl_set_command(void)
+{
+    unsigned int year, month, day, hour, min, sec;
+    ClockTime time;
+
+    if(sscanf(TerminalCommandArgs(), "%u-%u-%u %u:%u:%u", &year, &month, &day, &hour, &min, &sec) != 6) {
+        elog_w("rtc", "usage: bl_set yyyy-mm-dd hh:mm:ss");
+        return;
+    }
+    // 先检查范围，超出uint8_t的值截断后可能变成合法值
+    if(year > 0xffff || month > 12 || day > 31 || hour > 23 || min > 59 || sec > 59) {
+        elog_w("rtc", "invalid time");
+        return;
+    }
+    time.year = (uint16_t)year;
+    time.month = (uint8_t)month;
+    time.day = (uint8_t)day;
+    time.hour = (uint8_t)hour;
+    time.min = (uint8_t)min;
+    time.sec = (uint8_t)sec;
+    time.week = 0;
+    if(Bl8025SetTime(&time) != 0) {
+        elog_w("rtc", "invalid time or bl8025 busy");
+        return;
+    }
+    elog_i("rtc", "bl8025 set to %04u-%02u-%02u %02u:%02u:%02u", year, month, day, hour, min, sec);
+}
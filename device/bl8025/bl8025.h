@@ -0,0 +1,16 @@
+#pragma once
+
+#include "stdint.h"
+#include "calendar.h"
+
+int8_t Bl8025Init(void);
+
+void Bl8025Process(void);
+
+int8_t Bl8025GetTime(ClockTime *time);
+
+uint32_t Bl8025GetSeconds(void);
+
+int8_t Bl8025SetTime(const ClockTime *time);
+
+int32_t Bl8025GetDriftPpb(void);
@@ -0,0 +1,306 @@
+/**
+ * @file exmc_lcd.c
+ * @brief EXMC并口屏：控制器的命令和数据寄存器映射在EXMC地址空间，像素由DMA存储器到存储器写入
+ *
+ * 所有绘图操作都是设置窗口后把一块像素写入数据地址。设置窗口由CPU完成，需要等待上一次DMA结束，
+ * 像素写入交给DMA后立即返回，调用者在写入期间可以准备下一块数据。
+ */
+
+#include "exmc_lcd.h"
+#include "stddef.h"
+#include "gd32f30x.h"
+#include "driver.h"
+#include "driver_exmc.h"
+#include "system_timer.h"
+#include "terminal_com.h"
+#include "elog.h"
+
+// 控制器的RS接A16，A16为低是命令，为高是数据
+#define EXMC_LCD_CMD                ((volatile uint16_t *)EXMC_REGION0_ADDR)
+#define EXMC_LCD_DATA               ((volatile uint16_t *)(EXMC_REGION0_ADDR | EXMC_A16_OFFSET))
+
+#define EXMC_LCD_RST_PORT           GPIOD
+#define EXMC_LCD_RST_PIN            GPIO_PIN_13
+
+#define EXMC_LCD_INIT_DELAY         0x80    // 初始化表里参数个数的最高位，表示参数后跟一个延时(ms)
+
+#define EXMC_LCD_BENCH_FRAMES       10
+#define EXMC_LCD_BENCH_BAND_LINES   4       // 拷贝测试的源数据是几行像素，重复拷贝覆盖整屏
+
+/*
+ * 初始化表，每条为: 命令, 参数个数(|EXMC_LCD_INIT_DELAY), 参数..., [延时]
+ */
+static const uint8_t lcd_init_table[] = {
+    0x01, EXMC_LCD_INIT_DELAY, 120,                 // 软件复位
+    0x11, EXMC_LCD_INIT_DELAY, 120,                 // 退出睡眠
+    0x3A, 1, 0x55,                                  // RGB565
+    0x36, 1, 0x48,                                  // 列地址翻转，BGR
+    0x29, EXMC_LCD_INIT_DELAY, 20,                  // 开显示
+};
+
+static uint16_t fill_color;
+
+static uint16_t bench_band[EXMC_LCD_WIDTH * EXMC_LCD_BENCH_BAND_LINES];
+
+static void exmc_lcd_delay_ms(uint32_t ms);
+static void exmc_lcd_command(uint8_t cmd, const uint8_t *args, uint8_t arg_num);
+static void exmc_lcd_set_window(uint16_t x, uint16_t y, uint16_t w, uint16_t h);
+static void exmc_lcd_cpu_blit(uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint16_t *pixels);
+static uint32_t exmc_lcd_fps(uint32_t cycles);
+static void exmc_lcd_bench_command(void);
+
+/**
+ * @brief 初始化EXMC和屏幕并清屏，阻塞执行
+ *
+ * @return int8_t
+ */
+int8_t ExmcLcdInit(void)
+{
+    uint16_t i = 0;
+    uint8_t cmd;
+    uint8_t arg_num;
+
+    ExmcInit();
+
+    rcu_periph_clock_enable(RCU_GPIOD);
+    gpio_init(EXMC_LCD_RST_PORT, GPIO_MODE_OUT_PP, GPIO_OSPEED_50MHZ, EXMC_LCD_RST_PIN);
+
+    // 硬件复位
+    gpio_bit_reset(EXMC_LCD_RST_PORT, EXMC_LCD_RST_PIN);
+    exmc_lcd_delay_ms(10);
+    gpio_bit_set(EXMC_LCD_RST_PORT, EXMC_LCD_RST_PIN);
+    exmc_lcd_delay_ms(120);
+
+    while(i < sizeof(lcd_init_table))
+    {
+        cmd = lcd_init_table[i++];
+        arg_num = lcd_init_table[i++];
+        exmc_lcd_command(cmd, &lcd_init_table[i], arg_num & ~EXMC_LCD_INIT_DELAY);
+        i += arg_num & ~EXMC_LCD_INIT_DELAY;
+        if(arg_num & EXMC_LCD_INIT_DELAY)
+        {
+            exmc_lcd_delay_ms(lcd_init_table[i++]);
+        }
+    }
+
+    ExmcLcdFill(0, 0, EXMC_LCD_WIDTH, EXMC_LCD_HEIGHT, FONT_COLOR_BLACK);
+    ExmcLcdWait();
+
+    TerminalCommandRegister("exlcd_bench", &exmc_lcd_bench_command);
+
+    return 0;
+}
+
+/**
+ * @brief 矩形填充纯色
+ *
+ * @return int8_t 矩形超出屏幕时返回-1
+ */
+int8_t ExmcLcdFill(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color)
+{
+    if(w == 0 || h == 0 || x + w > EXMC_LCD_WIDTH || y + h > EXMC_LCD_HEIGHT)
+    {
+        return -1;
+    }
+
+    // DMA重复读取fill_color，必须等上一次填充结束才能修改
+    ExmcLcdWait();
+    fill_color = color;
+    exmc_lcd_set_window(x, y, w, h);
+    ExmcWriteDMA(EXMC_LCD_DATA, &fill_color, (uint32_t)w * h, 0);
+
+    return 0;
+}
+
+/**
+ * @brief 把逐行排列的像素块拷贝到屏幕，可以直接作为FontBlitFunc使用
+ *
+ * pixels在写入完成前不能修改，超出屏幕的像素块被丢弃
+ */
+void ExmcLcdBlit(uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint16_t *pixels)
+{
+    if(w == 0 || h == 0 || x + w > EXMC_LCD_WIDTH || y + h > EXMC_LCD_HEIGHT)
+    {
+        return;
+    }
+
+    ExmcLcdWait();
+    exmc_lcd_set_window(x, y, w, h);
+    ExmcWriteDMA(EXMC_LCD_DATA, pixels, (uint32_t)w * h, 1);
+}
+
+/**
+ * @brief 绘制一行文字
+ *
+ * 字形取自字体的渲染缓存，DMA发送当前字符时取下一个字符只会替换最久未用的缓存项，
+ * 不会覆盖正在发送的像素。
+ *
+ * @return uint16_t 绘制后的x坐标
+ */
+uint16_t ExmcLcdDrawText(uint16_t x, uint16_t y, const char *text, uint16_t fg, uint16_t bg)
+{
+    return FontDrawText(x, y, text, fg, bg, &ExmcLcdBlit);
+}
+
+uint8_t ExmcLcdIsBusy(void)
+{
+    return ExmcIsBusy();
+}
+
+void ExmcLcdWait(void)
+{
+    while(ExmcIsBusy());
+}
+
+static void exmc_lcd_delay_ms(uint32_t ms)
+{
+    uint64_t start = GetSystemTimer_us();
+
+    while(GetSystemTimer_us() - start < (uint64_t)ms * 1000);
+}
+
+static void exmc_lcd_command(uint8_t cmd, const uint8_t *args, uint8_t arg_num)
+{
+    uint8_t i;
+
+    *EXMC_LCD_CMD = cmd;
+    for(i = 0; i < arg_num; i ++)
+    {
+        *EXMC_LCD_DATA = args[i];
+    }
+}
+
+/**
+ * @brief 设置写入窗口并开始写显存，调用前DMA必须空闲
+ *
+ */
+static void exmc_lcd_set_window(uint16_t x, uint16_t y, uint16_t w, uint16_t h)
+{
+    uint8_t column[4];
+    uint8_t page[4];
+
+    column[0] = (uint8_t)(x >> 8);
+    column[1] = (uint8_t)x;
+    column[2] = (uint8_t)((x + w - 1) >> 8);
+    column[3] = (uint8_t)(x + w - 1);
+    page[0] = (uint8_t)(y >> 8);
+    page[1] = (uint8_t)y;
+    page[2] = (uint8_t)((y + h - 1) >> 8);
+    page[3] = (uint8_t)(y + h - 1);
+
+    exmc_lcd_command(0x2A, column, sizeof(column));
+    exmc_lcd_command(0x2B, page, sizeof(page));
+    exmc_lcd_command(0x2C, NULL, 0);
+}
+
+/**
+ * @brief CPU逐个像素写入，作为DMA的对比
+ *
+ */
+static void exmc_lcd_cpu_blit(uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint16_t *pixels)
+{
+    uint32_t num = (uint32_t)w * h;
+
+    exmc_lcd_set_window(x, y, w, h);
+    while(num--)
+    {
+        *EXMC_LCD_DATA = *pixels++;
+    }
+}
+
+static uint32_t exmc_lcd_fps(uint32_t cycles)
+{
+    return (uint32_t)((uint64_t)SystemCoreClock * EXMC_LCD_BENCH_FRAMES / cycles);
+}
+
+/**
+ * @brief 整屏填充、整屏拷贝和整屏文字分别用DMA和CPU写入，比较帧率
+ *
+ */
+static void exmc_lcd_bench_command(void)
+{
+    static const char text[] = "0123456789:0123456789:01234567";
+    uint32_t start_cycles;
+    uint32_t cycles;
+    uint32_t num;
+    uint16_t frame;
+    uint16_t y;
+    uint16_t i;
+
+    CycleCounterEnable();
+
+    for(i = 0; i < EXMC_LCD_WIDTH * EXMC_LCD_BENCH_BAND_LINES; i ++)
+    {
+        bench_band[i] = FONT_COLOR(i, i >> 2, i >> 4);
+    }
+
+    // 填充
+    start_cycles = DWT->CYCCNT;
+    for(frame = 0; frame < EXMC_LCD_BENCH_FRAMES; frame ++)
+    {
+        ExmcLcdFill(0, 0, EXMC_LCD_WIDTH, EXMC_LCD_HEIGHT, frame & 1 ? FONT_COLOR_WHITE : FONT_COLOR_BLACK);
+    }
+    ExmcLcdWait();
+    cycles = DWT->CYCCNT - start_cycles;
+    elog_i("exlcd", "fill dma %u fps", exmc_lcd_fps(cycles));
+
+    start_cycles = DWT->CYCCNT;
+    for(frame = 0; frame < EXMC_LCD_BENCH_FRAMES; frame ++)
+    {
+        exmc_lcd_set_window(0, 0, EXMC_LCD_WIDTH, EXMC_LCD_HEIGHT);
+        for(num = (uint32_t)EXMC_LCD_WIDTH * EXMC_LCD_HEIGHT; num > 0; num --)
+        {
+            *EXMC_LCD_DATA = frame & 1 ? FONT_COLOR_WHITE : FONT_COLOR_BLACK;
+        }
+    }
+    cycles = DWT->CYCCNT - start_cycles;
+    elog_i("exlcd", "fill cpu %u fps", exmc_lcd_fps(cycles));
+
+    // 拷贝，每次拷贝几行
+    start_cycles = DWT->CYCCNT;
+    for(frame = 0; frame < EXMC_LCD_BENCH_FRAMES; frame ++)
+    {
+        for(y = 0; y < EXMC_LCD_HEIGHT; y += EXMC_LCD_BENCH_BAND_LINES)
+        {
+            ExmcLcdBlit(0, y, EXMC_LCD_WIDTH, EXMC_LCD_BENCH_BAND_LINES, bench_band);
+        }
+    }
+    ExmcLcdWait();
+    cycles = DWT->CYCCNT - start_cycles;
+    elog_i("exlcd", "copy dma %u fps", exmc_lcd_fps(cycles));
+
+    start_cycles = DWT->CYCCNT;
+    for(frame = 0; frame < EXMC_LCD_BENCH_FRAMES; frame ++)
+    {
+        for(y = 0; y < EXMC_LCD_HEIGHT; y += EXMC_LCD_BENCH_BAND_LINES)
+        {
+            exmc_lcd_cpu_blit(0, y, EXMC_LCD_WIDTH, EXMC_LCD_BENCH_BAND_LINES, bench_band);
+        }
+    }
+    cycles = DWT->CYCCNT - start_cycles;
+    elog_i("exlcd", "copy cpu %u fps", exmc_lcd_fps(cycles));
+
+    // 整屏文字，每个字符一次小块拷贝
+    start_cycles = DWT->CYCCNT;
+    for(frame = 0; frame < EXMC_LCD_BENCH_FRAMES; frame ++)
+    {
+        for(y = 0; y + FONT_HEIGHT <= EXMC_LCD_HEIGHT; y += FONT_HEIGHT)
+        {
+            ExmcLcdDrawText(0, y, text, FONT_COLOR_WHITE, FONT_COLOR_BLACK);
+        }
+    }
+    ExmcLcdWait();
+    cycles = DWT->CYCCNT - start_cycles;
+    elog_i("exlcd", "text dma %u fps", exmc_lcd_fps(cycles));
+
+    start_cycles = DWT->CYCCNT;
+    for(frame = 0; frame < EXMC_LCD_BENCH_FRAMES; frame ++)
+    {
+        for(y = 0; y + FONT_HEIGHT <= EXMC_LCD_HEIGHT; y += FONT_HEIGHT)
+        {
+            FontDrawText(0, y, text, FONT_COLOR_WHITE, FONT_COLOR_BLACK, &exmc_lcd_cpu_blit);
+        }
+    }
+    cycles = DWT->CYCCNT - start_cycles;
+    elog_i("exlcd", "text cpu %u fps", exmc_lcd_fps(cycles));
+}
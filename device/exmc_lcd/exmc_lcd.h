@@ -0,0 +1,20 @@
+#pragma once
+
+#include "stdint.h"
+#include "font.h"
+
+// ILI9341，16位8080并口，竖屏
+#define EXMC_LCD_WIDTH              240
+#define EXMC_LCD_HEIGHT             320
+
+int8_t ExmcLcdInit(void);
+
+int8_t ExmcLcdFill(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color);
+
+void ExmcLcdBlit(uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint16_t *pixels);
+
+uint16_t ExmcLcdDrawText(uint16_t x, uint16_t y, const char *text, uint16_t fg, uint16_t bg);
+
+uint8_t ExmcLcdIsBusy(void);
+
+void ExmcLcdWait(void);
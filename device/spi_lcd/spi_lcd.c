@@ -0,0 +1,492 @@
+/**
+ * @file spi_lcd.c
+ * @brief SPI屏幕驱动，支持ST7735/ST7789彩屏和SSD1306单色屏
+ *
+ * 屏幕内容按字符格保存，LcdDrawText只把内容有变化的格标为脏。LcdProcess在主循环里调用，
+ * SPI空闲时把同一行相邻的脏格合并成一个矩形，设置窗口后用DMA发送像素，不等待发送完成就返回。
+ * 时钟每秒通常只有秒的个位变化，只需发送一个字符格，而不是整屏。
+ */
+
+#include "spi_lcd.h"
+#include "stddef.h"
+#include "string.h"
+#include "gd32f30x.h"
+#include "driver.h"
+#include "system_timer.h"
+#include "terminal_com.h"
+#include "elog.h"
+
+#ifndef LCD_SPI
+    #error "please define LCD_SPI first!"
+#endif
+
+// 片选PA15(关闭JTAG后可用)，数据/命令选择PB8，复位PB9
+#define LCD_CS_PORT             GPIOA
+#define LCD_CS_PIN              GPIO_PIN_15
+#define LCD_DC_PORT             GPIOB
+#define LCD_DC_PIN              GPIO_PIN_8
+#define LCD_RST_PORT            GPIOB
+#define LCD_RST_PIN             GPIO_PIN_9
+
+#define LCD_CS_LOW()            gpio_bit_reset(LCD_CS_PORT, LCD_CS_PIN)
+#define LCD_CS_HIGH()           gpio_bit_set(LCD_CS_PORT, LCD_CS_PIN)
+#define LCD_DC_COMMAND()        gpio_bit_reset(LCD_DC_PORT, LCD_DC_PIN)
+#define LCD_DC_DATA()           gpio_bit_set(LCD_DC_PORT, LCD_DC_PIN)
+
+// 部分模组的显示区域在控制器显存里有偏移
+#ifndef LCD_X_OFFSET
+#define LCD_X_OFFSET            0
+#endif
+#ifndef LCD_Y_OFFSET
+#define LCD_Y_OFFSET            0
+#endif
+
+#define LCD_RUN_CELLS           8           // 一次合并发送的最多字符格数
+
+#if LCD_CONTROLLER == LCD_SSD1306
+#define LCD_CELL_BYTES          (FONT_WIDTH * FONT_HEIGHT / 8)      // 单色，每字节竖向8个像素
+#define LCD_FRAME_BYTES         (LCD_WIDTH * LCD_HEIGHT / 8)
+#else
+#define LCD_CELL_BYTES          (FONT_GLYPH_PIXELS * 2)
+#define LCD_FRAME_BYTES         ((uint32_t)LCD_WIDTH * LCD_HEIGHT * 2)
+#endif
+
+#define LCD_INIT_DELAY          0x80        // 初始化表里参数个数的最高位，表示参数后跟一个延时(ms)
+
+typedef struct __LcdCell
+{
+    char c;
+    uint8_t dirty;
+    uint16_t fg;
+    uint16_t bg;
+}LcdCell;
+
+/*
+ * 初始化表，每条为: 命令, 参数个数(|LCD_INIT_DELAY), 参数..., [延时]
+ */
+#if LCD_CONTROLLER == LCD_SSD1306
+static const uint8_t lcd_init_table[] = {
+    0xAE, 0,                    // 关显示
+    0xD5, 1, 0x80,              // 时钟分频
+    0xA8, 1, LCD_HEIGHT - 1,    // 复用率
+    0xD3, 1, 0x00,              // 显示偏移
+    0x40, 0,                    // 起始行
+    0x8D, 1, 0x14,              // 开电荷泵
+    0x20, 1, 0x00,              // 水平寻址，窗口内写满一页自动换到下一页
+    0xA1, 0,                    // 列地址翻转
+    0xC8, 0,                    // 行扫描翻转
+    0xDA, 1, 0x12,
+    0x81, 1, 0xCF,              // 对比度
+    0xD9, 1, 0xF1,
+    0xDB, 1, 0x40,
+    0xA4, 0,
+    0xA6, 0,                    // 正常显示，不反色
+    0xAF, LCD_INIT_DELAY, 100,  // 开显示
+};
+#else
+static const uint8_t lcd_init_table[] = {
+    0x01, LCD_INIT_DELAY, 150,                  // 软件复位
+    0x11, LCD_INIT_DELAY, 120,                  // 退出睡眠
+    0x3A, 1 | LCD_INIT_DELAY, 0x05, 10,         // RGB565
+    0x36, 1, 0x00,                              // 扫描方向
+#if LCD_CONTROLLER == LCD_ST7789
+    0x21, 0,                                    // ST7789模组一般需要反色
+#else
+    0x20, 0,
+#endif
+    0x13, LCD_INIT_DELAY, 10,                   // 正常显示模式
+    0x29, LCD_INIT_DELAY, 100,                  // 开显示
+};
+#endif
+
+static LcdCell cells[LCD_ROWS][LCD_COLS];
+
+// 正在DMA发送的像素，发送期间不能修改
+static union
+{
+    uint16_t pixels[LCD_RUN_CELLS * FONT_GLYPH_PIXELS];
+    uint8_t bytes[LCD_RUN_CELLS * LCD_CELL_BYTES];
+}run_buf;
+
+static struct
+{
+    uint8_t inited;
+    uint8_t flushing;       // 正在发送一轮脏格
+    uint64_t flush_start_us;
+}lcd_state;
+
+static LcdStat lcd_stat;
+static uint32_t full_redraw_us;
+
+static void lcd_delay_ms(uint32_t ms);
+static void lcd_command(uint8_t cmd, const uint8_t *args, uint8_t arg_num);
+static void lcd_set_window(uint16_t x, uint16_t y, uint16_t w, uint16_t h);
+static void lcd_clear(uint16_t color);
+static int8_t lcd_find_run(uint8_t *row, uint8_t *col, uint8_t *num);
+static uint16_t lcd_render_run(uint8_t row, uint8_t col, uint8_t num);
+static void lcd_stat_command(void);
+
+/**
+ * @brief 初始化屏幕并清屏，阻塞执行，需要先初始化LCD_SPI
+ *
+ * @return int8_t
+ */
+int8_t LcdInit(void)
+{
+    uint16_t i = 0;
+    uint8_t cmd;
+    uint8_t arg_num;
+    uint8_t row, col;
+
+    rcu_periph_clock_enable(RCU_GPIOA);
+    rcu_periph_clock_enable(RCU_GPIOB);
+    gpio_init(LCD_CS_PORT, GPIO_MODE_OUT_PP, GPIO_OSPEED_50MHZ, LCD_CS_PIN);
+    gpio_init(LCD_DC_PORT, GPIO_MODE_OUT_PP, GPIO_OSPEED_50MHZ, LCD_DC_PIN);
+    gpio_init(LCD_RST_PORT, GPIO_MODE_OUT_PP, GPIO_OSPEED_50MHZ, LCD_RST_PIN);
+    LCD_CS_HIGH();
+    LCD_DC_DATA();
+
+    // 硬件复位
+    gpio_bit_reset(LCD_RST_PORT, LCD_RST_PIN);
+    lcd_delay_ms(10);
+    gpio_bit_set(LCD_RST_PORT, LCD_RST_PIN);
+    lcd_delay_ms(120);
+
+    LCD_CS_LOW();
+    while(i < sizeof(lcd_init_table))
+    {
+        cmd = lcd_init_table[i++];
+        arg_num = lcd_init_table[i++];
+        lcd_command(cmd, &lcd_init_table[i], arg_num & ~LCD_INIT_DELAY);
+        i += arg_num & ~LCD_INIT_DELAY;
+        if(arg_num & LCD_INIT_DELAY)
+        {
+            lcd_delay_ms(lcd_init_table[i++]);
+        }
+    }
+    lcd_clear(FONT_COLOR_BLACK);
+    LCD_CS_HIGH();
+
+    for(row = 0; row < LCD_ROWS; row ++)
+    {
+        for(col = 0; col < LCD_COLS; col ++)
+        {
+            cells[row][col].c = ' ';
+            cells[row][col].dirty = 0;
+            cells[row][col].fg = FONT_COLOR_WHITE;
+            cells[row][col].bg = FONT_COLOR_BLACK;
+        }
+    }
+    memset(&lcd_stat, 0, sizeof(lcd_stat));
+    lcd_state.flushing = 0;
+    lcd_state.inited = 1;
+
+    TerminalCommandRegister("lcd_stat", &lcd_stat_command);
+
+    return 0;
+}
+
+/**
+ * @brief 在字符格里写一行文字，超出屏幕的部分丢弃，只有内容或颜色变化的格才会重新发送
+ *
+ * @param col 起始列，单位为字符
+ * @param row 行，单位为字符
+ * @param text
+ * @param fg 前景色，RGB565，单色屏上非黑即亮
+ * @param bg 背景色
+ * @return int8_t
+ */
+int8_t LcdDrawText(uint8_t col, uint8_t row, const char *text, uint16_t fg, uint16_t bg)
+{
+    LcdCell *cell;
+
+    if(row >= LCD_ROWS || col >= LCD_COLS)
+    {
+        return -1;
+    }
+
+    while(*text != '\0' && col < LCD_COLS)
+    {
+        cell = &cells[row][col];
+        if(cell->c != *text || cell->fg != fg || cell->bg != bg)
+        {
+            cell->c = *text;
+            cell->fg = fg;
+            cell->bg = bg;
+            cell->dirty = 1;
+        }
+        col ++;
+        text ++;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief 所有字符格标为脏，下一轮整屏重画
+ *
+ */
+void LcdInvalidate(void)
+{
+    uint8_t row, col;
+
+    for(row = 0; row < LCD_ROWS; row ++)
+    {
+        for(col = 0; col < LCD_COLS; col ++)
+        {
+            cells[row][col].dirty = 1;
+        }
+    }
+}
+
+/**
+ * @brief 主循环里调用，SPI空闲时发送下一个脏矩形
+ *
+ */
+void LcdProcess(void)
+{
+    uint8_t row, col, num;
+    uint16_t data_num;
+    uint32_t flush_us;
+
+    if(lcd_state.inited == 0 || SpiIsBusy(LCD_SPI))
+    {
+        return;
+    }
+
+    if(lcd_find_run(&row, &col, &num) != 0)
+    {
+        if(lcd_state.flushing == 1)
+        {
+            // 一轮发送结束
+            LCD_CS_HIGH();
+            lcd_state.flushing = 0;
+            flush_us = (uint32_t)(GetSystemTimer_us() - lcd_state.flush_start_us);
+            lcd_stat.flushes ++;
+            lcd_stat.last_flush_us = flush_us;
+            if(flush_us > lcd_stat.max_flush_us)
+                lcd_stat.max_flush_us = flush_us;
+        }
+        return;
+    }
+
+    if(lcd_state.flushing == 0)
+    {
+        lcd_state.flushing = 1;
+        lcd_state.flush_start_us = GetSystemTimer_us();
+        LCD_CS_LOW();
+    }
+
+    data_num = lcd_render_run(row, col, num);
+    lcd_set_window(col * FONT_WIDTH, row * FONT_HEIGHT, num * FONT_WIDTH, FONT_HEIGHT);
+#if LCD_CONTROLLER == LCD_SSD1306
+    SpiSendDMA(LCD_SPI, run_buf.bytes, data_num, SpiFrame_8Bit);
+    lcd_stat.bytes += data_num;
+#else
+    SpiSendDMA(LCD_SPI, run_buf.pixels, data_num, SpiFrame_16Bit);
+    lcd_stat.bytes += data_num * 2;
+#endif
+    lcd_stat.rects ++;
+    lcd_stat.cells += num;
+}
+
+/**
+ * @brief 没有待发送的内容
+ *
+ */
+uint8_t LcdIsIdle(void)
+{
+    return lcd_state.flushing == 0 && !SpiIsBusy(LCD_SPI);
+}
+
+void LcdGetStat(LcdStat *stat)
+{
+    *stat = lcd_stat;
+}
+
+static void lcd_delay_ms(uint32_t ms)
+{
+    uint64_t start = GetSystemTimer_us();
+
+    while(GetSystemTimer_us() - start < (uint64_t)ms * 1000);
+}
+
+/**
+ * @brief 阻塞发送命令和参数，SSD1306的参数也按命令发送，ST77xx的参数按数据发送
+ *
+ */
+static void lcd_command(uint8_t cmd, const uint8_t *args, uint8_t arg_num)
+{
+    LCD_DC_COMMAND();
+    SpiSend(LCD_SPI, &cmd, 1);
+#if LCD_CONTROLLER != LCD_SSD1306
+    LCD_DC_DATA();
+#endif
+    if(arg_num != 0)
+    {
+        SpiSend(LCD_SPI, args, arg_num);
+    }
+    LCD_DC_DATA();
+    lcd_stat.bytes += 1 + arg_num;
+}
+
+/**
+ * @brief 设置写入窗口，之后发送的数据按行填满窗口
+ *
+ */
+static void lcd_set_window(uint16_t x, uint16_t y, uint16_t w, uint16_t h)
+{
+#if LCD_CONTROLLER == LCD_SSD1306
+    uint8_t column[2] = {(uint8_t)x, (uint8_t)(x + w - 1)};
+    uint8_t page[2] = {(uint8_t)(y / 8), (uint8_t)((y + h) / 8 - 1)};
+
+    lcd_command(0x21, column, sizeof(column));
+    lcd_command(0x22, page, sizeof(page));
+#else
+    uint8_t column[4];
+    uint8_t page[4];
+
+    x += LCD_X_OFFSET;
+    y += LCD_Y_OFFSET;
+    column[0] = (uint8_t)(x >> 8);
+    column[1] = (uint8_t)x;
+    column[2] = (uint8_t)((x + w - 1) >> 8);
+    column[3] = (uint8_t)(x + w - 1);
+    page[0] = (uint8_t)(y >> 8);
+    page[1] = (uint8_t)y;
+    page[2] = (uint8_t)((y + h - 1) >> 8);
+    page[3] = (uint8_t)(y + h - 1);
+
+    lcd_command(0x2A, column, sizeof(column));
+    lcd_command(0x2B, page, sizeof(page));
+    lcd_command(0x2C, NULL, 0);
+#endif
+}
+
+/**
+ * @brief 整屏填充纯色，DMA地址不递增，重复发送同一个数据，等待发送完成后返回
+ *
+ */
+static void lcd_clear(uint16_t color)
+{
+    static uint16_t fill;
+    uint64_t start = GetSystemTimer_us();
+    uint32_t remain = LCD_FRAME_BYTES;
+    uint16_t num;
+
+    lcd_set_window(0, 0, LCD_WIDTH, LCD_HEIGHT);
+#if LCD_CONTROLLER == LCD_SSD1306
+    fill = color != FONT_COLOR_BLACK ? 0xff : 0x00;
+#else
+    fill = color;
+    remain /= 2;
+#endif
+    while(remain > 0)
+    {
+        num = remain > 0xffff ? 0xffff : (uint16_t)remain;
+#if LCD_CONTROLLER == LCD_SSD1306
+        SpiSendRepeatDMA(LCD_SPI, &fill, num, SpiFrame_8Bit);
+#else
+        SpiSendRepeatDMA(LCD_SPI, &fill, num, SpiFrame_16Bit);
+#endif
+        while(SpiIsBusy(LCD_SPI));
+        remain -= num;
+    }
+
+    // 整屏重画的时间，作为局部刷新的对比
+    full_redraw_us = (uint32_t)(GetSystemTimer_us() - start);
+}
+
+/**
+ * @brief 按行扫描，找到第一段相邻的脏格，并清除它们的脏标记
+ *
+ * @return int8_t 没有脏格时返回-1
+ */
+static int8_t lcd_find_run(uint8_t *row, uint8_t *col, uint8_t *num)
+{
+    uint8_t r, c, n;
+
+    for(r = 0; r < LCD_ROWS; r ++)
+    {
+        for(c = 0; c < LCD_COLS; c ++)
+        {
+            if(cells[r][c].dirty == 0)
+                continue;
+
+            for(n = 0; n < LCD_RUN_CELLS && c + n < LCD_COLS && cells[r][c + n].dirty == 1; n ++)
+            {
+                cells[r][c + n].dirty = 0;
+            }
+            *row = r;
+            *col = c;
+            *num = n;
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * @brief 把一段字符格的像素按窗口的填充顺序写入run_buf
+ *
+ * @return uint16_t 要发送的数据个数，彩屏为像素数，单色屏为字节数
+ */
+static uint16_t lcd_render_run(uint8_t row, uint8_t col, uint8_t num)
+{
+#if LCD_CONTROLLER == LCD_SSD1306
+    // 水平寻址时先填满一页(8行)的所有列，每字节是一列的8个像素，最低位在上
+    const uint8_t *bitmap;
+    uint8_t *dst = run_buf.bytes;
+    uint8_t page, k, x, i;
+    uint8_t byte;
+
+    for(page = 0; page < FONT_HEIGHT / 8; page ++)
+    {
+        for(k = 0; k < num; k ++)
+        {
+            LcdCell *cell = &cells[row][col + k];
+            bitmap = FontBitmap(cell->c) + page * 8;
+            for(x = 0; x < FONT_WIDTH; x ++)
+            {
+                byte = 0;
+                for(i = 0; i < 8; i ++)
+                {
+                    byte |= ((bitmap[i] >> (7 - x)) & 0x01) << i;
+                }
+                // 前景色为黑时反色显示
+                *dst++ = cell->fg == FONT_COLOR_BLACK ? (uint8_t)~byte : byte;
+            }
+        }
+    }
+    return (uint16_t)(num * LCD_CELL_BYTES);
+#else
+    // 窗口按行填充，每个字符格的一行像素依次放在一起
+    const uint16_t *pixels;
+    uint16_t width = num * FONT_WIDTH;
+    uint8_t k, y;
+
+    for(k = 0; k < num; k ++)
+    {
+        LcdCell *cell = &cells[row][col + k];
+        pixels = FontGlyphPixels(cell->c, cell->fg, cell->bg);
+        for(y = 0; y < FONT_HEIGHT; y ++)
+        {
+            memcpy(&run_buf.pixels[y * width + k * FONT_WIDTH], &pixels[y * FONT_WIDTH], FONT_WIDTH * sizeof(uint16_t));
+        }
+    }
+    return (uint16_t)(num * FONT_GLYPH_PIXELS);
+#endif
+}
+
+static void lcd_stat_command(void)
+{
+    elog_i("lcd", "%ux%u, flushes %u, rects %u, cells %u, bytes %u", LCD_WIDTH, LCD_HEIGHT,
+        lcd_stat.flushes, lcd_stat.rects, lcd_stat.cells, lcd_stat.bytes);
+    if(lcd_stat.flushes != 0)
+    {
+        elog_i("lcd", "per flush %u bytes, last %uus, max %uus", lcd_stat.bytes / lcd_stat.flushes,
+            lcd_stat.last_flush_us, lcd_stat.max_flush_us);
+    }
+    elog_i("lcd", "full redraw %u bytes, %uus", LCD_FRAME_BYTES, full_redraw_us);
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "stdint.h"
+#include "font.h"
+
+// 支持的控制器，通过LCD_CONTROLLER选择
+#define LCD_ST7735              0
+#define LCD_ST7789              1
+#define LCD_SSD1306             2
+
+#ifndef LCD_CONTROLLER
+#define LCD_CONTROLLER          LCD_ST7735
+#endif
+
+#if LCD_CONTROLLER == LCD_ST7735
+#define LCD_WIDTH               128
+#define LCD_HEIGHT              160
+#elif LCD_CONTROLLER == LCD_ST7789
+#define LCD_WIDTH               240
+#define LCD_HEIGHT              240
+#elif LCD_CONTROLLER == LCD_SSD1306
+#define LCD_WIDTH               128
+#define LCD_HEIGHT              64
+#else
+#error "unsupported LCD_CONTROLLER"
+#endif
+
+// 屏幕按字符格管理，每格一个字符
+#define LCD_COLS                (LCD_WIDTH / FONT_WIDTH)
+#define LCD_ROWS                (LCD_HEIGHT / FONT_HEIGHT)
+
+typedef struct __LcdStat
+{
+    uint32_t flushes;               // 完成的刷新次数，一次刷新发送所有脏格
+    uint32_t rects;                 // 发送的矩形数，相邻的脏格合并成一个矩形
+    uint32_t cells;                 // 发送的字符格数
+    uint32_t bytes;                 // SPI发送的总字节数，包括命令
+    uint32_t last_flush_us;         // 最近一次刷新从开始发送到全部发完的时间
+    uint32_t max_flush_us;
+}LcdStat;
+
+int8_t LcdInit(void);
+
+int8_t LcdDrawText(uint8_t col, uint8_t row, const char *text, uint16_t fg, uint16_t bg);
+
+void LcdInvalidate(void);
+
+void LcdProcess(void);
+
+uint8_t LcdIsIdle(void);
+
+void LcdGetStat(LcdStat *stat);
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "stdint.h"
+
+#define ADC_SAMPLE_HZ               100         // 每秒采样组数，每组依次转换所有通道
+#define ADC_BUF_SETS                8           // DMA循环缓冲里的采样组数
+#define ADC_RESULT_BITS             14          // 16倍硬件过采样后右移2位
+#define ADC_FULL_SCALE              ((1U << ADC_RESULT_BITS) - 1)
+
+#define ADC_VREFINT_MV              1200        // 内部参考电压典型值
+#define ADC_VIN_DIVIDER             2           // 供电电压经1:1电阻分压接到PA0
+
+typedef enum __AdcChannel
+{
+    AdcChannel_Vin = 0,         // PA0，分压后的供电电压
+    AdcChannel_Spare0,          // PA1
+    AdcChannel_Spare1,          // PA6，PA4留给DAC0
+    AdcChannel_Temp,            // 内部温度传感器
+    AdcChannel_Vref,            // VREFINT
+    AdcChannel_Num,
+}AdcChannel;
+
+typedef struct __AdcReading
+{
+    uint32_t sequence;                  // 自初始化以来完成的采样组序号
+    uint16_t raw[AdcChannel_Num];       // ADC_RESULT_BITS位原始值
+    uint16_t vdda_mv;                   // 由VREFINT反推的模拟电源电压
+    uint16_t vin_mv;
+    uint16_t spare_mv[2];
+    int16_t temperature;                // 芯片温度，单位0.1度
+}AdcReading;
+
+int8_t AdcInit(void);
+
+int8_t AdcGetReading(AdcReading *reading);
+
+void AdcDmaCompleteCallback(void);
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "stdint.h"
+
+#define DAC_SAMPLE_HZ               16000       // TIMER1的TRGO触发DAC转换的频率
+#define DAC_MID_LEVEL               2048        // 12位DAC的中点，静音时的输出
+
+/**
+ * @brief 填充半个缓冲区，在DMA的半传输和传输完成中断里调用
+ *
+ * @param buf 需要填充的半个缓冲区，12位右对齐
+ * @param num 样点数
+ */
+typedef void (*DacFillFunc)(uint16_t *buf, uint16_t num);
+
+int8_t DacInit(uint16_t *buf, uint16_t len, DacFillFunc fill);
+
+int8_t DacStart(void);
+
+void DacStop(void);
+
+uint8_t DacIsRunning(void);
+
+void DacHalfCompleteCallback(void);
+
+void DacFullCompleteCallback(void);
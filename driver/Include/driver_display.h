@@ -0,0 +1,51 @@
+#pragma once
+
+#include "stdint.h"
+
+#define DISPLAY_DIGIT_NUM           4           // 扫描线数，每条扫描线一位数码管(或点阵的一行)
+#define DISPLAY_REFRESH_HZ          250         // 整帧刷新率
+#define DISPLAY_LINE_PERIOD_US      (1000000 / (DISPLAY_REFRESH_HZ * DISPLAY_DIGIT_NUM))
+#define DISPLAY_TIMER_TICK_HZ       12000000    // 扫描定时器计数频率，决定亮度PWM的分辨率
+#define DISPLAY_LINE_TICKS          (DISPLAY_LINE_PERIOD_US * (DISPLAY_TIMER_TICK_HZ / 1000000))
+
+#define DISPLAY_BRIGHTNESS_MAX      255         // 亮度等级0 ... 255，经过伽马校正后输出
+
+// 段码每一位对应的段，DP在时钟显示里用作冒号
+#define DISPLAY_SEG_A               0x01
+#define DISPLAY_SEG_B               0x02
+#define DISPLAY_SEG_C               0x04
+#define DISPLAY_SEG_D               0x08
+#define DISPLAY_SEG_E               0x10
+#define DISPLAY_SEG_F               0x20
+#define DISPLAY_SEG_G               0x40
+#define DISPLAY_SEG_DP              0x80
+
+typedef struct __DisplayStat
+{
+    uint32_t swaps;                 // 完成的帧切换次数
+    uint32_t measured_frames;       // 最近一次测量的帧数
+    uint32_t frame_cycles_min;      // 测量期间相邻两帧结束之间的CPU周期
+    uint32_t frame_cycles_max;
+}DisplayStat;
+
+int8_t DisplayInit(void);
+
+int8_t DisplaySetDigit(uint8_t digit, uint8_t segments);
+
+int8_t DisplaySetFrame(const uint8_t *segments);
+
+int8_t DisplaySwap(void);
+
+uint8_t DisplaySwapPending(void);
+
+void DisplayMeasureStart(void);
+
+void DisplayGetStat(DisplayStat *stat);
+
+int8_t DisplaySetBrightness(uint8_t level);
+
+int8_t DisplayFadeTo(uint8_t level);
+
+uint8_t DisplayGetBrightness(void);
+
+void DisplayFrameCompleteCallback(void);
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "stdint.h"
+
+// NOR/SRAM bank0 region0(NE0)的地址，16位总线下A16对应地址位17
+#define EXMC_REGION0_ADDR           0x60000000U
+#define EXMC_A16_OFFSET             (1U << 17)
+
+typedef void (*ExmcWriteCpltFunc)(void);
+
+int8_t ExmcInit(void);
+
+int8_t ExmcWriteDMA(volatile uint16_t *dst, const uint16_t *src, uint32_t num, uint8_t src_inc);
+
+uint8_t ExmcIsBusy(void);
+
+void ExmcWriteCallbackRegister(ExmcWriteCpltFunc func);
+
+void ExmcWriteCompleteCallback(void);
@@ -2,8 +2,13 @@
 
 #include "stdint.h"
 
-typedef void (*I2cWriteCallback)(void);
-typedef void (*I2cReadCallback)(void);
+// 每条总线上可以注册的回调数，挂在同一条总线上的设备各注册一个
+#define I2C_CALLBACK_MAX_NUM    4
+
+// 传输结束时在中断里调用，result为0表示完成，-1表示出错(无应答、总线错误、仲裁丢失)后已放弃
+// 总线上所有注册的回调都会被调用，由各自的等待标志判断是不是自己发起的传输
+typedef void (*I2cWriteCallback)(int8_t result);
+typedef void (*I2cReadCallback)(int8_t result);
 
 typedef struct __I2cInitStruct
 {
@@ -33,6 +38,8 @@ typedef struct __I2cStruct
         uint16_t cur_data_num;
         uint16_t total_data_len;
         uint8_t slave_addr;
+        uint8_t restart_read;   // 写完寄存器地址后以重复起始位转入读取
+        uint8_t mem_addr;       // I2cMemRead的寄存器地址
     }write_info;
     
     struct 
@@ -43,8 +50,11 @@ typedef struct __I2cStruct
         uint16_t total_data_len;
         uint8_t slave_addr;
     }read_info;
-    I2cWriteCallback write_call_back;
-    I2cReadCallback read_call_back;
+    I2cWriteCallback write_call_back[I2C_CALLBACK_MAX_NUM];
+    I2cReadCallback read_call_back[I2C_CALLBACK_MAX_NUM];
+    uint8_t write_call_back_num;
+    uint8_t read_call_back_num;
+    uint32_t errors;            // 出错放弃的传输数
 }I2cStruct;
 
 int8_t I2cInit(I2cStruct *i2c, I2cInitStruct *init);
@@ -53,6 +63,14 @@ int8_t I2cWrite(I2cStruct *i2c, uint8_t dev_addr, uint8_t *data, uint16_t data_l
 
 int8_t I2cRead(I2cStruct *i2c, uint8_t dev_addr, uint8_t *data, uint16_t data_len);
 
+int8_t I2cMemRead(I2cStruct *i2c, uint8_t dev_addr, uint8_t reg_addr, uint8_t *data, uint16_t data_len);
+
+uint8_t I2cIsBusy(I2cStruct *i2c);
+
+int8_t I2cWriteCallbackRegister(I2cStruct *i2c, I2cWriteCallback func);
+
+int8_t I2cReadCallbackRegister(I2cStruct *i2c, I2cReadCallback func);
+
 void I2cEventCallback(I2cStruct *i2c);
 
 void I2cErrorCallback(I2cStruct *i2c);
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "stdint.h"
+
+// 内部RTC计数器保存的是自2000-01-01 00:00:00起的秒数，与BL8025一致
+
+typedef void (*RtcAlarmFunc)(void);
+
+typedef enum __RtcSyncSource
+{
+    RTC_SYNC_NONE = 0,
+    RTC_SYNC_BL8025,        // 由外部I2C时钟芯片同步
+    RTC_SYNC_USER,          // 由用户设置
+}RtcSyncSource;
+
+typedef struct __RtcSyncInfo
+{
+    uint32_t last_sync_sec;     // 最近一次同步时的时间
+    int32_t calibration_ppb;    // 当前设置的校准量，正数表示晶振偏快
+    RtcSyncSource source;
+    uint8_t lxtal;              // 为0时LXTAL没有起振，RTC由IRC40K驱动，误差大且复位后时间丢失
+}RtcSyncInfo;
+
+int8_t RtcInit(void);
+
+uint32_t RtcNow(void);
+
+int8_t RtcSetTime(uint32_t seconds, RtcSyncSource source);
+
+int8_t RtcSetCalibration(int32_t ppb);
+
+void RtcGetSyncInfo(RtcSyncInfo *info);
+
+int8_t RtcSetAlarm(uint32_t seconds);
+
+void RtcDisableAlarm(void);
+
+int8_t RtcAlarmCallbackRegister(RtcAlarmFunc func);
+
+void RtcAlarmCallback(void);
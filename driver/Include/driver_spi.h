@@ -0,0 +1,47 @@
+#pragma once
+
+#include "stdint.h"
+
+typedef void (*SpiSendCpltFunc)(void);
+
+typedef enum __SpiFrameSize
+{
+    SpiFrame_8Bit = 0,
+    SpiFrame_16Bit,         // 16位数据高字节先发，RGB565像素不需要交换字节序
+}SpiFrameSize;
+
+typedef struct __SpiInitStruct
+{
+    uint32_t speed;         // 期望的SCK频率，取不超过该值的最高分频
+}SpiInitStruct;
+
+typedef struct __SpiStruct
+{
+    SpiInitStruct Init;
+
+    uint8_t spi_id;
+
+    uint8_t inited;
+
+    struct
+    {
+        volatile uint8_t send_busy;
+        SpiFrameSize frame_size;
+    }send_info;
+
+    SpiSendCpltFunc send_cplt_call_back;
+}SpiStruct;
+
+int8_t SpiInit(SpiStruct *spi, SpiInitStruct *init);
+
+int8_t SpiSend(SpiStruct *spi, const uint8_t *data, uint16_t data_len);
+
+int8_t SpiSendDMA(SpiStruct *spi, const void *data, uint16_t data_num, SpiFrameSize frame_size);
+
+int8_t SpiSendRepeatDMA(SpiStruct *spi, const void *data, uint16_t data_num, SpiFrameSize frame_size);
+
+uint8_t SpiIsBusy(SpiStruct *spi);
+
+int8_t SpiSendCallbackRegister(SpiStruct *spi, SpiSendCpltFunc func);
+
+void SpiSendCompleteCallback(SpiStruct *spi);
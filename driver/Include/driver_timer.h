@@ -36,3 +36,7 @@ void EnableTimerUpdateInt(TimerStruct *timer);
 
 void TimerUpdateCallback(TimerStruct *timer);
 
+uint32_t TimerClockGet(uint32_t timer_periph);
+
+void CycleCounterEnable(void);
+
@@ -0,0 +1,211 @@
+/**
+ * @file driver_adc.c
+ * @brief ADC0规则组扫描：TIMER2的TRGO触发一组转换，DMA0 CH0循环搬运到缓冲区
+ *
+ * 每个通道由硬件连续转换16次累加后右移2位，得到14位结果，CPU不参与平均。
+ * 读数时根据DMA剩余个数找到最新一组完整的结果，再用VREFINT反推模拟电源电压，
+ * 其余通道按实际电源电压换算，不受电源波动影响。
+ */
+
+#include "stddef.h"
+#include "driver_adc.h"
+#include "gd32f30x.h"
+#include "driver_timer.h"
+
+#define DRV_ADC                         ADC0
+#define DRV_ADC_CLK                     RCU_ADC0
+#define DRV_ADC_GPIO_PORT               GPIOA
+#define DRV_ADC_GPIO_CLK                RCU_GPIOA
+#define DRV_ADC_GPIO_PINS               (GPIO_PIN_0 | GPIO_PIN_1 | GPIO_PIN_6)
+
+#define DRV_ADC_DMA                     DMA0
+#define DRV_ADC_DMA_CLK                 RCU_DMA0
+#define DRV_ADC_DMA_CHL                 DMA_CH0
+#define DRV_ADC_DMA_IRQ                 DMA0_Channel0_IRQn
+
+#define DRV_ADC_TIMER                   TIMER2
+#define DRV_ADC_TIMER_CLK               RCU_TIMER2
+#define DRV_ADC_TIMER_TICK_HZ           1000000
+
+#define DRV_ADC_BUF_LEN                 (ADC_BUF_SETS * AdcChannel_Num)
+
+// 温度传感器典型参数：25度时1.45V，斜率4.1mV/度，电压随温度升高而下降
+#define DRV_ADC_TEMP_V25_UV             1450000
+#define DRV_ADC_TEMP_SLOPE_UV           4100
+
+#if (DRV_ADC_TIMER_TICK_HZ % ADC_SAMPLE_HZ) != 0 || (DRV_ADC_TIMER_TICK_HZ / ADC_SAMPLE_HZ) > 65536
+    #error "ADC_SAMPLE_HZ not reachable with a 1MHz 16 bit timer!"
+#endif
+
+// 规则组的转换顺序，和AdcChannel一一对应
+static const uint8_t adc_channel[AdcChannel_Num] = {
+    ADC_CHANNEL_0, ADC_CHANNEL_1, ADC_CHANNEL_6, ADC_CHANNEL_16, ADC_CHANNEL_17
+};
+
+// 内部通道要求采样时间不小于17us，239.5个ADC时钟约24us；每组16倍过采样共约1.1ms
+static const uint32_t adc_sample_time[AdcChannel_Num] = {
+    ADC_SAMPLETIME_55POINT5, ADC_SAMPLETIME_55POINT5, ADC_SAMPLETIME_55POINT5,
+    ADC_SAMPLETIME_239POINT5, ADC_SAMPLETIME_239POINT5
+};
+
+static uint16_t adc_buf[DRV_ADC_BUF_LEN];
+static volatile uint32_t buf_wraps = 0;
+
+static void adc_delay(void);
+
+/**
+ * @brief 初始化ADC、DMA和触发定时器，之后按ADC_SAMPLE_HZ自动采样
+ *
+ * @return int8_t
+ */
+int8_t AdcInit(void)
+{
+    dma_parameter_struct dma_init_struct;
+    timer_parameter_struct timer_initpara;
+    uint32_t clock_src_freq;
+    uint8_t i;
+
+    rcu_periph_clock_enable(DRV_ADC_GPIO_CLK);
+    rcu_periph_clock_enable(DRV_ADC_CLK);
+    rcu_periph_clock_enable(DRV_ADC_DMA_CLK);
+    rcu_periph_clock_enable(DRV_ADC_TIMER_CLK);
+    // APB2 120MHz十二分频，ADC时钟10MHz
+    rcu_adc_clock_config(RCU_CKADC_CKAPB2_DIV12);
+
+    gpio_init(DRV_ADC_GPIO_PORT, GPIO_MODE_AIN, GPIO_OSPEED_50MHZ, DRV_ADC_GPIO_PINS);
+
+    /* DMA0 CH0: ADC0 regular data to circular buffer */
+    dma_deinit(DRV_ADC_DMA, DRV_ADC_DMA_CHL);
+    dma_struct_para_init(&dma_init_struct);
+    dma_init_struct.direction = DMA_PERIPHERAL_TO_MEMORY;
+    dma_init_struct.memory_addr = (uint32_t)adc_buf;
+    dma_init_struct.memory_inc = DMA_MEMORY_INCREASE_ENABLE;
+    dma_init_struct.memory_width = DMA_MEMORY_WIDTH_16BIT;
+    dma_init_struct.number = DRV_ADC_BUF_LEN;
+    dma_init_struct.periph_addr = (uint32_t)&ADC_RDATA(DRV_ADC);
+    dma_init_struct.periph_inc = DMA_PERIPH_INCREASE_DISABLE;
+    dma_init_struct.periph_width = DMA_PERIPHERAL_WIDTH_16BIT;
+    dma_init_struct.priority = DMA_PRIORITY_MEDIUM;
+    dma_init(DRV_ADC_DMA, DRV_ADC_DMA_CHL, &dma_init_struct);
+    dma_circulation_enable(DRV_ADC_DMA, DRV_ADC_DMA_CHL);
+    dma_memory_to_memory_disable(DRV_ADC_DMA, DRV_ADC_DMA_CHL);
+    // 缓冲区每转一圈中断一次，只用来计数
+    dma_interrupt_enable(DRV_ADC_DMA, DRV_ADC_DMA_CHL, DMA_INT_FTF);
+    nvic_irq_enable(DRV_ADC_DMA_IRQ, 2, 2);
+    dma_channel_enable(DRV_ADC_DMA, DRV_ADC_DMA_CHL);
+
+    /* ADC0: regular group scan, one group per trigger */
+    adc_deinit(DRV_ADC);
+    adc_mode_config(ADC_MODE_FREE);
+    adc_special_function_config(DRV_ADC, ADC_SCAN_MODE, ENABLE);
+    adc_special_function_config(DRV_ADC, ADC_CONTINUOUS_MODE, DISABLE);
+    adc_data_alignment_config(DRV_ADC, ADC_DATAALIGN_RIGHT);
+    adc_resolution_config(DRV_ADC, ADC_RESOLUTION_12B);
+    adc_channel_length_config(DRV_ADC, ADC_REGULAR_CHANNEL, AdcChannel_Num);
+    for(i = 0; i < AdcChannel_Num; i ++)
+    {
+        adc_regular_channel_config(DRV_ADC, i, adc_channel[i], adc_sample_time[i]);
+    }
+    adc_tempsensor_vrefint_enable();
+
+    adc_external_trigger_source_config(DRV_ADC, ADC_REGULAR_CHANNEL, ADC0_1_EXTTRIG_REGULAR_T2_TRGO);
+    adc_external_trigger_config(DRV_ADC, ADC_REGULAR_CHANNEL, ENABLE);
+
+    // 过采样只能在ADC关闭时配置：每个通道连续转换16次，和右移2位
+    adc_oversample_mode_config(DRV_ADC, ADC_OVERSAMPLING_ALL_CONVERT, ADC_OVERSAMPLING_SHIFT_2B, ADC_OVERSAMPLING_RATIO_MUL16);
+    adc_oversample_mode_enable(DRV_ADC);
+
+    adc_dma_mode_enable(DRV_ADC);
+    adc_enable(DRV_ADC);
+    adc_delay();
+    adc_calibration_enable(DRV_ADC);
+
+    /* TIMER2: update event as TRGO */
+    timer_deinit(DRV_ADC_TIMER);
+
+    clock_src_freq = TimerClockGet(DRV_ADC_TIMER);
+
+    timer_struct_para_init(&timer_initpara);
+    timer_initpara.prescaler         = clock_src_freq/DRV_ADC_TIMER_TICK_HZ - 1;
+    timer_initpara.alignedmode       = TIMER_COUNTER_EDGE;
+    timer_initpara.counterdirection  = TIMER_COUNTER_UP;
+    timer_initpara.period            = DRV_ADC_TIMER_TICK_HZ / ADC_SAMPLE_HZ - 1;
+    timer_initpara.repetitioncounter = 0;
+    timer_init(DRV_ADC_TIMER, &timer_initpara);
+    timer_master_output_trigger_source_select(DRV_ADC_TIMER, TIMER_TRI_OUT_SRC_UPDATE);
+    timer_enable(DRV_ADC_TIMER);
+
+    return 0;
+}
+
+/**
+ * @brief 取最新一组完整的采样并换算
+ *
+ * @param reading
+ * @return int8_t 还没有完成任何一组采样时返回-1
+ */
+int8_t AdcGetReading(AdcReading *reading)
+{
+    const uint16_t *set;
+    uint32_t wraps;
+    uint32_t done;
+    uint32_t sets;
+    uint32_t vdda_uv;
+    uint32_t vsense_uv;
+    uint8_t i;
+
+    // 读剩余个数期间缓冲区转完一圈时重读，保证圈数和位置一致
+    do
+    {
+        wraps = buf_wraps;
+        done = DRV_ADC_BUF_LEN - dma_transfer_number_get(DRV_ADC_DMA, DRV_ADC_DMA_CHL);
+    }while(wraps != buf_wraps);
+
+    sets = wraps * ADC_BUF_SETS + done / AdcChannel_Num;
+    if(sets == 0)
+    {
+        return -1;
+    }
+    set = &adc_buf[((sets - 1) % ADC_BUF_SETS) * AdcChannel_Num];
+
+    reading->sequence = sets;
+    for(i = 0; i < AdcChannel_Num; i ++)
+    {
+        reading->raw[i] = set[i];
+    }
+    if(reading->raw[AdcChannel_Vref] == 0)
+    {
+        return -1;
+    }
+
+    vdda_uv = (uint32_t)((uint64_t)ADC_VREFINT_MV * 1000 * ADC_FULL_SCALE / reading->raw[AdcChannel_Vref]);
+    reading->vdda_mv = (uint16_t)(vdda_uv / 1000);
+    reading->vin_mv = (uint16_t)((uint64_t)reading->raw[AdcChannel_Vin] * vdda_uv * ADC_VIN_DIVIDER / ADC_FULL_SCALE / 1000);
+    reading->spare_mv[0] = (uint16_t)((uint64_t)reading->raw[AdcChannel_Spare0] * vdda_uv / ADC_FULL_SCALE / 1000);
+    reading->spare_mv[1] = (uint16_t)((uint64_t)reading->raw[AdcChannel_Spare1] * vdda_uv / ADC_FULL_SCALE / 1000);
+
+    vsense_uv = (uint32_t)((uint64_t)reading->raw[AdcChannel_Temp] * vdda_uv / ADC_FULL_SCALE);
+    reading->temperature = (int16_t)(((int32_t)DRV_ADC_TEMP_V25_UV - (int32_t)vsense_uv) * 10 / DRV_ADC_TEMP_SLOPE_UV + 250);
+
+    return 0;
+}
+
+/**
+ * @brief DMA传输完成中断里调用，缓冲区又转了一圈
+ *
+ */
+void AdcDmaCompleteCallback(void)
+{
+    buf_wraps ++;
+}
+
+/**
+ * @brief ADC上电后校准前的等待，不依赖系统定时器
+ *
+ */
+static void adc_delay(void)
+{
+    volatile uint32_t i;
+
+    for(i = 0; i < SystemCoreClock / 10000; i ++);
+}
@@ -0,0 +1,172 @@
+/**
+ * @file driver_dac.c
+ * @brief DAC0(PA4)流式输出：TIMER1的TRGO触发转换，DMA1 CH2循环搬运双缓冲
+ *
+ * DMA读到缓冲区中点时在半传输中断里填充前半部分，读到末尾时在传输完成中断里填充后半部分，
+ * 填充总是在DMA读取另一半的时候进行。
+ */
+
+#include "stddef.h"
+#include "driver_dac.h"
+#include "gd32f30x.h"
+#include "driver_timer.h"
+
+#define DRV_DAC                         DAC0
+#define DRV_DAC_GPIO_PORT               GPIOA
+#define DRV_DAC_GPIO_CLK                RCU_GPIOA
+#define DRV_DAC_PIN                     GPIO_PIN_4
+
+#define DRV_DAC_DMA                     DMA1
+#define DRV_DAC_DMA_CLK                 RCU_DMA1
+#define DRV_DAC_DMA_CHL                 DMA_CH2         // DAC0的DMA请求
+#define DRV_DAC_DMA_IRQ                 DMA1_Channel2_IRQn
+
+#define DRV_DAC_TIMER                   TIMER1
+#define DRV_DAC_TIMER_CLK               RCU_TIMER1
+
+static struct
+{
+    uint16_t *buf;
+    uint16_t len;
+    DacFillFunc fill;
+    volatile uint8_t running;
+}dac_stream;
+
+/**
+ * @brief 初始化DAC、DMA和触发定时器，不开始输出
+ *
+ * @param buf 双缓冲，DMA循环读取
+ * @param len 缓冲区总样点数，必须为偶数
+ * @param fill
+ * @return int8_t
+ */
+int8_t DacInit(uint16_t *buf, uint16_t len, DacFillFunc fill)
+{
+    timer_parameter_struct timer_initpara;
+    uint32_t clock_src_freq;
+
+    if(buf == NULL || fill == NULL || len == 0 || (len & 1) != 0)
+    {
+        return -1;
+    }
+    dac_stream.buf = buf;
+    dac_stream.len = len;
+    dac_stream.fill = fill;
+    dac_stream.running = 0;
+
+    rcu_periph_clock_enable(DRV_DAC_GPIO_CLK);
+    rcu_periph_clock_enable(RCU_DAC);
+    rcu_periph_clock_enable(DRV_DAC_DMA_CLK);
+    rcu_periph_clock_enable(DRV_DAC_TIMER_CLK);
+
+    gpio_init(DRV_DAC_GPIO_PORT, GPIO_MODE_AIN, GPIO_OSPEED_50MHZ, DRV_DAC_PIN);
+
+    dac_deinit();
+    dac_trigger_source_config(DRV_DAC, DAC_TRIGGER_T1_TRGO);
+    dac_trigger_enable(DRV_DAC);
+    dac_wave_mode_config(DRV_DAC, DAC_WAVE_DISABLE);
+    dac_output_buffer_enable(DRV_DAC);
+    dac_enable(DRV_DAC);
+    dac_data_set(DRV_DAC, DAC_ALIGN_12B_R, DAC_MID_LEVEL);
+
+    /* TIMER1: update event as TRGO at the sample rate */
+    timer_deinit(DRV_DAC_TIMER);
+
+    clock_src_freq = TimerClockGet(DRV_DAC_TIMER);
+
+    timer_struct_para_init(&timer_initpara);
+    timer_initpara.prescaler         = 0;
+    timer_initpara.alignedmode       = TIMER_COUNTER_EDGE;
+    timer_initpara.counterdirection  = TIMER_COUNTER_UP;
+    timer_initpara.period            = clock_src_freq / DAC_SAMPLE_HZ - 1;
+    timer_initpara.repetitioncounter = 0;
+    timer_init(DRV_DAC_TIMER, &timer_initpara);
+    timer_master_output_trigger_source_select(DRV_DAC_TIMER, TIMER_TRI_OUT_SRC_UPDATE);
+
+    nvic_irq_enable(DRV_DAC_DMA_IRQ, 2, 1);
+
+    return 0;
+}
+
+/**
+ * @brief 先填满两半缓冲区，再开始输出
+ *
+ * @return int8_t
+ */
+int8_t DacStart(void)
+{
+    dma_parameter_struct dma_init_struct;
+
+    if(dac_stream.fill == NULL)
+    {
+        return -1;
+    }
+    if(dac_stream.running == 1)
+    {
+        return 0;
+    }
+
+    dac_stream.fill(dac_stream.buf, dac_stream.len / 2);
+    dac_stream.fill(dac_stream.buf + dac_stream.len / 2, dac_stream.len / 2);
+
+    dma_deinit(DRV_DAC_DMA, DRV_DAC_DMA_CHL);
+    dma_struct_para_init(&dma_init_struct);
+    dma_init_struct.direction = DMA_MEMORY_TO_PERIPHERAL;
+    dma_init_struct.memory_addr = (uint32_t)dac_stream.buf;
+    dma_init_struct.memory_inc = DMA_MEMORY_INCREASE_ENABLE;
+    dma_init_struct.memory_width = DMA_MEMORY_WIDTH_16BIT;
+    dma_init_struct.number = dac_stream.len;
+    dma_init_struct.periph_addr = (uint32_t)&DAC0_R12DH;
+    dma_init_struct.periph_inc = DMA_PERIPH_INCREASE_DISABLE;
+    dma_init_struct.periph_width = DMA_PERIPHERAL_WIDTH_16BIT;
+    dma_init_struct.priority = DMA_PRIORITY_HIGH;
+    dma_init(DRV_DAC_DMA, DRV_DAC_DMA_CHL, &dma_init_struct);
+    dma_circulation_enable(DRV_DAC_DMA, DRV_DAC_DMA_CHL);
+    dma_memory_to_memory_disable(DRV_DAC_DMA, DRV_DAC_DMA_CHL);
+    dma_interrupt_enable(DRV_DAC_DMA, DRV_DAC_DMA_CHL, DMA_INT_HTF | DMA_INT_FTF);
+    dma_channel_enable(DRV_DAC_DMA, DRV_DAC_DMA_CHL);
+
+    dac_stream.running = 1;
+    dac_dma_enable(DRV_DAC);
+    timer_counter_value_config(DRV_DAC_TIMER, 0);
+    timer_enable(DRV_DAC_TIMER);
+
+    return 0;
+}
+
+/**
+ * @brief 停止输出，DAC保持最后一个样点的电平，可以在填充回调里调用
+ *
+ */
+void DacStop(void)
+{
+    timer_disable(DRV_DAC_TIMER);
+    dac_dma_disable(DRV_DAC);
+    dma_channel_disable(DRV_DAC_DMA, DRV_DAC_DMA_CHL);
+    dac_stream.running = 0;
+}
+
+uint8_t DacIsRunning(void)
+{
+    return dac_stream.running;
+}
+
+/**
+ * @brief DMA半传输中断里调用，DMA正在读后半部分，填充前半部分
+ *
+ */
+void DacHalfCompleteCallback(void)
+{
+    if(dac_stream.running == 1)
+        dac_stream.fill(dac_stream.buf, dac_stream.len / 2);
+}
+
+/**
+ * @brief DMA传输完成中断里调用，DMA回到开头，填充后半部分
+ *
+ */
+void DacFullCompleteCallback(void)
+{
+    if(dac_stream.running == 1)
+        dac_stream.fill(dac_stream.buf + dac_stream.len / 2, dac_stream.len / 2);
+}
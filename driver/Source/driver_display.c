@@ -0,0 +1,446 @@
+/**
+ * @file driver_display.c
+ * @brief 多路复用数码管扫描：TIMER0更新事件触发DMA把预先算好的端口值写入GPIO_BOP
+ *
+ * 每条扫描线对应一个32位BOP值，低16位置位本条线的段和位选，高16位清除其余的段和位选，
+ * 一次写入就完成换线。DMA0 CH1循环搬运整帧，扫描期间不占用CPU。
+ * 帧缓冲有前后两份，DisplaySwap只登记切换请求，在整帧传输完成中断里换DMA地址，
+ * 保证切换发生在帧边界，没有切换请求时不产生中断。
+ *
+ * 亮度由TIMER0_CH1_ON输出的PWM控制显示使能，每条扫描线只亮前一段时间。
+ * 占空比来自编译期生成的伽马表，渐变时DMA0 CH2在每个更新事件把表中下一项写入CH1CV，
+ * 渐变过程中不需要CPU参与。
+ */
+
+#include "stddef.h"
+#include "string.h"
+#include "driver_display.h"
+#include "gd32f30x.h"
+#include "driver_timer.h"
+
+#define DRV_DISPLAY_TIMER               TIMER0
+#define DRV_DISPLAY_TIMER_CLK           RCU_TIMER0
+#define DRV_DISPLAY_DMA                 DMA0
+#define DRV_DISPLAY_DMA_CHL             DMA_CH1         // TIMER0_CH0的DMA请求，请求源选为更新事件
+#define DRV_DISPLAY_DMA_IRQ             DMA0_Channel1_IRQn
+
+// 8个段和最多8个位选要在同一个端口上，一次BOP写入才能同时换线。
+// 48脚的GD32F303CC上GPIOC只有PC13-PC15，GPIOA/GPIOB去掉串口、I2C、ADC、DAC、SWD、LED和屏的引脚后
+// 凑不出12个，所以数码管要用64脚及以上的封装(GD32F303RC/VC)
+#define DRV_DISPLAY_GPIO_PORT           GPIOC
+#define DRV_DISPLAY_GPIO_CLK            RCU_GPIOC
+#define DRV_DISPLAY_SEG_SHIFT           0               // PC0-PC7：a b c d e f g dp，高电平点亮
+#define DRV_DISPLAY_DIGIT_SHIFT         8               // PC8起：位选，高电平选中
+#define DRV_DISPLAY_SEG_MASK            (0xffU << DRV_DISPLAY_SEG_SHIFT)
+#define DRV_DISPLAY_DIGIT_MASK          (((1U << DISPLAY_DIGIT_NUM) - 1) << DRV_DISPLAY_DIGIT_SHIFT)
+
+#define DRV_DISPLAY_PWM_DMA             DMA0
+#define DRV_DISPLAY_PWM_DMA_CHL         DMA_CH2         // TIMER0_CH1的DMA请求，同样在更新事件时发出
+#define DRV_DISPLAY_PWM_GPIO_PORT       GPIOB
+#define DRV_DISPLAY_PWM_GPIO_CLK        RCU_GPIOB
+#define DRV_DISPLAY_PWM_PIN             GPIO_PIN_14     // TIMER0_CH1_ON，CH1本身的PA9被USART0占用
+
+#define DRV_DISPLAY_MEASURE_FRAMES      64
+
+// 最大占空比留出1/16的消隐，避免换线时上一位的段码残影
+#define DRV_DISPLAY_PWM_MAX_TICKS       (DISPLAY_LINE_TICKS - DISPLAY_LINE_TICKS / 16)
+
+/*
+ * 伽马曲线 y = 0.8x^2 + 0.2x^3，x为亮度等级/255，展开成整数运算：
+ * ticks = MAX * (4 * 255 * x^2 + x^3) / (5 * 255^3)
+ * 表中先是0到255的升序，再是255到0的降序，升序和降序的渐变都是表里连续的一段
+ */
+#define GAMMA(x)        ((uint16_t)(((unsigned long long)DRV_DISPLAY_PWM_MAX_TICKS *                 \
+                        (4ULL * 255 * (x) * (x) + 1ULL * (x) * (x) * (x)) + 5ULL * 255 * 255 * 255 / 2) /\
+                        (5ULL * 255 * 255 * 255)))
+#define GAMMA_4(x)      GAMMA(x), GAMMA((x) + 1), GAMMA((x) + 2), GAMMA((x) + 3)
+#define GAMMA_16(x)     GAMMA_4(x), GAMMA_4((x) + 4), GAMMA_4((x) + 8), GAMMA_4((x) + 12)
+#define GAMMA_64(x)     GAMMA_16(x), GAMMA_16((x) + 16), GAMMA_16((x) + 32), GAMMA_16((x) + 48)
+#define GAMMA_256(x)    GAMMA_64(x), GAMMA_64((x) + 64), GAMMA_64((x) + 128), GAMMA_64((x) + 192)
+#define GAMMA_R4(x)     GAMMA(x), GAMMA((x) - 1), GAMMA((x) - 2), GAMMA((x) - 3)
+#define GAMMA_R16(x)    GAMMA_R4(x), GAMMA_R4((x) - 4), GAMMA_R4((x) - 8), GAMMA_R4((x) - 12)
+#define GAMMA_R64(x)    GAMMA_R16(x), GAMMA_R16((x) - 16), GAMMA_R16((x) - 32), GAMMA_R16((x) - 48)
+#define GAMMA_R256(x)   GAMMA_R64(x), GAMMA_R64((x) - 64), GAMMA_R64((x) - 128), GAMMA_R64((x) - 192)
+
+#define GAMMA_LEVELS    (DISPLAY_BRIGHTNESS_MAX + 1)
+#define GAMMA_UP(level)     (level)                             // 升序部分中某一级的下标
+#define GAMMA_DOWN(level)   (2 * GAMMA_LEVELS - 1 - (level))    // 降序部分中某一级的下标
+
+#if DISPLAY_REFRESH_HZ < 100
+    #error "DISPLAY_REFRESH_HZ too low, display will flicker!"
+#endif
+
+#if DISPLAY_DIGIT_NUM > 8
+    #error "DISPLAY_DIGIT_NUM too large, only 8 digit select pins!"
+#endif
+
+#if (1000000 % (DISPLAY_REFRESH_HZ * DISPLAY_DIGIT_NUM)) != 0
+    #error "scan line period must be a whole number of microseconds!"
+#endif
+
+#if DISPLAY_LINE_TICKS > 65536
+    #error "DISPLAY_TIMER_TICK_HZ too high for a 16 bit timer!"
+#endif
+
+static const uint16_t gamma_table[2 * GAMMA_LEVELS] = {GAMMA_256(0), GAMMA_R256(DISPLAY_BRIGHTNESS_MAX)};
+
+static uint32_t frame_buf[2][DISPLAY_DIGIT_NUM];
+static volatile uint8_t front = 0;
+static volatile uint8_t swap_pending = 0;
+static uint8_t back_stale = 0;                  // 切换后后台缓冲还是旧帧，下次修改前先拷贝前台
+
+static volatile uint32_t measure_frames = 0;    // 剩余需要测量的帧数
+static uint32_t measure_last_cycles;
+static DisplayStat display_stat;
+
+static struct
+{
+    uint8_t from;           // 渐变开始时的亮度
+    uint8_t to;
+    uint16_t steps;         // 渐变的总步数，DMA剩余数据量由此换算出当前亮度
+}fade_info;
+
+static uint32_t display_line_value(uint8_t digit, uint8_t segments);
+static void display_frame_irq_update(void);
+static uint8_t display_fade_level(void);
+
+/**
+ * @brief 初始化扫描引擎，TIMER0和DMA0 CH1由显示独占
+ *
+ * @return int8_t
+ */
+int8_t DisplayInit(void)
+{
+    dma_parameter_struct dma_init_struct;
+    timer_parameter_struct timer_initpara;
+    timer_oc_parameter_struct timer_ocintpara;
+    uint32_t clock_src_freq;
+    uint8_t i;
+
+    for(i = 0; i < DISPLAY_DIGIT_NUM; i ++) {
+        frame_buf[0][i] = display_line_value(i, 0);
+        frame_buf[1][i] = display_line_value(i, 0);
+    }
+
+    CycleCounterEnable();
+
+    rcu_periph_clock_enable(DRV_DISPLAY_GPIO_CLK);
+    gpio_init(DRV_DISPLAY_GPIO_PORT, GPIO_MODE_OUT_PP, GPIO_OSPEED_50MHZ, DRV_DISPLAY_SEG_MASK | DRV_DISPLAY_DIGIT_MASK);
+    GPIO_BC(DRV_DISPLAY_GPIO_PORT) = DRV_DISPLAY_SEG_MASK | DRV_DISPLAY_DIGIT_MASK;
+
+    /* DMA0 channel1: frame buffer -> GPIO_BOP, circular */
+    rcu_periph_clock_enable(RCU_DMA0);
+    dma_deinit(DRV_DISPLAY_DMA, DRV_DISPLAY_DMA_CHL);
+    dma_struct_para_init(&dma_init_struct);
+    dma_init_struct.direction = DMA_MEMORY_TO_PERIPHERAL;
+    dma_init_struct.memory_addr = (uint32_t)frame_buf[front];
+    dma_init_struct.memory_inc = DMA_MEMORY_INCREASE_ENABLE;
+    dma_init_struct.memory_width = DMA_MEMORY_WIDTH_32BIT;
+    dma_init_struct.number = DISPLAY_DIGIT_NUM;
+    dma_init_struct.periph_addr = (uint32_t)&GPIO_BOP(DRV_DISPLAY_GPIO_PORT);
+    dma_init_struct.periph_inc = DMA_PERIPH_INCREASE_DISABLE;
+    dma_init_struct.periph_width = DMA_PERIPHERAL_WIDTH_32BIT;
+    dma_init_struct.priority = DMA_PRIORITY_HIGH;
+    dma_init(DRV_DISPLAY_DMA, DRV_DISPLAY_DMA_CHL, &dma_init_struct);
+    dma_circulation_enable(DRV_DISPLAY_DMA, DRV_DISPLAY_DMA_CHL);
+    dma_memory_to_memory_disable(DRV_DISPLAY_DMA, DRV_DISPLAY_DMA_CHL);
+    nvic_irq_enable(DRV_DISPLAY_DMA_IRQ, 0, 2);
+    dma_channel_enable(DRV_DISPLAY_DMA, DRV_DISPLAY_DMA_CHL);
+
+    /* DMA0 channel2: gamma table slice -> TIMER0_CH1CV, started by DisplayFadeTo */
+    dma_deinit(DRV_DISPLAY_PWM_DMA, DRV_DISPLAY_PWM_DMA_CHL);
+    dma_struct_para_init(&dma_init_struct);
+    dma_init_struct.direction = DMA_MEMORY_TO_PERIPHERAL;
+    dma_init_struct.memory_addr = (uint32_t)gamma_table;
+    dma_init_struct.memory_inc = DMA_MEMORY_INCREASE_ENABLE;
+    dma_init_struct.memory_width = DMA_MEMORY_WIDTH_16BIT;
+    dma_init_struct.number = 0;
+    dma_init_struct.periph_addr = (uint32_t)&TIMER_CH1CV(DRV_DISPLAY_TIMER);
+    dma_init_struct.periph_inc = DMA_PERIPH_INCREASE_DISABLE;
+    dma_init_struct.periph_width = DMA_PERIPHERAL_WIDTH_16BIT;
+    dma_init_struct.priority = DMA_PRIORITY_MEDIUM;
+    dma_init(DRV_DISPLAY_PWM_DMA, DRV_DISPLAY_PWM_DMA_CHL, &dma_init_struct);
+    dma_circulation_disable(DRV_DISPLAY_PWM_DMA, DRV_DISPLAY_PWM_DMA_CHL);
+    dma_memory_to_memory_disable(DRV_DISPLAY_PWM_DMA, DRV_DISPLAY_PWM_DMA_CHL);
+
+    rcu_periph_clock_enable(DRV_DISPLAY_PWM_GPIO_CLK);
+    gpio_init(DRV_DISPLAY_PWM_GPIO_PORT, GPIO_MODE_AF_PP, GPIO_OSPEED_50MHZ, DRV_DISPLAY_PWM_PIN);
+
+    /* TIMER0: one update per scan line */
+    rcu_periph_clock_enable(DRV_DISPLAY_TIMER_CLK);
+    timer_deinit(DRV_DISPLAY_TIMER);
+
+    clock_src_freq = TimerClockGet(DRV_DISPLAY_TIMER);
+
+    if(clock_src_freq % DISPLAY_TIMER_TICK_HZ != 0)
+    {
+        return -1;
+    }
+
+    timer_struct_para_init(&timer_initpara);
+    timer_initpara.prescaler         = clock_src_freq/DISPLAY_TIMER_TICK_HZ - 1;
+    timer_initpara.alignedmode       = TIMER_COUNTER_EDGE;
+    timer_initpara.counterdirection  = TIMER_COUNTER_UP;
+    timer_initpara.period            = DISPLAY_LINE_TICKS - 1;
+    timer_initpara.repetitioncounter = 0;
+    timer_init(DRV_DISPLAY_TIMER, &timer_initpara);
+
+    // 只打开互补输出时CH1_ON = O1CPRE，PWM0模式下每条扫描线开始的CH1CV个计数内点亮
+    timer_channel_output_struct_para_init(&timer_ocintpara);
+    timer_ocintpara.outputstate  = TIMER_CCX_DISABLE;
+    timer_ocintpara.outputnstate = TIMER_CCXN_ENABLE;
+    timer_ocintpara.ocpolarity   = TIMER_OC_POLARITY_HIGH;
+    timer_ocintpara.ocnpolarity  = TIMER_OCN_POLARITY_HIGH;
+    timer_ocintpara.ocidlestate  = TIMER_OC_IDLE_STATE_LOW;
+    timer_ocintpara.ocnidlestate = TIMER_OCN_IDLE_STATE_LOW;
+    timer_channel_output_config(DRV_DISPLAY_TIMER, TIMER_CH_1, &timer_ocintpara);
+    timer_channel_output_mode_config(DRV_DISPLAY_TIMER, TIMER_CH_1, TIMER_OC_MODE_PWM0);
+    timer_channel_output_shadow_config(DRV_DISPLAY_TIMER, TIMER_CH_1, TIMER_OC_SHADOW_ENABLE);
+    timer_channel_output_pulse_value_config(DRV_DISPLAY_TIMER, TIMER_CH_1, gamma_table[GAMMA_UP(DISPLAY_BRIGHTNESS_MAX)]);
+    fade_info.from = DISPLAY_BRIGHTNESS_MAX;
+    fade_info.to = DISPLAY_BRIGHTNESS_MAX;
+    fade_info.steps = 0;
+    timer_primary_output_config(DRV_DISPLAY_TIMER, ENABLE);
+
+    timer_channel_dma_request_source_select(DRV_DISPLAY_TIMER, TIMER_DMAREQUEST_UPDATEEVENT);
+    timer_dma_enable(DRV_DISPLAY_TIMER, TIMER_DMA_CH0D | TIMER_DMA_CH1D);
+    timer_auto_reload_shadow_enable(DRV_DISPLAY_TIMER);
+    timer_enable(DRV_DISPLAY_TIMER);
+
+    return 0;
+}
+
+/**
+ * @brief 修改后台缓冲中一位的段码，调用DisplaySwap后才会显示
+ *
+ * @param digit 0 ... DISPLAY_DIGIT_NUM-1，从左到右
+ * @param segments DISPLAY_SEG_x的组合
+ * @return int8_t 切换还没完成时后台缓冲仍在被DMA读取，返回-1
+ */
+int8_t DisplaySetDigit(uint8_t digit, uint8_t segments)
+{
+    uint8_t back = front ^ 1;
+
+    if(swap_pending == 1 || digit >= DISPLAY_DIGIT_NUM)
+        return -1;
+
+    if(back_stale == 1) {
+        memcpy(frame_buf[back], frame_buf[front], sizeof(frame_buf[back]));
+        back_stale = 0;
+    }
+    frame_buf[back][digit] = display_line_value(digit, segments);
+
+    return 0;
+}
+
+/**
+ * @brief 一次写入整帧段码到后台缓冲
+ *
+ * @param segments DISPLAY_DIGIT_NUM个段码
+ * @return int8_t
+ */
+int8_t DisplaySetFrame(const uint8_t *segments)
+{
+    uint8_t back = front ^ 1;
+    uint8_t i;
+
+    if(swap_pending == 1)
+        return -1;
+
+    for(i = 0; i < DISPLAY_DIGIT_NUM; i ++)
+        frame_buf[back][i] = display_line_value(i, segments[i]);
+    back_stale = 0;
+
+    return 0;
+}
+
+/**
+ * @brief 请求在下一个帧边界切换前后台缓冲
+ *
+ * @return int8_t 上一次切换还没完成时返回-1
+ */
+int8_t DisplaySwap(void)
+{
+    uint32_t primask;
+
+    if(swap_pending == 1)
+        return -1;
+
+    // 中断使能位和帧完成中断里的操作在同一个寄存器上
+    primask = __get_PRIMASK();
+    __disable_irq();
+    swap_pending = 1;
+    display_frame_irq_update();
+    __set_PRIMASK(primask);
+
+    return 0;
+}
+
+uint8_t DisplaySwapPending(void)
+{
+    return swap_pending;
+}
+
+/**
+ * @brief 开始测量实际帧周期，测量期间每帧产生一次中断
+ *
+ */
+void DisplayMeasureStart(void)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    measure_last_cycles = 0;
+    display_stat.frame_cycles_min = 0xffffffff;
+    display_stat.frame_cycles_max = 0;
+    display_stat.measured_frames = 0;
+    measure_frames = DRV_DISPLAY_MEASURE_FRAMES;
+    display_frame_irq_update();
+    __set_PRIMASK(primask);
+}
+
+void DisplayGetStat(DisplayStat *stat)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *stat = display_stat;
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief 立即设置亮度，正在进行的渐变会被停止
+ *
+ * @param level 0 ... DISPLAY_BRIGHTNESS_MAX
+ * @return int8_t
+ */
+int8_t DisplaySetBrightness(uint8_t level)
+{
+    dma_channel_disable(DRV_DISPLAY_PWM_DMA, DRV_DISPLAY_PWM_DMA_CHL);
+    fade_info.from = level;
+    fade_info.to = level;
+    fade_info.steps = 0;
+    timer_channel_output_pulse_value_config(DRV_DISPLAY_TIMER, TIMER_CH_1, gamma_table[GAMMA_UP(level)]);
+
+    return 0;
+}
+
+/**
+ * @brief 从当前亮度开始渐变到目标亮度，每条扫描线走一级，只在开始时占用CPU
+ *
+ * 正在渐变时可以直接改变目标，会从当前已经到达的亮度继续
+ *
+ * @param level 0 ... DISPLAY_BRIGHTNESS_MAX
+ * @return int8_t
+ */
+int8_t DisplayFadeTo(uint8_t level)
+{
+    uint8_t current;
+    uint32_t start;
+
+    // 先停下DMA，剩余数据量不再变化，才能得到准确的当前亮度
+    dma_channel_disable(DRV_DISPLAY_PWM_DMA, DRV_DISPLAY_PWM_DMA_CHL);
+    current = display_fade_level();
+
+    fade_info.from = current;
+    fade_info.to = level;
+    if(level == current) {
+        fade_info.steps = 0;
+        return 0;
+    }
+
+    // 从下一级开始，最后一项正好是目标亮度
+    if(level > current) {
+        start = GAMMA_UP(current + 1);
+        fade_info.steps = level - current;
+    }
+    else {
+        start = GAMMA_DOWN(current - 1);
+        fade_info.steps = current - level;
+    }
+
+    dma_memory_address_config(DRV_DISPLAY_PWM_DMA, DRV_DISPLAY_PWM_DMA_CHL, (uint32_t)&gamma_table[start]);
+    dma_transfer_number_config(DRV_DISPLAY_PWM_DMA, DRV_DISPLAY_PWM_DMA_CHL, fade_info.steps);
+    dma_channel_enable(DRV_DISPLAY_PWM_DMA, DRV_DISPLAY_PWM_DMA_CHL);
+
+    return 0;
+}
+
+/**
+ * @brief 当前亮度，渐变过程中返回已经写入的那一级
+ *
+ * @return uint8_t
+ */
+uint8_t DisplayGetBrightness(void)
+{
+    return display_fade_level();
+}
+
+/**
+ * @brief DMA整帧传输完成中断，在这里切换缓冲，此时距离下一条扫描线还有一个扫描周期
+ *
+ */
+void DisplayFrameCompleteCallback(void)
+{
+    uint32_t cycles = DWT->CYCCNT;
+
+    if(swap_pending == 1) {
+        front ^= 1;
+        dma_channel_disable(DRV_DISPLAY_DMA, DRV_DISPLAY_DMA_CHL);
+        dma_memory_address_config(DRV_DISPLAY_DMA, DRV_DISPLAY_DMA_CHL, (uint32_t)frame_buf[front]);
+        dma_transfer_number_config(DRV_DISPLAY_DMA, DRV_DISPLAY_DMA_CHL, DISPLAY_DIGIT_NUM);
+        dma_channel_enable(DRV_DISPLAY_DMA, DRV_DISPLAY_DMA_CHL);
+        back_stale = 1;
+        swap_pending = 0;
+        display_stat.swaps ++;
+    }
+
+    if(measure_frames != 0) {
+        if(measure_last_cycles != 0) {
+            uint32_t period = cycles - measure_last_cycles;
+            if(period < display_stat.frame_cycles_min)
+                display_stat.frame_cycles_min = period;
+            if(period > display_stat.frame_cycles_max)
+                display_stat.frame_cycles_max = period;
+            display_stat.measured_frames ++;
+        }
+        measure_last_cycles = cycles;
+        measure_frames --;
+    }
+
+    display_frame_irq_update();
+}
+
+static uint32_t display_line_value(uint8_t digit, uint8_t segments)
+{
+    uint32_t set = ((uint32_t)segments << DRV_DISPLAY_SEG_SHIFT) | (1U << (DRV_DISPLAY_DIGIT_SHIFT + digit));
+    uint32_t reset = (DRV_DISPLAY_SEG_MASK | DRV_DISPLAY_DIGIT_MASK) & ~set;
+
+    // BOP高16位清零，低16位置位
+    return (reset << 16) | set;
+}
+
+static uint8_t display_fade_level(void)
+{
+    uint16_t done;
+
+    if(fade_info.steps == 0)
+        return fade_info.to;
+
+    done = fade_info.steps - dma_transfer_number_get(DRV_DISPLAY_PWM_DMA, DRV_DISPLAY_PWM_DMA_CHL);
+    if(fade_info.to > fade_info.from)
+        return fade_info.from + done;
+    else
+        return fade_info.from - done;
+}
+
+/**
+ * @brief 只有需要切换或测量时才打开帧完成中断
+ *
+ */
+static void display_frame_irq_update(void)
+{
+    if(swap_pending == 1 || measure_frames != 0)
+        dma_interrupt_enable(DRV_DISPLAY_DMA, DRV_DISPLAY_DMA_CHL, DMA_INT_FTF);
+    else
+        dma_interrupt_disable(DRV_DISPLAY_DMA, DRV_DISPLAY_DMA_CHL, DMA_INT_FTF);
+}
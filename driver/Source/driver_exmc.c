@@ -0,0 +1,182 @@
+/**
+ * @file driver_exmc.c
+ * @brief EXMC按16位异步SRAM访问8080并口设备，DMA1 CH3做存储器到存储器的写入
+ *
+ * 并口屏的命令和数据寄存器映射为两个固定地址，写像素就是连续写同一个地址，
+ * DMA目标地址不递增即可。一次DMA最多65535个数据，更长的写入在完成中断里接着发送。
+ * EXMC引脚只在100脚及以上的封装上引出。
+ */
+
+#include "stddef.h"
+#include "driver_exmc.h"
+#include "gd32f30x.h"
+
+#define DRV_EXMC_REGION                 EXMC_BANK0_NORSRAM_REGION0
+
+#define DRV_EXMC_DMA                    DMA1
+#define DRV_EXMC_DMA_CLK                RCU_DMA1
+#define DRV_EXMC_DMA_CHL                DMA_CH3         // 存储器到存储器可以用任意通道，DMA0已经全部占用
+#define DRV_EXMC_DMA_IRQ                DMA1_Channel3_Channel4_IRQn
+
+#define DRV_EXMC_DMA_MAX                0xffffU
+
+// D2 D3 NOE NWE NE0 D13 D14 D15 A16 D0 D1
+#define DRV_EXMC_GPIOD_PINS             (GPIO_PIN_0 | GPIO_PIN_1 | GPIO_PIN_4 | GPIO_PIN_5 | GPIO_PIN_7 | \
+                                         GPIO_PIN_8 | GPIO_PIN_9 | GPIO_PIN_10 | GPIO_PIN_11 | GPIO_PIN_14 | GPIO_PIN_15)
+// D4 ... D12
+#define DRV_EXMC_GPIOE_PINS             (GPIO_PIN_7 | GPIO_PIN_8 | GPIO_PIN_9 | GPIO_PIN_10 | GPIO_PIN_11 | \
+                                         GPIO_PIN_12 | GPIO_PIN_13 | GPIO_PIN_14 | GPIO_PIN_15)
+
+static struct
+{
+    volatile uint8_t busy;
+    volatile uint16_t *dst;
+    const uint16_t *src;
+    uint32_t remain;            // 还没交给DMA的数据个数
+    uint8_t src_inc;
+}exmc_write;
+
+static ExmcWriteCpltFunc write_cplt_call_back = NULL;
+
+static void exmc_dma_start(void);
+
+/**
+ * @brief 初始化EXMC，时序按HCLK 120MHz下写周期不小于66ns配置
+ *
+ * @return int8_t
+ */
+int8_t ExmcInit(void)
+{
+    exmc_norsram_parameter_struct norsram_init_struct;
+    exmc_norsram_timing_parameter_struct timing;
+
+    rcu_periph_clock_enable(RCU_GPIOD);
+    rcu_periph_clock_enable(RCU_GPIOE);
+    rcu_periph_clock_enable(RCU_EXMC);
+    rcu_periph_clock_enable(DRV_EXMC_DMA_CLK);
+
+    gpio_init(GPIOD, GPIO_MODE_AF_PP, GPIO_OSPEED_50MHZ, DRV_EXMC_GPIOD_PINS);
+    gpio_init(GPIOE, GPIO_MODE_AF_PP, GPIO_OSPEED_50MHZ, DRV_EXMC_GPIOE_PINS);
+
+    norsram_init_struct.read_write_timing = &timing;
+    norsram_init_struct.write_timing = &timing;
+    exmc_norsram_struct_para_init(&norsram_init_struct);
+
+    // 地址建立2个HCLK，数据建立5个HCLK，加上一个HCLK的间隔，每次写入约67ns
+    timing.asyn_access_mode = EXMC_ACCESS_MODE_A;
+    timing.syn_data_latency = EXMC_DATALAT_2_CLK;
+    timing.syn_clk_division = EXMC_SYN_CLOCK_RATIO_DISABLE;
+    timing.bus_latency = 0;
+    timing.asyn_data_setuptime = 5;
+    timing.asyn_address_holdtime = 1;
+    timing.asyn_address_setuptime = 2;
+
+    norsram_init_struct.norsram_region = DRV_EXMC_REGION;
+    norsram_init_struct.write_mode = EXMC_ASYN_WRITE;
+    norsram_init_struct.extended_mode = DISABLE;
+    norsram_init_struct.asyn_wait = DISABLE;
+    norsram_init_struct.nwait_signal = DISABLE;
+    norsram_init_struct.memory_write = ENABLE;
+    norsram_init_struct.wrap_burst_mode = DISABLE;
+    norsram_init_struct.burst_mode = DISABLE;
+    norsram_init_struct.databus_width = EXMC_NOR_DATABUS_WIDTH_16B;
+    norsram_init_struct.memory_type = EXMC_MEMORY_TYPE_SRAM;
+    norsram_init_struct.address_data_mux = DISABLE;
+    exmc_norsram_init(&norsram_init_struct);
+    exmc_norsram_enable(DRV_EXMC_REGION);
+
+    exmc_write.busy = 0;
+    nvic_irq_enable(DRV_EXMC_DMA_IRQ, 1, 2);
+
+    return 0;
+}
+
+/**
+ * @brief DMA写入同一个地址，返回后CPU不能再访问该设备，直到写入完成
+ *
+ * @param dst 设备的数据地址
+ * @param src
+ * @param num 16位数据个数，可以超过65535
+ * @param src_inc 为0时重复写src指向的同一个数据，用于填充
+ * @return int8_t 上一次写入还没完成时返回-1
+ */
+int8_t ExmcWriteDMA(volatile uint16_t *dst, const uint16_t *src, uint32_t num, uint8_t src_inc)
+{
+    if(num == 0) {
+        return -1;
+    }
+
+    if(exmc_write.busy == 1)
+    {
+        return -1;
+    }
+    exmc_write.busy = 1;
+
+    exmc_write.dst = dst;
+    exmc_write.src = src;
+    exmc_write.remain = num;
+    exmc_write.src_inc = src_inc;
+    exmc_dma_start();
+
+    return 0;
+}
+
+uint8_t ExmcIsBusy(void)
+{
+    return exmc_write.busy;
+}
+
+void ExmcWriteCallbackRegister(ExmcWriteCpltFunc func)
+{
+    if(func != NULL)
+        write_cplt_call_back = func;
+}
+
+/**
+ * @brief DMA传输完成中断里调用，还有剩余数据时发送下一段
+ *
+ */
+void ExmcWriteCompleteCallback(void)
+{
+    dma_channel_disable(DRV_EXMC_DMA, DRV_EXMC_DMA_CHL);
+
+    if(exmc_write.remain != 0) {
+        exmc_dma_start();
+        return;
+    }
+
+    exmc_write.busy = 0;
+    if(write_cplt_call_back != NULL)
+        write_cplt_call_back();
+}
+
+static void exmc_dma_start(void)
+{
+    dma_parameter_struct dma_init_struct;
+    uint16_t num = exmc_write.remain > DRV_EXMC_DMA_MAX ? DRV_EXMC_DMA_MAX : (uint16_t)exmc_write.remain;
+
+    dma_deinit(DRV_EXMC_DMA, DRV_EXMC_DMA_CHL);
+    dma_struct_para_init(&dma_init_struct);
+
+    // 存储器到存储器模式下从memory_addr读，写到periph_addr
+    dma_init_struct.direction = DMA_MEMORY_TO_PERIPHERAL;
+    dma_init_struct.memory_addr = (uint32_t)exmc_write.src;
+    dma_init_struct.memory_inc = exmc_write.src_inc ? DMA_MEMORY_INCREASE_ENABLE : DMA_MEMORY_INCREASE_DISABLE;
+    dma_init_struct.memory_width = DMA_MEMORY_WIDTH_16BIT;
+    dma_init_struct.number = num;
+    dma_init_struct.periph_addr = (uint32_t)exmc_write.dst;
+    dma_init_struct.periph_inc = DMA_PERIPH_INCREASE_DISABLE;
+    dma_init_struct.periph_width = DMA_PERIPHERAL_WIDTH_16BIT;
+    dma_init_struct.priority = DMA_PRIORITY_MEDIUM;
+    dma_init(DRV_EXMC_DMA, DRV_EXMC_DMA_CHL, &dma_init_struct);
+
+    dma_circulation_disable(DRV_EXMC_DMA, DRV_EXMC_DMA_CHL);
+    dma_memory_to_memory_enable(DRV_EXMC_DMA, DRV_EXMC_DMA_CHL);
+
+    if(exmc_write.src_inc)
+        exmc_write.src += num;
+    exmc_write.remain -= num;
+
+    dma_interrupt_enable(DRV_EXMC_DMA, DRV_EXMC_DMA_CHL, DMA_INT_FTF);
+    dma_channel_enable(DRV_EXMC_DMA, DRV_EXMC_DMA_CHL);
+}
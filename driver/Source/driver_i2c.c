@@ -1,3 +1,4 @@
+#include "stddef.h"
 #include "driver_i2c.h"
 #include "gd32f30x.h"
 #include "chip_resource.h"
@@ -15,6 +16,52 @@ static uint32_t I2C_GPIO_PORT[DRV_I2Cn] = {GPIOB, GPIOB};
 static uint32_t I2C_SCL_PIN[DRV_I2Cn] = {GPIO_PIN_6, GPIO_PIN_10};
 static uint32_t I2C_SDA_PIN[DRV_I2Cn] = {GPIO_PIN_7, GPIO_PIN_11};
 
+/**
+ * @brief 占用总线，检查和置位在关中断下完成，避免中断里发起的传输和主循环的传输撞在一起
+ * 
+ * @param i2c 
+ * @param write 1：占用为写，0：占用为读
+ * @return int8_t 总线忙时返回-1
+ */
+static int8_t i2c_claim(I2cStruct *i2c, uint8_t write)
+{
+    uint32_t primask = __get_PRIMASK();
+    int8_t ret = 0;
+
+    __disable_irq();
+    if(i2c->write_info.writing == 1 || i2c->read_info.reading == 1) {
+        ret = -1;
+    }
+    else if(i2c_flag_get(I2C_PERIPH[i2c->i2c_id], I2C_FLAG_I2CBSY) == 1) {
+        ret = -1;
+    }
+    else if(write == 1) {
+        i2c->write_info.writing = 1;
+    }
+    else {
+        i2c->read_info.reading = 1;
+    }
+    __set_PRIMASK(primask);
+
+    return ret;
+}
+
+static void i2c_write_done(I2cStruct *i2c, int8_t result)
+{
+    uint8_t i;
+
+    for(i = 0; i < i2c->write_call_back_num; i++)
+        i2c->write_call_back[i](result);
+}
+
+static void i2c_read_done(I2cStruct *i2c, int8_t result)
+{
+    uint8_t i;
+
+    for(i = 0; i < i2c->read_call_back_num; i++)
+        i2c->read_call_back[i](result);
+}
+
 int8_t I2cInit(I2cStruct *i2c, I2cInitStruct *init)
 {
     if(i2c->inited == 1)
@@ -59,17 +106,14 @@ int8_t I2cInit(I2cStruct *i2c, I2cInitStruct *init)
 
 int8_t I2cWrite(I2cStruct *i2c, uint8_t dev_addr, uint8_t *data, uint16_t data_len)
 {
-    if(i2c->write_info.writing == 1 || i2c->read_info.reading == 1)
-        return -1;
-    
-    if(i2c_flag_get(I2C_PERIPH[i2c->i2c_id], I2C_FLAG_I2CBSY) == 1)
+    if(i2c_claim(i2c, 1) != 0)
         return -1;
 
-    i2c->write_info.writing = 1;
     i2c->write_info.total_data_len = data_len;
     i2c->write_info.cur_data_num = 0;
     i2c->write_info.pdata = data;
     i2c->write_info.slave_addr = dev_addr;
+    i2c->write_info.restart_read = 0;
     
     i2c_interrupt_enable(I2C_PERIPH[i2c->i2c_id], I2C_INT_ERR);
     i2c_interrupt_enable(I2C_PERIPH[i2c->i2c_id], I2C_INT_BUF);
@@ -82,13 +126,46 @@ int8_t I2cWrite(I2cStruct *i2c, uint8_t dev_addr, uint8_t *data, uint16_t data_l
 
 int8_t I2cRead(I2cStruct *i2c, uint8_t dev_addr, uint8_t *data, uint16_t data_len)
 {
-    if(i2c->write_info.writing == 1 || i2c->read_info.reading == 1)
+    if(i2c_claim(i2c, 0) != 0)
         return -1;
+
+    i2c->read_info.total_data_len = data_len;
+    i2c->read_info.cur_data_num = 0;
+    i2c->read_info.pdata = data;
+    i2c->read_info.slave_addr = dev_addr;
     
-    if(i2c_flag_get(I2C_PERIPH[i2c->i2c_id], I2C_FLAG_I2CBSY) == 1)
+    i2c_interrupt_enable(I2C_PERIPH[i2c->i2c_id], I2C_INT_ERR);
+    i2c_interrupt_enable(I2C_PERIPH[i2c->i2c_id], I2C_INT_BUF);
+    i2c_interrupt_enable(I2C_PERIPH[i2c->i2c_id], I2C_INT_EV);
+    
+    i2c_start_on_bus(I2C_PERIPH[i2c->i2c_id]);
+
+    return 0;
+}
+
+/**
+ * @brief 读取从机寄存器：先写入寄存器地址，再以重复起始位读取数据，中间不发送停止位
+ * 
+ * @param i2c 
+ * @param dev_addr 从机地址
+ * @param reg_addr 寄存器地址
+ * @param data 读取数据的存放位置
+ * @param data_len 读取长度
+ * @return int8_t 总线忙时返回-1
+ */
+int8_t I2cMemRead(I2cStruct *i2c, uint8_t dev_addr, uint8_t reg_addr, uint8_t *data, uint16_t data_len)
+{
+    if(i2c_claim(i2c, 1) != 0)
         return -1;
 
-    i2c->read_info.reading = 1;
+    i2c->write_info.mem_addr = reg_addr;
+    i2c->write_info.total_data_len = 1;
+    i2c->write_info.cur_data_num = 0;
+    i2c->write_info.pdata = &i2c->write_info.mem_addr;
+    i2c->write_info.slave_addr = dev_addr;
+    i2c->write_info.restart_read = 1;
+
+    // 读取参数先准备好，写完地址后在中断里直接切换
     i2c->read_info.total_data_len = data_len;
     i2c->read_info.cur_data_num = 0;
     i2c->read_info.pdata = data;
@@ -97,12 +174,53 @@ int8_t I2cRead(I2cStruct *i2c, uint8_t dev_addr, uint8_t *data, uint16_t data_le
     i2c_interrupt_enable(I2C_PERIPH[i2c->i2c_id], I2C_INT_ERR);
     i2c_interrupt_enable(I2C_PERIPH[i2c->i2c_id], I2C_INT_BUF);
     i2c_interrupt_enable(I2C_PERIPH[i2c->i2c_id], I2C_INT_EV);
-    
+
     i2c_start_on_bus(I2C_PERIPH[i2c->i2c_id]);
 
     return 0;
 }
 
+/**
+ * @brief 查询是否还有传输未完成，供需要等待传输结束的调用者轮询
+ * 
+ * @param i2c 
+ * @return uint8_t 1：正在传输
+ */
+uint8_t I2cIsBusy(I2cStruct *i2c)
+{
+    return (i2c->write_info.writing == 1 || i2c->read_info.reading == 1) ? 1 : 0;
+}
+
+/**
+ * @brief 注册写完成回调，在中断里调用
+ * 
+ * @param i2c 
+ * @param func 
+ * @return int8_t 已经注册满I2C_CALLBACK_MAX_NUM个时返回-1
+ */
+int8_t I2cWriteCallbackRegister(I2cStruct *i2c, I2cWriteCallback func)
+{
+    if(func == NULL || i2c->write_call_back_num >= I2C_CALLBACK_MAX_NUM)
+        return -1;
+    i2c->write_call_back[i2c->write_call_back_num++] = func;
+    return 0;
+}
+
+/**
+ * @brief 注册读完成回调，I2cMemRead也在读完后调用它，在中断里调用
+ * 
+ * @param i2c 
+ * @param func 
+ * @return int8_t 已经注册满I2C_CALLBACK_MAX_NUM个时返回-1
+ */
+int8_t I2cReadCallbackRegister(I2cStruct *i2c, I2cReadCallback func)
+{
+    if(func == NULL || i2c->read_call_back_num >= I2C_CALLBACK_MAX_NUM)
+        return -1;
+    i2c->read_call_back[i2c->read_call_back_num++] = func;
+    return 0;
+}
+
 uint8_t tbe_cnt = 0;
 void I2cEventCallback(I2cStruct *i2c)
 {
@@ -137,6 +255,15 @@ void I2cEventCallback(I2cStruct *i2c)
             }
             break;
         case I2C_STOP:
+            if(i2c->write_info.restart_read == 1) {
+                /* repeated start, keep the bus and switch to receiver */
+                i2c->write_info.restart_read = 0;
+                i2c->write_info.writing = 0;
+                i2c->read_info.reading = 1;
+                i2c->i2c_process = I2C_SEND_ADDRESS_FIRST;
+                i2c_start_on_bus(I2C_PERIPH[i2c->i2c_id]);
+                break;
+            }
             /* the master sends a stop condition to I2C bus */
             i2c_stop_on_bus(I2C_PERIPH[i2c->i2c_id]);
             /* disable the I2C_PERIPH[i2c->i2c_id] interrupt */
@@ -145,6 +272,7 @@ void I2cEventCallback(I2cStruct *i2c)
             i2c_interrupt_disable(I2C_PERIPH[i2c->i2c_id], I2C_INT_EV);
             i2c->i2c_process = I2C_SEND_ADDRESS_FIRST;
             i2c->write_info.writing = 0;
+            i2c_write_done(i2c, 0);
             break;
         default:
             break;
@@ -194,6 +322,7 @@ void I2cEventCallback(I2cStruct *i2c)
                         i2c_interrupt_disable(I2C_PERIPH[i2c->i2c_id], I2C_INT_EV);
 
                         i2c->read_info.reading = 0;
+                        i2c_read_done(i2c, 0);
                     }
                 }
             }
@@ -206,8 +335,46 @@ void I2cEventCallback(I2cStruct *i2c)
 }
 
 
+/**
+ * @brief 错误中断：清除错误标志，发送停止位释放总线，结束当前传输并以-1通知发起者
+ *
+ * 仲裁丢失时硬件已经退回从机模式，不再发送停止位
+ *
+ * @param i2c
+ */
 void I2cErrorCallback(I2cStruct *i2c)
 {
-    return;
+    uint32_t periph = I2C_PERIPH[i2c->i2c_id];
+    uint8_t lost_arbitration = i2c_interrupt_flag_get(periph, I2C_INT_FLAG_LOSTARB) ? 1 : 0;
+    uint8_t was_reading = i2c->read_info.reading == 1 || i2c->write_info.restart_read == 1;
+    uint8_t was_busy = i2c->write_info.writing == 1 || i2c->read_info.reading == 1;
+
+    i2c_interrupt_flag_clear(periph, I2C_INT_FLAG_AERR);
+    i2c_interrupt_flag_clear(periph, I2C_INT_FLAG_BERR);
+    i2c_interrupt_flag_clear(periph, I2C_INT_FLAG_LOSTARB);
+    i2c_interrupt_flag_clear(periph, I2C_INT_FLAG_OUERR);
+    i2c_interrupt_flag_clear(periph, I2C_INT_FLAG_PECERR);
+    i2c_interrupt_flag_clear(periph, I2C_INT_FLAG_SMBTO);
+    i2c_interrupt_flag_clear(periph, I2C_INT_FLAG_SMBALT);
+
+    i2c_interrupt_disable(periph, I2C_INT_ERR);
+    i2c_interrupt_disable(periph, I2C_INT_BUF);
+    i2c_interrupt_disable(periph, I2C_INT_EV);
+    if(lost_arbitration == 0)
+        i2c_stop_on_bus(periph);
+    i2c_ack_config(periph, I2C_ACK_ENABLE);
+
+    i2c->i2c_process = I2C_SEND_ADDRESS_FIRST;
+    i2c->write_info.restart_read = 0;
+    i2c->write_info.writing = 0;
+    i2c->read_info.reading = 0;
+    if(was_busy == 0)
+        return;
+
+    i2c->errors ++;
+    if(was_reading == 1)
+        i2c_read_done(i2c, -1);
+    else
+        i2c_write_done(i2c, -1);
 }
 
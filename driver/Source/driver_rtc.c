@@ -0,0 +1,230 @@
+#include "stddef.h"
+#include "driver_rtc.h"
+#include "gd32f30x.h"
+
+#define RTC_PRESCALER               32767U      // LXTAL 32.768kHz分频到1Hz
+#define RTC_IRC40K_PRESCALER        39999U      // IRC40K分频到1Hz，频率偏差可达±50%，只作应急
+
+// 备份寄存器分配
+#define RTC_BKP_MAGIC_REG           BKP_DATA_0
+#define RTC_BKP_SYNC_L_REG          BKP_DATA_1
+#define RTC_BKP_SYNC_H_REG          BKP_DATA_2
+#define RTC_BKP_CALIB_L_REG         BKP_DATA_3
+#define RTC_BKP_CALIB_H_REG         BKP_DATA_4
+#define RTC_BKP_SOURCE_REG          BKP_DATA_5
+
+#define RTC_BKP_MAGIC               0xA5C3U     // 备份域已经配置过的标志
+
+// RCCV每一个单位让RTC时钟在2^20个周期里调整一个周期，约953.67ppb
+#define RTC_CALIB_STEP_PPB_X100     95367
+#define RTC_CALIB_MAX               0x7F
+
+static RtcAlarmFunc rtc_alarm_func = NULL;
+static uint8_t rtc_ready = 0;      // RTC时钟已起振，否则等待写完成会一直卡住
+static uint8_t rtc_lxtal = 0;
+
+static void rtc_bkp_write32(bkp_data_register_enum low_reg, bkp_data_register_enum high_reg, uint32_t value);
+static uint32_t rtc_bkp_read32(bkp_data_register_enum low_reg, bkp_data_register_enum high_reg);
+
+/**
+ * @brief 初始化内部RTC，备份域已经配置过时（复位而非掉电）直接沿用，不打断计时
+ *
+ * LXTAL起振失败时改用IRC40K，RTC照常走但精度很差，而且IRC40K不在备份域里，
+ * 复位和掉电后时间都会丢失，所以不写配置标志，下次上电重新尝试LXTAL。
+ *
+ * @return int8_t LXTAL和IRC40K都起振失败返回-1，此时其他RTC接口都不可用
+ */
+int8_t RtcInit(void)
+{
+    rcu_periph_clock_enable(RCU_BKPI);
+    rcu_periph_clock_enable(RCU_PMU);
+    pmu_backup_write_enable();
+
+    if(bkp_read_data(RTC_BKP_MAGIC_REG) != RTC_BKP_MAGIC)
+    {
+        // 备份域掉过电，重新配置RTC
+        rcu_bkp_reset_enable();
+        rcu_bkp_reset_disable();
+
+        rcu_osci_on(RCU_LXTAL);
+        if(rcu_osci_stab_wait(RCU_LXTAL) == SUCCESS)
+        {
+            rtc_lxtal = 1;
+            rcu_rtc_clock_config(RCU_RTCSRC_LXTAL);
+        }
+        else
+        {
+            rcu_osci_off(RCU_LXTAL);
+            rcu_osci_on(RCU_IRC40K);
+            if(rcu_osci_stab_wait(RCU_IRC40K) != SUCCESS)
+            {
+                return -1;
+            }
+            rcu_rtc_clock_config(RCU_RTCSRC_IRC40K);
+        }
+        rcu_periph_clock_enable(RCU_RTC);
+
+        rtc_register_sync_wait();
+        rtc_lwoff_wait();
+        rtc_prescaler_set(rtc_lxtal == 1 ? RTC_PRESCALER : RTC_IRC40K_PRESCALER);
+        rtc_lwoff_wait();
+
+        rtc_bkp_write32(RTC_BKP_SYNC_L_REG, RTC_BKP_SYNC_H_REG, 0);
+        rtc_bkp_write32(RTC_BKP_CALIB_L_REG, RTC_BKP_CALIB_H_REG, 0);
+        bkp_write_data(RTC_BKP_SOURCE_REG, RTC_SYNC_NONE);
+        if(rtc_lxtal == 1)
+            bkp_write_data(RTC_BKP_MAGIC_REG, RTC_BKP_MAGIC);
+    }
+    else
+    {
+        // 复位后APB1接口需要和RTC重新同步才能读到正确的计数值
+        rtc_lxtal = 1;
+        rtc_register_sync_wait();
+    }
+    rtc_ready = 1;
+
+    /* RTC alarm goes through EXTI line 17 */
+    exti_init(EXTI_17, EXTI_INTERRUPT, EXTI_TRIG_RISING);
+    exti_interrupt_flag_clear(EXTI_17);
+    nvic_irq_enable(RTC_Alarm_IRQn, 0, 3);
+
+    return 0;
+}
+
+/**
+ * @brief 读取当前时间，只读RTC计数器，不访问任何总线设备
+ *
+ * @return uint32_t 自2000-01-01起的秒数
+ */
+uint32_t RtcNow(void)
+{
+    uint16_t high;
+    uint16_t low;
+
+    // 计数器分高低两个16位寄存器，读低位期间高位可能进位，高位前后一致才有效
+    do {
+        high = RTC_CNTH;
+        low = RTC_CNTL;
+    } while(high != RTC_CNTH);
+
+    return ((uint32_t)high << 16) | low;
+}
+
+/**
+ * @brief 设置当前时间并记录同步信息到备份寄存器
+ *
+ * @param seconds 自2000-01-01起的秒数
+ * @param source 时间来源
+ * @return int8_t
+ */
+int8_t RtcSetTime(uint32_t seconds, RtcSyncSource source)
+{
+    if(rtc_ready == 0)
+        return -1;
+
+    rtc_lwoff_wait();
+    rtc_counter_set(seconds);
+    rtc_lwoff_wait();
+
+    rtc_bkp_write32(RTC_BKP_SYNC_L_REG, RTC_BKP_SYNC_H_REG, seconds);
+    bkp_write_data(RTC_BKP_SOURCE_REG, source);
+
+    return 0;
+}
+
+/**
+ * @brief 设置晶振校准量，写入BKP的RCCV，由BL8025对时时测出的LXTAL漂移调用
+ *
+ * 备份寄存器里保存的是按RCCV的步长取整、限幅之后实际生效的校准量，
+ * 调用者在它的基础上累加新测出的剩余漂移
+ *
+ * @param ppb 晶振偏快的量，单位十亿分之一，负数表示偏慢
+ * @return int8_t RTC不可用时返回-1；超出可校准范围时按最大值校准并返回-1
+ */
+int8_t RtcSetCalibration(int32_t ppb)
+{
+    int8_t ret = 0;
+    uint32_t abs_ppb = ppb >= 0 ? (uint32_t)ppb : (uint32_t)-ppb;
+    uint32_t value = (uint32_t)(((uint64_t)abs_ppb * 100U + RTC_CALIB_STEP_PPB_X100 / 2) / RTC_CALIB_STEP_PPB_X100);
+    int32_t applied;
+
+    if(rtc_ready == 0)
+        return -1;
+
+    if(value > RTC_CALIB_MAX)
+    {
+        value = RTC_CALIB_MAX;
+        ret = -1;
+    }
+    applied = (int32_t)((value * RTC_CALIB_STEP_PPB_X100 + 50) / 100);
+
+    // 晶振偏快则减慢RTC时钟，偏慢则加快
+    bkp_rtc_clock_calibration_direction(ppb >= 0 ? RTC_CLOCK_SLOWED_DOWN : RTC_CLOCK_SPEED_UP);
+    bkp_rtc_calibration_value_set((uint8_t)value);
+    rtc_bkp_write32(RTC_BKP_CALIB_L_REG, RTC_BKP_CALIB_H_REG, (uint32_t)(ppb >= 0 ? applied : -applied));
+
+    return ret;
+}
+
+void RtcGetSyncInfo(RtcSyncInfo *info)
+{
+    info->last_sync_sec = rtc_bkp_read32(RTC_BKP_SYNC_L_REG, RTC_BKP_SYNC_H_REG);
+    info->calibration_ppb = (int32_t)rtc_bkp_read32(RTC_BKP_CALIB_L_REG, RTC_BKP_CALIB_H_REG);
+    info->source = (RtcSyncSource)bkp_read_data(RTC_BKP_SOURCE_REG);
+    info->lxtal = rtc_lxtal;
+}
+
+/**
+ * @brief 设置闹钟，计数器到达该值时产生闹钟中断，只保留一个闹钟
+ *
+ * @param seconds 自2000-01-01起的秒数
+ * @return int8_t
+ */
+int8_t RtcSetAlarm(uint32_t seconds)
+{
+    if(rtc_ready == 0)
+        return -1;
+
+    rtc_lwoff_wait();
+    rtc_flag_clear(RTC_FLAG_ALARM);
+    rtc_alarm_config(seconds);
+    rtc_lwoff_wait();
+    rtc_interrupt_enable(RTC_INT_ALARM);
+    rtc_lwoff_wait();
+
+    return 0;
+}
+
+void RtcDisableAlarm(void)
+{
+    if(rtc_ready == 0)
+        return;
+
+    rtc_lwoff_wait();
+    rtc_interrupt_disable(RTC_INT_ALARM);
+    rtc_lwoff_wait();
+}
+
+int8_t RtcAlarmCallbackRegister(RtcAlarmFunc func)
+{
+    if(func != NULL)
+        rtc_alarm_func = func;
+    return 0;
+}
+
+void RtcAlarmCallback(void)
+{
+    if(rtc_alarm_func != NULL)
+        rtc_alarm_func();
+}
+
+static void rtc_bkp_write32(bkp_data_register_enum low_reg, bkp_data_register_enum high_reg, uint32_t value)
+{
+    bkp_write_data(low_reg, (uint16_t)value);
+    bkp_write_data(high_reg, (uint16_t)(value >> 16));
+}
+
+static uint32_t rtc_bkp_read32(bkp_data_register_enum low_reg, bkp_data_register_enum high_reg)
+{
+    return ((uint32_t)bkp_read_data(high_reg) << 16) | bkp_read_data(low_reg);
+}
@@ -0,0 +1,242 @@
+#include "stddef.h"
+#include "driver_spi.h"
+#include "gd32f30x.h"
+#include "chip_resource.h"
+
+#define DRV_SPIn                        1U
+
+// SPI2用PB3/PB5，需要关闭JTAG只保留SWD，同时释放出PA15
+#define DRV_SPI2                        SPI2
+#define DRV_SPI2_CLK                    RCU_SPI2
+#define DRV_SPI2_SCK_PIN                GPIO_PIN_3
+#define DRV_SPI2_MOSI_PIN               GPIO_PIN_5
+#define DRV_SPI2_GPIO_PORT              GPIOB
+#define DRV_SPI2_GPIO_CLK               RCU_GPIOB
+
+static uint32_t SPI_PERIPH[DRV_SPIn] = {DRV_SPI2};
+
+// RCU clock
+static rcu_periph_enum SPI_CLK[DRV_SPIn] = {DRV_SPI2_CLK};
+static rcu_periph_enum SPI_GPIO_CLK[DRV_SPIn] = {DRV_SPI2_GPIO_CLK};
+static rcu_clock_freq_enum SPI_CLK_SRC[DRV_SPIn] = {CK_APB1};
+
+// GPIO
+static uint32_t SPI_SCK_PIN[DRV_SPIn] = {DRV_SPI2_SCK_PIN};
+static uint32_t SPI_MOSI_PIN[DRV_SPIn] = {DRV_SPI2_MOSI_PIN};
+static uint32_t SPI_GPIO_PORT[DRV_SPIn] = {DRV_SPI2_GPIO_PORT};
+
+// SPI TX
+static uint32_t SPI_TX_DMA[DRV_SPIn] = {DMA1};
+static rcu_periph_enum SPI_TX_DMA_CLK[DRV_SPIn] = {RCU_DMA1};
+static IRQn_Type SPI_TX_DMA_IRQ[DRV_SPIn] = {DMA1_Channel1_IRQn};
+static dma_channel_enum SPI_TX_DMA_CHL[DRV_SPIn] = {DMA_CH1};
+
+static void spi_frame_size_set(SpiStruct *spi, SpiFrameSize frame_size);
+static int8_t spi_send_dma(SpiStruct *spi, const void *data, uint16_t data_num, SpiFrameSize frame_size, uint32_t memory_inc);
+
+int8_t SpiInit(SpiStruct *spi, SpiInitStruct *init)
+{
+    spi_parameter_struct spi_init_struct;
+    uint32_t clk_freq;
+    uint32_t psc = 0;
+    uint8_t spi_id = 0U;
+
+    if(spi->inited != 0){
+        return 0;
+    }
+    spi->inited = 1;
+    spi->Init = *init;
+    spi->send_info.send_busy = 0;
+    spi->send_info.frame_size = SpiFrame_8Bit;
+
+    if(spi == &Spi2){
+        spi_id = 0U;
+    }
+    spi->spi_id = spi_id;
+
+    rcu_periph_clock_enable(SPI_TX_DMA_CLK[spi_id]);
+    rcu_periph_clock_enable(SPI_GPIO_CLK[spi_id]);
+    rcu_periph_clock_enable(SPI_CLK[spi_id]);
+    rcu_periph_clock_enable(RCU_AF);
+
+    if(spi == &Spi2){
+        gpio_pin_remap_config(GPIO_SWJ_SWDPENABLE_REMAP, ENABLE);
+    }
+
+    /* only transmit is used, MISO is left for other functions */
+    gpio_init(SPI_GPIO_PORT[spi_id], GPIO_MODE_AF_PP, GPIO_OSPEED_50MHZ, SPI_SCK_PIN[spi_id] | SPI_MOSI_PIN[spi_id]);
+
+    // 分频系数为2的(psc+1)次方
+    clk_freq = rcu_clock_freq_get(SPI_CLK_SRC[spi_id]);
+    while(psc < 7 && (clk_freq >> (psc + 1)) > init->speed)
+    {
+        psc ++;
+    }
+
+    spi_i2s_deinit(SPI_PERIPH[spi_id]);
+    spi_struct_para_init(&spi_init_struct);
+    spi_init_struct.trans_mode           = SPI_TRANSMODE_BDTRANSMIT;
+    spi_init_struct.device_mode          = SPI_MASTER;
+    spi_init_struct.frame_size           = SPI_FRAMESIZE_8BIT;
+    spi_init_struct.clock_polarity_phase = SPI_CK_PL_LOW_PH_1EDGE;
+    spi_init_struct.nss                  = SPI_NSS_SOFT;
+    spi_init_struct.prescale             = CTL0_PSC(psc);
+    spi_init_struct.endian               = SPI_ENDIAN_MSB;
+    spi_init(SPI_PERIPH[spi_id], &spi_init_struct);
+
+    spi_enable(SPI_PERIPH[spi_id]);
+
+    nvic_irq_enable(SPI_TX_DMA_IRQ[spi_id], 0, 2);
+
+    return 0;
+}
+
+/**
+ * @brief 阻塞发送少量8位数据，用于命令字节，发送完成（移位寄存器空）后返回
+ *
+ * @param spi
+ * @param data
+ * @param data_len
+ * @return int8_t DMA发送还没完成时返回-1
+ */
+int8_t SpiSend(SpiStruct *spi, const uint8_t *data, uint16_t data_len)
+{
+    uint16_t i;
+
+    if(spi->send_info.send_busy == 1)
+    {
+        return -1;
+    }
+
+    spi_frame_size_set(spi, SpiFrame_8Bit);
+    for(i = 0; i < data_len; i ++)
+    {
+        while(spi_i2s_flag_get(SPI_PERIPH[spi->spi_id], SPI_FLAG_TBE) == RESET);
+        spi_i2s_data_transmit(SPI_PERIPH[spi->spi_id], data[i]);
+    }
+    while(spi_i2s_flag_get(SPI_PERIPH[spi->spi_id], SPI_FLAG_TBE) == RESET);
+    while(spi_i2s_flag_get(SPI_PERIPH[spi->spi_id], SPI_FLAG_TRANS) == SET);
+
+    return 0;
+}
+
+/**
+ * @brief DMA发送
+ *
+ * @param spi
+ * @param data
+ * @param data_num 数据个数，单位为帧而不是字节
+ * @param frame_size
+ * @return int8_t
+ */
+int8_t SpiSendDMA(SpiStruct *spi, const void *data, uint16_t data_num, SpiFrameSize frame_size)
+{
+    return spi_send_dma(spi, data, data_num, frame_size, DMA_MEMORY_INCREASE_ENABLE);
+}
+
+/**
+ * @brief DMA重复发送同一个数据，用于填充纯色
+ *
+ * @param spi
+ * @param data 指向一个数据
+ * @param data_num 重复次数
+ * @param frame_size
+ * @return int8_t
+ */
+int8_t SpiSendRepeatDMA(SpiStruct *spi, const void *data, uint16_t data_num, SpiFrameSize frame_size)
+{
+    return spi_send_dma(spi, data, data_num, frame_size, DMA_MEMORY_INCREASE_DISABLE);
+}
+
+uint8_t SpiIsBusy(SpiStruct *spi)
+{
+    return spi->send_info.send_busy;
+}
+
+int8_t SpiSendCallbackRegister(SpiStruct *spi, SpiSendCpltFunc func)
+{
+    if(func != NULL)
+        spi->send_cplt_call_back = func;
+    return 0;
+}
+
+/**
+ * @brief DMA传输完成中断里调用，DMA完成时最后一帧还在移位，等移位结束后才算发送完成
+ *
+ * @param spi
+ */
+void SpiSendCompleteCallback(SpiStruct *spi)
+{
+    while(spi_i2s_flag_get(SPI_PERIPH[spi->spi_id], SPI_FLAG_TBE) == RESET);
+    while(spi_i2s_flag_get(SPI_PERIPH[spi->spi_id], SPI_FLAG_TRANS) == SET);
+
+    dma_channel_disable(SPI_TX_DMA[spi->spi_id], SPI_TX_DMA_CHL[spi->spi_id]);
+    spi_dma_disable(SPI_PERIPH[spi->spi_id], SPI_DMA_TRANSMIT);
+    spi->send_info.send_busy = 0;
+
+    if(spi->send_cplt_call_back != NULL)
+        spi->send_cplt_call_back();
+}
+
+/**
+ * @brief 切换帧长度，只能在SPI空闲时关闭SPI后修改
+ *
+ */
+static void spi_frame_size_set(SpiStruct *spi, SpiFrameSize frame_size)
+{
+    if(spi->send_info.frame_size == frame_size)
+        return;
+
+    spi_disable(SPI_PERIPH[spi->spi_id]);
+    spi_i2s_data_frame_format_config(SPI_PERIPH[spi->spi_id],
+        frame_size == SpiFrame_16Bit ? SPI_FRAMESIZE_16BIT : SPI_FRAMESIZE_8BIT);
+    spi_enable(SPI_PERIPH[spi->spi_id]);
+    spi->send_info.frame_size = frame_size;
+}
+
+static int8_t spi_send_dma(SpiStruct *spi, const void *data, uint16_t data_num, SpiFrameSize frame_size, uint32_t memory_inc)
+{
+    dma_parameter_struct dma_init_struct;
+    uint8_t spi_id = spi->spi_id;
+
+    if(data_num == 0) {
+        return -1;
+    }
+
+    if(spi->send_info.send_busy == 1)
+    {
+        return -1;
+    }
+    spi->send_info.send_busy = 1;
+
+    spi_frame_size_set(spi, frame_size);
+
+    dma_deinit(SPI_TX_DMA[spi_id], SPI_TX_DMA_CHL[spi_id]);
+    dma_struct_para_init(&dma_init_struct);
+
+    dma_init_struct.direction = DMA_MEMORY_TO_PERIPHERAL;
+    dma_init_struct.memory_addr = (uint32_t)data;
+    dma_init_struct.memory_inc = memory_inc;
+    dma_init_struct.number = data_num;
+    dma_init_struct.periph_addr = ((uint32_t)&SPI_DATA(SPI_PERIPH[spi_id]));
+    dma_init_struct.periph_inc = DMA_PERIPH_INCREASE_DISABLE;
+    if(frame_size == SpiFrame_16Bit) {
+        dma_init_struct.memory_width = DMA_MEMORY_WIDTH_16BIT;
+        dma_init_struct.periph_width = DMA_PERIPHERAL_WIDTH_16BIT;
+    }
+    else {
+        dma_init_struct.memory_width = DMA_MEMORY_WIDTH_8BIT;
+        dma_init_struct.periph_width = DMA_PERIPHERAL_WIDTH_8BIT;
+    }
+    dma_init_struct.priority = DMA_PRIORITY_HIGH;
+    dma_init(SPI_TX_DMA[spi_id], SPI_TX_DMA_CHL[spi_id], &dma_init_struct);
+
+    dma_circulation_disable(SPI_TX_DMA[spi_id], SPI_TX_DMA_CHL[spi_id]);
+    dma_memory_to_memory_disable(SPI_TX_DMA[spi_id], SPI_TX_DMA_CHL[spi_id]);
+
+    dma_interrupt_enable(SPI_TX_DMA[spi_id], SPI_TX_DMA_CHL[spi_id], DMA_INT_FTF);
+    dma_channel_enable(SPI_TX_DMA[spi_id], SPI_TX_DMA_CHL[spi_id]);
+    spi_dma_enable(SPI_PERIPH[spi_id], SPI_DMA_TRANSMIT);
+
+    return 0;
+}
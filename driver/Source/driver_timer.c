@@ -3,21 +3,21 @@
 #include "gd32f30x.h"
 #include "chip_resource.h"
 
-#define DRV_TIMERn     2
+#define DRV_TIMERn     4
 
 #define DRV_TIMER0                        TIMER0
 #define DRV_TIMER5                        TIMER5
+#define DRV_TIMER6                        TIMER6
+#define DRV_TIMER3                        TIMER3
 
-static uint32_t TIMER_PERIPH[DRV_TIMERn] = {DRV_TIMER0, DRV_TIMER5};
-static rcu_periph_enum TIMER_CLK[DRV_TIMERn] = {RCU_TIMER0, RCU_TIMER5};
-static IRQn_Type TIMER_IRQ[DRV_TIMERn] = {TIMER0_UP_IRQn, TIMER5_IRQn};
-static rcu_clock_freq_enum TIMER_CLK_SRC[DRV_TIMERn] = {CK_APB2, CK_APB1};
+static uint32_t TIMER_PERIPH[DRV_TIMERn] = {DRV_TIMER0, DRV_TIMER5, DRV_TIMER6, DRV_TIMER3};
+static rcu_periph_enum TIMER_CLK[DRV_TIMERn] = {RCU_TIMER0, RCU_TIMER5, RCU_TIMER6, RCU_TIMER3};
+static IRQn_Type TIMER_IRQ[DRV_TIMERn] = {TIMER0_UP_IRQn, TIMER5_IRQn, TIMER6_IRQn, TIMER3_IRQn};
 
 int8_t TimerInit(TimerStruct *timer, TimerInitStruct *init)
 {
     timer_parameter_struct timer_initpara;
     uint32_t clock_src_freq;
-    uint32_t apb_clk_freq;
 
     if(timer == &Timer0)
     {
@@ -27,6 +27,14 @@ int8_t TimerInit(TimerStruct *timer, TimerInitStruct *init)
     {
         timer->timer_id = 1;
     }
+    else if(timer == &Timer6)
+    {
+        timer->timer_id = 2;
+    }
+    else if(timer == &Timer3)
+    {
+        timer->timer_id = 3;
+    }
     
     nvic_irq_enable(TIMER_IRQ[timer->timer_id], 0, 1);
 
@@ -34,16 +42,7 @@ int8_t TimerInit(TimerStruct *timer, TimerInitStruct *init)
 
     timer_deinit(TIMER_PERIPH[timer->timer_id]);
 
-    // 根据GD32F30x_用户手册 P79，若APB时钟小于AHB时钟，则定时器的时钟源为APB的两倍
-    apb_clk_freq = rcu_clock_freq_get(TIMER_CLK_SRC[timer->timer_id]);
-    if(apb_clk_freq < rcu_clock_freq_get(CK_AHB))
-    {
-        clock_src_freq = apb_clk_freq*2;
-    }
-    else
-    {
-        clock_src_freq = apb_clk_freq;
-    }
+    clock_src_freq = TimerClockGet(TIMER_PERIPH[timer->timer_id]);
 
     /* TIMER0 configuration */
     timer_initpara.prescaler         = clock_src_freq/1000000U - 1;
@@ -90,3 +89,42 @@ void TimerUpdateCallback(TimerStruct *timer)
     if(timer->timer_update_func != NULL)
         timer->timer_update_func();
 }
+
+/**
+ * @brief 定时器的输入时钟，TIMER0/7/8/9/10挂在APB2上，其余挂在APB1上
+ *
+ * 根据GD32F30x_用户手册 P79，若APB时钟小于AHB时钟，则定时器的时钟源为APB的两倍
+ *
+ * @param timer_periph TIMERx
+ * @return uint32_t Hz
+ */
+uint32_t TimerClockGet(uint32_t timer_periph)
+{
+    uint32_t apb_clk_freq;
+
+    if(timer_periph == TIMER0 || timer_periph == TIMER7 || timer_periph == TIMER8 ||
+        timer_periph == TIMER9 || timer_periph == TIMER10)
+    {
+        apb_clk_freq = rcu_clock_freq_get(CK_APB2);
+    }
+    else
+    {
+        apb_clk_freq = rcu_clock_freq_get(CK_APB1);
+    }
+
+    if(apb_clk_freq < rcu_clock_freq_get(CK_AHB))
+    {
+        return apb_clk_freq*2;
+    }
+    return apb_clk_freq;
+}
+
+/**
+ * @brief 打开DWT周期计数器，各模块统计耗时都读DWT->CYCCNT，重复调用没有影响
+ *
+ */
+void CycleCounterEnable(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
@@ -7,7 +7,11 @@ UartStruct Uart1;
 I2cStruct  I2c0;
 I2cStruct  I2c1;
 
+SpiStruct  Spi2;
+
 TimerStruct Timer0;
 TimerStruct Timer5;
+TimerStruct Timer6;
+TimerStruct Timer3;
 
 
@@ -1,9 +1,15 @@
 #include "driver_uart.h"
 #include "driver_timer.h"
 #include "driver_i2c.h"
+#include "driver_spi.h"
 
 #define TERMINAL_UART        (&Uart0)
 #define SYSTEM_TIMER_TIMER   (&Timer5)
+#define AS5600_I2C           (&I2c0)
+#define AS5600_SAMPLE_TIMER  (&Timer6)
+#define BL8025_I2C           (&I2c0)
+#define LCD_SPI              (&Spi2)
+#define ANIMATION_TIMER      (&Timer3)
 
 extern UartStruct Uart0;
 extern UartStruct Uart1;
@@ -11,6 +17,10 @@ extern UartStruct Uart1;
 extern I2cStruct  I2c0;
 extern I2cStruct  I2c1;
 
+extern SpiStruct  Spi2;
+
 extern TimerStruct Timer0;
 extern TimerStruct Timer5;
+extern TimerStruct Timer6;
+extern TimerStruct Timer3;
 
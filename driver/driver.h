@@ -5,5 +5,11 @@
 #include "driver_rcc.h"
 #include "driver_uart.h"
 #include "driver_i2c.h"
+#include "driver_spi.h"
 #include "driver_timer.h"
+#include "driver_rtc.h"
+#include "driver_display.h"
+#include "driver_exmc.h"
+#include "driver_adc.h"
 
+#include "driver_dac.h"
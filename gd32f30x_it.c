@@ -162,6 +162,52 @@ void TIMER5_IRQHandler(void)
     }
 }
 
+/*!
+    \brief      this function handles TIMER6 interrupt request
+    \param[in]  none
+    \param[out] none
+    \retval     none
+*/
+void TIMER6_IRQHandler(void)
+{
+    if(timer_interrupt_flag_get(TIMER6, TIMER_INT_FLAG_UP) == SET)
+    {
+        timer_interrupt_flag_clear(TIMER6, TIMER_INT_FLAG_UP);
+        TimerUpdateCallback(&Timer6);
+    }
+}
+
+/*!
+    \brief      this function handles TIMER3 interrupt request
+    \param[in]  none
+    \param[out] none
+    \retval     none
+*/
+void TIMER3_IRQHandler(void)
+{
+    if(timer_interrupt_flag_get(TIMER3, TIMER_INT_FLAG_UP) == SET)
+    {
+        timer_interrupt_flag_clear(TIMER3, TIMER_INT_FLAG_UP);
+        TimerUpdateCallback(&Timer3);
+    }
+}
+
+/*!
+    \brief      this function handles RTC alarm interrupt request
+    \param[in]  none
+    \param[out] none
+    \retval     none
+*/
+void RTC_Alarm_IRQHandler(void)
+{
+    if(rtc_flag_get(RTC_FLAG_ALARM) == SET)
+    {
+        rtc_flag_clear(RTC_FLAG_ALARM);
+        exti_interrupt_flag_clear(EXTI_17);
+        RtcAlarmCallback();
+    }
+}
+
 /*!
     \brief      this function handles USART interrupt request
     \param[in]  none
@@ -238,6 +284,34 @@ void I2C1_ER_IRQHandler(void)
     I2cErrorCallback(&I2c1);
 }
 
+/*!
+    \brief      this function handles DMA0_Channel0_IRQHandler interrupt
+    \param[in]  none
+    \param[out] none
+    \retval     none
+*/
+void DMA0_Channel0_IRQHandler(void)
+{
+    if(dma_interrupt_flag_get(DMA0, DMA_CH0, DMA_INT_FLAG_FTF)) {
+        dma_interrupt_flag_clear(DMA0, DMA_CH0, DMA_INT_FLAG_G);
+        AdcDmaCompleteCallback();
+    }
+}
+
+/*!
+    \brief      this function handles DMA0_Channel1_IRQHandler interrupt
+    \param[in]  none
+    \param[out] none
+    \retval     none
+*/
+void DMA0_Channel1_IRQHandler(void)
+{
+    if(dma_interrupt_flag_get(DMA0, DMA_CH1, DMA_INT_FLAG_FTF)) {
+        dma_interrupt_flag_clear(DMA0, DMA_CH1, DMA_INT_FLAG_G);
+        DisplayFrameCompleteCallback();
+    }
+}
+
 /*!
     \brief      this function handles DMA0_Channel3_IRQHandler interrupt
     \param[in]  none
@@ -293,3 +367,49 @@ void DMA0_Channel6_IRQHandler(void)
         UartSendCompleteCallback(&Uart1);
     }
 }
+
+/*!
+    \brief      this function handles DMA1_Channel1_IRQHandler interrupt
+    \param[in]  none
+    \param[out] none
+    \retval     none
+*/
+void DMA1_Channel1_IRQHandler(void)
+{
+    if(dma_interrupt_flag_get(DMA1, DMA_CH1, DMA_INT_FLAG_FTF)) {
+        dma_interrupt_flag_clear(DMA1, DMA_CH1, DMA_INT_FLAG_G);
+        SpiSendCompleteCallback(&Spi2);
+    }
+}
+
+/*!
+    \brief      this function handles DMA1_Channel2_IRQHandler interrupt
+    \param[in]  none
+    \param[out] none
+    \retval     none
+*/
+void DMA1_Channel2_IRQHandler(void)
+{
+    if(dma_interrupt_flag_get(DMA1, DMA_CH2, DMA_INT_FLAG_HTF)) {
+        dma_interrupt_flag_clear(DMA1, DMA_CH2, DMA_INT_FLAG_HTF);
+        DacHalfCompleteCallback();
+    }
+    if(dma_interrupt_flag_get(DMA1, DMA_CH2, DMA_INT_FLAG_FTF)) {
+        dma_interrupt_flag_clear(DMA1, DMA_CH2, DMA_INT_FLAG_FTF);
+        DacFullCompleteCallback();
+    }
+}
+
+/*!
+    \brief      this function handles DMA1_Channel3_4_IRQHandler interrupt
+    \param[in]  none
+    \param[out] none
+    \retval     none
+*/
+void DMA1_Channel3_4_IRQHandler(void)
+{
+    if(dma_interrupt_flag_get(DMA1, DMA_CH3, DMA_INT_FLAG_FTF)) {
+        dma_interrupt_flag_clear(DMA1, DMA_CH3, DMA_INT_FLAG_G);
+        ExmcWriteCompleteCallback();
+    }
+}
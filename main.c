@@ -42,38 +42,50 @@ OF SUCH DAMAGE.
 #include "elog.h"
 #include "system_timer.h"
 #include "terminal_com.h"
+#include "calendar.h"
+#include "font.h"
+#include "animation.h"
+#include "rom_key_value.h"
+#include "alarm.h"
+#include "data_bus.h"
 
 #define USE_SHT30       // 温湿度计
 // #define USE_BL8025      // 时钟
 #define USE_BH1750      // 环境光传感器
 #define USE_OPT3001     // 环境光传感器
 // #define USE_AS5600      // 磁编码
+// #define USE_DISPLAY     // 数码管，段和位选占用PC0-PC11，只在64脚及以上的封装上有(GD32F303RC/VC)
+// #define USE_LCD         // SPI屏，占用PB3/PB5/PA15，需要关闭JTAG
+// #define USE_EXMC_LCD    // 并口屏，EXMC引脚只在100脚及以上的封装上有
+#define USE_SOUND       // 提示音，DAC0输出PA4
+
+#ifdef USE_AS5600
+#include "as5600.h"
+#endif
+#ifdef USE_BL8025
+#include "bl8025.h"
+#endif
+#ifdef USE_LCD
+#include "spi_lcd.h"
+#endif
+#ifdef USE_EXMC_LCD
+#include "exmc_lcd.h"
+#endif
+#ifdef USE_SOUND
+#include "sound.h"
+#endif
 
-#define ENCODER_ADDR        0x6C
-#define DIGITAL_CLOCK_ADDR  0x64
 #define TEMPERATURE_ADDR    0x88
 #define BH1750_ADDR         0x46
 #define OPT3001_ADDR        0x8A
 
 const float bh1750_sensitivity  = 1/1.2f/2;
 
-#define UINT8_BCD(value)    ((uint8_t)value>>4)*10 + (value&0x0f)
-
 __IO FlagStatus g_transfer_complete = RESET;
 uint8_t rx_dma_buffer[10];
 const uint8_t txbuffer[] = "\nUSART0 DMA transmit\n";
 const uint8_t txbuffer1[] = "\nUSART1 DMA transmit\n";
 
-#ifdef USE_AS5600
-uint8_t i2c_as5600_write_buf[] = {0x2C, 0x06};
-uint8_t i2c_as5600_read_buf[16];
-#endif // USE_AS5600
-
-#ifdef USE_BL8025
-uint8_t i2c_bl8025_write_buf[] = {0x00, 0x50, 0x59, 0x13, 0x10, 0x18, 0x01, 0x24};
-uint8_t i2c_bl8025_read_buf[7];
-#endif // USE_BL8025
-
 #ifdef USE_SHT30
 uint8_t i2c_sht30_init_buf[] = {0x27, 0x37}; // 每秒十次执行转换
 uint8_t i2c_sht30_write_buf[] = {0xe0, 0x00}; // 获取数据指令
@@ -92,23 +104,39 @@ uint8_t i2c_opt3001_read_buf[2];
 
 uint32_t system_freq;
 uint32_t temp;
-float degree;
 
-float temperature;
-float humidity;
+TimeZone local_zone = TIME_ZONE_CHINA;
 
-float illuminance;
-float illuminance_opt3001;
+#ifdef USE_DISPLAY
+typedef struct __DigitRoll
+{
+    uint8_t index;
+    uint8_t from;
+    uint8_t to;
+    int8_t anim;
+}DigitRoll;
+
+#define SCROLL_STEP_MS      200
+
+uint8_t display_segments[DISPLAY_DIGIT_NUM];
+uint8_t display_dirty = 0;
+uint8_t display_colon = 0;
+char display_chars[DISPLAY_DIGIT_NUM] = {' ', ' ', ' ', ' '};
+DigitRoll digit_roll[DISPLAY_DIGIT_NUM] = {{0, 0, 0, -1}, {1, 0, 0, -1}, {2, 0, 0, -1}, {3, 0, 0, -1}};
+
+char scroll_text[24];
+int8_t scroll_anim = -1;
+AnimKeyframe scroll_keys[2];
+
+const AnimKeyframe roll_keys[] = {
+    {0, 0, AnimEase_Linear},
+    {240, FONT_SEGMENT_ROLL_STEPS, AnimEase_OutQuad},
+};
+#endif
 
-struct {
-    uint8_t sec;
-    uint8_t min;
-    uint8_t hour;
-    uint8_t week;
-    uint8_t day;
-    uint8_t month;
-    uint16_t year;
-}clock_time;
+#ifdef USE_LCD
+char lcd_line[LCD_COLS + 1];
+#endif
 
 uint8_t debug_control_flag = 0;
 uint16_t send_time = 0;
@@ -129,7 +157,9 @@ static void restart_receive1(uint16_t data_len)
 {
     send_time1 ++;
     sprintf((char *)debug_buf1, "uart1 recv %d time\b\bs\n\r", send_time1);
+#ifndef ELOG_SINK_UART1_ENABLE
     UartSendDMA(&Uart1, debug_buf1, strlen((const char *)debug_buf1));
+#endif
     UartReceiveToIdleDMA(&Uart1, rx_dma_buffer, sizeof(rx_dma_buffer));
 }
 
@@ -159,12 +189,207 @@ static void print12_func(void)
 
 static void get_temp_func(void)
 {
-    elog_i("main", "temperature:%d degrees", temperature);
+    DataSample sample;
+
+    if(DataBusGet(DataTopic_Temperature, &sample) != 0)
+    {
+        elog_w("main", "no temperature yet");
+        return;
+    }
+    elog_i("main", "temperature:%.2f degrees, %ums ago", sample.value.f, (uint32_t)GetSystemTimer_ms() - sample.timestamp_ms);
 }
 
 static void get_humidity_func(void)
 {
-    elog_i("main", "humidity:%d%%", humidity);
+    DataSample sample;
+
+    if(DataBusGet(DataTopic_Humidity, &sample) != 0)
+    {
+        elog_w("main", "no humidity yet");
+        return;
+    }
+    elog_i("main", "humidity:%.1f%%, %ums ago", sample.value.f, (uint32_t)GetSystemTimer_ms() - sample.timestamp_ms);
+}
+
+#ifdef USE_DISPLAY
+/**
+ * @brief 环境光照度换算为显示亮度等级，人眼对亮度的感受接近对数，照度每翻一倍亮度加一档
+ *
+ */
+static uint8_t brightness_from_lux(float lux)
+{
+    uint32_t value = (uint32_t)lux;
+    uint8_t level = 16;
+
+    while(value > 0 && level < DISPLAY_BRIGHTNESS_MAX - 24)
+    {
+        value >>= 1;
+        level += 24;
+    }
+    return level;
+}
+
+/**
+ * @brief 光照度变化超过死区时调整亮度，渐变由DMA完成
+ *
+ */
+static void brightness_on_lux(DataTopic topic, const DataSample *sample, void *arg)
+{
+    DisplayFadeTo(brightness_from_lux(sample->value.f));
+}
+
+static void digit_roll_apply(int32_t step, void *arg)
+{
+    DigitRoll *roll = (DigitRoll *)arg;
+
+    display_segments[roll->index] = FontSegmentsRoll(roll->from, roll->to, (uint8_t)step);
+    display_dirty = 1;
+    // 最后一步说明动画已经结束，编号可能被别的动画重新使用
+    if(step == FONT_SEGMENT_ROLL_STEPS)
+        roll->anim = -1;
+}
+
+static void scroll_apply(int32_t pos, void *arg)
+{
+    const char *text = (const char *)arg;
+    uint8_t i;
+
+    for(i = 0; i < DISPLAY_DIGIT_NUM; i ++)
+        display_segments[i] = FontSegments(text[pos + i]);
+    display_dirty = 1;
+    if(pos == scroll_keys[1].value)
+        scroll_anim = -1;
+}
+
+/**
+ * @brief 显示时:分，变化的数字滚动切换
+ *
+ */
+static void display_show_time(const ClockTime *local)
+{
+    char digits[DISPLAY_DIGIT_NUM];
+    DigitRoll *roll;
+    uint8_t i;
+
+    digits[0] = '0' + local->hour / 10;
+    digits[1] = '0' + local->hour % 10;
+    digits[2] = '0' + local->min / 10;
+    digits[3] = '0' + local->min % 10;
+
+    for(i = 0; i < DISPLAY_DIGIT_NUM; i ++)
+    {
+        if(digits[i] == display_chars[i])
+            continue;
+
+        roll = &digit_roll[i];
+        AnimationStop(roll->anim);
+        roll->anim = -1;
+        roll->index = i;
+        roll->from = FontSegments(display_chars[i]);
+        roll->to = FontSegments(digits[i]);
+        roll->anim = AnimationStart(roll_keys, 2, 0, &digit_roll_apply, roll);
+        if(roll->anim < 0)
+            digit_roll_apply(FONT_SEGMENT_ROLL_STEPS, roll);
+        display_chars[i] = digits[i];
+    }
+}
+
+/**
+ * @brief 从右向左滚动一行文字，滚完后时间从空白处滚入
+ *
+ */
+static void display_scroll(const char *text)
+{
+    uint8_t len;
+    uint8_t i;
+
+    for(i = 0; i < DISPLAY_DIGIT_NUM; i ++)
+    {
+        AnimationStop(digit_roll[i].anim);
+        digit_roll[i].anim = -1;
+        display_chars[i] = ' ';
+    }
+
+    // 前后各补一屏空白
+    len = (uint8_t)sprintf(scroll_text, "    %.14s    ", text);
+    scroll_keys[0].time_ms = 0;
+    scroll_keys[0].value = 0;
+    scroll_keys[0].ease = AnimEase_Linear;
+    scroll_keys[1].time_ms = (len - DISPLAY_DIGIT_NUM) * SCROLL_STEP_MS;
+    scroll_keys[1].value = len - DISPLAY_DIGIT_NUM;
+    scroll_keys[1].ease = AnimEase_Linear;
+    scroll_anim = AnimationStart(scroll_keys, 2, 0, &scroll_apply, scroll_text);
+}
+
+/**
+ * @brief 有变化时把段码交给数码管，滚动文字时不显示冒号
+ *
+ */
+static void display_flush(void)
+{
+    uint8_t frame[DISPLAY_DIGIT_NUM];
+
+    if(display_dirty == 0)
+        return;
+
+    memcpy(frame, display_segments, sizeof(frame));
+    if(display_colon == 1 && AnimationIsRunning(scroll_anim) == 0)
+        frame[1] |= FontSegments(':');
+    if(DisplaySetFrame(frame) == 0 && DisplaySwap() == 0)
+        display_dirty = 0;
+}
+
+static void disp_stat_func(void)
+{
+    DisplayStat stat;
+
+    // 打印上一次的测量结果，并开始新一轮测量
+    DisplayGetStat(&stat);
+    elog_i("disp", "line %uus, refresh %uHz, swaps %u, brightness %u", DISPLAY_LINE_PERIOD_US, DISPLAY_REFRESH_HZ,
+        stat.swaps, DisplayGetBrightness());
+    if(stat.measured_frames != 0)
+    {
+        elog_i("disp", "%u frames, period %u-%u us", stat.measured_frames,
+            stat.frame_cycles_min / (SystemCoreClock / 1000000), stat.frame_cycles_max / (SystemCoreClock / 1000000));
+    }
+    DisplayMeasureStart();
+}
+#endif
+
+static void adc_info_func(void)
+{
+    AdcReading reading;
+
+    if(AdcGetReading(&reading) != 0)
+    {
+        elog_w("adc", "no sample yet");
+        return;
+    }
+    elog_i("adc", "seq %u, vdda %umV, vin %umV, spare %umV %umV, chip %d.%d degrees", reading.sequence,
+        reading.vdda_mv, reading.vin_mv, reading.spare_mv[0], reading.spare_mv[1],
+        reading.temperature / 10, (reading.temperature < 0 ? -reading.temperature : reading.temperature) % 10);
+}
+
+static void alarm_ring(uint8_t id, const Alarm *alarm)
+{
+    elog_i("alarm", "alarm %u ring", id);
+#ifdef USE_SOUND
+    SoundPlayChime();
+#endif
+}
+
+static void rtc_info_func(void)
+{
+    RtcSyncInfo info;
+    ClockTime local;
+    uint32_t now = RtcNow();
+
+    RtcGetSyncInfo(&info);
+    CalendarFromSeconds(CalendarToLocal(&local_zone, now), &local);
+    elog_i("rtc", "%04d-%02d-%02d %02d:%02d:%02d week %d", local.year, local.month, local.day,
+        local.hour, local.min, local.sec, local.week);
+    elog_i("rtc", "now %u, last sync %u from %d, calibration %d ppb, %s", now, info.last_sync_sec, info.source,
+        info.calibration_ppb, info.lxtal ? "LXTAL" : "IRC40K");
 }
 
 
@@ -176,8 +401,13 @@ static void get_humidity_func(void)
 */
 int main(void)
 {
+#ifndef ELOG_SINK_UART1_ENABLE
     UartInitStruct uart_init;
+#endif
     I2cInitStruct i2c_init;
+#ifdef USE_LCD
+    SpiInitStruct spi_init;
+#endif
     uint8_t rd_wr_addr = 0;
     
     // LED PB12
@@ -185,27 +415,36 @@ int main(void)
     gpio_init(GPIOB, GPIO_MODE_OUT_PP, GPIO_OSPEED_50MHZ,GPIO_PIN_12);
     gpio_bit_reset(GPIOB, GPIO_PIN_12);
     
-    uart_init.baudrate = 115200;
-    uart_init.parity = ParityNone;
-    uart_init.stop_bit = StopBit_1Bit;
-    uart_init.word_length = WordLen_8Bit;
-    
     SystemTimerInit();
 
     elog();
     TerminalComInit();
     
+    // UART1做日志输出时由elog初始化，发送也归它
+#ifndef ELOG_SINK_UART1_ENABLE
+    uart_init.baudrate = 115200;
+    uart_init.parity = ParityNone;
+    uart_init.stop_bit = StopBit_1Bit;
+    uart_init.word_length = WordLen_8Bit;
     UartInit(&Uart1, &uart_init);
     UartSendCallbackRegister(&Uart1, &updateflag1);
+#endif
     UartRecvCallbackRegister(&Uart1, &restart_receive1);
 
+#ifndef ELOG_SINK_UART1_ENABLE
     UartSendDMA(&Uart1, txbuffer1, sizeof(txbuffer1));
+#endif
     UartReceiveToIdleDMA(&Uart1, rx_dma_buffer, sizeof(rx_dma_buffer));
     
-    i2c_init.speed = 100000;
+    i2c_init.speed = 400000;
     i2c_init.local_addr = 0x47;
     I2cInit(&I2c0, &i2c_init);
 
+#ifdef USE_LCD
+    spi_init.speed = 30000000;
+    SpiInit(LCD_SPI, &spi_init);
+#endif
+
     TerminalCommandRegister("command_test", &command_test_func);
     TerminalCommandRegister("print", &print_func);
     TerminalCommandRegister("print1", &print1_func);
@@ -213,18 +452,77 @@ int main(void)
     TerminalCommandRegister("print12", &print12_func);
     TerminalCommandRegister("get_temperature", &get_temp_func);
     TerminalCommandRegister("get_humidity", &get_humidity_func);
+    TerminalCommandRegister("rtc_info", &rtc_info_func);
+    TerminalCommandRegister("adc_info", &adc_info_func);
+    DataBusInit();
+    CalendarInit();
+    FontInit();
+    AnimationInit();
+#ifdef USE_DISPLAY
+    TerminalCommandRegister("disp_stat", &disp_stat_func);
+#endif
     
 //  GetSystemClock(&system_freq);
 //  while(SetSystemClock(96000000));
 //  GetSystemClock(&system_freq);
 
+#ifdef USE_AS5600
+    // 旋钮1kHz采样，在I2C中断里完成处理
+    As5600Init();
+#endif
+
+#ifdef USE_DISPLAY
+    // 数码管由TIMER0触发DMA扫描，不占用CPU
+    DisplayInit();
+#ifdef USE_BH1750
+    // 亮度跟随环境光，光照变化超过2lux且距上次调整1s以上才改变
+    DataBusSubscribe(DataTopic_Illuminance, 2.0f, 1000, &brightness_on_lux, NULL);
+#endif
+#endif
+
+#ifdef USE_LCD
+    // 屏幕只发送有变化的字符格，发送由DMA完成
+    LcdInit();
+#endif
+
+#ifdef USE_EXMC_LCD
+    // 并口屏，像素由DMA写入
+    ExmcLcdInit();
+#endif
+
+    // 供电电压、芯片温度等模拟量由定时器触发采样，硬件过采样，DMA搬运
+    AdcInit();
+
+#ifdef USE_SOUND
+    // 提示音在DMA中断里混音，不播放时DAC和定时器停止
+    SoundInit();
+#endif
+
+    rom_key_value_init();
+
+    // 内部RTC在备份域供电下复位不丢时间，没有外部时钟芯片时也能计时
+    if(RtcInit() != 0)
+    {
+        // RTC没有时钟，设置时间和闹钟都会卡在等待写完成上，跳过依赖RTC的初始化
+        elog_e("rtc", "LXTAL and IRC40K failed, time and alarms disabled");
+    }
+    else
+    {
+        RtcSyncInfo info;
+
+        RtcGetSyncInfo(&info);
+        if(info.lxtal == 0)
+            elog_w("rtc", "LXTAL failed, running on IRC40K, time is lost on reset");
+
 #ifdef USE_BL8025
-    // 初始化电子钟
-    while(I2cWrite(&I2c0, DIGITAL_CLOCK_ADDR, i2c_bl8025_write_buf, sizeof(i2c_bl8025_write_buf)) != 0);
-    while(I2cWrite(&I2c0, DIGITAL_CLOCK_ADDR, &rd_wr_addr, sizeof(rd_wr_addr)) != 0);
-    while(I2cRead(&I2c0, DIGITAL_CLOCK_ADDR, i2c_bl8025_read_buf, sizeof(i2c_bl8025_read_buf)) != 0);
+        // 初始化电子钟，对时成功后按芯片设置内部RTC，之后定期对时并校准RTC的晶振
+        Bl8025Init();
 #endif
-    
+
+        // 闹钟保存在内部闪存里，只把最近的一个设置到RTC闹钟上
+        AlarmInit(&local_zone, &alarm_ring);
+    }
+
 #ifdef USE_SHT30
     // 初始化温度计
     while(I2cWrite(&I2c0, TEMPERATURE_ADDR, i2c_sht30_init_buf, sizeof(i2c_sht30_init_buf)) != 0);
@@ -250,11 +548,47 @@ int main(void)
         {
             terminal_output();
         }
+        // 串口空闲时启动日志发送，之后由发送完成中断接着发送
+        elog_flush();
+#ifdef ELOG_REPEAT_SUPPRESS_ENABLE
+        // 停下来的重复日志过一段时间报告次数，不用等下一条不同的日志
+        elog_repeat_flush();
+#endif
+#ifdef ELOG_FLASH_ENABLE
+        // 日志写进flash，每次只编程几个字
+        elog_flash_process();
+#endif
+
+#ifdef USE_BL8025
+        Bl8025Process();
+#endif
+
+#ifdef USE_LCD
+        LcdProcess();
+#endif
+
+        AlarmProcess();
+
+        DataBusProcess();
+
+        AnimationProcess();
+#ifdef USE_DISPLAY
+        display_flush();
+#endif
+
+#ifdef USE_AS5600
+        {
+            KnobEvent knob_event;
+            while(As5600GetEvent(&knob_event) == 0)
+            {
+                elog_d("knob", "event %d detent %d velocity %d", knob_event.type, knob_event.detent, knob_event.velocity);
+            }
+        }
+#endif
 
         if(time - last_flush_time > 500000)
         {
             last_flush_time = time;
-            elog_flush();		// 500ms调用一次即可
             if(led == 0)
             {
                 led = 1;
@@ -266,26 +600,55 @@ int main(void)
                 gpio_bit_reset(GPIOB, GPIO_PIN_12);
             }
             
-#ifdef USE_AS5600
-            while(I2cWrite(&I2c0, ENCODER_ADDR, &rd_wr_addr, sizeof(rd_wr_addr)) != 0);
-            while(I2cRead(&I2c0, ENCODER_ADDR, i2c_as5600_read_buf, sizeof(i2c_as5600_read_buf)) != 0);
-            while(I2c0.read_info.reading == 1);
-            temp = i2c_as5600_read_buf[14]<<8|i2c_as5600_read_buf[15];
-            degree = temp*360.f/4096;
+#ifdef USE_DISPLAY
+            // 显示时:分，冒号随LED闪烁，每分钟的第30秒滚动显示温度
+            {
+                ClockTime local;
+                CalendarFromSeconds(CalendarToLocal(&local_zone, RtcNow()), &local);
+                display_colon = led;
+                display_dirty = 1;
+                if(AnimationIsRunning(scroll_anim) == 0)
+                {
+                    DataSample sample;
+                    if(local.sec == 30 && DataBusGet(DataTopic_Temperature, &sample) == 0)
+                    {
+                        char text[16];
+                        sprintf(text, "%.1f\x7f" "C", sample.value.f);
+                        display_scroll(text);
+                    }
+                    else
+                    {
+                        display_show_time(&local);
+                    }
+                }
+            }
 #endif
 
-#ifdef USE_BL8025
-            // 读取电子钟数据
-            rd_wr_addr = 0;
-            while(I2cWrite(&I2c0, DIGITAL_CLOCK_ADDR, &rd_wr_addr, 1) != 0);
-            while(I2cRead(&I2c0, DIGITAL_CLOCK_ADDR, i2c_bl8025_read_buf, sizeof(i2c_bl8025_read_buf)) != 0);
-            clock_time.sec = UINT8_BCD(i2c_bl8025_read_buf[0]);
-            clock_time.min = UINT8_BCD(i2c_bl8025_read_buf[1]);
-            clock_time.hour = UINT8_BCD(i2c_bl8025_read_buf[2]);
-            clock_time.week = UINT8_BCD(i2c_bl8025_read_buf[3]);
-            clock_time.day = UINT8_BCD(i2c_bl8025_read_buf[4]);
-            clock_time.month = UINT8_BCD(i2c_bl8025_read_buf[5]);
-            clock_time.year = UINT8_BCD(i2c_bl8025_read_buf[6]);
+#ifdef USE_LCD
+            // 时间和温湿度，内容没变的字符不会重新发送
+            {
+                ClockTime local;
+                DataSample temperature;
+                DataSample humidity;
+                CalendarFromSeconds(CalendarToLocal(&local_zone, RtcNow()), &local);
+                sprintf(lcd_line, "%02d:%02d:%02d", local.hour, local.min, local.sec);
+                LcdDrawText(0, 0, lcd_line, FONT_COLOR_WHITE, FONT_COLOR_BLACK);
+                if(DataBusGet(DataTopic_Temperature, &temperature) == 0 && DataBusGet(DataTopic_Humidity, &humidity) == 0)
+                {
+                    sprintf(lcd_line, "%5.1f\x7f" "C %3d%%", temperature.value.f, (int)humidity.value.f);
+                    LcdDrawText(0, 1, lcd_line, FONT_COLOR_WHITE, FONT_COLOR_BLACK);
+                }
+            }
+#endif
+
+#ifdef USE_EXMC_LCD
+            {
+                char text[16];
+                ClockTime local;
+                CalendarFromSeconds(CalendarToLocal(&local_zone, RtcNow()), &local);
+                sprintf(text, "%02d:%02d:%02d", local.hour, local.min, local.sec);
+                ExmcLcdDrawText(0, 0, text, FONT_COLOR_WHITE, FONT_COLOR_BLACK);
+            }
 #endif
 
 #ifdef USE_SHT30
@@ -293,16 +656,16 @@ int main(void)
             while(I2cWrite(&I2c0, TEMPERATURE_ADDR, i2c_sht30_write_buf, sizeof(i2c_sht30_write_buf)) != 0);
             while(I2cRead(&I2c0, TEMPERATURE_ADDR, i2c_sht30_read_buf, sizeof(i2c_sht30_read_buf)) != 0);
             temp = i2c_sht30_read_buf[0] << 8 | i2c_sht30_read_buf[1];
-            temperature = 175.f*temp/0xffff - 45;
+            DataBusPublishFloat(DataTopic_Temperature, 175.f*temp/0xffff - 45);
             temp = i2c_sht30_read_buf[3] << 8 | i2c_sht30_read_buf[4];
-            humidity = (float)temp/0xffff * 100;
+            DataBusPublishFloat(DataTopic_Humidity, (float)temp/0xffff * 100);
 #endif
             
 #ifdef USE_BH1750
             // 读取光照度数据
             while(I2cRead(&I2c0, BH1750_ADDR, i2c_bh1750_rd_buf, sizeof(i2c_bh1750_rd_buf)) != 0);
             temp = i2c_bh1750_rd_buf[0] << 8 | i2c_bh1750_rd_buf[1];
-            illuminance = temp * bh1750_sensitivity;
+            DataBusPublishFloat(DataTopic_Illuminance, temp * bh1750_sensitivity);
 #endif
 
 #ifdef USE_OPT3001
@@ -312,8 +675,18 @@ int main(void)
             while(I2cRead(&I2c0, OPT3001_ADDR, i2c_opt3001_read_buf, sizeof(i2c_opt3001_read_buf)) != 0);
             uint8_t exp = i2c_opt3001_read_buf[0] >> 4;
             temp = ((i2c_opt3001_read_buf[0] & 0x0f) << 8) | i2c_opt3001_read_buf[1];
-            illuminance_opt3001 = (float)(temp << exp) * 0.01f;
+            DataBusPublishFloat(DataTopic_IlluminanceOpt3001, (float)(temp << exp) * 0.01f);
 #endif
+
+            // 供电电压和芯片温度，ADC由硬件定时采样，这里只取最新一组
+            {
+                AdcReading reading;
+                if(AdcGetReading(&reading) == 0)
+                {
+                    DataBusPublishInt(DataTopic_SupplyVoltage, reading.vin_mv);
+                    DataBusPublishInt(DataTopic_ChipTemperature, reading.temperature);
+                }
+            }
         }
         
     }
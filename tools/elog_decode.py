@@ -0,0 +1,271 @@
+#!/usr/bin/env python3
+"""easy_log 二进制日志和压缩日志解码
+
+固件里的 elog_bin_x 只输出调用点编号、时间戳和 32 位参数，这里根据固件镜像
+找回调用点的 tag 和格式字符串，还原成和文本日志一样的行。二进制记录以 0xFF 开头，
+其余字节按文本原样输出，所以文本日志和二进制日志可以混在一个串口流里。
+终端串口默认发送文本，打开 ELOG_CONSOLE_BIN_ENABLE 或者用 log_sink uart0 bin|lz 切换后才有二进制记录。
+
+记录格式（小端）：
+    0xFF, level << 4 | nargs, site id (u16), timestamp us (u32), args (u32 * nargs)
+调用点描述 ElogBinSite 的地址为 ELOG_BIN_SITE_BASE + site id * 4：
+    const char *tag; const char *fmt; uint16_t line; uint8_t level; uint8_t reserved;
+
+打开 ELOG_LZ_OUTPUT_ENABLE 后日志以 LZ 帧发送，加 --lz 先解压（帧外的终端回显原样输出）：
+    0xFE, length (u16, bit 15: 历史清空), 控制字节和 8 个 token 为一组
+    bit n 为 1 时 token n 是匹配：(distance - 1) 低 8 位, (distance - 1) >> 8 << 6 | (length - 3)
+    否则是 1 字节原文
+
+用法：
+    python3 tools/elog_decode.py -i Objects/digital_clock.axf log.bin
+    python3 tools/elog_decode.py --lz log.bin
+    stty -F /dev/ttyUSB0 115200 raw && python3 tools/elog_decode.py -i digital_clock.axf /dev/ttyUSB0
+    python3 tools/elog_decode.py -i digital_clock.bin --base 0x08000000 log.bin
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+SITE_BASE = 0x08000000
+SYNC = 0xFF
+MAX_ARGS = 8
+LEVEL_NAME = "AEWIDV"
+HEADER_SIZE = 8
+FRAME_SYNC = 0xFE
+FRAME_RESET = 0x8000
+WINDOW_SIZE = 1024
+
+CONVERSION = re.compile(r"%([-+ #0]*\d*(?:\.\d+)?)(hh|h|ll|l|z|t|j)?([diouxXcsfFeEgGp%])")
+
+
+class Image:
+    """固件镜像，按地址读取 flash 里的常量"""
+
+    def __init__(self, path, base):
+        with open(path, "rb") as f:
+            data = f.read()
+        if data[:4] == b"\x7fELF":
+            self.segments = self._load_elf(data)
+        else:
+            self.segments = [(base, data)]
+
+    @staticmethod
+    def _load_elf(data):
+        if data[4] != 1 or data[5] != 1:
+            raise ValueError("only 32 bit little endian ELF is supported")
+        phoff, = struct.unpack_from("<I", data, 28)
+        phentsize, phnum = struct.unpack_from("<HH", data, 42)
+        segments = []
+        for i in range(phnum):
+            p_type, p_offset, _, p_paddr, p_filesz = struct.unpack_from("<IIIII", data, phoff + i * phentsize)
+            # 常量在加载地址上，用物理地址而不是运行地址
+            if p_type == 1 and p_filesz > 0:
+                segments.append((p_paddr, data[p_offset:p_offset + p_filesz]))
+        return segments
+
+    def read(self, addr, size):
+        for start, blob in self.segments:
+            if start <= addr and addr + size <= start + len(blob):
+                return blob[addr - start:addr - start + size]
+        return None
+
+    def string(self, addr, limit=256):
+        for start, blob in self.segments:
+            if start <= addr < start + len(blob):
+                offset = addr - start
+                end = blob.find(b"\0", offset, offset + limit)
+                if end < 0:
+                    end = min(offset + limit, len(blob))
+                return blob[offset:end].decode("utf-8", "replace")
+        return None
+
+
+class Inflater:
+    """LZ 帧解压，帧外的字节原样输出，收到第一个清空历史的帧之前的帧无法解出"""
+
+    def __init__(self):
+        self.pending = bytearray()
+        self.history = bytearray()
+        self.synced = False
+
+    def feed(self, data):
+        self.pending += data
+        buf = self.pending
+        out = bytearray()
+        pos = 0
+        while pos < len(buf):
+            sync = buf.find(bytes([FRAME_SYNC]), pos)
+            if sync < 0:
+                out += buf[pos:]
+                pos = len(buf)
+                break
+            out += buf[pos:sync]
+            pos = sync
+            if len(buf) - pos < 3:
+                break
+            header, = struct.unpack_from("<H", buf, pos + 1)
+            size = header & ~FRAME_RESET
+            if len(buf) - pos - 3 < size:
+                break
+            payload = bytes(buf[pos + 3:pos + 3 + size])
+            pos += 3 + size
+            if header & FRAME_RESET:
+                self.history = bytearray()
+                self.synced = True
+            if self.synced:
+                out += self.expand(payload)
+        del self.pending[:pos]
+        return bytes(out)
+
+    def expand(self, payload):
+        history = self.history
+        start = len(history)
+        pos = 0
+        while pos < len(payload):
+            control = payload[pos]
+            pos += 1
+            for bit in range(8):
+                if pos >= len(payload):
+                    break
+                if control >> bit & 1:
+                    distance = (payload[pos] | (payload[pos + 1] >> 6) << 8) + 1
+                    length = (payload[pos + 1] & 0x3F) + 3
+                    pos += 2
+                    for _ in range(length):
+                        history.append(history[-distance])
+                else:
+                    history.append(payload[pos])
+                    pos += 1
+        out = bytes(history[start:])
+        del history[:-WINDOW_SIZE]
+        return out
+
+
+class Decoder:
+    def __init__(self, image, site_base, out):
+        self.image = image
+        self.site_base = site_base
+        self.out = out
+        self.sites = {}
+        self.pending = bytearray()
+        self.last_timestamp = None
+        self.timestamp_high = 0
+
+    def site(self, site_id):
+        if site_id not in self.sites:
+            raw = self.image.read(self.site_base + site_id * 4, 12) if self.image else None
+            if raw is None:
+                self.sites[site_id] = None
+            else:
+                tag_addr, fmt_addr, line, level = struct.unpack("<IIHB", raw[:11])
+                tag = self.image.string(tag_addr)
+                fmt = self.image.string(fmt_addr)
+                self.sites[site_id] = (tag, fmt, line, level) if fmt is not None else None
+        return self.sites[site_id]
+
+    def unwrap(self, timestamp):
+        # 固件只发送 32 位 us，约 71 分钟回绕一次
+        if self.last_timestamp is not None and timestamp < self.last_timestamp:
+            self.timestamp_high += 1 << 32
+        self.last_timestamp = timestamp
+        return (self.timestamp_high + timestamp) / 1000000.0
+
+    def format(self, fmt, args):
+        args = list(args)
+
+        def convert(match):
+            flags, _, conv = match.groups()
+            if conv == "%":
+                return "%"
+            if not args:
+                return match.group(0)
+            value = args.pop(0)
+            if conv in "di":
+                value = struct.unpack("<i", struct.pack("<I", value))[0]
+            elif conv in "fFeEgG":
+                value = struct.unpack("<f", struct.pack("<I", value))[0]
+            elif conv == "c":
+                value = chr(value & 0xFF)
+            elif conv == "s":
+                text = self.image.string(value)
+                value = text if text is not None else "<ram 0x%08x>" % value
+            elif conv == "p":
+                return "0x%08x" % value
+            return ("%" + flags + conv) % value
+
+        return CONVERSION.sub(convert, fmt)
+
+    def feed(self, data):
+        self.pending += data
+        buf = self.pending
+        pos = 0
+        while pos < len(buf):
+            sync = buf.find(bytes([SYNC]), pos)
+            if sync < 0:
+                self.text(buf[pos:])
+                pos = len(buf)
+                break
+            self.text(buf[pos:sync])
+            pos = sync
+            if len(buf) - pos < 2:
+                break
+            level, nargs = buf[pos + 1] >> 4, buf[pos + 1] & 0x0F
+            if level >= len(LEVEL_NAME) or nargs > MAX_ARGS:
+                # 不是记录头，当作文本里的坏字节
+                self.text(buf[pos:pos + 1])
+                pos += 1
+                continue
+            size = HEADER_SIZE + nargs * 4
+            if len(buf) - pos < size:
+                break
+            site_id, timestamp = struct.unpack_from("<HI", buf, pos + 2)
+            args = struct.unpack_from("<%dI" % nargs, buf, pos + HEADER_SIZE)
+            self.record(level, site_id, timestamp, args)
+            pos += size
+        del self.pending[:pos]
+
+    def record(self, level, site_id, timestamp, args):
+        time = self.unwrap(timestamp)
+        site = self.site(site_id)
+        if site is None:
+            self.out.write("%s/? [%8.3f] <unknown site %d> %s\n" % (LEVEL_NAME[level], time, site_id,
+                           " ".join("0x%08x" % a for a in args)))
+            return
+        tag, fmt, _, _ = site
+        self.out.write("%s/%s [%8.3f] %s\n" % (LEVEL_NAME[level], tag, time, self.format(fmt, args)))
+
+    def text(self, data):
+        if data:
+            self.out.write(bytes(data).decode("utf-8", "replace"))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="decode easy_log binary records")
+    parser.add_argument("-i", "--image", help="firmware image, .axf/.elf or raw .bin, needed by binary logs")
+    parser.add_argument("--base", type=lambda x: int(x, 0), default=SITE_BASE,
+                        help="load address of a raw .bin image and ELOG_BIN_SITE_BASE (default 0x08000000)")
+    parser.add_argument("--lz", action="store_true", help="expand LZ frames (ELOG_LZ_OUTPUT_ENABLE)")
+    parser.add_argument("log", nargs="?", default="-", help="captured log or serial device, - for stdin")
+    args = parser.parse_args()
+
+    decoder = Decoder(Image(args.image, args.base) if args.image else None, args.base, sys.stdout)
+    inflater = Inflater() if args.lz else None
+    stream = sys.stdin.buffer if args.log == "-" else open(args.log, "rb", buffering=0)
+    try:
+        while True:
+            data = stream.read(4096)
+            if not data:
+                break
+            decoder.feed(inflater.feed(data) if inflater else data)
+            sys.stdout.flush()
+    except KeyboardInterrupt:
+        pass
+    finally:
+        if stream is not sys.stdin.buffer:
+            stream.close()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,108 @@
+/*
+ * 在主机上比较 elog_vsnprintf 和 C 库 vsnprintf 的输出和速度
+ *
+ * gcc -O2 -Icommon/easy_log tools/elog_fmt_bench.c common/easy_log/elog_fmt.c -o elog_fmt_bench
+ * ./elog_fmt_bench [rounds]
+ *
+ * 先逐条核对输出是否一致，再用固件里常见的几种日志行测量每条的平均耗时。
+ * 主机的 vsnprintf 比 ARMCC MicroLIB 快得多，目标上的差距要用 elog_bench 命令看。
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "elog.h"
+
+#define LINE_SIZE   256
+
+typedef int (*FormatFunc)(char *buf, size_t size, const char *format, va_list args);
+
+static int check_failed = 0;
+
+static int format_with(FormatFunc func, char *buf, size_t size, const char *format, ...) {
+    va_list args;
+    int result;
+
+    va_start(args, format);
+    result = func(buf, size, format, args);
+    va_end(args);
+
+    return result;
+}
+
+#define CHECK(size, ...) check_one(__LINE__, size, \
+    format_with(elog_vsnprintf, elog_buf, size, __VA_ARGS__), \
+    format_with(vsnprintf, libc_buf, size, __VA_ARGS__))
+
+static char elog_buf[LINE_SIZE];
+static char libc_buf[LINE_SIZE];
+
+static void check_one(int line, size_t size, int elog_len, int libc_len) {
+    if (elog_len != libc_len || memcmp(elog_buf, libc_buf, size < LINE_SIZE ? size : LINE_SIZE) != 0) {
+        printf("line %d: elog \"%s\" (%d), libc \"%s\" (%d)\n", line, elog_buf, elog_len, libc_buf, libc_len);
+        check_failed++;
+    }
+}
+
+static void check_all(void) {
+    CHECK(LINE_SIZE, "plain text");
+    CHECK(LINE_SIZE, "%d %i %u %x %X %o %%", -123, 456, 4000000000u, 0xbeef, 0xbeef, 8);
+    CHECK(LINE_SIZE, "[%5d] [%-5d] [%05d] [%+d] [% d] [%.3d] [%8.3d]", 42, 42, -42, 42, 42, 7, -7);
+    CHECK(LINE_SIZE, "%02d:%02d:%02d %04d-%02u-%02x", 3, 4, 5, 2024, 9u, 0xau);
+    CHECK(LINE_SIZE, "%ld %lu %lld %llu %zu", -1L, 123456UL, -9000000000LL, 18000000000000000000ULL, (size_t)77);
+    CHECK(LINE_SIZE, "%hd %hu %hhd %hhu", 70000, 70000, 300, 300);
+    CHECK(LINE_SIZE, "%s|%10s|%-10s|%.3s|%*s|%-*s|", "str", "right", "left", "truncate", 6, "w", 6, "w");
+    CHECK(LINE_SIZE, "%c%c%3c%-3c|", 'a', 'b', 'c', 'd');
+    CHECK(LINE_SIZE, "%.2f %.1f %f %.0f %.3f", 23.456f, -0.05f, 3.14159265, 2.7, 0.0006);
+    CHECK(LINE_SIZE, "%8.2f|%-8.2f|%08.2f|%+.2f|%.2f", 1.5, 1.5, -1.5, 1.5, 99.999);
+    CHECK(LINE_SIZE, "%.9f %.4f", 0.123456789, 65535.99995);
+    CHECK(8, "truncated %d", 123456);
+    CHECK(1, "empty %s", "x");
+    CHECK(LINE_SIZE, "%4u.%03u", 12u, 7u);
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static double bench(FormatFunc func, long rounds) {
+    volatile int sink = 0;
+    double start = now_ns();
+    long i;
+
+    for (i = 0; i < rounds; i++) {
+        sink += format_with(func, elog_buf, LINE_SIZE, "temperature: %.2f, humidity: %.1f", 23.45f + (i & 7), 56.7f);
+        sink += format_with(func, elog_buf, LINE_SIZE, "%04d-%02d-%02d %02d:%02d:%02d", 2024, 9, 1, 12, 34, (int)(i % 60));
+        sink += format_with(func, elog_buf, LINE_SIZE, "published %u, delivered %u, filtered %u, deferred %u",
+            (unsigned)i, 1234u, 56u, 7u);
+        sink += format_with(func, elog_buf, LINE_SIZE, "%s: %d at %ums, seq %u", "vin_mv", 3300, (unsigned)i, 42u);
+    }
+    (void)sink;
+
+    return (now_ns() - start) / (rounds * 4);
+}
+
+int main(int argc, char *argv[]) {
+    long rounds = argc > 1 ? atol(argv[1]) : 1000000;
+    double elog_ns, libc_ns;
+
+    check_all();
+    if (check_failed != 0) {
+        printf("%d mismatches\n", check_failed);
+        return 1;
+    }
+    printf("output matches vsnprintf\n");
+
+    libc_ns = bench(vsnprintf, rounds);
+    elog_ns = bench(elog_vsnprintf, rounds);
+    printf("vsnprintf      %7.1f ns/line\n", libc_ns);
+    printf("elog_vsnprintf %7.1f ns/line (%.2fx)\n", elog_ns, libc_ns / elog_ns);
+
+    return 0;
+}
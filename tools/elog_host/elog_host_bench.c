@@ -0,0 +1,291 @@
+/*
+ * 在主机上编译整个 easy_log，测量每条日志的耗时和输出字节数，作为日志优化前后对比的基准
+ *
+ * cd tools/elog_host && make && ./elog_host_bench [lines] [-a]
+ *
+ * 配置用的是固件的 elog_cfg.h，移植层换成 elog_port_host.c：输出只计字节数，时间是模拟的。
+ * 分别测直接输出和 buffer 模式、颜色开关、各种 ELOG_FMT_* 组合（-a 测全部 256 种），
+ * 再测被过滤、合并和限速的调用。buffer 模式只计日志调用本身，每批之间取走缓存的时间不算。
+ * x86 上同时给出 TSC 计数，它按固定频率走，和核心周期不完全一样；其它架构只给纳秒。
+ * 主机比 Cortex-M4 快得多，这里看的是相对变化，目标上的绝对耗时用 elog_bench 命令看。
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC    1
+#else
+#define HAVE_TSC    0
+#endif
+
+#include "elog.h"
+#include "elog_port_host.h"
+
+/* 一批日志要能全部放进 elog_port_host.c 的终端缓存 */
+#define BATCH_LINES     256
+#define WARMUP_LINES    16
+/* 每条日志之间模拟时间前进的微秒数 */
+#define LINE_PERIOD_US  1000
+/* 每行测几遍取最快的一遍，减少主机调度的干扰 */
+#define BENCH_ROUNDS    3
+
+typedef void (*LogFunc)(uint32_t index);
+
+typedef struct {
+    double ns;
+    double tsc;
+    double bytes;
+} BenchResult;
+
+/* 不加 -a 时测的格式，tag|time 是 main.c 里设置的 */
+static const size_t fmt_list[] = {
+    0,
+    ELOG_FMT_LVL,
+    ELOG_FMT_TAG,
+    ELOG_FMT_TAG | ELOG_FMT_TIME,
+    ELOG_FMT_LVL | ELOG_FMT_TAG | ELOG_FMT_TIME,
+    ELOG_FMT_LVL | ELOG_FMT_TAG | ELOG_FMT_TIME | ELOG_FMT_LINE,
+    ELOG_FMT_LVL | ELOG_FMT_TAG | ELOG_FMT_TIME | ELOG_FMT_FUNC | ELOG_FMT_LINE,
+    ELOG_FMT_ALL,
+};
+
+static const char *const fmt_flag_name[] = { "lvl", "tag", "time", "p", "t", "dir", "func", "line" };
+
+static double now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static uint64_t now_tsc(void) {
+#if HAVE_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+/* 主循环里常见的一条日志，参数每次都变，不会被当成重复日志 */
+static void log_text(uint32_t index) {
+    elog_i("main", "temperature:%.2f degrees, %ums ago", 23.0 + (index % 13) * 0.07, (unsigned)(index % 500));
+}
+
+static void log_debug(uint32_t index) {
+    elog_d("main", "event %d detent %d", (int)(index % 3), (int)(index % 24));
+}
+
+static void log_quiet(uint32_t index) {
+    elog_i("quiet", "event %d detent %d", (int)(index % 3), (int)(index % 24));
+}
+
+static void log_repeat(uint32_t index) {
+    (void)index;
+    elog_w("i2c", "sht30 read failed");
+}
+
+static void log_limited(uint32_t index) {
+    elog_w("limited", "retry %u", (unsigned)index);
+}
+
+#ifdef ELOG_BIN_OUTPUT_ENABLE
+static void log_binary(uint32_t index) {
+    elog_bin_i("main", "temperature:%.2f degrees, %ums ago", ELOG_BIN_FLOAT(23.0f + (index % 13) * 0.07f),
+            index % 500);
+}
+#endif
+
+static BenchResult measure_once(LogFunc func, uint32_t lines) {
+    BenchResult result = { 0, 0, 0 };
+    uint64_t bytes, tsc = 0;
+    uint32_t done, num, i;
+    double start_ns;
+    uint64_t start_tsc;
+
+    for (i = 0; i < WARMUP_LINES; i++) {
+        func(i);
+    }
+    elog_flush();
+    bytes = ElogHostOutputBytes();
+
+    for (done = 0; done < lines; done += num) {
+        num = lines - done < BATCH_LINES ? lines - done : BATCH_LINES;
+        start_ns = now_ns();
+        start_tsc = now_tsc();
+        for (i = 0; i < num; i++) {
+            ElogHostTimeAdvance(LINE_PERIOD_US);
+            func(WARMUP_LINES + done + i);
+        }
+        tsc += now_tsc() - start_tsc;
+        result.ns += now_ns() - start_ns;
+        /* 取走缓存不计时 */
+        elog_flush();
+    }
+
+    result.ns /= lines;
+    result.tsc = (double)tsc / lines;
+    result.bytes = (double)(ElogHostOutputBytes() - bytes) / lines;
+
+    return result;
+}
+
+static BenchResult measure(LogFunc func, uint32_t lines) {
+    BenchResult best, result;
+    int round;
+
+    best = measure_once(func, lines);
+    for (round = 1; round < BENCH_ROUNDS; round++) {
+        result = measure_once(func, lines);
+        if (result.ns < best.ns) {
+            best = result;
+        }
+    }
+
+    return best;
+}
+
+static void print_head(const char *first) {
+    printf("%-46s %9s %9s %10s\n", first, "ns/line", HAVE_TSC ? "tsc/line" : "", "bytes/line");
+}
+
+static void print_row(const char *name, BenchResult result) {
+    if (HAVE_TSC) {
+        printf("%-46s %9.1f %9.0f %10.1f\n", name, result.ns, result.tsc, result.bytes);
+    } else {
+        printf("%-46s %9.1f %9s %10.1f\n", name, result.ns, "", result.bytes);
+    }
+}
+
+static void set_fmt(size_t fmt) {
+    uint8_t level;
+
+    for (level = ELOG_LVL_ASSERT; level <= ELOG_LVL_VERBOSE; level++) {
+        elog_set_fmt(level, fmt);
+    }
+}
+
+static void fmt_name(size_t fmt, char *name, size_t size) {
+    size_t len = 0;
+    uint8_t i;
+
+    name[0] = '\0';
+    for (i = 0; i < sizeof(fmt_flag_name) / sizeof(fmt_flag_name[0]); i++) {
+        if (fmt & (1u << i)) {
+            len += snprintf(name + len, size - len, "%s%s", len != 0 ? "|" : "", fmt_flag_name[i]);
+        }
+    }
+    if (len == 0) {
+        snprintf(name, size, "none");
+    }
+}
+
+/* 每种输出方式、颜色和格式组合的正常日志 */
+static void bench_formats(uint32_t lines, bool all_fmt) {
+    size_t fmt_num = all_fmt ? 256 : sizeof(fmt_list) / sizeof(fmt_list[0]);
+    char name[64], row[96];
+    int buffered, color;
+    size_t i, fmt;
+
+    print_head("mode   color format");
+    for (buffered = 0; buffered <= 1; buffered++) {
+        elog_buf_enabled(buffered);
+        for (color = 0; color <= 1; color++) {
+#ifdef ELOG_COLOR_ENABLE
+            elog_set_text_color_enabled(color);
+#else
+            if (color) {
+                continue;
+            }
+#endif
+            for (i = 0; i < fmt_num; i++) {
+                fmt = all_fmt ? i : fmt_list[i];
+                fmt_name(fmt, name, sizeof(name));
+                set_fmt(fmt);
+                snprintf(row, sizeof(row), "%-6s %-5s %s", buffered ? "buf" : "direct", color ? "on" : "off", name);
+                print_row(row, measure(log_text, lines));
+            }
+        }
+    }
+}
+
+/* 被过滤、合并、限速的调用，和二进制日志，都用固件的 buffer 模式、颜色和格式 */
+static void bench_suppressed(uint32_t lines) {
+    elog_buf_enabled(true);
+#ifdef ELOG_COLOR_ENABLE
+    elog_set_text_color_enabled(true);
+#endif
+    set_fmt(ELOG_FMT_TAG | ELOG_FMT_TIME);
+
+    printf("\n");
+    print_head("buf, color on, tag|time");
+    print_row("output", measure(log_text, lines));
+
+    elog_set_filter_lvl(ELOG_LVL_INFO);
+    print_row("level filtered", measure(log_debug, lines));
+    elog_set_filter_lvl(ELOG_LVL_VERBOSE);
+
+    elog_set_filter_tag_lvl("quiet", ELOG_LVL_WARN);
+    print_row("tag level filtered", measure(log_quiet, lines));
+    elog_set_filter_tag_lvl("quiet", ELOG_FILTER_LVL_ALL);
+
+    elog_set_filter_kw("no such word");
+    print_row("keyword filtered", measure(log_text, lines));
+    elog_set_filter_kw("");
+
+    elog_set_output_enabled(false);
+    print_row("output disabled", measure(log_text, lines));
+    elog_set_output_enabled(true);
+
+#ifdef ELOG_REPEAT_SUPPRESS_ENABLE
+    print_row("repeat suppressed", measure(log_repeat, lines));
+#endif
+#ifdef ELOG_RATE_LIMIT_ENABLE
+    /* 先输出一次，tag 有了 id 才能单独设置 */
+    log_limited(0);
+    elog_set_rate_limit("limited", 1, 1);
+    print_row("rate limited", measure(log_limited, lines));
+#endif
+#ifdef ELOG_BIN_OUTPUT_ENABLE
+    print_row("binary", measure(log_binary, lines));
+    /* 固件的终端默认是文本模式，二进制日志要格式化成文本 */
+    elog_sink_set_mode(elog_sink_find("console"), ELOG_SINK_TEXT);
+    print_row("binary to a text console", measure(log_binary, lines));
+    elog_sink_set_mode(elog_sink_find("console"), ELOG_SINK_BIN);
+#endif
+}
+
+int main(int argc, char *argv[]) {
+    uint32_t lines = 20000;
+    bool all_fmt = false;
+    int i;
+
+    for (i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-a")) {
+            all_fmt = true;
+        } else {
+            lines = (uint32_t)atoi(argv[i]);
+        }
+    }
+    if (lines == 0) {
+        printf("usage: elog_host_bench [lines] [-a]\n");
+        return 1;
+    }
+
+    elog_init();
+    elog_start();
+#ifdef ELOG_RATE_LIMIT_ENABLE
+    /* 正常日志不限速，否则测到的是被丢掉的调用 */
+    elog_set_rate_limit(NULL, 0, 1);
+#endif
+    elog_flush();
+
+    printf("%u lines per row, line buffer %d bytes\n\n", (unsigned)lines, ELOG_LINE_BUF_SIZE);
+    bench_formats(lines, all_fmt);
+    bench_suppressed(lines);
+    printf("\nbuffer dropped %u\n", (unsigned)elog_buf_get_dropped());
+
+    return 0;
+}
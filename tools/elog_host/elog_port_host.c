@@ -0,0 +1,139 @@
+/*
+ * 主机上的 easy_log 移植层，给 elog_host_bench 用
+ *
+ * 终端 sink 和直接输出都只统计字节数，不复制数据，测到的是 elog 自己的开销。
+ * 时间是模拟的，只在 ElogHostTimeAdvance 里前进，输出格式和固件的 elog_port_get_time 一样。
+ */
+
+#include <stdio.h>
+
+#include "elog.h"
+#include "elog_port_host.h"
+
+// 足够放下一批最长的日志，批与批之间才取走
+#define HOST_CONSOLE_BUF_LEN    (256 * 1024)
+
+static size_t host_console_write(ElogSink *sink, const char *log, size_t size);
+
+static char console_buf[HOST_CONSOLE_BUF_LEN];
+static ElogSink console_sink = ELOG_SINK_INIT("console", console_buf, &host_console_write, NULL, ELOG_SINK_BIN,
+    ELOG_LVL_VERBOSE);
+static uint64_t output_bytes = 0;
+static uint64_t time_us = 0;
+
+/**
+ * EasyLogger port initialize
+ *
+ * @return result
+ */
+ElogErrCode elog_port_init(void) {
+    elog_sink_register(&console_sink);
+
+    return ELOG_NO_ERR;
+}
+
+/**
+ * EasyLogger port deinitialize
+ *
+ */
+void elog_port_deinit(void) {
+
+}
+
+/**
+ * 固件打开了ELOG_FLASH_ENABLE，主机上没有flash，不注册flash sink
+ */
+ElogErrCode elog_flash_init(void) {
+    return ELOG_NO_ERR;
+}
+
+/**
+ * output log port interface, 不使用buffer模式时直接到这里
+ *
+ * @param log output of log
+ * @param size log size
+ * @return 0
+ */
+int8_t elog_port_output(const char *log, size_t size) {
+    (void)log;
+    output_bytes += size;
+
+    return 0;
+}
+
+/**
+ * output lock
+ */
+void elog_port_output_lock(void) {
+
+}
+
+/**
+ * output unlock
+ */
+void elog_port_output_unlock(void) {
+
+}
+
+/**
+ * get current time interface
+ *
+ * @param time 输出缓存
+ * @param size 缓存大小
+ * @return 写入的长度
+ */
+size_t elog_port_get_time(char *time, size_t size) {
+    int len;
+
+    if(size == 0)
+        return 0;
+    len = elog_snprintf(time, size, "%4u.%03u", (uint32_t)(time_us / 1000000), (uint32_t)(time_us / 1000 % 1000));
+
+    return (size_t)len < size ? (size_t)len : size - 1;
+}
+
+/**
+ * get current time in microseconds for binary logs and rate limiting
+ *
+ * @return microseconds since start, wraps every 71 minutes
+ */
+uint32_t elog_port_get_timestamp(void) {
+    return (uint32_t)time_us;
+}
+
+/**
+ * get current process name interface
+ *
+ * @return current process name
+ */
+const char *elog_port_get_p_info(void) {
+    return "";
+}
+
+/**
+ * get current thread name interface
+ *
+ * @return current thread name
+ */
+const char *elog_port_get_t_info(void) {
+    return "";
+}
+
+void ElogHostTimeAdvance(uint32_t us)
+{
+    time_us += us;
+}
+
+uint64_t ElogHostOutputBytes(void)
+{
+    return output_bytes;
+}
+
+static size_t host_console_write(ElogSink *sink, const char *log, size_t size)
+{
+    (void)sink;
+    (void)log;
+    output_bytes += size;
+
+    return size;
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <stdint.h>
+
+// 主机移植层：输出只计字节数，时间由调用者推进
+
+void ElogHostTimeAdvance(uint32_t us);
+
+uint64_t ElogHostOutputBytes(void);
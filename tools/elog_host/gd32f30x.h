@@ -0,0 +1,27 @@
+/*
+ * 主机编译 easy_log 时代替芯片头文件，只提供 elog 用到的几个 CMSIS 内联函数
+ * 基准测试是单线程的，独占访问直接读写即可，关中断什么也不做
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#define __LDREXW(addr)          (*(addr))
+#define __STREXW(value, addr)   ((*(addr) = (value)), 0U)
+#define __CLREX()               ((void)0)
+#define __DMB()                 __sync_synchronize()
+
+static inline uint32_t __get_PRIMASK(void)
+{
+    return 0;
+}
+
+static inline void __set_PRIMASK(uint32_t primask)
+{
+    (void)primask;
+}
+
+static inline void __disable_irq(void)
+{
+}
@@ -0,0 +1,188 @@
+/*
+ * 在主机上测量 elog_lz 压缩后 115200 波特率下每秒能发送的日志行数
+ *
+ * gcc -O2 -DELOG_LZ_OUTPUT_ENABLE -Icommon/easy_log tools/elog_lz_bench.c common/easy_log/elog_lz.c -o elog_lz_bench
+ * ./elog_lz_bench [lines]
+ *
+ * 按固件的行格式（颜色、等级、补齐的 tag、时间）生成主循环里常见的几种日志，
+ * 分别按每次 flush 一行和每次 flush 半个 DMA 缓存压缩，解压核对后统计每行字节数。
+ * 串口 8N1 每字节 10 位，115200 波特率每秒 11520 字节。
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "elog.h"
+
+#define LINK_BYTES_PER_SEC  11520.0
+#define DMA_BUFFER_LEN      512
+#define STREAM_MAX          (4 * 1024 * 1024)
+
+static char raw[STREAM_MAX];
+static uint8_t packed[STREAM_MAX + STREAM_MAX / 8];
+static uint8_t unpacked[STREAM_MAX];
+
+static size_t make_line(char *line, size_t size, unsigned index) {
+    static const char *const color[] = { "35;22m", "31;22m", "33;22m", "36;22m", "32;22m", "34;22m" };
+    unsigned ms = 1000 + index * 37;
+    char head[48];
+    char text[160];
+    int level = 3;
+
+    switch (index % 7) {
+    case 0:
+        snprintf(text, sizeof(text), "temperature:%.2f degrees, %ums ago", 23.0 + (index % 13) * 0.07, index % 500);
+        snprintf(head, sizeof(head), "I/main     ");
+        break;
+    case 1:
+        snprintf(text, sizeof(text), "humidity:%.1f%%, %ums ago", 45.0 + (index % 9) * 0.3, index % 500);
+        snprintf(head, sizeof(head), "I/main     ");
+        break;
+    case 2:
+        snprintf(text, sizeof(text), "seq %u, vdda %umV, vin %umV, spare %umV %umV, chip %d.%d degrees", index,
+                 3300 + index % 5, 5012 - index % 11, 12u, 7u, 31, (int)(index % 10));
+        snprintf(head, sizeof(head), "I/adc      ");
+        break;
+    case 3:
+        snprintf(text, sizeof(text), "event %d detent %d velocity %d", (int)(index % 3), (int)(index % 24),
+                 (int)(index % 17) - 8);
+        snprintf(head, sizeof(head), "D/knob     ");
+        level = 4;
+        break;
+    case 4:
+        snprintf(text, sizeof(text), "%04d-%02d-%02d %02d:%02d:%02d week %d", 2024, 9, 1, 12, (int)(index / 60 % 60),
+                 (int)(index % 60), 0);
+        snprintf(head, sizeof(head), "I/rtc      ");
+        break;
+    case 5:
+        snprintf(text, sizeof(text), "sht30 read failed, retry %u", index % 4);
+        snprintf(head, sizeof(head), "W/i2c      ");
+        level = 2;
+        break;
+    default:
+        snprintf(text, sizeof(text), "%u frames, period %u-%u us", 100u + index % 3, 9990u + index % 7,
+                 10010u - index % 5);
+        snprintf(head, sizeof(head), "I/disp     ");
+        break;
+    }
+
+    return (size_t)snprintf(line, size, "\033[%s%s[%4u.%03u] %s\033[0m\n", color[level], head, ms / 1000, ms % 1000,
+                            text);
+}
+
+/* host side of the frame format, the same as tools/elog_decode.py --lz */
+static size_t inflate(const uint8_t *in, size_t in_len, uint8_t *out) {
+    size_t pos = 0, olen = 0, start = 0, end, size;
+    unsigned control, bit, header, distance, len;
+
+    while (pos + 3 <= in_len) {
+        if (in[pos] != 0xFE) {
+            return 0;
+        }
+        header = in[pos + 1] | in[pos + 2] << 8;
+        size = header & 0x7FFF;
+        if (header & 0x8000) {
+            start = olen;
+        }
+        pos += 3;
+        end = pos + size;
+        while (pos < end) {
+            control = in[pos++];
+            for (bit = 0; bit < 8 && pos < end; bit++) {
+                if (control & (1u << bit)) {
+                    distance = (in[pos] | (in[pos + 1] >> 6) << 8) + 1;
+                    len = (in[pos + 1] & 0x3F) + 3;
+                    pos += 2;
+                    if (distance > olen - start) {
+                        return 0;
+                    }
+                    while (len-- > 0) {
+                        out[olen] = out[olen - distance];
+                        olen++;
+                    }
+                } else {
+                    out[olen++] = in[pos++];
+                }
+            }
+        }
+    }
+
+    return olen;
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* compress like elog_port_write: frames into half DMA buffers, a new buffer when one is full */
+static size_t pack(const size_t *line_end, unsigned lines, size_t step, double *ns) {
+    static ElogLz lz;
+    size_t in_pos = 0, out_pos = 0, fill = 0, end, done, frame;
+    double start;
+    unsigned i = 0;
+
+    elog_lz_init(&lz);
+    start = now_ns();
+    while (in_pos < line_end[lines - 1]) {
+        /* one flush: a line, or what the ring holds when the link is behind */
+        end = step == 0 ? line_end[i++] : (in_pos + step < line_end[lines - 1] ? in_pos + step : line_end[lines - 1]);
+        while (in_pos < end) {
+            done = elog_lz_compress(&lz, raw + in_pos, end - in_pos, packed + out_pos, DMA_BUFFER_LEN - fill, &frame);
+            if (done == 0) {
+                fill = 0;
+                continue;
+            }
+            in_pos += done;
+            out_pos += frame;
+            fill += frame;
+        }
+    }
+    *ns = now_ns() - start;
+
+    return out_pos;
+}
+
+static int report(const char *name, const size_t *line_end, unsigned lines, size_t step) {
+    size_t raw_len = line_end[lines - 1];
+    size_t packed_len;
+    double ns;
+
+    packed_len = pack(line_end, lines, step, &ns);
+    if (inflate(packed, packed_len, unpacked) != raw_len || memcmp(raw, unpacked, raw_len) != 0) {
+        printf("%s: round trip failed\n", name);
+        return 1;
+    }
+    printf("%-18s %6.1f bytes/line %5.1f%%  %6.1f lines/s  %5.1f ns/byte\n", name, (double)packed_len / lines,
+           100.0 * packed_len / raw_len, LINK_BYTES_PER_SEC * lines / packed_len, ns / raw_len);
+
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    unsigned lines = argc > 1 ? (unsigned)atoi(argv[1]) : 20000;
+    size_t *line_end;
+    size_t len = 0;
+    unsigned i;
+    int failed = 0;
+
+    line_end = malloc(sizeof(size_t) * lines);
+    for (i = 0; i < lines && len + 256 < STREAM_MAX; i++) {
+        len += make_line(raw + len, STREAM_MAX - len, i);
+        line_end[i] = len;
+    }
+    lines = i;
+
+    printf("%u lines, window %d, hash %d\n", lines, ELOG_LZ_WINDOW_SIZE, ELOG_LZ_HASH_SIZE);
+    printf("%-18s %6.1f bytes/line %5.1f%%  %6.1f lines/s\n", "raw", (double)len / lines, 100.0,
+           LINK_BYTES_PER_SEC * lines / len);
+    failed |= report("lz, line flush", line_end, lines, 0);
+    failed |= report("lz, 512 B flush", line_end, lines, DMA_BUFFER_LEN);
+    free(line_end);
+
+    return failed;
+}
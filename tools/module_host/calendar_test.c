@@ -0,0 +1,264 @@
+/*
+ * 在主机上校验 calendar.c：支持范围内的每一天和 C 库比对，每一秒做往返换算，
+ * 夏令时切换和 C 库的 POSIX TZ 规则比对，最后测每种换算的耗时
+ *
+ * cd tools/module_host && make calendar_test && ./calendar_test [-q]
+ *
+ * 每一秒的往返要跑四十多亿次，主机上一分多钟，-q 只检查每天的零点、正午和最后一秒。
+ * 主机比 Cortex-M4 快得多，耗时只看相对变化，目标上用 cal_test 命令看周期数。
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "calendar.h"
+
+// 2000-01-01 00:00:00 UTC 的 Unix 时间
+#define UNIX_2000           946684800LL
+#define MAX_DAYS            CALENDAR_DAYS(CALENDAR_MAX_YEAR, 12, 31)
+#define MAX_SECONDS         ((uint32_t)MAX_DAYS * CALENDAR_SECONDS_PER_DAY + CALENDAR_SECONDS_PER_DAY - 1)
+#define DST_STEP            900         // 切换都在整点，按15分钟步进能踩到每个切换时刻
+#define BENCH_CALLS         20000000
+
+typedef struct {
+    const char *name;
+    TimeZone zone;
+    const char *tz;
+} ZoneCase;
+
+static ZoneCase zone_case[] = {
+    { "china", TIME_ZONE_CHINA, "CST-8" },
+    { "central europe", TIME_ZONE_CENTRAL_EUROPE, "CET-1CEST,M3.5.0,M10.5.0/3" },
+    { "us eastern", TIME_ZONE_US_EASTERN, "EST5EDT,M3.2.0,M11.1.0" },
+};
+
+static uint32_t errors = 0;
+
+#define CHECK(cond, ...) \
+    do { if(!(cond)) { if(errors ++ < 20) { printf("FAIL: "); printf(__VA_ARGS__); printf("\n"); } } } while(0)
+
+// 编译期换算，和运行时的结果一起比对
+static const uint32_t const_seconds = CALENDAR_SECONDS(2024, 2, 29, 12, 34, 56);
+
+static double now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * @brief 每一天和 gmtime、timegm、strftime 的 ISO 周数比对
+ */
+static void check_days(void)
+{
+    ClockTime time;
+    struct tm tm;
+    time_t unix_time;
+    int32_t days;
+    uint16_t iso_year;
+    uint8_t iso_week;
+    int tm_iso_year, tm_iso_week;
+    char buf[16];
+
+    for(days = 0; days <= MAX_DAYS; days ++) {
+        unix_time = (time_t)(UNIX_2000 + (int64_t)days * CALENDAR_SECONDS_PER_DAY);
+        gmtime_r(&unix_time, &tm);
+        CalendarDateFromDays(days, &time);
+
+        CHECK(time.year == tm.tm_year + 1900 && time.month == tm.tm_mon + 1 && time.day == tm.tm_mday,
+            "day %d: %04d-%02d-%02d", days, time.year, time.month, time.day);
+        CHECK(time.week == tm.tm_wday, "day %d: weekday %d, expected %d", days, time.week, tm.tm_wday);
+        CHECK(CalendarDaysFromDate(time.year, time.month, time.day) == days, "day %d: from date", days);
+        CHECK(CalendarCheck(&time) == 0, "day %d: check", days);
+        if(time.month == 12 && time.day == 31)
+            CHECK(CalendarIsLeapYear(time.year) == (tm.tm_yday == 365), "year %d: leap", time.year);
+        if(time.day == 1)
+            CHECK(CalendarDaysInMonth(time.year, time.month) == (time.month == 12 ? 31 :
+                CALENDAR_DAYS(time.year, time.month + 1, 1) - days), "%04d-%02d: days in month", time.year,
+                time.month);
+
+        strftime(buf, sizeof(buf), "%G %V", &tm);
+        sscanf(buf, "%d %d", &tm_iso_year, &tm_iso_week);
+        iso_week = CalendarIsoWeek(&time, &iso_year);
+        CHECK(iso_week == tm_iso_week && iso_year == tm_iso_year, "%04d-%02d-%02d: iso week %d-%d, expected %s",
+            time.year, time.month, time.day, iso_year, iso_week, buf);
+
+        time.hour = tm.tm_hour;
+        time.min = tm.tm_min;
+        time.sec = tm.tm_sec;
+        CHECK(CalendarToSeconds(&time) == (uint32_t)(timegm(&tm) - UNIX_2000), "day %d: to seconds", days);
+    }
+    // 范围外和不合法的日期
+    time.year = CALENDAR_MAX_YEAR + 1;
+    time.month = 1;
+    time.day = 1;
+    CHECK(CalendarCheck(&time) == -1, "year after range accepted");
+    time.year = 2023;
+    time.month = 2;
+    time.day = 29;
+    CHECK(CalendarCheck(&time) == -1, "2023-02-29 accepted");
+    memset(&tm, 0, sizeof(tm));
+    tm.tm_year = 2024 - 1900;
+    tm.tm_mon = 1;
+    tm.tm_mday = 29;
+    tm.tm_hour = 12;
+    tm.tm_min = 34;
+    tm.tm_sec = 56;
+    CHECK(const_seconds == (uint32_t)(timegm(&tm) - UNIX_2000), "compile-time seconds");
+
+    printf("days: %d days 2000-01-01 ... %d-12-31 checked against gmtime\n", days, CALENDAR_MAX_YEAR);
+}
+
+/**
+ * @brief 每一秒往返换算，期望值逐秒进位得到，每天的日期已经在check_days里和C库比对过
+ */
+static void check_seconds(uint8_t quick)
+{
+    ClockTime time, expect;
+    uint32_t seconds = 0, checked = 0;
+    int32_t days = 0;
+
+    CalendarDateFromDays(0, &expect);
+    expect.hour = expect.min = expect.sec = 0;
+    while(1) {
+        if(quick == 0 || (expect.hour == 0 && expect.min == 0 && expect.sec == 0) ||
+            (expect.hour == 12 && expect.min == 0 && expect.sec == 0) ||
+            (expect.hour == 23 && expect.min == 59 && expect.sec == 59)) {
+            CalendarFromSeconds(seconds, &time);
+            if(memcmp(&time, &expect, sizeof(time)) != 0 || CalendarToSeconds(&time) != seconds)
+                CHECK(0, "second %u: %04d-%02d-%02d %02d:%02d:%02d", seconds, time.year, time.month, time.day,
+                    time.hour, time.min, time.sec);
+            checked ++;
+        }
+        if(seconds == MAX_SECONDS)
+            break;
+        seconds ++;
+
+        if(++ expect.sec == 60) {
+            expect.sec = 0;
+            if(++ expect.min == 60) {
+                expect.min = 0;
+                if(++ expect.hour == 24) {
+                    expect.hour = 0;
+                    CalendarDateFromDays(++ days, &expect);
+                }
+            }
+        }
+    }
+
+    printf("seconds: %u seconds round-tripped, last %04d-%02d-%02d %02d:%02d:%02d\n", checked, expect.year,
+        expect.month, expect.day, expect.hour, expect.min, expect.sec);
+}
+
+/**
+ * @brief 时区偏移和 localtime 比对，先顺序走一遍，再随机跳着查，验证年份缓存的更新
+ */
+static void check_zones(void)
+{
+    struct tm tm;
+    time_t unix_time;
+    uint32_t seconds, i, rand_state = 1;
+    uint32_t checked, changes;
+    size_t n;
+
+    for(n = 0; n < sizeof(zone_case) / sizeof(zone_case[0]); n++) {
+        setenv("TZ", zone_case[n].tz, 1);
+        tzset();
+        checked = 0;
+        changes = 0;
+
+        for(seconds = DST_STEP; seconds <= MAX_SECONDS - DST_STEP; seconds += DST_STEP) {
+            // 整点时刻和前一秒都比对，切换正好发生在整点
+            for(i = 0; i < 2; i++) {
+                unix_time = (time_t)(UNIX_2000 + seconds - i);
+                localtime_r(&unix_time, &tm);
+                CHECK(CalendarUtcOffset(&zone_case[n].zone, seconds - i) == tm.tm_gmtoff,
+                    "%s: second %u offset %d, expected %ld", zone_case[n].name, seconds - i,
+                    CalendarUtcOffset(&zone_case[n].zone, seconds - i), (long)tm.tm_gmtoff);
+                checked ++;
+            }
+            if(tm.tm_gmtoff != CalendarUtcOffset(&zone_case[n].zone, seconds))
+                changes ++;
+        }
+        for(i = 0; i < 1000000; i++) {
+            rand_state = rand_state * 1103515245 + 12345;
+            seconds = rand_state % MAX_SECONDS;
+            unix_time = (time_t)(UNIX_2000 + seconds);
+            localtime_r(&unix_time, &tm);
+            CHECK(CalendarToLocal(&zone_case[n].zone, seconds) == seconds + (uint32_t)tm.tm_gmtoff,
+                "%s: random second %u", zone_case[n].name, seconds);
+            checked ++;
+        }
+
+        printf("zone %s: %u instants checked against localtime, %u dst changes\n", zone_case[n].name, checked,
+            changes);
+    }
+}
+
+static void bench(void)
+{
+    TimeZone zone = TIME_ZONE_CENTRAL_EUROPE;
+    ClockTime time;
+    volatile uint32_t sink = 0;
+    uint32_t i, seconds, rand_state = 1;
+    uint16_t iso_year;
+    double start;
+
+    // 步长取质数，每次换算都落在不同的日期和时刻
+    start = now_ns();
+    for(i = 0, seconds = 0; i < BENCH_CALLS; i++, seconds += 214741) {
+        CalendarFromSeconds(seconds % MAX_SECONDS, &time);
+        sink += time.sec;
+    }
+    printf("\n%-28s %6.1f ns\n", "CalendarFromSeconds", (now_ns() - start) / BENCH_CALLS);
+
+    start = now_ns();
+    for(i = 0; i < BENCH_CALLS; i++) {
+        time.sec = i % 60;
+        time.day = 1 + i % 28;
+        sink += CalendarToSeconds(&time);
+    }
+    printf("%-28s %6.1f ns\n", "CalendarToSeconds", (now_ns() - start) / BENCH_CALLS);
+
+    start = now_ns();
+    for(i = 0; i < BENCH_CALLS; i++) {
+        time.day = 1 + i % 28;
+        time.week = i % 7;
+        sink += CalendarIsoWeek(&time, &iso_year);
+    }
+    printf("%-28s %6.1f ns\n", "CalendarIsoWeek", (now_ns() - start) / BENCH_CALLS);
+
+    // 显示每帧都换算当前时间，年份缓存命中
+    start = now_ns();
+    for(i = 0, seconds = CALENDAR_SECONDS(2024, 6, 1, 0, 0, 0); i < BENCH_CALLS; i++, seconds ++) {
+        CalendarFromSeconds(CalendarToLocal(&zone, seconds), &time);
+        sink += time.sec;
+    }
+    printf("%-28s %6.1f ns\n", "local time, dst cache hit", (now_ns() - start) / BENCH_CALLS);
+
+    start = now_ns();
+    for(i = 0; i < BENCH_CALLS; i++) {
+        rand_state = rand_state * 1103515245 + 12345;
+        sink += CalendarToLocal(&zone, rand_state % MAX_SECONDS);
+    }
+    printf("%-28s %6.1f ns\n", "CalendarToLocal, cache miss", (now_ns() - start) / BENCH_CALLS);
+    (void)sink;
+}
+
+int main(int argc, char *argv[])
+{
+    uint8_t quick = argc > 1 && strcmp(argv[1], "-q") == 0;
+
+    check_days();
+    check_seconds(quick);
+    check_zones();
+    bench();
+
+    printf(errors != 0 ? "\n%u errors, FAILED\n" : "\nPASSED\n", errors);
+
+    return errors != 0;
+}
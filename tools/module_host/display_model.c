@@ -0,0 +1,251 @@
+/*
+ * 数码管扫描引擎的主机模型：driver_display.c 跑在 host_periph.c 的定时器/DMA/GPIO 模型上，
+ * 逐条扫描线检查时序、换帧、亮度渐变和中断次数
+ *
+ * cd tools/module_host && make display_model && ./display_model
+ *
+ * 直接包含 driver_display.c，用它的引脚和定时器定义解读 GPIO 输出。
+ * 检查的内容：扫描线周期和整帧刷新率、每条线只选中一位且段码和帧内容一致、
+ * 换帧只发生在帧边界且一帧之内完成、不换帧时没有中断、点亮时间不超过消隐后的上限、
+ * 渐变每条线走一级且中途改目标不跳变、disp_stat 测到的帧周期。
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../../driver/Source/driver_display.c"
+#include "host_periph.h"
+
+#define RUN_FRAMES          1000
+#define FRAME_VERSIONS      60          // 段码是8位的，帧版本循环使用
+
+static uint32_t line_count = 0;
+static int failed = 0;
+
+#define CHECK(cond, ...) \
+    do { if(!(cond)) { printf("FAIL line %d: ", __LINE__); printf(__VA_ARGS__); printf("\n"); failed = 1; } } while(0)
+
+typedef struct
+{
+    int8_t digit;           // 选中的位，没有或多于一位时为-1
+    uint8_t segments;
+    uint32_t pulse;         // 这条线点亮的计数值
+}ScanLine;
+
+static ScanLine scan_line(void)
+{
+    ScanLine line;
+    uint32_t out;
+    uint32_t select;
+    uint8_t i;
+
+    HostTimerUpdateEvent(DRV_DISPLAY_TIMER);
+    line_count ++;
+
+    out = HostGpioOutput(DRV_DISPLAY_GPIO_PORT);
+    select = (out & DRV_DISPLAY_DIGIT_MASK) >> DRV_DISPLAY_DIGIT_SHIFT;
+    line.digit = -1;
+    for(i = 0; i < DISPLAY_DIGIT_NUM; i++) {
+        if(select == (1U << i))
+            line.digit = i;
+    }
+    line.segments = (uint8_t)((out & DRV_DISPLAY_SEG_MASK) >> DRV_DISPLAY_SEG_SHIFT);
+    line.pulse = HostTimerActivePulse(DRV_DISPLAY_TIMER, TIMER_CH_1);
+
+    return line;
+}
+
+// 第version帧第digit位的段码，相邻的帧每位都不同，能从段码认出是哪一帧
+static uint8_t frame_segments(uint32_t version, uint8_t digit)
+{
+    return (uint8_t)(version % FRAME_VERSIONS * DISPLAY_DIGIT_NUM + digit + 1);
+}
+
+static void set_frame(uint32_t version)
+{
+    uint8_t segments[DISPLAY_DIGIT_NUM];
+    uint8_t i;
+
+    for(i = 0; i < DISPLAY_DIGIT_NUM; i++)
+        segments[i] = frame_segments(version, i);
+    CHECK(DisplaySetFrame(segments) == 0, "set frame %u", version);
+}
+
+static void check_timing(void)
+{
+    uint32_t tick_hz = HostTimerTickHz(DRV_DISPLAY_TIMER);
+    uint32_t ticks = HostTimerPeriodTicks(DRV_DISPLAY_TIMER);
+    double line_us = ticks * 1e6 / tick_hz;
+    double refresh_hz = 1e6 / (line_us * DISPLAY_DIGIT_NUM);
+
+    CHECK(tick_hz == DISPLAY_TIMER_TICK_HZ, "tick %u Hz", tick_hz);
+    CHECK(ticks == DISPLAY_LINE_TICKS, "line %u ticks", ticks);
+    CHECK(line_us == DISPLAY_LINE_PERIOD_US, "line %.3f us", line_us);
+    CHECK(refresh_hz == DISPLAY_REFRESH_HZ, "refresh %.3f Hz", refresh_hz);
+    printf("timing: %u digits, line %.0f us = %u ticks at %u Hz, frame %.0f Hz, pwm max %u ticks (%u blanking)\n",
+        DISPLAY_DIGIT_NUM, line_us, ticks, tick_hz, refresh_hz, DRV_DISPLAY_PWM_MAX_TICKS,
+        ticks - DRV_DISPLAY_PWM_MAX_TICKS);
+}
+
+/**
+ * @brief 随机时刻请求换帧，每一帧的所有扫描线都必须来自同一版本，新版本在一帧之内显示出来
+ */
+static void check_scan_and_swap(void)
+{
+    ScanLine line;
+    uint32_t version = 0, shown = 0, frame_version = 0;
+    uint32_t swap_line = 0, latency_max = 0, swaps = 0;
+    uint32_t irq_start = HostDmaIrqCount(DRV_DISPLAY_DMA, DRV_DISPLAY_DMA_CHL);
+    uint32_t rand_state = 1;
+    uint32_t i;
+    uint8_t expect_digit = 0;
+
+    // 扫描从第0位开始，DMA的第一个请求写的就是第0位。先显示第0版，等它完整显示一帧
+    set_frame(0);
+    CHECK(DisplaySwap() == 0, "first swap");
+    for(i = 0; i < 2 * DISPLAY_DIGIT_NUM; i++) {
+        line = scan_line();
+        CHECK(line.digit == expect_digit, "line %u: digit %d", line_count, line.digit);
+        expect_digit = (expect_digit + 1) % DISPLAY_DIGIT_NUM;
+    }
+    CHECK(DisplaySwapPending() == 0 && line.segments == frame_segments(0, line.digit), "first frame not shown");
+    swaps ++;
+
+    for(i = 0; i < RUN_FRAMES * DISPLAY_DIGIT_NUM; i++) {
+        rand_state = rand_state * 1103515245 + 12345;
+        if(DisplaySwapPending() == 0 && (rand_state >> 16) % 7 == 0) {
+            version ++;
+            set_frame(version);
+            CHECK(DisplaySwap() == 0, "swap");
+            swap_line = line_count;
+            swaps ++;
+        }
+
+        line = scan_line();
+        CHECK(line.digit == expect_digit, "line %u: digit %d, expected %d", line_count, line.digit, expect_digit);
+        expect_digit = (expect_digit + 1) % DISPLAY_DIGIT_NUM;
+        if(line.digit < 0)
+            continue;
+
+        if(line.digit == 0) {
+            frame_version = (line.segments - 1) / DISPLAY_DIGIT_NUM;
+            CHECK(frame_version == shown || frame_version == (shown + 1) % FRAME_VERSIONS,
+                "frame went from %u to %u", shown, frame_version);
+            if(frame_version != shown) {
+                if(line_count - swap_line > latency_max)
+                    latency_max = line_count - swap_line;
+                shown = frame_version;
+            }
+        }
+        CHECK(line.segments == frame_segments(frame_version, line.digit), "line %u: torn frame", line_count);
+        CHECK(line.pulse <= DRV_DISPLAY_PWM_MAX_TICKS, "line %u: pulse %u", line_count, line.pulse);
+    }
+    CHECK(latency_max <= DISPLAY_DIGIT_NUM + 1, "swap took %u lines", latency_max);
+    CHECK(HostDmaIrqCount(DRV_DISPLAY_DMA, DRV_DISPLAY_DMA_CHL) - irq_start == swaps, "%u irqs for %u swaps",
+        HostDmaIrqCount(DRV_DISPLAY_DMA, DRV_DISPLAY_DMA_CHL) - irq_start, swaps);
+
+    // 换帧后只改一位，其余位保持新帧的内容
+    while(DisplaySwapPending() == 1)
+        scan_line();
+    CHECK(DisplaySetDigit(2, 0x7f) == 0 && DisplaySwap() == 0, "set digit");
+    for(i = 0; i < 3 * DISPLAY_DIGIT_NUM; i++) {
+        line = scan_line();
+        if(i >= 2 * DISPLAY_DIGIT_NUM && line.digit >= 0)
+            CHECK(line.segments == (line.digit == 2 ? 0x7f : frame_segments(version, line.digit)),
+                "digit %d after set digit", line.digit);
+    }
+
+    printf("scan: %u lines, %u swaps, new frame shown within %u lines, one irq per swap\n", line_count, swaps,
+        latency_max);
+}
+
+static void check_idle(void)
+{
+    uint32_t irq_start = HostDmaIrqCount(DRV_DISPLAY_DMA, DRV_DISPLAY_DMA_CHL);
+    uint32_t i;
+
+    for(i = 0; i < RUN_FRAMES * DISPLAY_DIGIT_NUM; i++)
+        scan_line();
+    CHECK(HostDmaIrqCount(DRV_DISPLAY_DMA, DRV_DISPLAY_DMA_CHL) == irq_start, "irqs while idle");
+    printf("idle: %u frames without a swap, 0 irqs\n", RUN_FRAMES);
+}
+
+/**
+ * @brief 渐变每条线写一级，比较值在下一条线生效；中途改目标时从当前亮度接着走
+ */
+static void check_fade(void)
+{
+    ScanLine line;
+    uint32_t last_pulse, lines;
+    int32_t jump_max = 0, jump;
+
+    DisplaySetBrightness(DISPLAY_BRIGHTNESS_MAX);
+    scan_line();
+    line = scan_line();
+    CHECK(line.pulse == gamma_table[GAMMA_UP(DISPLAY_BRIGHTNESS_MAX)], "full brightness pulse %u", line.pulse);
+    CHECK(line.pulse == DRV_DISPLAY_PWM_MAX_TICKS, "full brightness is not the blanking limit");
+
+    DisplayFadeTo(0);
+    last_pulse = line.pulse;
+    for(lines = 0; lines < 100; lines++) {
+        line = scan_line();
+        CHECK(line.pulse <= last_pulse, "fade down went up");
+        last_pulse = line.pulse;
+    }
+    // 中途反向，亮度从已经到达的一级开始
+    CHECK(DisplayGetBrightness() == DISPLAY_BRIGHTNESS_MAX - 100, "brightness %u after 100 lines",
+        DisplayGetBrightness());
+    DisplayFadeTo(200);
+    for(lines = 0; lines < 300; lines++) {
+        line = scan_line();
+        jump = (int32_t)line.pulse - (int32_t)last_pulse;
+        if(jump < 0)
+            jump = -jump;
+        if(jump > jump_max)
+            jump_max = jump;
+        last_pulse = line.pulse;
+    }
+    CHECK(DisplayGetBrightness() == 200, "brightness %u after fade", DisplayGetBrightness());
+    CHECK(last_pulse == gamma_table[GAMMA_UP(200)], "pulse %u after fade", last_pulse);
+    CHECK(jump_max <= gamma_table[GAMMA_UP(DISPLAY_BRIGHTNESS_MAX)] - gamma_table[GAMMA_UP(DISPLAY_BRIGHTNESS_MAX - 1)],
+        "fade jumped %d ticks", jump_max);
+
+    DisplayFadeTo(0);
+    for(lines = 0; lines < 256; lines++)
+        line = scan_line();
+    CHECK(line.pulse == 0 && DisplayGetBrightness() == 0, "fade to off");
+    DisplaySetBrightness(DISPLAY_BRIGHTNESS_MAX);
+    printf("fade: one level per line, largest step %d ticks, reverse mid-fade ok\n", jump_max);
+}
+
+static void check_measure(void)
+{
+    DisplayStat stat;
+    uint32_t expect = HOST_CORE_CLOCK / DISPLAY_REFRESH_HZ;
+    uint32_t i;
+
+    DisplayMeasureStart();
+    for(i = 0; i < (DRV_DISPLAY_MEASURE_FRAMES + 2) * DISPLAY_DIGIT_NUM; i++)
+        scan_line();
+    DisplayGetStat(&stat);
+    CHECK(stat.measured_frames == DRV_DISPLAY_MEASURE_FRAMES - 1, "measured %u frames", stat.measured_frames);
+    CHECK(stat.frame_cycles_min == expect && stat.frame_cycles_max == expect, "frame cycles %u ... %u",
+        stat.frame_cycles_min, stat.frame_cycles_max);
+    printf("measure: %u frames, %u cycles per frame\n", stat.measured_frames, stat.frame_cycles_max);
+}
+
+int main(void)
+{
+    HostDmaIrqRegister(DRV_DISPLAY_DMA, DRV_DISPLAY_DMA_CHL, &DisplayFrameCompleteCallback);
+    CHECK(DisplayInit() == 0, "init");
+
+    check_timing();
+    check_scan_and_swap();
+    check_idle();
+    check_fade();
+    check_measure();
+
+    printf(failed ? "FAILED\n" : "PASSED\n");
+
+    return failed;
+}
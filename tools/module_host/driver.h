@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdint.h>
+#include "driver_display.h"
+#include "driver_spi.h"
+
+// 主机上的驱动层：只声明被测模块用到的接口，实现见 host_stub.c
+
+typedef struct __I2cStruct I2cStruct;
+typedef struct __TimerStruct TimerStruct;
+
+typedef void (*I2cReadCallback)(int8_t result);
+typedef void (*TimerUpdateCpltFunc)(void);
+
+typedef struct __TimerInitStruct
+{
+    uint32_t update_time_us;
+}TimerInitStruct;
+
+extern I2cStruct I2c0;
+extern TimerStruct Timer6;
+extern SpiStruct Spi2;          // SPI 的实现是 lcd_ppm.c 里的屏幕控制器模型
+
+#define AS5600_I2C           (&I2c0)
+#define AS5600_SAMPLE_TIMER  (&Timer6)
+#define LCD_SPI              (&Spi2)
+
+int8_t I2cMemRead(I2cStruct *i2c, uint8_t dev_addr, uint8_t reg_addr, uint8_t *data, uint16_t data_len);
+
+int8_t I2cReadCallbackRegister(I2cStruct *i2c, I2cReadCallback func);
+
+int8_t TimerInit(TimerStruct *timer, TimerInitStruct *init);
+
+int8_t TimerUpdateCallbackRegister(TimerStruct *timer, TimerUpdateCpltFunc func);
+
+void CycleCounterEnable(void);
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <stdio.h>
+
+// 主机上不编译 easy_log，模块里的日志直接打印到标准输出
+
+#define elog_e(tag, ...)    host_log("E", tag, __VA_ARGS__)
+#define elog_w(tag, ...)    host_log("W", tag, __VA_ARGS__)
+#define elog_i(tag, ...)    host_log("I", tag, __VA_ARGS__)
+#define elog_d(tag, ...)    host_log("D", tag, __VA_ARGS__)
+
+#define host_log(lvl, tag, ...) \
+    do { printf(lvl "/%s ", tag); printf(__VA_ARGS__); printf("\n"); } while(0)
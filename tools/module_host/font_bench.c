@@ -0,0 +1,225 @@
+/*
+ * 在主机上检查 font.c 的渲染缓存并测绘制一帧时钟文字的耗时
+ *
+ * cd tools/module_host && make font_bench && ./font_bench
+ *
+ * 检查每个字符缓存的像素块和点阵逐像素展开的结果一致，缓存命中、未命中和最久未用替换的次数，
+ * 以及七段码滚动的首尾。然后测 "HH:MM:SS" 加温湿度一行：缓存全部失效、全部命中，
+ * 和不用缓存每次都展开的对照。blit 是拷进帧缓冲，"no copy" 一行只交出地址，相当于每个字符一次 DMA。
+ * 主机比 Cortex-M4 快得多，耗时只看相对变化，目标上用 font_bench 命令看周期数。
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "font.h"
+#include "driver.h"
+
+#define BENCH_FRAMES        1000000
+#define SCREEN_WIDTH        160
+#define SCREEN_HEIGHT       (2 * FONT_HEIGHT)
+
+static const char time_text[] = "12:34:56";
+static const char temp_text[] = "23.5\x7f" "C 45%";
+
+static uint16_t screen[SCREEN_HEIGHT][SCREEN_WIDTH];
+static uint32_t blit_calls = 0;
+static uint64_t blit_bytes = 0;
+static int failed = 0;
+
+#define CHECK(cond, ...) \
+    do { if(!(cond)) { printf("FAIL line %d: ", __LINE__); printf(__VA_ARGS__); printf("\n"); failed = 1; } } while(0)
+
+static double now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// 拷进帧缓冲，和固件 font_bench 的 blit 一样按整块 memcpy 计
+static void screen_blit(uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint16_t *pixels)
+{
+    uint16_t row;
+
+    for(row = 0; row < h; row++)
+        memcpy(&screen[y + row][x], &pixels[row * w], w * sizeof(uint16_t));
+    blit_calls ++;
+    blit_bytes += (uint32_t)w * h * sizeof(uint16_t);
+}
+
+// 只交出像素块的地址，相当于目标上 SPI 屏每个字符启动一次 DMA
+static void handoff_blit(uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint16_t *pixels)
+{
+    (void)x;
+    (void)y;
+    blit_calls ++;
+    blit_bytes += (uint32_t)w * h * sizeof(pixels[0]);
+}
+
+// 不用缓存，每个字符都从点阵展开
+static void draw_uncached(uint16_t x, uint16_t y, const char *text, uint16_t fg, uint16_t bg)
+{
+    uint16_t pixels[FONT_GLYPH_PIXELS];
+    const uint8_t *bitmap;
+    uint8_t row, i;
+
+    for(; *text != '\0'; text++, x += FONT_WIDTH) {
+        bitmap = FontBitmap(*text);
+        for(row = 0; row < FONT_HEIGHT; row++) {
+            for(i = 0; i < FONT_WIDTH; i++)
+                pixels[row * FONT_WIDTH + i] = (bitmap[row] << i) & 0x80 ? fg : bg;
+        }
+        screen_blit(x, y, FONT_WIDTH, FONT_HEIGHT, pixels);
+    }
+}
+
+static void draw_frame(void)
+{
+    FontDrawText(0, 0, time_text, FONT_COLOR_WHITE, FONT_COLOR_BLACK, &screen_blit);
+    FontDrawText(0, FONT_HEIGHT, temp_text, FONT_COLOR_WHITE, FONT_COLOR_BLACK, &screen_blit);
+}
+
+static void check_glyphs(void)
+{
+    static const uint16_t color[][2] = {
+        { FONT_COLOR_WHITE, FONT_COLOR_BLACK },
+        { FONT_COLOR(255, 0, 0), FONT_COLOR(0, 0, 64) },
+    };
+    const uint16_t *pixels;
+    const uint8_t *bitmap;
+    uint8_t row, i, n;
+    int c;
+
+    for(n = 0; n < sizeof(color) / sizeof(color[0]); n++) {
+        for(c = FONT_CHAR_FIRST; c < FONT_CHAR_FIRST + FONT_CHAR_NUM; c++) {
+            // 连续取两次，第二次来自缓存
+            FontGlyphPixels((char)c, color[n][0], color[n][1]);
+            pixels = FontGlyphPixels((char)c, color[n][0], color[n][1]);
+            bitmap = FontBitmap((char)c);
+            for(row = 0; row < FONT_HEIGHT; row++) {
+                for(i = 0; i < FONT_WIDTH; i++) {
+                    CHECK(pixels[row * FONT_WIDTH + i] == ((bitmap[row] << i) & 0x80 ? color[n][0] : color[n][1]),
+                        "char 0x%02x row %d col %d", c, row, i);
+                }
+            }
+        }
+    }
+    // 字库外的字符显示为空格
+    CHECK(FontBitmap('\x01') == FontBitmap(' ') && FontBitmap('Z') == FontBitmap(' '), "missing char not blank");
+    CHECK(FontSegments('8') == (DISPLAY_SEG_A | DISPLAY_SEG_B | DISPLAY_SEG_C | DISPLAY_SEG_D | DISPLAY_SEG_E |
+        DISPLAY_SEG_F | DISPLAY_SEG_G), "segments of 8");
+    for(c = '0'; c <= '9'; c++) {
+        CHECK(FontSegmentsRoll(FontSegments('0'), FontSegments((char)c), 0) == FontSegments('0'), "roll start");
+        CHECK(FontSegmentsRoll(FontSegments('0'), FontSegments((char)c), FONT_SEGMENT_ROLL_STEPS) ==
+            FontSegments((char)c), "roll end");
+    }
+    printf("glyphs: %d chars x %d colour pairs match the bitmap\n", FONT_CHAR_NUM,
+        (int)(sizeof(color) / sizeof(color[0])));
+}
+
+/**
+ * @brief 一帧的缓存行为：冷启动每个不同字符一次未命中，之后全部命中；不同字符多于缓存时替换最久没用的
+ */
+static void check_cache(void)
+{
+    FontStat start, stat;
+    uint32_t intruder_misses;
+    uint8_t distinct = 0, seen[256] = { 0 };
+    const char *text;
+
+    for(text = time_text; *text != '\0'; text++)
+        distinct += seen[(uint8_t)*text] ++ == 0;
+    for(text = temp_text; *text != '\0'; text++)
+        distinct += seen[(uint8_t)*text] ++ == 0;
+
+    // 用不在帧里的颜色把缓存挤满，相当于清空
+    for(text = "0123456789:."; *text != '\0'; text++)
+        FontGlyphPixels(*text, FONT_COLOR(1, 2, 3), FONT_COLOR(4, 5, 6));
+
+    FontGetStat(&start);
+    draw_frame();
+    FontGetStat(&stat);
+    CHECK(stat.misses - start.misses == distinct, "cold frame %u misses, expected %u", stat.misses - start.misses,
+        distinct);
+
+    start = stat;
+    draw_frame();
+    FontGetStat(&stat);
+    CHECK(stat.misses == start.misses, "warm frame %u misses", stat.misses - start.misses);
+    CHECK(distinct <= FONT_CACHE_SIZE, "%u distinct chars do not fit the cache", distinct);
+
+    // 帧里的字形正好占满缓存时插进一个别的字形，按最久未用替换，这一帧最多每个字形重新渲染一次，
+    // 下一帧又全部命中
+    FontGlyphPixels('-', FONT_COLOR_WHITE, FONT_COLOR_BLACK);
+    FontGetStat(&start);
+    draw_frame();
+    FontGetStat(&stat);
+    intruder_misses = stat.misses - start.misses;
+    CHECK(intruder_misses <= distinct, "frame after a new glyph: %u misses", intruder_misses);
+    start = stat;
+    draw_frame();
+    FontGetStat(&stat);
+    CHECK(stat.misses == start.misses, "no recovery after a new glyph: %u misses", stat.misses - start.misses);
+
+    printf("cache: %u distinct chars per frame in %d entries, cold frame misses each once, warm frame all hits, "
+        "one extra glyph costs %u misses once\n", distinct, FONT_CACHE_SIZE, intruder_misses);
+}
+
+static void bench(void)
+{
+    double start, cold, warm, handoff, uncached;
+    uint32_t i, calls, bytes;
+
+    start = now_ns();
+    for(i = 0; i < BENCH_FRAMES / 100; i++) {
+        // 每帧换一对颜色，缓存永远不命中
+        FontDrawText(0, 0, time_text, (uint16_t)(i * 2), FONT_COLOR_BLACK, &screen_blit);
+        FontDrawText(0, FONT_HEIGHT, temp_text, (uint16_t)(i * 2), FONT_COLOR_BLACK, &screen_blit);
+    }
+    cold = (now_ns() - start) / (BENCH_FRAMES / 100);
+
+    draw_frame();
+    blit_calls = 0;
+    blit_bytes = 0;
+    start = now_ns();
+    for(i = 0; i < BENCH_FRAMES; i++)
+        draw_frame();
+    warm = (now_ns() - start) / BENCH_FRAMES;
+    calls = blit_calls / BENCH_FRAMES;
+    bytes = (uint32_t)(blit_bytes / BENCH_FRAMES);
+
+    start = now_ns();
+    for(i = 0; i < BENCH_FRAMES; i++) {
+        FontDrawText(0, 0, time_text, FONT_COLOR_WHITE, FONT_COLOR_BLACK, &handoff_blit);
+        FontDrawText(0, FONT_HEIGHT, temp_text, FONT_COLOR_WHITE, FONT_COLOR_BLACK, &handoff_blit);
+    }
+    handoff = (now_ns() - start) / BENCH_FRAMES;
+
+    start = now_ns();
+    for(i = 0; i < BENCH_FRAMES / 10; i++) {
+        draw_uncached(0, 0, time_text, FONT_COLOR_WHITE, FONT_COLOR_BLACK);
+        draw_uncached(0, FONT_HEIGHT, temp_text, FONT_COLOR_WHITE, FONT_COLOR_BLACK);
+    }
+    uncached = (now_ns() - start) / (BENCH_FRAMES / 10);
+
+    printf("\nframe \"%s\" + \"23.5'C 45%%\": %u blits, %u bytes\n", time_text, calls, bytes);
+    printf("%-20s %8.1f ns/frame\n", "cache miss", cold);
+    printf("%-20s %8.1f ns/frame\n", "cache hit", warm);
+    printf("%-20s %8.1f ns/frame\n", "cache hit, no copy", handoff);
+    printf("%-20s %8.1f ns/frame\n", "no cache", uncached);
+}
+
+int main(void)
+{
+    FontInit();
+    check_glyphs();
+    check_cache();
+    bench();
+
+    printf(failed ? "FAILED\n" : "PASSED\n");
+
+    return failed;
+}
@@ -0,0 +1,214 @@
+/*
+ * 主机编译固件模块时代替芯片头文件，只提供模块里用到的 CMSIS 定义和外设库接口
+ * 测试是单线程的，关中断什么也不做；DWT 周期计数器由外设模型按模拟时间推进，不用模型时不走
+ *
+ * 外设库接口在 host_periph.c 里实现成一个简单的模型：寄存器是主机内存里的数组，
+ * 固件把地址转成 uint32_t 交给 DMA，所以要用 -no-pie 链接，让静态数据落在低 4GB 里
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+typedef struct {
+    uint32_t DEMCR;
+} CoreDebugType;
+
+typedef struct {
+    uint32_t CTRL;
+    uint32_t CYCCNT;
+} DwtType;
+
+extern CoreDebugType HostCoreDebug;
+extern DwtType HostDwt;
+extern uint32_t SystemCoreClock;
+
+#define CoreDebug                       (&HostCoreDebug)
+#define DWT                             (&HostDwt)
+#define CoreDebug_DEMCR_TRCENA_Msk      (1UL << 24)
+#define DWT_CTRL_CYCCNTENA_Msk          (1UL << 0)
+
+static inline uint32_t __get_PRIMASK(void)
+{
+    return 0;
+}
+
+static inline void __set_PRIMASK(uint32_t primask)
+{
+    (void)primask;
+}
+
+static inline void __disable_irq(void)
+{
+}
+
+/* 外设模型 */
+
+#define REG32(addr)                     (*(volatile uint32_t *)(uintptr_t)(addr))
+#define BIT(x)                          ((uint32_t)((uint32_t)0x01U << (x)))
+
+typedef enum {DISABLE = 0, ENABLE = !DISABLE} EventStatus, ControlStatus;
+typedef enum {RESET = 0, SET = !RESET} FlagStatus;
+typedef enum {ERROR = 0, SUCCESS = !ERROR} ErrStatus;
+
+extern uint32_t HostGpioReg[4][8];
+extern uint32_t HostTimerReg[1][32];
+
+#define GPIOA                           ((uint32_t)(uintptr_t)HostGpioReg[0])
+#define GPIOB                           ((uint32_t)(uintptr_t)HostGpioReg[1])
+#define GPIOC                           ((uint32_t)(uintptr_t)HostGpioReg[2])
+#define GPIOD                           ((uint32_t)(uintptr_t)HostGpioReg[3])
+#define GPIO_OCTL(gpiox)                REG32((gpiox) + 0x0CU)
+#define GPIO_BOP(gpiox)                 REG32((gpiox) + 0x10U)
+#define GPIO_BC(gpiox)                  REG32((gpiox) + 0x14U)
+
+#define GPIO_PIN_0                      BIT(0)
+#define GPIO_PIN_1                      BIT(1)
+#define GPIO_PIN_2                      BIT(2)
+#define GPIO_PIN_3                      BIT(3)
+#define GPIO_PIN_4                      BIT(4)
+#define GPIO_PIN_5                      BIT(5)
+#define GPIO_PIN_6                      BIT(6)
+#define GPIO_PIN_7                      BIT(7)
+#define GPIO_PIN_8                      BIT(8)
+#define GPIO_PIN_9                      BIT(9)
+#define GPIO_PIN_10                     BIT(10)
+#define GPIO_PIN_11                     BIT(11)
+#define GPIO_PIN_12                     BIT(12)
+#define GPIO_PIN_13                     BIT(13)
+#define GPIO_PIN_14                     BIT(14)
+#define GPIO_PIN_15                     BIT(15)
+#define GPIO_MODE_OUT_PP                0x10U
+#define GPIO_MODE_AF_PP                 0x18U
+#define GPIO_OSPEED_50MHZ               0x03U
+
+typedef enum {
+    RCU_GPIOA, RCU_GPIOB, RCU_GPIOC, RCU_GPIOD, RCU_DMA0, RCU_DMA1, RCU_TIMER0, RCU_SPI2,
+} rcu_periph_enum;
+
+typedef enum {
+    CK_SYS, CK_AHB, CK_APB1, CK_APB2,
+} rcu_clock_freq_enum;
+
+typedef enum {
+    DMA0_Channel1_IRQn = 12, DMA0_Channel2_IRQn = 13,
+} IRQn_Type;
+
+#define DMA0                            0U
+#define DMA1                            1U
+
+typedef enum {
+    DMA_CH0 = 0, DMA_CH1, DMA_CH2, DMA_CH3, DMA_CH4, DMA_CH5, DMA_CH6,
+} dma_channel_enum;
+
+typedef struct
+{
+    uint32_t periph_addr;
+    uint32_t periph_width;
+    uint32_t memory_addr;
+    uint32_t memory_width;
+    uint32_t number;
+    uint32_t priority;
+    uint8_t periph_inc;
+    uint8_t memory_inc;
+    uint8_t direction;
+}dma_parameter_struct;
+
+#define DMA_PERIPHERAL_TO_MEMORY        0x00U
+#define DMA_MEMORY_TO_PERIPHERAL        0x01U
+#define DMA_PERIPH_INCREASE_DISABLE     0x00U
+#define DMA_PERIPH_INCREASE_ENABLE      0x01U
+#define DMA_MEMORY_INCREASE_DISABLE     0x00U
+#define DMA_MEMORY_INCREASE_ENABLE      0x01U
+#define DMA_PERIPHERAL_WIDTH_8BIT       0U
+#define DMA_PERIPHERAL_WIDTH_16BIT      1U
+#define DMA_PERIPHERAL_WIDTH_32BIT      2U
+#define DMA_MEMORY_WIDTH_8BIT           0U
+#define DMA_MEMORY_WIDTH_16BIT          1U
+#define DMA_MEMORY_WIDTH_32BIT          2U
+#define DMA_PRIORITY_LOW                0U
+#define DMA_PRIORITY_MEDIUM             1U
+#define DMA_PRIORITY_HIGH               2U
+#define DMA_PRIORITY_ULTRA_HIGH         3U
+#define DMA_INT_FTF                     BIT(1)
+#define DMA_INT_HTF                     BIT(2)
+#define DMA_INT_ERR                     BIT(3)
+
+#define TIMER0                          ((uint32_t)(uintptr_t)HostTimerReg[0])
+#define TIMER_CH0CV(timerx)             REG32((timerx) + 0x34U)
+#define TIMER_CH1CV(timerx)             REG32((timerx) + 0x38U)
+
+typedef struct
+{
+    uint16_t prescaler;
+    uint16_t alignedmode;
+    uint16_t counterdirection;
+    uint16_t clockdivision;
+    uint32_t period;
+    uint8_t  repetitioncounter;
+}timer_parameter_struct;
+
+typedef struct
+{
+    uint16_t outputstate;
+    uint16_t outputnstate;
+    uint16_t ocpolarity;
+    uint16_t ocnpolarity;
+    uint16_t ocidlestate;
+    uint16_t ocnidlestate;
+}timer_oc_parameter_struct;
+
+#define TIMER_COUNTER_EDGE              0U
+#define TIMER_COUNTER_UP                0U
+#define TIMER_CH_0                      0U
+#define TIMER_CH_1                      1U
+#define TIMER_CCX_DISABLE               0U
+#define TIMER_CCX_ENABLE                1U
+#define TIMER_CCXN_DISABLE              0U
+#define TIMER_CCXN_ENABLE               1U
+#define TIMER_OC_POLARITY_HIGH          0U
+#define TIMER_OCN_POLARITY_HIGH         0U
+#define TIMER_OC_IDLE_STATE_LOW         0U
+#define TIMER_OCN_IDLE_STATE_LOW        0U
+#define TIMER_OC_MODE_PWM0              6U
+#define TIMER_OC_SHADOW_ENABLE          1U
+#define TIMER_DMAREQUEST_UPDATEEVENT    1U
+#define TIMER_DMA_CH0D                  BIT(9)
+#define TIMER_DMA_CH1D                  BIT(10)
+
+void nvic_irq_enable(uint8_t nvic_irq, uint8_t nvic_irq_pre_priority, uint8_t nvic_irq_sub_priority);
+
+void rcu_periph_clock_enable(rcu_periph_enum periph);
+uint32_t rcu_clock_freq_get(rcu_clock_freq_enum clock);
+
+void gpio_init(uint32_t gpio_periph, uint32_t mode, uint32_t speed, uint32_t pin);
+void gpio_bit_set(uint32_t gpio_periph, uint32_t pin);
+void gpio_bit_reset(uint32_t gpio_periph, uint32_t pin);
+
+void dma_deinit(uint32_t dma_periph, dma_channel_enum channelx);
+void dma_struct_para_init(dma_parameter_struct *init_struct);
+void dma_init(uint32_t dma_periph, dma_channel_enum channelx, dma_parameter_struct *init_struct);
+void dma_circulation_enable(uint32_t dma_periph, dma_channel_enum channelx);
+void dma_circulation_disable(uint32_t dma_periph, dma_channel_enum channelx);
+void dma_memory_to_memory_disable(uint32_t dma_periph, dma_channel_enum channelx);
+void dma_channel_enable(uint32_t dma_periph, dma_channel_enum channelx);
+void dma_channel_disable(uint32_t dma_periph, dma_channel_enum channelx);
+void dma_memory_address_config(uint32_t dma_periph, dma_channel_enum channelx, uint32_t address);
+void dma_transfer_number_config(uint32_t dma_periph, dma_channel_enum channelx, uint32_t number);
+uint32_t dma_transfer_number_get(uint32_t dma_periph, dma_channel_enum channelx);
+void dma_interrupt_enable(uint32_t dma_periph, dma_channel_enum channelx, uint32_t source);
+void dma_interrupt_disable(uint32_t dma_periph, dma_channel_enum channelx, uint32_t source);
+
+void timer_deinit(uint32_t timer_periph);
+void timer_struct_para_init(timer_parameter_struct *initpara);
+void timer_init(uint32_t timer_periph, timer_parameter_struct *initpara);
+void timer_channel_output_struct_para_init(timer_oc_parameter_struct *ocpara);
+void timer_channel_output_config(uint32_t timer_periph, uint16_t channel, timer_oc_parameter_struct *ocpara);
+void timer_channel_output_mode_config(uint32_t timer_periph, uint16_t channel, uint16_t ocmode);
+void timer_channel_output_shadow_config(uint32_t timer_periph, uint16_t channel, uint16_t ocshadow);
+void timer_channel_output_pulse_value_config(uint32_t timer_periph, uint16_t channel, uint32_t pulse);
+void timer_primary_output_config(uint32_t timer_periph, ControlStatus newvalue);
+void timer_channel_dma_request_source_select(uint32_t timer_periph, uint8_t dma_request);
+void timer_dma_enable(uint32_t timer_periph, uint16_t dma);
+void timer_auto_reload_shadow_enable(uint32_t timer_periph);
+void timer_enable(uint32_t timer_periph);
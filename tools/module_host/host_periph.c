@@ -0,0 +1,360 @@
+/*
+ * 主机上的外设库模型，只模拟固件模块用到的行为
+ *
+ * 定时器每个更新事件先把比较值的预装载值装进影子寄存器，再按 DMA 请求使能发出请求。
+ * DMA 每个请求搬运一个数据，传输完成后循环模式重新装载，打开了完成中断就调用登记的中断函数。
+ * DMA 写到 GPIO_BOP 时按置位/清零的含义更新输出寄存器。DWT 周期计数器随更新事件前进。
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "host_periph.h"
+
+#define HOST_DMA_NUM        2
+#define HOST_DMA_CHL_NUM    7
+#define HOST_TIMER_NUM      1
+#define HOST_GPIO_NUM       4
+
+typedef struct
+{
+    dma_parameter_struct init;
+    uint8_t circular;
+    uint8_t enable;
+    uint32_t int_enable;
+    uint32_t remaining;
+    uint32_t index;
+    HostIrqFunc irq;
+    uint32_t irq_count;
+}HostDmaChannel;
+
+typedef struct
+{
+    timer_parameter_struct init;
+    uint8_t enable;
+    uint8_t dma_request_update;
+    uint16_t dma_enable;
+    uint32_t active_pulse[4];
+}HostTimer;
+
+uint32_t HostGpioReg[HOST_GPIO_NUM][8];
+uint32_t HostTimerReg[HOST_TIMER_NUM][32];
+
+static HostDmaChannel dma_channel[HOST_DMA_NUM][HOST_DMA_CHL_NUM];
+static HostTimer host_timer[HOST_TIMER_NUM];
+
+static HostTimer *timer_get(uint32_t timer_periph)
+{
+    return &host_timer[(timer_periph - TIMER0) / sizeof(HostTimerReg[0])];
+}
+
+static uint32_t width_bytes(uint32_t width)
+{
+    return 1U << width;
+}
+
+static uint32_t mem_read(uint32_t addr, uint32_t width)
+{
+    if(width == 0)
+        return *(volatile uint8_t *)(uintptr_t)addr;
+    if(width == 1)
+        return *(volatile uint16_t *)(uintptr_t)addr;
+    return *(volatile uint32_t *)(uintptr_t)addr;
+}
+
+static void mem_write(uint32_t addr, uint32_t width, uint32_t value)
+{
+    uint8_t port;
+
+    if(width == 0)
+        *(volatile uint8_t *)(uintptr_t)addr = (uint8_t)value;
+    else if(width == 1)
+        *(volatile uint16_t *)(uintptr_t)addr = (uint16_t)value;
+    else
+        *(volatile uint32_t *)(uintptr_t)addr = value;
+
+    // BOP写入：低16位置位，高16位清零，置位优先
+    for(port = 0; port < HOST_GPIO_NUM; port++) {
+        if(addr == (uint32_t)(uintptr_t)&HostGpioReg[port][4]) {
+            HostGpioReg[port][3] &= ~(value >> 16);
+            HostGpioReg[port][3] |= value & 0xffff;
+        }
+    }
+}
+
+static void dma_request(uint32_t dma_periph, dma_channel_enum channelx)
+{
+    HostDmaChannel *chl = &dma_channel[dma_periph][channelx];
+    dma_parameter_struct *init = &chl->init;
+    uint32_t mem_addr, periph_addr;
+
+    if(chl->enable == 0 || chl->remaining == 0)
+        return;
+
+    mem_addr = init->memory_addr + (init->memory_inc ? chl->index * width_bytes(init->memory_width) : 0);
+    periph_addr = init->periph_addr + (init->periph_inc ? chl->index * width_bytes(init->periph_width) : 0);
+    if(init->direction == DMA_MEMORY_TO_PERIPHERAL)
+        mem_write(periph_addr, init->periph_width, mem_read(mem_addr, init->memory_width));
+    else
+        mem_write(mem_addr, init->memory_width, mem_read(periph_addr, init->periph_width));
+    chl->index ++;
+    chl->remaining --;
+
+    if(chl->remaining == 0) {
+        if(chl->circular) {
+            chl->remaining = init->number;
+            chl->index = 0;
+        }
+        if((chl->int_enable & DMA_INT_FTF) && chl->irq != NULL) {
+            chl->irq_count ++;
+            chl->irq();
+        }
+    }
+}
+
+void nvic_irq_enable(uint8_t nvic_irq, uint8_t nvic_irq_pre_priority, uint8_t nvic_irq_sub_priority)
+{
+    (void)nvic_irq;
+    (void)nvic_irq_pre_priority;
+    (void)nvic_irq_sub_priority;
+}
+
+void rcu_periph_clock_enable(rcu_periph_enum periph)
+{
+    (void)periph;
+}
+
+uint32_t TimerClockGet(uint32_t timer_periph)
+{
+    (void)timer_periph;
+
+    return HOST_CORE_CLOCK;
+}
+
+uint32_t rcu_clock_freq_get(rcu_clock_freq_enum clock)
+{
+    (void)clock;
+
+    return HOST_CORE_CLOCK;
+}
+
+void gpio_init(uint32_t gpio_periph, uint32_t mode, uint32_t speed, uint32_t pin)
+{
+    (void)gpio_periph;
+    (void)mode;
+    (void)speed;
+    (void)pin;
+}
+
+void gpio_bit_set(uint32_t gpio_periph, uint32_t pin)
+{
+    GPIO_OCTL(gpio_periph) |= pin;
+}
+
+void gpio_bit_reset(uint32_t gpio_periph, uint32_t pin)
+{
+    GPIO_OCTL(gpio_periph) &= ~pin;
+}
+
+void dma_deinit(uint32_t dma_periph, dma_channel_enum channelx)
+{
+    HostIrqFunc irq = dma_channel[dma_periph][channelx].irq;
+
+    memset(&dma_channel[dma_periph][channelx], 0, sizeof(HostDmaChannel));
+    dma_channel[dma_periph][channelx].irq = irq;
+}
+
+void dma_struct_para_init(dma_parameter_struct *init_struct)
+{
+    memset(init_struct, 0, sizeof(*init_struct));
+}
+
+void dma_init(uint32_t dma_periph, dma_channel_enum channelx, dma_parameter_struct *init_struct)
+{
+    dma_channel[dma_periph][channelx].init = *init_struct;
+    dma_channel[dma_periph][channelx].remaining = init_struct->number;
+}
+
+void dma_circulation_enable(uint32_t dma_periph, dma_channel_enum channelx)
+{
+    dma_channel[dma_periph][channelx].circular = 1;
+}
+
+void dma_circulation_disable(uint32_t dma_periph, dma_channel_enum channelx)
+{
+    dma_channel[dma_periph][channelx].circular = 0;
+}
+
+void dma_memory_to_memory_disable(uint32_t dma_periph, dma_channel_enum channelx)
+{
+    (void)dma_periph;
+    (void)channelx;
+}
+
+void dma_channel_enable(uint32_t dma_periph, dma_channel_enum channelx)
+{
+    HostDmaChannel *chl = &dma_channel[dma_periph][channelx];
+
+    // 重新使能时从头开始，剩余数量取最近一次配置的值
+    if(chl->enable == 0)
+        chl->index = 0;
+    chl->enable = 1;
+}
+
+void dma_channel_disable(uint32_t dma_periph, dma_channel_enum channelx)
+{
+    dma_channel[dma_periph][channelx].enable = 0;
+}
+
+void dma_memory_address_config(uint32_t dma_periph, dma_channel_enum channelx, uint32_t address)
+{
+    dma_channel[dma_periph][channelx].init.memory_addr = address;
+}
+
+void dma_transfer_number_config(uint32_t dma_periph, dma_channel_enum channelx, uint32_t number)
+{
+    dma_channel[dma_periph][channelx].init.number = number;
+    dma_channel[dma_periph][channelx].remaining = number;
+}
+
+uint32_t dma_transfer_number_get(uint32_t dma_periph, dma_channel_enum channelx)
+{
+    return dma_channel[dma_periph][channelx].remaining;
+}
+
+void dma_interrupt_enable(uint32_t dma_periph, dma_channel_enum channelx, uint32_t source)
+{
+    dma_channel[dma_periph][channelx].int_enable |= source;
+}
+
+void dma_interrupt_disable(uint32_t dma_periph, dma_channel_enum channelx, uint32_t source)
+{
+    dma_channel[dma_periph][channelx].int_enable &= ~source;
+}
+
+void timer_deinit(uint32_t timer_periph)
+{
+    memset(timer_get(timer_periph), 0, sizeof(HostTimer));
+    memset((void *)(uintptr_t)timer_periph, 0, sizeof(HostTimerReg[0]));
+}
+
+void timer_struct_para_init(timer_parameter_struct *initpara)
+{
+    memset(initpara, 0, sizeof(*initpara));
+    initpara->period = 65535U;
+}
+
+void timer_init(uint32_t timer_periph, timer_parameter_struct *initpara)
+{
+    timer_get(timer_periph)->init = *initpara;
+}
+
+void timer_channel_output_struct_para_init(timer_oc_parameter_struct *ocpara)
+{
+    memset(ocpara, 0, sizeof(*ocpara));
+}
+
+void timer_channel_output_config(uint32_t timer_periph, uint16_t channel, timer_oc_parameter_struct *ocpara)
+{
+    (void)timer_periph;
+    (void)channel;
+    (void)ocpara;
+}
+
+void timer_channel_output_mode_config(uint32_t timer_periph, uint16_t channel, uint16_t ocmode)
+{
+    (void)timer_periph;
+    (void)channel;
+    (void)ocmode;
+}
+
+void timer_channel_output_shadow_config(uint32_t timer_periph, uint16_t channel, uint16_t ocshadow)
+{
+    (void)timer_periph;
+    (void)channel;
+    (void)ocshadow;
+}
+
+void timer_channel_output_pulse_value_config(uint32_t timer_periph, uint16_t channel, uint32_t pulse)
+{
+    REG32(timer_periph + 0x34U + channel * 4U) = pulse;
+}
+
+void timer_primary_output_config(uint32_t timer_periph, ControlStatus newvalue)
+{
+    (void)timer_periph;
+    (void)newvalue;
+}
+
+void timer_channel_dma_request_source_select(uint32_t timer_periph, uint8_t dma_request)
+{
+    timer_get(timer_periph)->dma_request_update = dma_request == TIMER_DMAREQUEST_UPDATEEVENT;
+}
+
+void timer_dma_enable(uint32_t timer_periph, uint16_t dma)
+{
+    timer_get(timer_periph)->dma_enable |= dma;
+}
+
+void timer_auto_reload_shadow_enable(uint32_t timer_periph)
+{
+    (void)timer_periph;
+}
+
+void timer_enable(uint32_t timer_periph)
+{
+    timer_get(timer_periph)->enable = 1;
+}
+
+/**
+ * @brief 一个更新事件：比较值装入影子寄存器，CH0/CH1的DMA请求分别对应DMA0的通道1/2
+ */
+void HostTimerUpdateEvent(uint32_t timer_periph)
+{
+    HostTimer *timer = timer_get(timer_periph);
+    uint8_t ch;
+
+    if(timer->enable == 0)
+        return;
+
+    HostDwt.CYCCNT += HostTimerPeriodTicks(timer_periph) * (timer->init.prescaler + 1U);
+    for(ch = 0; ch < 4; ch++)
+        timer->active_pulse[ch] = REG32(timer_periph + 0x34U + ch * 4U);
+
+    if(timer->dma_request_update) {
+        if(timer->dma_enable & TIMER_DMA_CH0D)
+            dma_request(DMA0, DMA_CH1);
+        if(timer->dma_enable & TIMER_DMA_CH1D)
+            dma_request(DMA0, DMA_CH2);
+    }
+}
+
+uint32_t HostTimerPeriodTicks(uint32_t timer_periph)
+{
+    return timer_get(timer_periph)->init.period + 1U;
+}
+
+uint32_t HostTimerTickHz(uint32_t timer_periph)
+{
+    return HOST_CORE_CLOCK / (timer_get(timer_periph)->init.prescaler + 1U);
+}
+
+uint32_t HostTimerActivePulse(uint32_t timer_periph, uint16_t channel)
+{
+    return timer_get(timer_periph)->active_pulse[channel];
+}
+
+uint32_t HostGpioOutput(uint32_t gpio_periph)
+{
+    return GPIO_OCTL(gpio_periph);
+}
+
+void HostDmaIrqRegister(uint32_t dma_periph, dma_channel_enum channelx, HostIrqFunc func)
+{
+    dma_channel[dma_periph][channelx].irq = func;
+}
+
+uint32_t HostDmaIrqCount(uint32_t dma_periph, dma_channel_enum channelx)
+{
+    return dma_channel[dma_periph][channelx].irq_count;
+}
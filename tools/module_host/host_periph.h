@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stdint.h>
+#include "gd32f30x.h"
+
+// 主机上的外设模型：定时器更新事件由测试程序推进，触发 DMA 搬运，寄存器状态可以直接读出来
+
+#define HOST_CORE_CLOCK     120000000UL     // AHB 和 APB2 都是 120MHz
+
+typedef void (*HostIrqFunc)(void);
+
+void HostTimerUpdateEvent(uint32_t timer_periph);
+
+uint32_t HostTimerPeriodTicks(uint32_t timer_periph);
+
+uint32_t HostTimerTickHz(uint32_t timer_periph);
+
+uint32_t HostTimerActivePulse(uint32_t timer_periph, uint16_t channel);
+
+uint32_t HostGpioOutput(uint32_t gpio_periph);
+
+void HostDmaIrqRegister(uint32_t dma_periph, dma_channel_enum channelx, HostIrqFunc func);
+
+uint32_t HostDmaIrqCount(uint32_t dma_periph, dma_channel_enum channelx);
@@ -0,0 +1,186 @@
+/*
+ * 主机上的驱动层、系统时间和终端命令，给 module_host 下的测试用
+ *
+ * I2C 传输在 I2cMemRead 时只记下请求，HostI2cComplete 时才从寄存器映像拷数据并调读完成回调，
+ * 和目标上中断里完成传输的顺序一样。时间是模拟的，只在 HostTimeAdvance 里前进，
+ * 或者用 HostTimeStep 设成每读一次前进一步，让忙等的代码能走出来。
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "gd32f30x.h"
+#include "host_stub.h"
+#include "system_timer.h"
+#include "terminal_com.h"
+
+struct __I2cStruct
+{
+    uint8_t reg[256];
+    uint8_t busy;
+    uint8_t reg_addr;
+    uint8_t *data;
+    uint16_t data_len;
+    I2cReadCallback read_callback;
+};
+
+struct __TimerStruct
+{
+    TimerInitStruct Init;
+    TimerUpdateCpltFunc update_callback;
+};
+
+I2cStruct I2c0;
+TimerStruct Timer6;
+
+CoreDebugType HostCoreDebug;
+DwtType HostDwt;
+uint32_t SystemCoreClock = 120000000;
+
+static uint64_t time_us = 0;
+static uint32_t time_step_us = 0;
+static Command command[TERMINAL_COMMAND_MAX_NUM];
+static uint8_t command_num = 0;
+static const char *command_args = "";
+
+void HostTimeAdvance(uint32_t us)
+{
+    time_us += us;
+}
+
+/**
+ * @brief 每读一次系统时间就前进us，被测模块忙等延时或等待传输完成时时间才会走
+ */
+void HostTimeStep(uint32_t us)
+{
+    time_step_us = us;
+}
+
+uint64_t GetSystemTimer_us(void)
+{
+    time_us += time_step_us;
+
+    return time_us - time_step_us;
+}
+
+uint64_t GetSystemTimer_ms(void)
+{
+    return GetSystemTimer_us() / 1000;
+}
+
+int8_t TimerInit(TimerStruct *timer, TimerInitStruct *init)
+{
+    timer->Init = *init;
+
+    return 0;
+}
+
+int8_t TimerUpdateCallbackRegister(TimerStruct *timer, TimerUpdateCpltFunc func)
+{
+    timer->update_callback = func;
+
+    return 0;
+}
+
+void CycleCounterEnable(void)
+{
+    HostCoreDebug.DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    HostDwt.CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+void HostTimerUpdate(TimerStruct *timer)
+{
+    if(timer->update_callback != NULL)
+        timer->update_callback();
+}
+
+int8_t I2cMemRead(I2cStruct *i2c, uint8_t dev_addr, uint8_t reg_addr, uint8_t *data, uint16_t data_len)
+{
+    (void)dev_addr;
+    if(i2c->busy == 1)
+        return -1;
+
+    i2c->busy = 1;
+    i2c->reg_addr = reg_addr;
+    i2c->data = data;
+    i2c->data_len = data_len;
+
+    return 0;
+}
+
+int8_t I2cReadCallbackRegister(I2cStruct *i2c, I2cReadCallback func)
+{
+    i2c->read_callback = func;
+
+    return 0;
+}
+
+void HostI2cSetReg(I2cStruct *i2c, uint8_t reg_addr, const uint8_t *data, uint16_t data_len)
+{
+    memcpy(&i2c->reg[reg_addr], data, data_len);
+}
+
+/**
+ * @brief 完成正在进行的传输，没有传输时返回-1
+ */
+int8_t HostI2cComplete(I2cStruct *i2c)
+{
+    if(i2c->busy == 0)
+        return -1;
+
+    memcpy(i2c->data, &i2c->reg[i2c->reg_addr], i2c->data_len);
+    i2c->busy = 0;
+    if(i2c->read_callback != NULL)
+        i2c->read_callback(0);
+
+    return 0;
+}
+
+/**
+ * @brief 让正在进行的传输以总线错误结束，和驱动的错误中断一样以-1调读完成回调
+ */
+int8_t HostI2cFail(I2cStruct *i2c)
+{
+    if(i2c->busy == 0)
+        return -1;
+
+    i2c->busy = 0;
+    if(i2c->read_callback != NULL)
+        i2c->read_callback(-1);
+
+    return 0;
+}
+
+int8_t TerminalCommandRegister(const char *command_string, CommandFuncType* command_func)
+{
+    if(command_num >= TERMINAL_COMMAND_MAX_NUM)
+        return -1;
+
+    command[command_num].command_string = command_string;
+    command[command_num].command_func = command_func;
+    command_num ++;
+
+    return 0;
+}
+
+const char *TerminalCommandArgs(void)
+{
+    return command_args;
+}
+
+int8_t HostTerminalRun(const char *command_string, const char *args)
+{
+    uint8_t i;
+
+    for(i = 0; i < command_num; i++) {
+        if(strcmp(command[i].command_string, command_string) == 0) {
+            command_args = args;
+            command[i].command_func();
+            command_args = "";
+            return 0;
+        }
+    }
+    printf("no command %s\n", command_string);
+
+    return -1;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <stdint.h>
+#include "driver.h"
+
+// 主机上驱动层的模拟：时间、定时器和 I2C 都由测试程序推进
+
+void HostTimeAdvance(uint32_t us);
+
+void HostTimeStep(uint32_t us);
+
+void HostTimerUpdate(TimerStruct *timer);
+
+void HostI2cSetReg(I2cStruct *i2c, uint8_t reg_addr, const uint8_t *data, uint16_t data_len);
+
+int8_t HostI2cComplete(I2cStruct *i2c);
+
+int8_t HostI2cFail(I2cStruct *i2c);
+
+int8_t HostTerminalRun(const char *command_string, const char *args);
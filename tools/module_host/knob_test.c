@@ -0,0 +1,201 @@
+/*
+ * 在主机上跑 as5600.c 的旋钮处理：模拟 1kHz 的定时器和 I2C 读，检查档位事件、去抖和延迟，
+ * 再测每个采样的处理耗时
+ *
+ * cd tools/module_host && make knob_test && ./knob_test
+ *
+ * 档位参数和 as5600.c 里的一致：每圈 24 档，越过档位中心半个档位再加 1/8 档位的滞回才算一步，
+ * 连续 2 个采样越过才产生事件。主机比 Cortex-M4 快得多，耗时只看相对变化，目标上用 knob_stat 看。
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "as5600.h"
+#include "host_stub.h"
+
+#define DETENT_NUM          24
+#define WIDTH_Q8            ((AS5600_COUNTS_PER_REV << 8) / DETENT_NUM)
+#define THRESHOLD_Q8        (WIDTH_Q8 / 2 + WIDTH_Q8 / 8)
+#define LATENCY_MAX_MS      5
+// 速度低通每个采样衰减1/8，从快转降到停稳阈值以下要几十个采样
+#define SETTLE_MAX_MS       60
+#define BENCH_SAMPLES       2000000
+#define CROSS_MAX_NUM       1024
+
+static int32_t angle = 0;       // 模拟的累计角度，单位counts
+static uint32_t now_ms = 0;
+static uint32_t latency_max = 0;
+static int failed = 0;
+
+#define CHECK(cond, ...) \
+    do { if(!(cond)) { printf("FAIL line %d: ", __LINE__); printf(__VA_ARGS__); printf("\n"); failed = 1; } } while(0)
+
+static void sample(void)
+{
+    uint16_t raw = (uint16_t)(angle & (AS5600_COUNTS_PER_REV - 1));
+    uint8_t reg[2] = { (uint8_t)(raw >> 8), (uint8_t)raw };
+
+    HostTimeAdvance(1000);
+    now_ms ++;
+    HostI2cSetReg(&I2c0, 0x0C, reg, sizeof(reg));
+    HostTimerUpdate(&Timer6);
+    HostI2cComplete(&I2c0);
+}
+
+static int32_t detent_center(int32_t detent)
+{
+    return (int32_t)(((int64_t)detent * WIDTH_Q8 + 128) >> 8);
+}
+
+/**
+ * @brief 每个采样转过speed个counts，共ms个采样，记录每次越过档位阈值的时刻并和事件比对
+ */
+static void rotate(int32_t speed, uint32_t ms, int32_t *detent)
+{
+    KnobEvent event;
+    uint32_t cross_ms[CROSS_MAX_NUM];
+    uint32_t tail = LATENCY_MAX_MS;
+    int32_t cross_num = 0, step_num = 0;
+    int32_t model = *detent;
+    int64_t offset_q8;
+
+    // 停下后再采几个样，最后一次越过阈值的事件也要在延迟上限内出来
+    while(ms != 0 || tail -- != 0) {
+        if(ms != 0) {
+            angle += speed;
+            ms --;
+        }
+        sample();
+        // 按同样的阈值算出期望的档位，记下越过阈值的时刻
+        offset_q8 = (int64_t)angle * 256 - (int64_t)model * WIDTH_Q8;
+        while(offset_q8 > THRESHOLD_Q8 || offset_q8 < -THRESHOLD_Q8) {
+            model += offset_q8 > 0 ? 1 : -1;
+            offset_q8 = (int64_t)angle * 256 - (int64_t)model * WIDTH_Q8;
+            if(cross_num < CROSS_MAX_NUM)
+                cross_ms[cross_num] = now_ms;
+            cross_num ++;
+        }
+        while(As5600GetEvent(&event) == 0) {
+            if(event.type == KNOB_EVENT_DETENT)
+                continue;
+            CHECK(event.type == (speed > 0 ? KNOB_EVENT_STEP_CW : KNOB_EVENT_STEP_CCW), "wrong direction");
+            if(step_num < cross_num && step_num < CROSS_MAX_NUM) {
+                CHECK(event.time_ms - cross_ms[step_num] < LATENCY_MAX_MS, "step %d latency %u ms", step_num,
+                    event.time_ms - cross_ms[step_num]);
+                if(event.time_ms - cross_ms[step_num] > latency_max)
+                    latency_max = event.time_ms - cross_ms[step_num];
+            }
+            step_num ++;
+        }
+    }
+    CHECK(step_num == cross_num, "speed %d: %d steps, expected %d", speed, step_num, cross_num);
+    CHECK(As5600GetDetent() == model, "detent %d, expected %d", As5600GetDetent(), model);
+    *detent = model;
+}
+
+/**
+ * @brief 停在原地ms个采样，角度加上幅度为noise的抖动，返回期间的步进事件数和是否报告了停稳
+ */
+static int32_t hold(int32_t noise, uint32_t ms, uint8_t *detent_event)
+{
+    KnobEvent event;
+    int32_t base = angle, step_num = 0;
+    uint32_t i;
+
+    *detent_event = 0;
+    for(i = 0; i < ms; i++) {
+        angle = base + ((i & 1) ? noise : -noise);
+        sample();
+        while(As5600GetEvent(&event) == 0) {
+            if(event.type == KNOB_EVENT_DETENT)
+                *detent_event = 1;
+            else
+                step_num ++;
+        }
+    }
+    angle = base;
+
+    return step_num;
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main(void)
+{
+    KnobEvent event;
+    KnobStat stat;
+    int32_t detent = 5;
+    uint8_t settled;
+    double start;
+    uint32_t i;
+
+    // 上电时停在5档中心
+    angle = detent_center(detent);
+    As5600Init();
+    CHECK(hold(0, 20, &settled) == 0, "events while idle");
+    CHECK(As5600GetDetent() == detent, "initial detent %d", As5600GetDetent());
+
+    // 慢转、快转、反向越过0点
+    rotate(17, 300, &detent);
+    CHECK(hold(0, SETTLE_MAX_MS, &settled) == 0 && settled == 1, "no settle after slow turn");
+    rotate(-60, 400, &detent);
+    CHECK(hold(0, SETTLE_MAX_MS, &settled) == 0 && settled == 1, "no settle after wrap");
+    rotate(400, 200, &detent);
+    CHECK(hold(0, SETTLE_MAX_MS, &settled) == 0 && settled == 1, "no settle after fast turn");
+    printf("rotate: detent %d position %d, step latency max %u ms\n", As5600GetDetent(), As5600GetPosition(),
+        latency_max);
+
+    // 在档位中心和刚越过阈值处抖动，都不应产生步进
+    angle = detent_center(detent);
+    CHECK(hold(40, 200, &settled) == 0, "steps on centre jitter");
+    angle = detent_center(detent) + (THRESHOLD_Q8 >> 8) - 2;
+    CHECK(hold(6, 200, &settled) == 0, "steps on single-sample threshold jitter");
+    // 越过阈值后回到两档中间的边界上抖动，滞回让它不会来回跳
+    rotate(2, 10, &detent);
+    angle = detent_center(detent) - (WIDTH_Q8 >> 9);
+    CHECK(hold(8, 200, &settled) == 0, "steps on hysteresis jitter");
+    printf("jitter: detent %d\n", As5600GetDetent());
+
+    // 总线忙时丢弃采样并计数
+    As5600GetStat(&stat);
+    HostTimerUpdate(&Timer6);
+    HostTimerUpdate(&Timer6);
+    HostI2cComplete(&I2c0);
+    As5600GetStat(&stat);
+    CHECK(stat.missed == 1, "missed %u", stat.missed);
+
+    // 总线出错时丢弃这个采样并计数，之后的采样照常进行
+    HostTimerUpdate(&Timer6);
+    HostI2cFail(&I2c0);
+    sample();
+    As5600GetStat(&stat);
+    CHECK(stat.errors == 1, "errors %u", stat.errors);
+    CHECK(HostI2cComplete(&I2c0) == -1, "sample still pending after bus error");
+
+    while(As5600GetEvent(&event) == 0) {
+    }
+    // 来回转动测耗时，队列满了就清空，不让事件丢弃影响测量
+    start = now_ns();
+    for(i = 0; i < BENCH_SAMPLES; i++) {
+        angle += (int32_t)((i >> 9) & 1 ? 37 : -23);
+        sample();
+        if((i & 7) == 0) {
+            while(As5600GetEvent(&event) == 0) {
+            }
+        }
+    }
+    printf("bench: %.1f ns/sample including the simulated bus\n", (now_ns() - start) / BENCH_SAMPLES);
+    HostTerminalRun("knob_stat", "");
+
+    printf(failed ? "FAILED\n" : "PASSED\n");
+
+    return failed;
+}
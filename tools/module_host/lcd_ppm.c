@@ -0,0 +1,429 @@
+/*
+ * 在主机上跑 spi_lcd.c：SPI 后面接一个 ST77xx 控制器的模型，按 D/C 和片选解析命令和像素写进显存，
+ * 和直接从字库点阵画出的期望画面逐像素比对，最后把显存写成 PPM 图片
+ *
+ * cd tools/module_host && make lcd_ppm && ./lcd_ppm [out.ppm]
+ *
+ * DMA 发送按 SCK 频率算出完成时刻，完成时才把缓冲区的内容交给控制器，发送期间改了缓冲区、
+ * 切了 D/C 或拉高片选都会在画面或检查里体现出来。检查的内容：初始化序列、清屏、
+ * 每次刷新只发送变化的字符格、整屏重画和只改颜色的重画。SSD1306 的页寻址没有建模。
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gd32f30x.h"
+#include "spi_lcd.h"
+#include "font.h"
+#include "system_timer.h"
+#include "host_stub.h"
+#include "host_periph.h"
+
+#if LCD_CONTROLLER == LCD_SSD1306
+#error "lcd_ppm only models the ST7735/ST7789 command set"
+#endif
+
+#define LCD_CS_PORT         GPIOA
+#define LCD_CS_PIN          GPIO_PIN_15
+#define LCD_DC_PORT         GPIOB
+#define LCD_DC_PIN          GPIO_PIN_8
+
+#define CLOCK_SECONDS       70
+#define SCREEN_INIT         0xA5A5      // 上电时显存里的随机内容，清屏后不应留下
+
+SpiStruct Spi2;
+
+typedef struct
+{
+    uint8_t cmd;
+    uint8_t arg[4];
+    uint8_t arg_num;
+    uint8_t sleep;
+    uint8_t display_on;
+    uint8_t colmod;
+    uint16_t x0, x1, y0, y1;
+    uint16_t x, y;
+    uint8_t pixel_high;
+    uint8_t pixel_half;         // 已收到像素的高字节
+    uint32_t bytes;
+    uint32_t errors;
+    uint16_t ram[LCD_HEIGHT][LCD_WIDTH];
+}Panel;
+
+typedef struct
+{
+    uint8_t busy;
+    const void *data;
+    uint16_t data_num;
+    SpiFrameSize frame_size;
+    uint8_t repeat;
+    uint8_t dc;
+    uint64_t end_us;
+}SpiTransfer;
+
+static Panel panel;
+static SpiTransfer transfer;
+static uint16_t expect[LCD_HEIGHT][LCD_WIDTH];
+static char screen[LCD_ROWS][LCD_COLS];
+static uint16_t screen_fg[LCD_ROWS][LCD_COLS];
+static uint16_t screen_bg[LCD_ROWS][LCD_COLS];
+static int failed = 0;
+
+#define CHECK(cond, ...) \
+    do { if(!(cond)) { printf("FAIL line %d: ", __LINE__); printf(__VA_ARGS__); printf("\n"); failed = 1; } } while(0)
+
+static uint8_t pin_high(uint32_t port, uint32_t pin)
+{
+    return (HostGpioOutput(port) & pin) != 0;
+}
+
+/**
+ * @brief 控制器收到一个字节，dc为1是数据，0是命令
+ */
+static void panel_byte(uint8_t byte, uint8_t dc)
+{
+    panel.bytes ++;
+    if(dc == 0) {
+        panel.cmd = byte;
+        panel.arg_num = 0;
+        switch(byte) {
+        case 0x01:
+            panel.sleep = 1;
+            panel.display_on = 0;
+            break;
+        case 0x11:
+            panel.sleep = 0;
+            break;
+        case 0x29:
+            panel.display_on = 1;
+            break;
+        case 0x2C:
+            panel.x = panel.x0;
+            panel.y = panel.y0;
+            panel.pixel_half = 0;
+            break;
+        }
+        return;
+    }
+
+    switch(panel.cmd) {
+    case 0x2A:
+    case 0x2B:
+        if(panel.arg_num < 4)
+            panel.arg[panel.arg_num ++] = byte;
+        if(panel.arg_num == 4 && panel.cmd == 0x2A) {
+            panel.x0 = (uint16_t)(panel.arg[0] << 8 | panel.arg[1]);
+            panel.x1 = (uint16_t)(panel.arg[2] << 8 | panel.arg[3]);
+        } else if(panel.arg_num == 4) {
+            panel.y0 = (uint16_t)(panel.arg[0] << 8 | panel.arg[1]);
+            panel.y1 = (uint16_t)(panel.arg[2] << 8 | panel.arg[3]);
+        }
+        break;
+    case 0x3A:
+        panel.colmod = byte;
+        break;
+    case 0x2C:
+        // RGB565高字节先到，窗口写满后回到起点
+        if(panel.pixel_half == 0) {
+            panel.pixel_high = byte;
+            panel.pixel_half = 1;
+            break;
+        }
+        panel.pixel_half = 0;
+        if(panel.x >= LCD_WIDTH || panel.y >= LCD_HEIGHT || panel.x0 > panel.x1 || panel.y0 > panel.y1) {
+            if(panel.errors ++ == 0)
+                printf("pixel outside the screen at %u,%u\n", panel.x, panel.y);
+        } else {
+            panel.ram[panel.y][panel.x] = (uint16_t)(panel.pixel_high << 8 | byte);
+        }
+        if(++ panel.x > panel.x1) {
+            panel.x = panel.x0;
+            if(++ panel.y > panel.y1)
+                panel.y = panel.y0;
+        }
+        break;
+    }
+}
+
+static void panel_send(const void *data, uint16_t data_num, SpiFrameSize frame_size, uint8_t repeat, uint8_t dc)
+{
+    const uint8_t *bytes = data;
+    const uint16_t *words = data;
+    uint16_t i, word;
+
+    if(pin_high(LCD_CS_PORT, LCD_CS_PIN)) {
+        if(panel.errors ++ == 0)
+            printf("%u bytes sent with chip select high\n", data_num);
+        return;
+    }
+    for(i = 0; i < data_num; i++) {
+        if(frame_size == SpiFrame_8Bit) {
+            panel_byte(bytes[repeat ? 0 : i], dc);
+        } else {
+            word = words[repeat ? 0 : i];
+            panel_byte((uint8_t)(word >> 8), dc);
+            panel_byte((uint8_t)word, dc);
+        }
+    }
+}
+
+static uint64_t transfer_us(uint32_t bytes)
+{
+    return ((uint64_t)bytes * 8 * 1000000 + Spi2.Init.speed - 1) / Spi2.Init.speed;
+}
+
+/**
+ * @brief DMA发送到完成时刻才交给控制器，期间D/C或片选变了就不是固件想发的内容
+ */
+static void transfer_complete(void)
+{
+    if(transfer.busy == 0 || GetSystemTimer_us() < transfer.end_us)
+        return;
+
+    transfer.busy = 0;
+    if(pin_high(LCD_DC_PORT, LCD_DC_PIN) != transfer.dc || pin_high(LCD_CS_PORT, LCD_CS_PIN)) {
+        if(panel.errors ++ == 0)
+            printf("D/C or chip select changed during DMA\n");
+    }
+    panel_send(transfer.data, transfer.data_num, transfer.frame_size, transfer.repeat, transfer.dc);
+}
+
+int8_t SpiInit(SpiStruct *spi, SpiInitStruct *init)
+{
+    spi->Init = *init;
+    spi->inited = 1;
+
+    return 0;
+}
+
+int8_t SpiSend(SpiStruct *spi, const uint8_t *data, uint16_t data_len)
+{
+    transfer_complete();
+    if(spi->inited == 0 || transfer.busy == 1)
+        return -1;
+
+    HostTimeAdvance((uint32_t)transfer_us(data_len));
+    panel_send(data, data_len, SpiFrame_8Bit, 0, pin_high(LCD_DC_PORT, LCD_DC_PIN));
+
+    return 0;
+}
+
+static int8_t spi_start(SpiStruct *spi, const void *data, uint16_t data_num, SpiFrameSize frame_size, uint8_t repeat)
+{
+    transfer_complete();
+    if(spi->inited == 0 || transfer.busy == 1 || data_num == 0)
+        return -1;
+
+    transfer.busy = 1;
+    transfer.data = data;
+    transfer.data_num = data_num;
+    transfer.frame_size = frame_size;
+    transfer.repeat = repeat;
+    transfer.dc = pin_high(LCD_DC_PORT, LCD_DC_PIN);
+    transfer.end_us = GetSystemTimer_us() + transfer_us((uint32_t)data_num * (frame_size == SpiFrame_16Bit ? 2 : 1));
+
+    return 0;
+}
+
+int8_t SpiSendDMA(SpiStruct *spi, const void *data, uint16_t data_num, SpiFrameSize frame_size)
+{
+    return spi_start(spi, data, data_num, frame_size, 0);
+}
+
+int8_t SpiSendRepeatDMA(SpiStruct *spi, const void *data, uint16_t data_num, SpiFrameSize frame_size)
+{
+    return spi_start(spi, data, data_num, frame_size, 1);
+}
+
+uint8_t SpiIsBusy(SpiStruct *spi)
+{
+    (void)spi;
+    transfer_complete();
+
+    return transfer.busy;
+}
+
+/**
+ * @brief 上电显存是随机内容，初始化后应该全黑，字符格全是白字黑底的空格
+ */
+static void expect_init(void)
+{
+    uint16_t x, y;
+
+    for(y = 0; y < LCD_HEIGHT; y++) {
+        for(x = 0; x < LCD_WIDTH; x++) {
+            panel.ram[y][x] = SCREEN_INIT;
+            expect[y][x] = FONT_COLOR_BLACK;
+        }
+    }
+    for(y = 0; y < LCD_ROWS; y++) {
+        for(x = 0; x < LCD_COLS; x++) {
+            screen[y][x] = ' ';
+            screen_fg[y][x] = FONT_COLOR_WHITE;
+            screen_bg[y][x] = FONT_COLOR_BLACK;
+        }
+    }
+}
+
+/**
+ * @brief 期望画面：按LcdDrawText的规则更新字符格，直接用字库点阵画，不经过渲染缓存
+ *
+ * @return uint32_t 内容或颜色变化的字符格数
+ */
+static uint32_t expect_text(uint8_t col, uint8_t row, const char *text, uint16_t fg, uint16_t bg)
+{
+    const uint8_t *bitmap;
+    uint32_t changed = 0;
+    uint8_t x, y;
+
+    for(; *text != '\0' && col < LCD_COLS; col++, text++) {
+        if(screen[row][col] == *text && screen_fg[row][col] == fg && screen_bg[row][col] == bg)
+            continue;
+        screen[row][col] = *text;
+        screen_fg[row][col] = fg;
+        screen_bg[row][col] = bg;
+        changed ++;
+        bitmap = FontBitmap(*text);
+        for(y = 0; y < FONT_HEIGHT; y++) {
+            for(x = 0; x < FONT_WIDTH; x++)
+                expect[row * FONT_HEIGHT + y][col * FONT_WIDTH + x] = (bitmap[y] >> (7 - x)) & 0x01 ? fg : bg;
+        }
+    }
+
+    return changed;
+}
+
+static uint32_t draw(uint8_t col, uint8_t row, const char *text, uint16_t fg, uint16_t bg)
+{
+    CHECK(LcdDrawText(col, row, text, fg, bg) == 0, "draw \"%s\" at %u,%u", text, col, row);
+
+    return expect_text(col, row, text, fg, bg);
+}
+
+/**
+ * @brief 主循环一样反复调用LcdProcess直到发完，返回这一轮发送的字符格数
+ */
+static uint32_t flush(void)
+{
+    LcdStat before, after;
+    uint32_t loops = 0;
+
+    LcdGetStat(&before);
+    do {
+        LcdProcess();
+        HostTimeAdvance(1);
+    } while(LcdIsIdle() == 0 && ++ loops < 1000000);
+    LcdGetStat(&after);
+    CHECK(loops < 1000000, "flush never finished");
+
+    return after.cells - before.cells;
+}
+
+static void check_screen(const char *what)
+{
+    uint32_t diff = 0;
+    uint16_t x, y;
+
+    for(y = 0; y < LCD_HEIGHT; y++) {
+        for(x = 0; x < LCD_WIDTH; x++) {
+            if(panel.ram[y][x] != expect[y][x] && diff ++ == 0)
+                printf("%s: first wrong pixel at %u,%u: %04x, expected %04x\n", what, x, y, panel.ram[y][x],
+                    expect[y][x]);
+        }
+    }
+    CHECK(diff == 0, "%s: %u wrong pixels", what, diff);
+    CHECK(panel.errors == 0, "%s: %u protocol errors", what, panel.errors);
+}
+
+static int8_t write_ppm(const char *path)
+{
+    FILE *file = fopen(path, "wb");
+    uint16_t x, y, pixel;
+    uint8_t rgb[3];
+
+    if(file == NULL)
+        return -1;
+
+    fprintf(file, "P6\n%d %d\n255\n", LCD_WIDTH, LCD_HEIGHT);
+    for(y = 0; y < LCD_HEIGHT; y++) {
+        for(x = 0; x < LCD_WIDTH; x++) {
+            pixel = panel.ram[y][x];
+            rgb[0] = (uint8_t)((pixel >> 11) * 255 / 31);
+            rgb[1] = (uint8_t)(((pixel >> 5) & 0x3f) * 255 / 63);
+            rgb[2] = (uint8_t)((pixel & 0x1f) * 255 / 31);
+            fwrite(rgb, 1, sizeof(rgb), file);
+        }
+    }
+    fclose(file);
+
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *path = argc > 1 ? argv[1] : "lcd.ppm";
+    const uint16_t yellow = FONT_COLOR(255, 220, 0), blue = FONT_COLOR(0, 40, 120);
+    SpiInitStruct spi_init = { 30000000 };
+    LcdStat stat;
+    char line[LCD_COLS + 1];
+    uint32_t sec, changed, sent, cells_max = 0;
+
+    expect_init();
+    // 忙等延时靠读系统时间推进
+    HostTimeStep(1);
+    FontInit();
+    SpiInit(LCD_SPI, &spi_init);
+    CHECK(LcdInit() == 0, "init");
+    CHECK(panel.sleep == 0 && panel.display_on == 1 && panel.colmod == 0x05, "init sequence: sleep %u on %u colmod %02x",
+        panel.sleep, panel.display_on, panel.colmod);
+    check_screen("clear");
+    printf("init: %ux%u, %u bytes, cleared in %llu us\n", LCD_WIDTH, LCD_HEIGHT, panel.bytes,
+        (unsigned long long)GetSystemTimer_us());
+
+    // 和main.c一样的时钟和温湿度两行
+    changed = draw(0, 0, "12:34:56", FONT_COLOR_WHITE, FONT_COLOR_BLACK);
+    changed += draw(0, 1, "  23.5\x7f" "C  45%", FONT_COLOR_WHITE, FONT_COLOR_BLACK);
+    changed += draw(0, LCD_ROWS - 1, "overflowing text is clipped", yellow, blue);
+    sent = flush();
+    CHECK(sent == changed, "first frame sent %u cells, %u changed", sent, changed);
+    check_screen("first frame");
+
+    // 每秒只发送变化的格
+    for(sec = 0; sec < CLOCK_SECONDS; sec++) {
+        snprintf(line, sizeof(line), "12:%02u:%02u", (34 + (56 + sec + 1) / 60) % 60, (56 + sec + 1) % 60);
+        changed = draw(0, 0, line, FONT_COLOR_WHITE, FONT_COLOR_BLACK);
+        sent = flush();
+        CHECK(sent == changed, "second %u sent %u cells, %u changed", sec, sent, changed);
+        if(sent > cells_max)
+            cells_max = sent;
+    }
+    check_screen("clock");
+    printf("clock: %u seconds, at most %u cells per second\n", CLOCK_SECONDS, cells_max);
+
+    // 只改颜色也要重画，画面内容不变时不发送
+    changed = draw(2, 1, "23.5\x7f" "C", yellow, FONT_COLOR_BLACK);
+    CHECK(changed == 6 && flush() == changed, "colour change sent wrong cells");
+    CHECK(flush() == 0, "idle flush sent cells");
+    check_screen("colour");
+
+    LcdInvalidate();
+    CHECK(flush() == LCD_ROWS * LCD_COLS, "invalidate did not redraw every cell");
+    check_screen("redraw");
+
+    LcdGetStat(&stat);
+    printf("flushes %u, rects %u, cells %u, %u bytes (full frame %u bytes)\n", stat.flushes, stat.rects, stat.cells,
+        stat.bytes, LCD_WIDTH * LCD_HEIGHT * 2);
+    HostTerminalRun("lcd_stat", "");
+
+    if(write_ppm(path) != 0) {
+        printf("can't write %s\n", path);
+        failed = 1;
+    } else {
+        printf("screen written to %s\n", path);
+    }
+
+    printf(failed ? "FAILED\n" : "PASSED\n");
+
+    return failed;
+}